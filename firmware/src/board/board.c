@@ -34,6 +34,7 @@ static const Board board =
     .lwnodeI2cSda  = GPIO_NUM_8,
     .lwnodeI2cScl  = GPIO_NUM_9,
     .lwnodeI2cAddr = 0x20U,
+    .lwnodeIrqPin  = GPIO_NUM_NC,  /* Not wired on this board */
 
     /* AC Light Dimmer */
     .dimmerOutPin = GPIO_NUM_12,
@@ -45,6 +45,7 @@ typedef struct Board
     gpio_num_t lwnodeI2cSda;
     gpio_num_t lwnodeI2cScl;
     uint16_t lwnodeI2cAddr;
+    gpio_num_t lwnodeIrqPin;
     gpio_num_t dimmerOutPin;
     gpio_num_t dimmerZcPin;
 } Board;
@@ -1,6 +1,7 @@
 #include "num_fmt.h"
 
 static char num_fmt_hex_nibble_to_char( uint8_t value );
+static bool num_fmt_hex_char_to_nibble( char c, uint8_t * const nibble );
 
 bool num_fmt_hex_encode( const uint8_t * const in,
                          size_t inLen,
@@ -31,6 +32,31 @@ bool num_fmt_hex_encode( const uint8_t * const in,
     return result;
 }
 
+bool num_fmt_hex_decode( const char * const in,
+                         size_t inLen,
+                         uint8_t * const out,
+                         size_t outLen )
+{
+    bool result = false;
+
+    if( ( in != NULL ) && ( out != NULL ) && ( inLen == ( outLen * 2U ) ) )
+    {
+        result = true;
+
+        for( size_t i = 0U; ( i < outLen ) && result; ++i )
+        {
+            uint8_t hi = 0U;
+            uint8_t lo = 0U;
+
+            result = num_fmt_hex_char_to_nibble( in[ i * 2U ], &hi ) &&
+                     num_fmt_hex_char_to_nibble( in[ ( i * 2U ) + 1U ], &lo );
+            out[ i ] = ( uint8_t ) ( ( uint8_t ) ( hi << 4 ) | lo );
+        }
+    }
+
+    return result;
+}
+
 bool num_fmt_u32toa( uint32_t value,
                      char * const out,
                      size_t outCap )
@@ -160,3 +186,35 @@ static char num_fmt_hex_nibble_to_char( uint8_t value )
 
     return result;
 }
+
+/**
+ * @brief Convert a hexadecimal character to its 4-bit value.
+ *
+ * @param c       Character to convert ('0'-'9', 'A'-'F', 'a'-'f').
+ * @param nibble  Output value.
+ *
+ * @return true if c is a hex digit, false otherwise.
+ */
+static bool num_fmt_hex_char_to_nibble( char c, uint8_t * const nibble )
+{
+    bool result = true;
+
+    if( ( c >= '0' ) && ( c <= '9' ) )
+    {
+        *nibble = ( uint8_t ) ( c - '0' );
+    }
+    else if( ( c >= 'A' ) && ( c <= 'F' ) )
+    {
+        *nibble = ( uint8_t ) ( ( c - 'A' ) + 10 );
+    }
+    else if( ( c >= 'a' ) && ( c <= 'f' ) )
+    {
+        *nibble = ( uint8_t ) ( ( c - 'a' ) + 10 );
+    }
+    else
+    {
+        result = false;
+    }
+
+    return result;
+}
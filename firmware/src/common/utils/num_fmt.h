@@ -25,6 +25,24 @@ bool num_fmt_hex_encode( const uint8_t * in,
                          char * out,
                          size_t outCap );
 
+/**
+ * @brief Decode a hex string into binary data.
+ *
+ * Accepts upper- and lowercase digits; exactly outLen * 2 characters are
+ * read.
+ *
+ * @param in       Hex characters (need not be null-terminated)
+ * @param inLen    Number of characters, must be outLen * 2
+ * @param out      Output byte buffer
+ * @param outLen   Number of bytes to produce
+ *
+ * @return true on success, false on a length mismatch or a non-hex character
+ */
+bool num_fmt_hex_decode( const char * in,
+                         size_t inLen,
+                         uint8_t * out,
+                         size_t outLen );
+
 /**
  * @brief Convert uint32_t to decimal ASCII.
  *
@@ -6,10 +6,30 @@
 #include <freertos/task.h>
 
 #include <esp_err.h>
+#include <esp_mac.h>
+#include <esp_timer.h>
+#include <nvs.h>
 
 #define LWNODE_I2C_FREQ_HZ         ( 400000U )
 #define LWNODE_I2C_TIMEOUT_MS      ( 100U )
 #define LWNODE_MAX_TRANSFER_LEN    ( 256U )
+#define LWNODE_NVS_NAMESPACE       "lwnode"
+
+static bool lwnode_hal_irq_init( LwnodeHw * const sensor );
+static void lwnode_hal_irq_isr( void * arg );
+
+void lwnode_hal_config_default( LwnodeHw * const sensor )
+{
+    if( sensor != NULL )
+    {
+        ( void ) memset( sensor, 0, sizeof( *sensor ) );
+        sensor->port = I2C_NUM_0;
+        sensor->sclPin = GPIO_NUM_NC;
+        sensor->sdaPin = GPIO_NUM_NC;
+        sensor->i2cAddr = LWNODE_HAL_DEFAULT_I2C_ADDR;
+        sensor->irqPin = GPIO_NUM_NC;
+    }
+}
 
 bool lwnode_hal_init( LwnodeHw * const sensor )
 {
@@ -51,11 +71,23 @@ bool lwnode_hal_init( LwnodeHw * const sensor )
 
             if( err == ESP_OK )
             {
-                result = true;
+                result = lwnode_hal_irq_init( sensor );
+
+                if( !result )
+                {
+                    /* Failed to arm the IRQ, detach the device */
+                    err = i2c_master_bus_rm_device( sensor->devHandle );
+
+                    if( err == ESP_OK )
+                    {
+                        sensor->devHandle = NULL;
+                    }
+                }
             }
-            else
+
+            if( !result )
             {
-                /* Failed to add device, cleanup */
+                /* Failed to add device or arm the IRQ, cleanup */
                 err = i2c_del_master_bus( sensor->busHandle );
 
                 if( err == ESP_OK )
@@ -84,6 +116,12 @@ bool lwnode_hal_deinit( LwnodeHw * const sensor )
         {
             esp_err_t err = ESP_OK;
 
+            if( sensor->irqSem != NULL )
+            {
+                ( void ) gpio_isr_handler_remove( sensor->irqPin );
+                sensor->irqSem = NULL;
+            }
+
             if( sensor->devHandle != NULL )
             {
                 err = i2c_master_bus_rm_device( sensor->devHandle );
@@ -171,6 +209,25 @@ bool lwnode_hal_read( const LwnodeHw * const sensor,
     return result;
 }
 
+bool lwnode_hal_probe( const LwnodeHw * const sensor )
+{
+    bool result = false;
+
+    if( ( sensor != NULL ) && ( sensor->busHandle != NULL ) )
+    {
+        const esp_err_t err = i2c_master_probe( sensor->busHandle,
+                                                sensor->i2cAddr,
+                                                ( int ) LWNODE_I2C_TIMEOUT_MS );
+
+        if( err == ESP_OK )
+        {
+            result = true;
+        }
+    }
+
+    return result;
+}
+
 void lwnode_hal_delay_ms( uint32_t delayMs )
 {
     if( delayMs > 0U )
@@ -178,3 +235,166 @@ void lwnode_hal_delay_ms( uint32_t delayMs )
         vTaskDelay( pdMS_TO_TICKS( delayMs ) );
     }
 }
+
+bool lwnode_hal_irq_available( const LwnodeHw * const sensor )
+{
+    return ( ( sensor != NULL ) && ( sensor->irqSem != NULL ) );
+}
+
+bool lwnode_hal_wait_irq( const LwnodeHw * const sensor, uint32_t timeoutMs )
+{
+    bool result = false;
+
+    if( lwnode_hal_irq_available( sensor ) )
+    {
+        if( xSemaphoreTake( sensor->irqSem, pdMS_TO_TICKS( timeoutMs ) ) == pdTRUE )
+        {
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+uint32_t lwnode_hal_get_time_ms( void )
+{
+    const int64_t timeUs = esp_timer_get_time();
+    uint32_t result = 0U;
+
+    if( timeUs >= 0 )
+    {
+        result = ( uint32_t ) ( ( uint64_t ) timeUs / 1000U );
+    }
+
+    return result;
+}
+
+uint32_t lwnode_hal_device_id( void )
+{
+    uint8_t mac[ 6 ] = { 0U };
+    uint32_t result = 0U;
+
+    if( esp_efuse_mac_get_default( mac ) == ESP_OK )
+    {
+        result = ( ( uint32_t ) mac[ 2 ] << 24 ) | ( ( uint32_t ) mac[ 3 ] << 16 ) |
+                 ( ( uint32_t ) mac[ 4 ] << 8 ) | ( uint32_t ) mac[ 5 ];
+    }
+
+    return result;
+}
+
+bool lwnode_hal_nvs_load( const char * const key, void * const data, size_t len )
+{
+    bool result = false;
+
+    if( ( key != NULL ) && ( data != NULL ) && ( len > 0U ) )
+    {
+        nvs_handle_t handle = 0U;
+
+        if( nvs_open( LWNODE_NVS_NAMESPACE, NVS_READONLY, &handle ) == ESP_OK )
+        {
+            size_t storedLen = len;
+
+            if( ( nvs_get_blob( handle, key, data, &storedLen ) == ESP_OK ) &&
+                ( storedLen == len ) )
+            {
+                result = true;
+            }
+
+            nvs_close( handle );
+        }
+    }
+
+    return result;
+}
+
+bool lwnode_hal_nvs_store( const char * const key, const void * const data, size_t len )
+{
+    bool result = false;
+
+    if( ( key != NULL ) && ( data != NULL ) && ( len > 0U ) )
+    {
+        nvs_handle_t handle = 0U;
+
+        if( nvs_open( LWNODE_NVS_NAMESPACE, NVS_READWRITE, &handle ) == ESP_OK )
+        {
+            if( ( nvs_set_blob( handle, key, data, len ) == ESP_OK ) &&
+                ( nvs_commit( handle ) == ESP_OK ) )
+            {
+                result = true;
+            }
+
+            nvs_close( handle );
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Arm the optional module IRQ line.
+ *
+ * Leaves the IRQ disabled (and succeeds) when no pin is configured.
+ *
+ * @param[in,out] sensor Pointer to the LWNode hardware configuration.
+ *
+ * @return true if the IRQ is armed or not wired, false on GPIO errors.
+ */
+static bool lwnode_hal_irq_init( LwnodeHw * const sensor )
+{
+    bool result = true;
+
+    sensor->irqSem = NULL;
+
+    if( sensor->irqPin != GPIO_NUM_NC )
+    {
+        const gpio_config_t irqConfig =
+        {
+            .pin_bit_mask = ( 1ULL << ( uint32_t ) sensor->irqPin ),
+            .mode = GPIO_MODE_INPUT,
+            .pull_up_en = GPIO_PULLUP_ENABLE,
+            .pull_down_en = GPIO_PULLDOWN_DISABLE,
+            .intr_type = GPIO_INTR_NEGEDGE
+        };
+        esp_err_t err = gpio_config( &irqConfig );
+
+        if( err == ESP_OK )
+        {
+            /* The ISR service may already be installed by another driver */
+            err = gpio_install_isr_service( 0 );
+
+            if( err == ESP_ERR_INVALID_STATE )
+            {
+                err = ESP_OK;
+            }
+        }
+
+        if( err == ESP_OK )
+        {
+            sensor->irqSem = xSemaphoreCreateBinaryStatic( &sensor->irqSemBuffer );
+            err = gpio_isr_handler_add( sensor->irqPin, lwnode_hal_irq_isr, sensor );
+        }
+
+        if( err != ESP_OK )
+        {
+            sensor->irqSem = NULL;
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Module IRQ handler: wake the task sleeping in lwnode_hal_wait_irq().
+ *
+ * @param[in] arg Pointer to the LWNode hardware configuration.
+ */
+static void lwnode_hal_irq_isr( void * arg )
+{
+    const LwnodeHw * const sensor = ( const LwnodeHw * ) arg;
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    ( void ) xSemaphoreGiveFromISR( sensor->irqSem, &xHigherPriorityTaskWoken );
+    portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+}
@@ -5,6 +5,9 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
 #include <driver/gpio.h>
 #include <driver/i2c_master.h>
 
@@ -12,6 +15,8 @@
 extern "C" {
 #endif
 
+#define LWNODE_HAL_DEFAULT_I2C_ADDR  ( 0x20U )  /**< DFR1115 7-bit I2C address */
+
 typedef struct LwnodeHw
 {
     /* Static configuration */
@@ -19,17 +24,35 @@ typedef struct LwnodeHw
     gpio_num_t sclPin;     /**< GPIO number used for I2C SCL */
     gpio_num_t sdaPin;     /**< GPIO number used for I2C SDA */
     uint16_t i2cAddr;      /**< 7-bit I2C device address */
+    gpio_num_t irqPin;     /**< Module data-ready IRQ (active low), GPIO_NUM_NC if not wired (0 is GPIO0) */
 
     /* Runtime-managed handles */
     i2c_master_bus_handle_t busHandle;  /**< I2C master bus handle */
     i2c_master_dev_handle_t devHandle;  /**< I2C device handle */
+    SemaphoreHandle_t irqSem;           /**< Given from the IRQ ISR */
+    StaticSemaphore_t irqSemBuffer;     /**< Storage for irqSem */
 } LwnodeHw;
 
+/**
+ * @brief Fill a hardware descriptor with safe defaults.
+ *
+ * Selects I2C port 0 and the module's default address, leaves the bus pins
+ * and the IRQ line unassigned (GPIO_NUM_NC) and clears the runtime
+ * handles. Start from this rather than a zeroed struct, where irqPin 0
+ * would arm GPIO0, a strapping pin. Set the pins, and irqPin if wired,
+ * before lwnode_hal_init().
+ *
+ * @param sensor  Pointer to the LWNode hardware configuration structure.
+ */
+void lwnode_hal_config_default( LwnodeHw * sensor );
+
 /**
  * @brief Initialize the LWNode I2C hardware interface.
  *
  * Configures and initializes the I2C master bus and attaches the LWNode
  * device to the bus using the parameters provided in the hardware descriptor.
+ * The IRQ line is armed if irqPin is set. On failure nothing stays
+ * allocated.
  *
  * @param sensor  Pointer to the LWNode hardware configuration structure.
  *
@@ -86,6 +109,18 @@ bool lwnode_hal_read( const LwnodeHw * sensor,
                       uint8_t * data,
                       size_t len );
 
+/**
+ * @brief Check that the LWNode acknowledges its I2C address.
+ *
+ * A missing or unpowered module NACKs the address, which is detected in a
+ * single bus transaction instead of an AT command timeout.
+ *
+ * @param sensor  Pointer to the LWNode hardware configuration structure.
+ *
+ * @return true if the device ACKed its address, false otherwise.
+ */
+bool lwnode_hal_probe( const LwnodeHw * sensor );
+
 /**
  * @brief Delay execution for a specified number of milliseconds.
  *
@@ -95,6 +130,71 @@ bool lwnode_hal_read( const LwnodeHw * sensor,
  */
 void lwnode_hal_delay_ms( uint32_t delayMs );
 
+/**
+ * @brief Check whether the module IRQ line is wired and armed.
+ *
+ * @param sensor  Pointer to the LWNode hardware configuration structure.
+ *
+ * @return true if lwnode_hal_wait_irq() can be used, false otherwise.
+ */
+bool lwnode_hal_irq_available( const LwnodeHw * sensor );
+
+/**
+ * @brief Block until the module IRQ fires or the timeout expires.
+ *
+ * @param sensor     Pointer to the LWNode hardware configuration structure.
+ * @param timeoutMs  Maximum time to wait in milliseconds.
+ *
+ * @return true if the IRQ fired, false on timeout or if no IRQ is wired.
+ */
+bool lwnode_hal_wait_irq( const LwnodeHw * sensor, uint32_t timeoutMs );
+
+/**
+ * @brief Get the current monotonic time in milliseconds.
+ *
+ * The value wraps around after ~49 days; callers must compare timestamps
+ * using unsigned differences.
+ *
+ * @return uint32_t Current time in milliseconds.
+ */
+uint32_t lwnode_hal_get_time_ms( void );
+
+/**
+ * @brief Get a number that differs between boards.
+ *
+ * Used to spread periodic work (e.g. forced re-joins) across a fleet of
+ * nodes that were powered on together.
+ *
+ * @return Low 32 bits of the factory MAC address, 0 if it can not be read.
+ */
+uint32_t lwnode_hal_device_id( void );
+
+/**
+ * @brief Load a persisted driver state blob from NVS.
+ *
+ * The default NVS partition must already be initialized by the
+ * application (nvs_flash_init() at startup); the driver never erases it.
+ *
+ * @param key   Blob name (at most 15 characters).
+ * @param data  Destination buffer.
+ * @param len   Expected blob size in bytes.
+ *
+ * @return true if a blob of exactly len bytes was read, false otherwise.
+ */
+bool lwnode_hal_nvs_load( const char * key, void * data, size_t len );
+
+/**
+ * @brief Persist a driver state blob to NVS.
+ *
+ * @param key   Blob name (at most 15 characters).
+ * @param data  Blob to store.
+ * @param len   Blob size in bytes.
+ *
+ * @return true if the blob was written and committed, false otherwise
+ *         (including when NVS is not initialized).
+ */
+bool lwnode_hal_nvs_store( const char * key, const void * data, size_t len );
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,294 @@
+#include "lwnode_uart.h"
+
+#include <string.h>
+
+#include <freertos/task.h>
+
+#include <esp_err.h>
+
+#include "lib/at_response.h"
+
+#define LWNODE_UART_RX_BUF_LEN      ( 1024U )
+#define LWNODE_UART_EVENT_QUEUE_LEN ( 16U )
+#define LWNODE_UART_PATTERN_CHAR    ( '\n' )
+
+static bool lwnode_uart_write_at( void * const ctx,
+                                  const uint8_t * const data,
+                                  size_t len,
+                                  bool final );
+static bool lwnode_uart_read_at( void * const ctx,
+                                 uint8_t * const buf,
+                                 size_t cap,
+                                 uint16_t * const outLen );
+static bool lwnode_uart_wait_rx( void * const ctx, uint32_t timeoutMs );
+static uint16_t lwnode_uart_stage( LwnodeUart * const uart );
+
+const LwnodeTransport lwnodeUartTransport =
+{
+    .name = "uart",
+    .stream = true,
+    .probe = NULL,
+    .write_at = lwnode_uart_write_at,
+    .read_at = lwnode_uart_read_at,
+    .wait_rx = lwnode_uart_wait_rx
+};
+
+bool lwnode_uart_init( LwnodeUart * const uart )
+{
+    bool result = false;
+
+    if( uart != NULL )
+    {
+        const uart_config_t config =
+        {
+            .baud_rate = ( int ) uart->baud,
+            .data_bits = UART_DATA_8_BITS,
+            .parity = UART_PARITY_DISABLE,
+            .stop_bits = UART_STOP_BITS_1,
+            .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+            .source_clk = UART_SCLK_DEFAULT
+        };
+
+        uart->events = NULL;
+        uart->stageLen = 0U;
+        uart->installed = false;
+
+        esp_err_t err = uart_driver_install( uart->port,
+                                             ( int ) LWNODE_UART_RX_BUF_LEN,
+                                             0,
+                                             ( int ) LWNODE_UART_EVENT_QUEUE_LEN,
+                                             &uart->events,
+                                             0 );
+
+        if( err == ESP_OK )
+        {
+            uart->installed = true;
+            err = uart_param_config( uart->port, &config );
+        }
+
+        if( err == ESP_OK )
+        {
+            err = uart_set_pin( uart->port,
+                                uart->txPin,
+                                uart->rxPin,
+                                UART_PIN_NO_CHANGE,
+                                UART_PIN_NO_CHANGE );
+        }
+
+        if( err == ESP_OK )
+        {
+            /* One '\n' ends a line; no idle guard is needed on an 8N1 stream */
+            err = uart_enable_pattern_det_baud_intr( uart->port, LWNODE_UART_PATTERN_CHAR, 1U, 1, 0, 0 );
+        }
+
+        if( err == ESP_OK )
+        {
+            err = uart_pattern_queue_reset( uart->port, ( int ) LWNODE_UART_EVENT_QUEUE_LEN );
+        }
+
+        if( err == ESP_OK )
+        {
+            result = true;
+        }
+        else
+        {
+            ( void ) lwnode_uart_deinit( uart );
+        }
+    }
+
+    return result;
+}
+
+bool lwnode_uart_deinit( LwnodeUart * const uart )
+{
+    bool result = false;
+
+    if( uart != NULL )
+    {
+        if( !uart->installed )
+        {
+            result = true;
+        }
+        else if( uart_driver_delete( uart->port ) == ESP_OK )
+        {
+            uart->installed = false;
+            uart->events = NULL;
+            uart->stageLen = 0U;
+            result = true;
+        }
+        else
+        {
+            /* Driver still installed */
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Queue command bytes for transmission.
+ *
+ * The module parses the command once CR LF arrives, so chunks are written
+ * back to back without any gap.
+ *
+ * @param[in] ctx   UART instance.
+ * @param[in] data  Command bytes.
+ * @param[in] len   Number of bytes.
+ * @param[in] final Unused; the command carries its own terminator.
+ *
+ * @retval true  All bytes were queued.
+ * @retval false The driver rejected the write.
+ */
+static bool lwnode_uart_write_at( void * const ctx,
+                                  const uint8_t * const data,
+                                  size_t len,
+                                  bool final )
+{
+    const LwnodeUart * const uart = ( const LwnodeUart * ) ctx;
+    bool result = false;
+
+    ( void ) final;
+
+    if( ( uart != NULL ) && uart->installed && ( data != NULL ) )
+    {
+        result = ( uart_write_bytes( uart->port, data, len ) == ( int ) len );
+    }
+
+    return result;
+}
+
+/**
+ * @brief Hand complete reply lines and frames to the driver.
+ *
+ * Only whole tokens that fit in buf are returned; a token that would be
+ * cut at cap stays staged for the next call. The driver's cap
+ * (LWNODE_AT_REPLY_MAX_LEN) holds a full stage, so it always progresses.
+ *
+ * @param[in,out] ctx    UART instance.
+ * @param[out]    buf    Destination buffer.
+ * @param[in]     cap    Capacity of buf in bytes.
+ * @param[out]    outLen Number of bytes returned.
+ *
+ * @retval true  Complete tokens were returned.
+ * @retval false Nothing complete that fits has arrived yet.
+ */
+static bool lwnode_uart_read_at( void * const ctx,
+                                 uint8_t * const buf,
+                                 size_t cap,
+                                 uint16_t * const outLen )
+{
+    LwnodeUart * const uart = ( LwnodeUart * ) ctx;
+    bool result = false;
+
+    if( ( uart != NULL ) && uart->installed && ( buf != NULL ) && ( outLen != NULL ) )
+    {
+        const uint16_t complete = lwnode_uart_stage( uart );
+        /* Re-frame within cap so the last token returned is never split */
+        const uint16_t n = ( ( size_t ) complete <= cap ) ?
+                           complete :
+                           at_response_complete_len( uart->stage, ( uint16_t ) cap );
+
+        *outLen = 0U;
+
+        if( n > 0U )
+        {
+            ( void ) memcpy( buf, uart->stage, n );
+            ( void ) memmove( uart->stage, &uart->stage[ n ], ( size_t ) ( uart->stageLen - n ) );
+            uart->stageLen = ( uint16_t ) ( uart->stageLen - n );
+            *outLen = n;
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Sleep on the UART event queue until a complete token is staged.
+ *
+ * @param[in,out] ctx       UART instance.
+ * @param[in]     timeoutMs Maximum time to wait in milliseconds.
+ *
+ * @retval true  A complete line or frame is ready for read_at().
+ * @retval false Timeout.
+ */
+static bool lwnode_uart_wait_rx( void * const ctx, uint32_t timeoutMs )
+{
+    LwnodeUart * const uart = ( LwnodeUart * ) ctx;
+    bool result = false;
+
+    if( ( uart != NULL ) && uart->installed )
+    {
+        const TickType_t startTick = xTaskGetTickCount();
+        const TickType_t waitTicks = pdMS_TO_TICKS( timeoutMs );
+        TickType_t elapsed = 0U;
+        uart_event_t event;
+
+        result = ( lwnode_uart_stage( uart ) > 0U );
+
+        while( ( !result ) && ( elapsed <= waitTicks ) &&
+               ( xQueueReceive( uart->events, &event, waitTicks - elapsed ) == pdTRUE ) )
+        {
+            switch( event.type )
+            {
+                case UART_PATTERN_DET:
+                    /* Positions are not needed, framing is redone on the bytes */
+                    ( void ) uart_pattern_pop_pos( uart->port );
+                    result = ( lwnode_uart_stage( uart ) > 0U );
+                    break;
+                case UART_DATA:
+                    /* RX timeout or FIFO threshold: frames may end without '\n' */
+                    result = ( lwnode_uart_stage( uart ) > 0U );
+                    break;
+                case UART_FIFO_OVF:
+                case UART_BUFFER_FULL:
+                    /* Bytes were lost; resynchronize on the next line */
+                    ( void ) uart_flush_input( uart->port );
+                    ( void ) xQueueReset( uart->events );
+                    uart->stageLen = 0U;
+                    break;
+                default:
+                    break;
+            }
+
+            elapsed = xTaskGetTickCount() - startTick;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Move buffered bytes from the driver into the stage.
+ *
+ * @param[in,out] uart UART instance.
+ *
+ * @return Length of the complete tokens at the start of the stage.
+ */
+static uint16_t lwnode_uart_stage( LwnodeUart * const uart )
+{
+    size_t buffered = 0U;
+    uint16_t complete = 0U;
+
+    if( ( uart_get_buffered_data_len( uart->port, &buffered ) == ESP_OK ) && ( buffered > 0U ) )
+    {
+        const size_t space = ( size_t ) ( LWNODE_UART_STAGE_LEN - uart->stageLen );
+        const size_t want = ( buffered <= space ) ? buffered : space;
+        const int got = uart_read_bytes( uart->port, &uart->stage[ uart->stageLen ], ( uint32_t ) want, 0 );
+
+        if( got > 0 )
+        {
+            uart->stageLen = ( uint16_t ) ( uart->stageLen + ( uint16_t ) got );
+        }
+    }
+
+    complete = at_response_complete_len( uart->stage, uart->stageLen );
+
+    /* A full stage without a token boundary is noise */
+    if( ( complete == 0U ) && ( uart->stageLen == LWNODE_UART_STAGE_LEN ) )
+    {
+        uart->stageLen = 0U;
+    }
+
+    return complete;
+}
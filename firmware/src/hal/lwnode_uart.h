@@ -0,0 +1,68 @@
+#ifndef SRC_HAL_LWNODE_UART_H
+#define SRC_HAL_LWNODE_UART_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include <driver/gpio.h>
+#include <driver/uart.h>
+
+#include "lib/lwnode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LWNODE_UART_STAGE_LEN    ( LWNODE_MAX_RX_BYTES - 1U )  /**< Bytes held until a token completes */
+
+typedef struct LwnodeUart
+{
+    /* Static configuration */
+    uart_port_t port;       /**< UART wired to the module */
+    gpio_num_t txPin;       /**< GPIO number used for TX */
+    gpio_num_t rxPin;       /**< GPIO number used for RX */
+    uint32_t baud;          /**< Line rate, 115200 on the DFR1115 */
+
+    /* Runtime-managed state */
+    QueueHandle_t events;                           /**< UART driver event queue */
+    uint8_t stage[ LWNODE_UART_STAGE_LEN ];         /**< Received bytes of an unfinished token */
+    uint16_t stageLen;                              /**< Bytes in stage */
+    bool installed;                                 /**< Driver installed */
+} LwnodeUart;
+
+/**
+ * @brief Transport callbacks for lwnode_set_transport(); context is an LwnodeUart.
+ *
+ * RX runs on the UART driver's interrupt-fed ring buffer with line pattern
+ * detection: the task sleeps until a '\n' or an RX timeout is reported and
+ * is handed only complete lines and "+RECV=" frames.
+ */
+extern const LwnodeTransport lwnodeUartTransport;
+
+/**
+ * @brief Install the UART driver and arm '\n' pattern detection.
+ *
+ * @param uart  Pointer to the UART configuration structure.
+ *
+ * @return true if the UART is ready, false otherwise.
+ */
+bool lwnode_uart_init( LwnodeUart * uart );
+
+/**
+ * @brief Remove the UART driver. Safe to call multiple times.
+ *
+ * @param uart  Pointer to the UART configuration structure.
+ *
+ * @return true if the driver is removed, false otherwise.
+ */
+bool lwnode_uart_deinit( LwnodeUart * uart );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_HAL_LWNODE_UART_H */
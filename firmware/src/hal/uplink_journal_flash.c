@@ -0,0 +1,103 @@
+#include "uplink_journal_flash.h"
+
+#include <stddef.h>
+
+#include <esp_err.h>
+
+static bool uplink_journal_flash_read( void * const ctx,
+                                       uint32_t offset,
+                                       void * const buf,
+                                       size_t len );
+static bool uplink_journal_flash_write( void * const ctx,
+                                        uint32_t offset,
+                                        const void * const data,
+                                        size_t len );
+static bool uplink_journal_flash_erase( void * const ctx,
+                                        uint32_t offset,
+                                        uint32_t len );
+
+const UplinkJournalFlash uplinkJournalPartitionFlash =
+{
+    .read = uplink_journal_flash_read,
+    .write = uplink_journal_flash_write,
+    .erase = uplink_journal_flash_erase
+};
+
+bool uplink_journal_flash_mount( UplinkJournal * const journal )
+{
+    bool result = false;
+    const esp_partition_t * const part = esp_partition_find_first( ESP_PARTITION_TYPE_DATA,
+                                                                   ESP_PARTITION_SUBTYPE_ANY,
+                                                                   UPLINK_JOURNAL_FLASH_LABEL );
+
+    if( ( journal != NULL ) && ( part != NULL ) && ( part->erase_size != 0U ) )
+    {
+        const uint32_t sectors = part->size / part->erase_size;
+
+        if( sectors <= UINT16_MAX )
+        {
+            result = uplink_journal_mount( journal,
+                                           &uplinkJournalPartitionFlash,
+                                           ( void * ) part,
+                                           part->erase_size,
+                                           ( uint16_t ) sectors );
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Read bytes from the partition.
+ *
+ * @param[in]  ctx    Partition.
+ * @param[in]  offset Offset in the partition.
+ * @param[out] buf    Destination buffer.
+ * @param[in]  len    Number of bytes.
+ *
+ * @retval true  Bytes were read.
+ * @retval false Driver error.
+ */
+static bool uplink_journal_flash_read( void * const ctx,
+                                       uint32_t offset,
+                                       void * const buf,
+                                       size_t len )
+{
+    return esp_partition_read( ( const esp_partition_t * ) ctx, offset, buf, len ) == ESP_OK;
+}
+
+/**
+ * @brief Program bytes into the partition.
+ *
+ * @param[in] ctx    Partition.
+ * @param[in] offset Offset in the partition.
+ * @param[in] data   Bytes to program.
+ * @param[in] len    Number of bytes.
+ *
+ * @retval true  Bytes were programmed.
+ * @retval false Driver error.
+ */
+static bool uplink_journal_flash_write( void * const ctx,
+                                        uint32_t offset,
+                                        const void * const data,
+                                        size_t len )
+{
+    return esp_partition_write( ( const esp_partition_t * ) ctx, offset, data, len ) == ESP_OK;
+}
+
+/**
+ * @brief Erase whole sectors of the partition.
+ *
+ * @param[in] ctx    Partition.
+ * @param[in] offset Sector-aligned offset in the partition.
+ * @param[in] len    Multiple of the sector size.
+ *
+ * @retval true  Sectors were erased.
+ * @retval false Driver error.
+ */
+static bool uplink_journal_flash_erase( void * const ctx,
+                                        uint32_t offset,
+                                        uint32_t len )
+{
+    return esp_partition_erase_range( ( const esp_partition_t * ) ctx, offset, len ) == ESP_OK;
+}
@@ -0,0 +1,35 @@
+#ifndef SRC_HAL_UPLINK_JOURNAL_FLASH_H
+#define SRC_HAL_UPLINK_JOURNAL_FLASH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <esp_partition.h>
+
+#include "lib/uplink_journal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UPLINK_JOURNAL_FLASH_LABEL    "storage"   /**< Partition holding the journal */
+
+/**
+ * @brief Flash callbacks for uplink_journal_mount(); context is an esp_partition_t.
+ */
+extern const UplinkJournalFlash uplinkJournalPartitionFlash;
+
+/**
+ * @brief Find the journal partition and mount the journal on all of it.
+ *
+ * @param journal  Pointer to the journal instance.
+ *
+ * @return true if the partition exists and the journal is mounted, false otherwise.
+ */
+bool uplink_journal_flash_mount( UplinkJournal * journal );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_HAL_UPLINK_JOURNAL_FLASH_H */
@@ -0,0 +1,323 @@
+#include "at_response.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define AT_RESPONSE_CR          ( ( uint8_t ) '\r' )
+#define AT_RESPONSE_LF          ( ( uint8_t ) '\n' )
+
+static bool at_response_has_prefix( const uint8_t * const data,
+                                    uint16_t len,
+                                    const char * const prefix );
+static bool at_response_has_suffix( const uint8_t * const data,
+                                    uint16_t len,
+                                    const char * const suffix );
+static bool at_response_is_urc( const uint8_t * const data, uint16_t left );
+static uint16_t at_response_urc_len( const uint8_t * const data, uint16_t left );
+static uint16_t at_response_text_len( const uint8_t * const data,
+                                      uint16_t left,
+                                      uint16_t * const span );
+static AtResponseKind at_response_classify( const uint8_t * const data, uint16_t len );
+
+bool at_response_init( AtResponseTokenizer * const tok,
+                       const uint8_t * const buf,
+                       uint16_t len )
+{
+    bool result = false;
+
+    if( ( tok != NULL ) && ( ( buf != NULL ) || ( len == 0U ) ) )
+    {
+        tok->buf = buf;
+        tok->len = len;
+        tok->pos = 0U;
+        result = true;
+    }
+
+    return result;
+}
+
+bool at_response_next( AtResponseTokenizer * const tok, AtResponseLine * const line )
+{
+    bool result = false;
+
+    if( ( tok != NULL ) && ( line != NULL ) )
+    {
+        while( ( !result ) && ( tok->pos < tok->len ) )
+        {
+            const uint8_t * const data = &tok->buf[ tok->pos ];
+            const uint16_t left = ( uint16_t ) ( tok->len - tok->pos );
+            uint16_t span = 0U;
+            uint16_t len = 0U;
+
+            if( at_response_is_urc( data, left ) )
+            {
+                len = at_response_urc_len( data, left );
+                span = len;
+
+                /* Frame terminator, if the module sent one */
+                if( ( ( uint16_t ) ( left - span ) >= 2U ) &&
+                    ( data[ span ] == AT_RESPONSE_CR ) && ( data[ span + 1U ] == AT_RESPONSE_LF ) )
+                {
+                    span = ( uint16_t ) ( span + 2U );
+                }
+            }
+            else
+            {
+                len = at_response_text_len( data, left, &span );
+            }
+
+            if( len > 0U )
+            {
+                line->data = data;
+                line->len = len;
+                line->offset = tok->pos;
+                line->span = span;
+                line->kind = at_response_classify( data, len );
+                result = true;
+            }
+
+            tok->pos = ( uint16_t ) ( tok->pos + span );
+        }
+    }
+
+    return result;
+}
+
+bool at_response_line_equals( const AtResponseLine * const line, const char * const expected )
+{
+    bool result = false;
+
+    if( ( line != NULL ) && ( expected != NULL ) )
+    {
+        size_t expectedLen = strlen( expected );
+
+        while( ( expectedLen > 0U ) &&
+               ( ( expected[ expectedLen - 1U ] == '\r' ) || ( expected[ expectedLen - 1U ] == '\n' ) ) )
+        {
+            expectedLen--;
+        }
+
+        result = ( expectedLen == ( size_t ) line->len ) &&
+                 ( memcmp( line->data, expected, expectedLen ) == 0 );
+    }
+
+    return result;
+}
+
+bool at_response_contains( const uint8_t * const buf, uint16_t len, const char * const expected )
+{
+    bool result = false;
+    AtResponseTokenizer tok = { 0 };
+    AtResponseLine line = { 0 };
+
+    if( ( expected != NULL ) && at_response_init( &tok, buf, len ) )
+    {
+        while( ( !result ) && at_response_next( &tok, &line ) )
+        {
+            result = ( line.kind != AT_RESPONSE_URC ) && at_response_line_equals( &line, expected );
+        }
+    }
+
+    return result;
+}
+
+uint16_t at_response_complete_len( const uint8_t * const buf, uint16_t len )
+{
+    uint16_t pos = 0U;
+    bool complete = ( buf != NULL );
+
+    while( complete && ( pos < len ) )
+    {
+        const uint8_t * const data = &buf[ pos ];
+        const uint16_t left = ( uint16_t ) ( len - pos );
+        const uint16_t headerEnd = ( uint16_t ) ( AT_RESPONSE_URC_PREFIX_LEN + AT_RESPONSE_URC_HEADER_LEN );
+        uint16_t span = 0U;
+
+        if( at_response_is_urc( data, left ) )
+        {
+            /* Header and payload must both be in */
+            complete = ( left >= headerEnd ) &&
+                       ( ( uint16_t ) ( headerEnd + ( uint16_t ) data[ headerEnd - 1U ] ) <= left );
+            span = complete ? at_response_urc_len( data, left ) : 0U;
+        }
+        else
+        {
+            ( void ) at_response_text_len( data, left, &span );
+            complete = ( data[ span - 1U ] == AT_RESPONSE_LF );
+        }
+
+        if( complete )
+        {
+            pos = ( uint16_t ) ( pos + span );
+        }
+    }
+
+    return pos;
+}
+
+/**
+ * @brief Check whether bytes start with a text prefix.
+ *
+ * @param[in] data   Bytes to check.
+ * @param[in] len    Number of bytes available.
+ * @param[in] prefix Null-terminated prefix.
+ *
+ * @retval true  data starts with prefix.
+ * @retval false Too short or different.
+ */
+static bool at_response_has_prefix( const uint8_t * const data,
+                                    uint16_t len,
+                                    const char * const prefix )
+{
+    const size_t prefixLen = strlen( prefix );
+
+    return ( ( size_t ) len >= prefixLen ) && ( memcmp( data, prefix, prefixLen ) == 0 );
+}
+
+/**
+ * @brief Check whether bytes end with a text suffix.
+ *
+ * @param[in] data   Bytes to check.
+ * @param[in] len    Number of bytes available.
+ * @param[in] suffix Null-terminated suffix.
+ *
+ * @retval true  data ends with suffix.
+ * @retval false Too short or different.
+ */
+static bool at_response_has_suffix( const uint8_t * const data,
+                                    uint16_t len,
+                                    const char * const suffix )
+{
+    const size_t suffixLen = strlen( suffix );
+
+    return ( ( size_t ) len >= suffixLen ) &&
+           ( memcmp( &data[ ( size_t ) len - suffixLen ], suffix, suffixLen ) == 0 );
+}
+
+/**
+ * @brief Tell a "+RECV=" downlink frame from the AT+RECV command's reply.
+ *
+ * Both start with the same prefix. The text replies ("+RECV=OK", "=ERROR",
+ * "=FAIL", "=0", "=1") are recognized by their terminated word; read as a
+ * frame header their SNR byte would be far outside what the radio reports.
+ *
+ * @param[in] data Bytes to check.
+ * @param[in] left Number of bytes available.
+ *
+ * @retval true  data starts with a downlink frame.
+ * @retval false No prefix, or a text reply.
+ */
+static bool at_response_is_urc( const uint8_t * const data, uint16_t left )
+{
+    static const char * const words[] = { "OK", "ERROR", "FAIL", "0", "1" };
+    bool result = at_response_has_prefix( data, left, AT_RESPONSE_URC_PREFIX );
+
+    for( size_t i = 0U; result && ( i < ( sizeof( words ) / sizeof( words[ 0 ] ) ) ); ++i )
+    {
+        const uint16_t wordEnd = ( uint16_t ) ( AT_RESPONSE_URC_PREFIX_LEN + strlen( words[ i ] ) );
+
+        if( at_response_has_prefix( &data[ AT_RESPONSE_URC_PREFIX_LEN ],
+                                    ( uint16_t ) ( left - AT_RESPONSE_URC_PREFIX_LEN ),
+                                    words[ i ] ) &&
+            ( ( wordEnd == left ) ||
+              ( data[ wordEnd ] == AT_RESPONSE_CR ) || ( data[ wordEnd ] == AT_RESPONSE_LF ) ) )
+        {
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Length of a "+RECV=" frame from its header.
+ *
+ * @param[in] data Frame bytes, starting at the prefix.
+ * @param[in] left Number of bytes available.
+ *
+ * @return Frame length without terminator, clamped to left if truncated.
+ */
+static uint16_t at_response_urc_len( const uint8_t * const data, uint16_t left )
+{
+    uint16_t len = left;
+    const uint16_t headerEnd = ( uint16_t ) ( AT_RESPONSE_URC_PREFIX_LEN + AT_RESPONSE_URC_HEADER_LEN );
+
+    if( left >= headerEnd )
+    {
+        const uint16_t frameLen = ( uint16_t ) ( headerEnd + ( uint16_t ) data[ headerEnd - 1U ] );
+
+        if( frameLen <= left )
+        {
+            len = frameLen;
+        }
+    }
+
+    return len;
+}
+
+/**
+ * @brief Length of a text line.
+ *
+ * @param[in]  data Line bytes.
+ * @param[in]  left Number of bytes available.
+ * @param[out] span Bytes consumed including CR LF or LF.
+ *
+ * @return Line length without terminator.
+ */
+static uint16_t at_response_text_len( const uint8_t * const data,
+                                      uint16_t left,
+                                      uint16_t * const span )
+{
+    uint16_t len = 0U;
+
+    while( ( len < left ) && ( data[ len ] != AT_RESPONSE_LF ) )
+    {
+        len++;
+    }
+
+    *span = ( len < left ) ? ( uint16_t ) ( len + 1U ) : len;
+
+    /* Drop the CR of a CR LF pair */
+    if( ( len > 0U ) && ( data[ len - 1U ] == AT_RESPONSE_CR ) )
+    {
+        len--;
+    }
+
+    return len;
+}
+
+/**
+ * @brief Classify a line.
+ *
+ * @param[in] data Line bytes without terminator.
+ * @param[in] len  Line length.
+ *
+ * @return Line kind.
+ */
+static AtResponseKind at_response_classify( const uint8_t * const data, uint16_t len )
+{
+    AtResponseKind kind = AT_RESPONSE_INFO;
+
+    if( at_response_is_urc( data, len ) )
+    {
+        kind = AT_RESPONSE_URC;
+    }
+    else if( ( ( len == 2U ) && at_response_has_prefix( data, len, "OK" ) ) ||
+             ( ( data[ 0 ] == ( uint8_t ) '+' ) && at_response_has_suffix( data, len, "=OK" ) ) )
+    {
+        kind = AT_RESPONSE_OK;
+    }
+    else if( ( ( len == 5U ) && at_response_has_prefix( data, len, "ERROR" ) ) ||
+             ( ( data[ 0 ] == ( uint8_t ) '+' ) &&
+               ( at_response_has_suffix( data, len, "=ERROR" ) ||
+                 at_response_has_suffix( data, len, "=FAIL" ) ) ) )
+    {
+        kind = AT_RESPONSE_ERROR;
+    }
+    else
+    {
+        /* Query value or banner */
+    }
+
+    return kind;
+}
@@ -0,0 +1,133 @@
+/******************************************************************************
+ * @file at_response.h
+ * @brief Line tokenizer for DFR1115 AT replies
+ *
+ * Splits the bytes read from the AT reply registers into lines and
+ * classifies each one as a final result code, an information line or an
+ * unsolicited "+RECV=" downlink frame. "+RECV=" frames carry binary
+ * metadata and payload that may contain CR/LF bytes, so they are delimited
+ * by their length byte rather than by the line terminator.
+ *
+ * The tokenizer never copies: lines point into the caller's buffer.
+ ******************************************************************************/
+
+#ifndef SRC_LIB_AT_RESPONSE_H
+#define SRC_LIB_AT_RESPONSE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup AtResponseConfig AT Response Constants */
+/** @{ */
+#define AT_RESPONSE_URC_PREFIX       "+RECV="    /**< Unsolicited downlink frame */
+#define AT_RESPONSE_URC_PREFIX_LEN   ( 6U )
+#define AT_RESPONSE_URC_HEADER_LEN   ( 3U )      /**< RSSI, SNR and payload length */
+/** @} */
+
+/**
+ * @enum AtResponseKind
+ * @brief Line classification
+ */
+typedef enum AtResponseKind
+{
+    AT_RESPONSE_OK = 0,     /**< "OK" or "+<CMD>=OK" */
+    AT_RESPONSE_ERROR,      /**< "ERROR", "+<CMD>=ERROR" or "+<CMD>=FAIL" */
+    AT_RESPONSE_INFO,       /**< Any other line, e.g. a query value */
+    AT_RESPONSE_URC         /**< Unsolicited "+RECV=" frame */
+} AtResponseKind;
+
+/**
+ * @struct AtResponseLine
+ * @brief One token of a reply
+ */
+typedef struct AtResponseLine
+{
+    const uint8_t * data;   /**< First byte of the line */
+    uint16_t len;           /**< Line length without the terminator */
+    uint16_t offset;        /**< Offset of the line in the buffer */
+    uint16_t span;          /**< Bytes consumed, terminator included */
+    AtResponseKind kind;    /**< Classification */
+} AtResponseLine;
+
+/**
+ * @struct AtResponseTokenizer
+ * @brief Tokenizer state over one reply buffer
+ */
+typedef struct AtResponseTokenizer
+{
+    const uint8_t * buf;    /**< Reply bytes */
+    uint16_t len;           /**< Reply length */
+    uint16_t pos;           /**< Offset of the next token */
+} AtResponseTokenizer;
+
+/**
+ * @brief Start tokenizing a reply buffer
+ *
+ * @param tok Pointer to tokenizer instance
+ * @param buf Reply bytes (may be NULL if len is 0)
+ * @param len Reply length in bytes
+ * @return true if initialized, false on invalid parameter
+ */
+bool at_response_init( AtResponseTokenizer * tok, const uint8_t * buf, uint16_t len );
+
+/**
+ * @brief Get the next non-empty line
+ *
+ * A line ends at CR LF, a lone LF or the end of the buffer. A "+RECV="
+ * frame spans its header and payload plus an optional CR LF; a frame cut
+ * short by the end of the buffer is returned as a URC with the bytes left.
+ *
+ * @param tok Pointer to tokenizer instance
+ * @param line Output line
+ * @return true if a line was produced, false at the end of the buffer
+ */
+bool at_response_next( AtResponseTokenizer * tok, AtResponseLine * line );
+
+/**
+ * @brief Compare a line against an expected reply
+ *
+ * A trailing CR LF in expected is ignored, so the literal ACK strings used
+ * by the driver (e.g. "+JOIN=OK\r\n") can be passed as they are.
+ *
+ * @param line Pointer to line
+ * @param expected Null-terminated expected reply
+ * @return true if the line equals the expected reply
+ */
+bool at_response_line_equals( const AtResponseLine * line, const char * expected );
+
+/**
+ * @brief Check whether a reply contains an expected line
+ *
+ * Information lines and result codes are searched in order; URCs are
+ * skipped, so a downlink that arrived during the transaction or an extra
+ * line before the result does not turn a good reply into a mismatch.
+ *
+ * @param buf Reply bytes
+ * @param len Reply length in bytes
+ * @param expected Null-terminated expected reply
+ * @return true if a non-URC line equals the expected reply
+ */
+bool at_response_contains( const uint8_t * buf, uint16_t len, const char * expected );
+
+/**
+ * @brief Length of the complete tokens at the start of a byte stream
+ *
+ * Stream transports receive replies in arbitrary pieces. Text lines count
+ * once their LF has arrived and "+RECV=" frames once the payload length in
+ * their header is covered; whatever follows is still in flight.
+ *
+ * @param buf Stream bytes
+ * @param len Number of bytes received
+ * @return Bytes that can be handed to the tokenizer without splitting a token
+ */
+uint16_t at_response_complete_len( const uint8_t * buf, uint16_t len );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_LIB_AT_RESPONSE_H */
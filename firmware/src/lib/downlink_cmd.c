@@ -0,0 +1,274 @@
+#include "downlink_cmd.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * @brief Decode and range-check the value of one command.
+ */
+typedef bool (*DownlinkCmdDecodeFn)( const uint8_t * value, DownlinkCmdEvent * event );
+
+/**
+ * @brief Wire format of one opcode.
+ */
+typedef struct DownlinkCmdDesc
+{
+    uint8_t len;                    /**< Exact value length in bytes */
+    DownlinkCmdDecodeFn decode;     /**< Value decoder, NULL if reserved */
+} DownlinkCmdDesc;
+
+static bool downlink_cmd_decode_level( const uint8_t * const value,
+                                       DownlinkCmdEvent * const event );
+static bool downlink_cmd_decode_thresholds( const uint8_t * const value,
+                                            DownlinkCmdEvent * const event );
+static bool downlink_cmd_decode_period( const uint8_t * const value,
+                                        DownlinkCmdEvent * const event );
+static bool downlink_cmd_decode_dr_hint( const uint8_t * const value,
+                                         DownlinkCmdEvent * const event );
+static bool downlink_cmd_decode_empty( const uint8_t * const value,
+                                       DownlinkCmdEvent * const event );
+static uint16_t downlink_cmd_read_u16( const uint8_t * const value );
+static void downlink_cmd_post( DownlinkCmdDispatcher * const dispatcher,
+                               const DownlinkCmdEvent * const event,
+                               uint8_t * const posted );
+
+static const DownlinkCmdDesc downlinkCmdTable[ DOWNLINK_CMD_OPCODE_COUNT ] =
+{
+    [ DOWNLINK_CMD_NONE ]              = { 0U, NULL },
+    [ DOWNLINK_CMD_SET_LIGHT_LEVEL ]   = { 1U, downlink_cmd_decode_level },
+    [ DOWNLINK_CMD_SET_THRESHOLDS ]    = { 4U, downlink_cmd_decode_thresholds },
+    [ DOWNLINK_CMD_SET_SAMPLE_PERIOD ] = { 2U, downlink_cmd_decode_period },
+    [ DOWNLINK_CMD_SET_UPLINK_PERIOD ] = { 2U, downlink_cmd_decode_period },
+    [ DOWNLINK_CMD_DR_HINT ]           = { 2U, downlink_cmd_decode_dr_hint },
+    [ DOWNLINK_CMD_REBOOT ]            = { 0U, downlink_cmd_decode_empty },
+};
+
+bool downlink_cmd_init( DownlinkCmdDispatcher * const dispatcher )
+{
+    bool result = false;
+
+    if( dispatcher != NULL )
+    {
+        ( void ) memset( dispatcher, 0, sizeof( *dispatcher ) );
+        result = true;
+    }
+
+    return result;
+}
+
+bool downlink_cmd_route( DownlinkCmdDispatcher * const dispatcher,
+                         DownlinkCmdOpcode opcode,
+                         DownlinkCmdPostFn post,
+                         void * const ctx )
+{
+    bool result = false;
+
+    if( ( dispatcher != NULL ) && ( opcode > DOWNLINK_CMD_NONE ) &&
+        ( opcode < DOWNLINK_CMD_OPCODE_COUNT ) )
+    {
+        dispatcher->routes[ opcode ].post = post;
+        dispatcher->routes[ opcode ].ctx = ( post != NULL ) ? ctx : NULL;
+        result = true;
+    }
+
+    return result;
+}
+
+uint8_t downlink_cmd_dispatch( DownlinkCmdDispatcher * const dispatcher,
+                               const uint8_t * const payload,
+                               uint8_t len )
+{
+    uint8_t posted = 0U;
+    uint8_t offset = 0U;
+
+    if( ( dispatcher != NULL ) && ( payload != NULL ) && ( len != 0U ) )
+    {
+        dispatcher->stats.frames++;
+
+        while( offset < len )
+        {
+            uint8_t remaining = ( uint8_t ) ( len - offset );
+
+            if( remaining < DOWNLINK_CMD_HEADER_LEN )
+            {
+                dispatcher->stats.truncated++;
+                break;
+            }
+
+            uint8_t opcode = payload[ offset ];
+            uint8_t valueLen = payload[ offset + 1U ];
+            const uint8_t * value = &payload[ offset + DOWNLINK_CMD_HEADER_LEN ];
+
+            if( valueLen > ( uint8_t ) ( remaining - DOWNLINK_CMD_HEADER_LEN ) )
+            {
+                dispatcher->stats.truncated++;
+                break;
+            }
+
+            offset = ( uint8_t ) ( offset + DOWNLINK_CMD_HEADER_LEN + valueLen );
+
+            if( ( opcode >= ( uint8_t ) DOWNLINK_CMD_OPCODE_COUNT ) ||
+                ( downlinkCmdTable[ opcode ].decode == NULL ) )
+            {
+                dispatcher->stats.unknown++;
+            }
+            else
+            {
+                DownlinkCmdEvent event;
+
+                ( void ) memset( &event, 0, sizeof( event ) );
+                event.opcode = ( DownlinkCmdOpcode ) opcode;
+
+                if( ( valueLen != downlinkCmdTable[ opcode ].len ) ||
+                    !downlinkCmdTable[ opcode ].decode( value, &event ) )
+                {
+                    dispatcher->stats.invalid++;
+                }
+                else
+                {
+                    downlink_cmd_post( dispatcher, &event, &posted );
+                }
+            }
+        }
+    }
+
+    return posted;
+}
+
+bool downlink_cmd_get_stats( const DownlinkCmdDispatcher * const dispatcher,
+                             DownlinkCmdStats * const out )
+{
+    bool result = false;
+
+    if( ( dispatcher != NULL ) && ( out != NULL ) )
+    {
+        *out = dispatcher->stats;
+        result = true;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Decode SET_LIGHT_LEVEL: one byte, 0-100 %.
+ *
+ * @param[in] value Command value.
+ * @param[in] event Event to fill.
+ *
+ * @return true if the level is in range.
+ */
+static bool downlink_cmd_decode_level( const uint8_t * const value,
+                                       DownlinkCmdEvent * const event )
+{
+    event->lightLevel = value[ 0 ];
+
+    return event->lightLevel <= DOWNLINK_CMD_MAX_LEVEL;
+}
+
+/**
+ * @brief Decode SET_THRESHOLDS: on then off lux x10, on below off.
+ *
+ * @param[in] value Command value.
+ * @param[in] event Event to fill.
+ *
+ * @return true if the thresholds leave a hysteresis band.
+ */
+static bool downlink_cmd_decode_thresholds( const uint8_t * const value,
+                                            DownlinkCmdEvent * const event )
+{
+    event->luxOnX10 = downlink_cmd_read_u16( &value[ 0 ] );
+    event->luxOffX10 = downlink_cmd_read_u16( &value[ 2 ] );
+
+    return event->luxOnX10 < event->luxOffX10;
+}
+
+/**
+ * @brief Decode SET_SAMPLE_PERIOD and SET_UPLINK_PERIOD: seconds, nonzero.
+ *
+ * @param[in] value Command value.
+ * @param[in] event Event to fill.
+ *
+ * @return true if the period is nonzero.
+ */
+static bool downlink_cmd_decode_period( const uint8_t * const value,
+                                        DownlinkCmdEvent * const event )
+{
+    event->periodS = downlink_cmd_read_u16( value );
+
+    return event->periodS != 0U;
+}
+
+/**
+ * @brief Decode DR_HINT: data rate index, then EIRP (0 keeps the current one).
+ *
+ * @param[in] value Command value.
+ * @param[in] event Event to fill.
+ *
+ * @return true if both are in range.
+ */
+static bool downlink_cmd_decode_dr_hint( const uint8_t * const value,
+                                         DownlinkCmdEvent * const event )
+{
+    event->dataRate = value[ 0 ];
+    event->eirp = value[ 1 ];
+
+    return ( event->dataRate <= DOWNLINK_CMD_MAX_DR ) &&
+           ( event->eirp <= DOWNLINK_CMD_MAX_EIRP );
+}
+
+/**
+ * @brief Decode a command without a value.
+ *
+ * @param[in] value Command value (unused).
+ * @param[in] event Event to fill (unused).
+ *
+ * @return true.
+ */
+static bool downlink_cmd_decode_empty( const uint8_t * const value,
+                                       DownlinkCmdEvent * const event )
+{
+    ( void ) value;
+    ( void ) event;
+
+    return true;
+}
+
+/**
+ * @brief Read a big-endian 16-bit value.
+ *
+ * @param[in] value First byte.
+ *
+ * @return Decoded value.
+ */
+static uint16_t downlink_cmd_read_u16( const uint8_t * const value )
+{
+    return ( uint16_t ) ( ( ( uint16_t ) value[ 0 ] << 8 ) | value[ 1 ] );
+}
+
+/**
+ * @brief Hand a decoded event to the route of its opcode.
+ *
+ * @param[in] dispatcher Pointer to dispatcher instance.
+ * @param[in] event      Decoded event.
+ * @param[in] posted     Count of accepted events, incremented on success.
+ */
+static void downlink_cmd_post( DownlinkCmdDispatcher * const dispatcher,
+                               const DownlinkCmdEvent * const event,
+                               uint8_t * const posted )
+{
+    const DownlinkCmdRoute * route = &dispatcher->routes[ event->opcode ];
+
+    if( route->post == NULL )
+    {
+        dispatcher->stats.unrouted++;
+    }
+    else if( route->post( route->ctx, event ) )
+    {
+        dispatcher->stats.posted++;
+        ( *posted )++;
+    }
+    else
+    {
+        dispatcher->stats.dropped++;
+    }
+}
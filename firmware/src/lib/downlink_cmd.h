@@ -0,0 +1,164 @@
+/******************************************************************************
+ * @file downlink_cmd.h
+ * @brief Binary downlink command decoder and dispatcher
+ *
+ * A downlink payload carries one or more commands back to back, each
+ * encoded as opcode (1 byte), value length (1 byte) and value (big-endian),
+ * see docs/lorawan/downlink-commands-v1.md. Every command is checked for
+ * its length and value range, turned into a typed event and posted to the
+ * route registered for its opcode, typically a wrapper around the owning
+ * task's queue. Opcodes index the decode and route tables directly, so
+ * dispatch costs the same for every command.
+ *
+ * Unknown opcodes are skipped by their length, so older firmware ignores
+ * commands it does not know and still applies the rest of the payload.
+ * The dispatcher is not thread-safe; the radio task owns it.
+ ******************************************************************************/
+
+#ifndef SRC_LIB_DOWNLINK_CMD_H
+#define SRC_LIB_DOWNLINK_CMD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup DownlinkCmdConfig Downlink Command Configuration Constants */
+/** @{ */
+#define DOWNLINK_CMD_HEADER_LEN     ( 2U )    /**< Opcode and length bytes */
+#define DOWNLINK_CMD_MAX_LEVEL      ( 100U )  /**< Highest light level in percent */
+#define DOWNLINK_CMD_MAX_DR         ( 15U )   /**< Highest data rate index */
+#define DOWNLINK_CMD_MAX_EIRP       ( 30U )   /**< Highest EIRP in dBm */
+/** @} */
+
+/**
+ * @enum DownlinkCmdOpcode
+ * @brief Command opcodes (first byte of each command)
+ */
+typedef enum
+{
+    DOWNLINK_CMD_NONE = 0,              /**< Reserved, never sent */
+    DOWNLINK_CMD_SET_LIGHT_LEVEL,       /**< Light level in percent, 1 byte */
+    DOWNLINK_CMD_SET_THRESHOLDS,        /**< Lux x10 to switch on and off, 2 x 2 bytes */
+    DOWNLINK_CMD_SET_SAMPLE_PERIOD,     /**< Sensor sampling period in seconds, 2 bytes */
+    DOWNLINK_CMD_SET_UPLINK_PERIOD,     /**< Telemetry uplink period in seconds, 2 bytes */
+    DOWNLINK_CMD_DR_HINT,               /**< Data rate and EIRP to use, 2 bytes */
+    DOWNLINK_CMD_REBOOT,                /**< Reboot request, no value */
+    DOWNLINK_CMD_OPCODE_COUNT           /**< Number of opcodes, not an opcode */
+} DownlinkCmdOpcode;
+
+/**
+ * @struct DownlinkCmdEvent
+ * @brief Decoded command, posted by value to its route
+ *
+ * Only the fields of the event's opcode are set; the others are zero.
+ */
+typedef struct DownlinkCmdEvent
+{
+    DownlinkCmdOpcode opcode;   /**< Command */
+    uint8_t lightLevel;         /**< SET_LIGHT_LEVEL: 0-100 % */
+    uint16_t luxOnX10;          /**< SET_THRESHOLDS: switch on below this lux x10 */
+    uint16_t luxOffX10;         /**< SET_THRESHOLDS: switch off above this lux x10 */
+    uint16_t periodS;           /**< SET_SAMPLE_PERIOD / SET_UPLINK_PERIOD: seconds */
+    uint8_t dataRate;           /**< DR_HINT: data rate index */
+    uint8_t eirp;               /**< DR_HINT: EIRP in dBm, 0 to keep the current one */
+} DownlinkCmdEvent;
+
+/**
+ * @brief Route callback, typically a non-blocking queue send
+ *
+ * @param ctx Context registered with the route
+ * @param event Decoded command (copy it; it is not valid after the call)
+ * @return true if the event was accepted, false if it was dropped
+ */
+typedef bool (*DownlinkCmdPostFn)( void * ctx, const DownlinkCmdEvent * event );
+
+/**
+ * @struct DownlinkCmdStats
+ * @brief Dispatcher counters
+ */
+typedef struct DownlinkCmdStats
+{
+    uint32_t frames;        /**< Payloads decoded */
+    uint32_t posted;        /**< Commands accepted by their route */
+    uint32_t unknown;       /**< Commands skipped for an unknown opcode */
+    uint32_t invalid;       /**< Commands with a bad length or value */
+    uint32_t truncated;     /**< Payloads that ended inside a command */
+    uint32_t unrouted;      /**< Valid commands with no route registered */
+    uint32_t dropped;       /**< Valid commands their route refused (queue full) */
+} DownlinkCmdStats;
+
+/**
+ * @struct DownlinkCmdRoute
+ * @brief Destination of one opcode
+ */
+typedef struct DownlinkCmdRoute
+{
+    DownlinkCmdPostFn post;     /**< Callback, NULL if unrouted */
+    void * ctx;                 /**< Callback context */
+} DownlinkCmdRoute;
+
+/**
+ * @struct DownlinkCmdDispatcher
+ * @brief Dispatcher instance
+ */
+typedef struct DownlinkCmdDispatcher
+{
+    DownlinkCmdRoute routes[ DOWNLINK_CMD_OPCODE_COUNT ];  /**< Route per opcode */
+    DownlinkCmdStats stats;                                 /**< Counters */
+} DownlinkCmdDispatcher;
+
+/**
+ * @brief Initialize a dispatcher with no routes
+ *
+ * @param dispatcher Pointer to dispatcher instance
+ * @return true if initialized, false on invalid parameter
+ */
+bool downlink_cmd_init( DownlinkCmdDispatcher * dispatcher );
+
+/**
+ * @brief Register where the events of an opcode are posted
+ *
+ * @param dispatcher Pointer to dispatcher instance
+ * @param opcode Command opcode
+ * @param post Callback, NULL to remove the route
+ * @param ctx Context passed to the callback
+ * @return true if registered, false on invalid parameter
+ */
+bool downlink_cmd_route( DownlinkCmdDispatcher * dispatcher,
+                         DownlinkCmdOpcode opcode,
+                         DownlinkCmdPostFn post,
+                         void * ctx );
+
+/**
+ * @brief Decode a downlink payload and post its commands
+ *
+ * Commands are posted in payload order. A bad command is counted and
+ * skipped; decoding stops only when the payload ends inside a command.
+ *
+ * @param dispatcher Pointer to dispatcher instance
+ * @param payload Downlink payload
+ * @param len Payload length in bytes
+ * @return Number of commands accepted by their routes
+ */
+uint8_t downlink_cmd_dispatch( DownlinkCmdDispatcher * dispatcher,
+                               const uint8_t * payload,
+                               uint8_t len );
+
+/**
+ * @brief Get dispatcher counters
+ *
+ * @param dispatcher Pointer to dispatcher instance
+ * @param out Output counters
+ * @return true if copied, false on invalid parameter
+ */
+bool downlink_cmd_get_stats( const DownlinkCmdDispatcher * dispatcher,
+                             DownlinkCmdStats * out );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_LIB_DOWNLINK_CMD_H */
@@ -0,0 +1,276 @@
+#include "link_quality.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define LINK_QUALITY_SF_MIN          ( 7U )
+#define LINK_QUALITY_SF_MAX          ( 12U )
+#define LINK_QUALITY_SF7_FLOOR_X10   ( -75 )   /* SX127x demodulation floor at SF7 */
+
+static void link_quality_sorted( const LinkQuality * const lq,
+                                 int8_t * const rssi,
+                                 int8_t * const snr );
+static void link_quality_sort( int8_t * const values, uint8_t count );
+static int8_t link_quality_rank( const int8_t * const sorted, uint8_t count, uint8_t pct );
+
+bool link_quality_init( LinkQuality * const lq )
+{
+    bool result = false;
+
+    if( lq != NULL )
+    {
+        ( void ) memset( lq, 0, sizeof( *lq ) );
+        result = true;
+    }
+
+    return result;
+}
+
+bool link_quality_add( LinkQuality * const lq, int8_t rssi, int8_t snr )
+{
+    bool result = false;
+
+    if( lq != NULL )
+    {
+        uint8_t slot = 0U;
+
+        if( lq->count < LINK_QUALITY_WINDOW )
+        {
+            slot = ( uint8_t ) ( ( lq->head + lq->count ) % LINK_QUALITY_WINDOW );
+            lq->count++;
+        }
+        else
+        {
+            /* Window full: overwrite the oldest sample */
+            slot = lq->head;
+            lq->head = ( uint8_t ) ( ( lq->head + 1U ) % LINK_QUALITY_WINDOW );
+        }
+
+        lq->samples[ slot ].rssi = rssi;
+        lq->samples[ slot ].snr = snr;
+        result = true;
+    }
+
+    return result;
+}
+
+bool link_quality_percentile( const LinkQuality * const lq,
+                              uint8_t pct,
+                              int8_t * const rssi,
+                              int8_t * const snr )
+{
+    bool result = false;
+
+    if( ( lq != NULL ) && ( lq->count > 0U ) && ( pct <= 100U ) )
+    {
+        int8_t rssiSorted[ LINK_QUALITY_WINDOW ];
+        int8_t snrSorted[ LINK_QUALITY_WINDOW ];
+
+        link_quality_sorted( lq, rssiSorted, snrSorted );
+
+        if( rssi != NULL )
+        {
+            *rssi = link_quality_rank( rssiSorted, lq->count, pct );
+        }
+
+        if( snr != NULL )
+        {
+            *snr = link_quality_rank( snrSorted, lq->count, pct );
+        }
+
+        result = true;
+    }
+
+    return result;
+}
+
+int16_t link_quality_snr_trend_x10( const LinkQuality * const lq )
+{
+    int16_t trend = 0;
+
+    if( ( lq != NULL ) && ( lq->count >= 2U ) )
+    {
+        const int32_t n = ( int32_t ) lq->count;
+        int32_t sumX = 0;
+        int32_t sumY = 0;
+        int32_t sumXY = 0;
+        int32_t sumXX = 0;
+
+        for( uint8_t i = 0U; i < lq->count; i++ )
+        {
+            const int32_t x = ( int32_t ) i;
+            const int32_t y = lq->samples[ ( lq->head + i ) % LINK_QUALITY_WINDOW ].snr;
+
+            sumX += x;
+            sumY += y;
+            sumXY += x * y;
+            sumXX += x * x;
+        }
+
+        /* n >= 2 with distinct x values: the denominator is positive */
+        trend = ( int16_t ) ( ( 10 * ( ( n * sumXY ) - ( sumX * sumY ) ) ) /
+                              ( ( n * sumXX ) - ( sumX * sumX ) ) );
+    }
+
+    return trend;
+}
+
+bool link_quality_summary( const LinkQuality * const lq, LinkQualitySummary * const out )
+{
+    bool result = false;
+
+    if( ( lq != NULL ) && ( out != NULL ) && ( lq->count > 0U ) )
+    {
+        int8_t rssiSorted[ LINK_QUALITY_WINDOW ];
+        int8_t snrSorted[ LINK_QUALITY_WINDOW ];
+
+        link_quality_sorted( lq, rssiSorted, snrSorted );
+
+        out->count = lq->count;
+        out->rssiP10 = link_quality_rank( rssiSorted, lq->count, 10U );
+        out->rssiP50 = link_quality_rank( rssiSorted, lq->count, 50U );
+        out->rssiP90 = link_quality_rank( rssiSorted, lq->count, 90U );
+        out->snrP10 = link_quality_rank( snrSorted, lq->count, 10U );
+        out->snrP50 = link_quality_rank( snrSorted, lq->count, 50U );
+        out->snrP90 = link_quality_rank( snrSorted, lq->count, 90U );
+        out->snrTrendX10 = link_quality_snr_trend_x10( lq );
+
+        result = true;
+    }
+
+    return result;
+}
+
+bool link_quality_advise( const LinkQuality * const lq,
+                          const LinkQualityLimits * const limits,
+                          uint8_t dataRate,
+                          uint8_t sf,
+                          uint8_t eirp,
+                          LinkQualityAdvice * const out )
+{
+    bool result = false;
+    int8_t snr = 0;
+
+    if( ( limits != NULL ) && ( out != NULL ) &&
+        ( sf >= LINK_QUALITY_SF_MIN ) && ( sf <= LINK_QUALITY_SF_MAX ) &&
+        ( lq != NULL ) && ( lq->count >= LINK_QUALITY_MIN_SAMPLES ) &&
+        link_quality_percentile( lq, LINK_QUALITY_DECISION_PCT, NULL, &snr ) )
+    {
+        const int32_t floorX10 = LINK_QUALITY_SF7_FLOOR_X10 -
+                                 ( ( int32_t ) ( sf - LINK_QUALITY_SF_MIN ) * LINK_QUALITY_DR_STEP_X10 );
+        const int32_t marginX10 = ( ( int32_t ) snr * 10 ) - floorX10 -
+                                  ( ( int32_t ) limits->marginDb * 10 );
+
+        out->action = LINK_QUALITY_HOLD;
+        out->dataRate = dataRate;
+        out->eirp = eirp;
+        out->marginX10 = ( int16_t ) marginX10;
+
+        if( ( marginX10 >= LINK_QUALITY_DR_STEP_X10 ) &&
+            ( link_quality_snr_trend_x10( lq ) >= LINK_QUALITY_FALLING_TREND_X10 ) )
+        {
+            /* Spend spare margin on airtime first, then on power */
+            if( dataRate < limits->maxDr )
+            {
+                out->action = LINK_QUALITY_FASTER_DR;
+                out->dataRate = ( uint8_t ) ( dataRate + 1U );
+            }
+            else if( eirp >= ( uint8_t ) ( limits->minEirp + LINK_QUALITY_EIRP_STEP_DB ) )
+            {
+                out->action = LINK_QUALITY_LOWER_EIRP;
+                out->eirp = ( uint8_t ) ( eirp - LINK_QUALITY_EIRP_STEP_DB );
+            }
+            else
+            {
+                /* Already fastest and quietest */
+            }
+        }
+        else if( marginX10 < 0 )
+        {
+            /* Recover with power first, airtime last */
+            if( eirp < limits->maxEirp )
+            {
+                out->action = LINK_QUALITY_RAISE_EIRP;
+                out->eirp = ( ( uint32_t ) eirp + LINK_QUALITY_EIRP_STEP_DB > limits->maxEirp ) ?
+                            limits->maxEirp : ( uint8_t ) ( eirp + LINK_QUALITY_EIRP_STEP_DB );
+            }
+            else if( dataRate > limits->minDr )
+            {
+                out->action = LINK_QUALITY_SLOWER_DR;
+                out->dataRate = ( uint8_t ) ( dataRate - 1U );
+            }
+            else
+            {
+                /* Already slowest and loudest */
+            }
+        }
+        else
+        {
+            /* Within the target margin */
+        }
+
+        result = true;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Copy the window into sorted RSSI and SNR arrays.
+ *
+ * @param[in]  lq   Estimator instance (non-empty).
+ * @param[out] rssi Sorted RSSI values, LINK_QUALITY_WINDOW entries.
+ * @param[out] snr  Sorted SNR values, LINK_QUALITY_WINDOW entries.
+ */
+static void link_quality_sorted( const LinkQuality * const lq,
+                                 int8_t * const rssi,
+                                 int8_t * const snr )
+{
+    for( uint8_t i = 0U; i < lq->count; i++ )
+    {
+        rssi[ i ] = lq->samples[ i ].rssi;
+        snr[ i ] = lq->samples[ i ].snr;
+    }
+
+    link_quality_sort( rssi, lq->count );
+    link_quality_sort( snr, lq->count );
+}
+
+/**
+ * @brief Insertion sort, ascending (the window is small).
+ *
+ * @param[in,out] values Values to sort.
+ * @param[in]     count  Number of values.
+ */
+static void link_quality_sort( int8_t * const values, uint8_t count )
+{
+    for( uint8_t i = 1U; i < count; i++ )
+    {
+        const int8_t v = values[ i ];
+        uint8_t j = i;
+
+        while( ( j > 0U ) && ( values[ j - 1U ] > v ) )
+        {
+            values[ j ] = values[ j - 1U ];
+            j--;
+        }
+
+        values[ j ] = v;
+    }
+}
+
+/**
+ * @brief Nearest-rank percentile of a sorted array.
+ *
+ * @param[in] sorted Ascending values.
+ * @param[in] count  Number of values (> 0).
+ * @param[in] pct    Percentile (0-100).
+ *
+ * @return Value at the percentile.
+ */
+static int8_t link_quality_rank( const int8_t * const sorted, uint8_t count, uint8_t pct )
+{
+    const uint32_t index = ( ( ( uint32_t ) pct * ( count - 1U ) ) + 50U ) / 100U;
+
+    return sorted[ index ];
+}
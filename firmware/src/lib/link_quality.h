@@ -0,0 +1,191 @@
+/******************************************************************************
+ * @file link_quality.h
+ * @brief Downlink RSSI/SNR history and node-side DR/EIRP advice
+ *
+ * Keeps a sliding window of the RSSI/SNR reported with each downlink and
+ * derives percentiles and an SNR trend from it. From the low SNR
+ * percentile and the demodulation floor of the current spreading factor,
+ * the estimator advises one DR or EIRP step at a time: strong links move
+ * to faster data rates (less airtime) and then to lower power, marginal
+ * links get more power and then slower data rates.
+ *
+ * Downlink SNR measured at the node stands in for the uplink SNR at the
+ * gateway; it is meant for when network ADR is off or slow to converge.
+ ******************************************************************************/
+
+#ifndef SRC_LIB_LINK_QUALITY_H
+#define SRC_LIB_LINK_QUALITY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup LinkQualityConfig Link Quality Configuration Constants */
+/** @{ */
+#define LINK_QUALITY_WINDOW             ( 16U )  /**< Samples kept in the history */
+#define LINK_QUALITY_MIN_SAMPLES        ( 8U )   /**< Samples needed before advising */
+#define LINK_QUALITY_DECISION_PCT       ( 10U )  /**< SNR percentile the advice is based on */
+#define LINK_QUALITY_DR_STEP_X10        ( 25 )   /**< SNR floor difference per SF step (0.1 dB) */
+#define LINK_QUALITY_EIRP_STEP_DB       ( 2U )   /**< EIRP change per advice step */
+#define LINK_QUALITY_FALLING_TREND_X10  ( -5 )   /**< SNR trend that blocks stepping up */
+/** @} */
+
+/**
+ * @struct LinkQualitySample
+ * @brief One downlink's link metrics
+ */
+typedef struct LinkQualitySample
+{
+    int8_t rssi;    /**< RSSI in dBm */
+    int8_t snr;     /**< SNR in dB */
+} LinkQualitySample;
+
+/**
+ * @struct LinkQuality
+ * @brief Estimator instance
+ */
+typedef struct LinkQuality
+{
+    LinkQualitySample samples[ LINK_QUALITY_WINDOW ]; /**< Ring buffer, oldest at head */
+    uint8_t head;   /**< Index of the oldest sample */
+    uint8_t count;  /**< Samples in the window */
+} LinkQuality;
+
+/**
+ * @struct LinkQualitySummary
+ * @brief Window statistics
+ */
+typedef struct LinkQualitySummary
+{
+    uint8_t count;          /**< Samples in the window */
+    int8_t rssiP10;         /**< 10th percentile RSSI in dBm */
+    int8_t rssiP50;         /**< Median RSSI in dBm */
+    int8_t rssiP90;         /**< 90th percentile RSSI in dBm */
+    int8_t snrP10;          /**< 10th percentile SNR in dB */
+    int8_t snrP50;          /**< Median SNR in dB */
+    int8_t snrP90;          /**< 90th percentile SNR in dB */
+    int16_t snrTrendX10;    /**< SNR slope in 0.1 dB per sample */
+} LinkQualitySummary;
+
+/**
+ * @struct LinkQualityLimits
+ * @brief Range the advice may move within
+ */
+typedef struct LinkQualityLimits
+{
+    uint8_t minDr;      /**< Slowest data rate allowed */
+    uint8_t maxDr;      /**< Fastest data rate allowed */
+    uint8_t minEirp;    /**< Lowest EIRP in dBm */
+    uint8_t maxEirp;    /**< Highest EIRP in dBm */
+    uint8_t marginDb;   /**< SNR margin to keep above the demodulation floor */
+} LinkQualityLimits;
+
+/**
+ * @enum LinkQualityAction
+ * @brief Advised change
+ */
+typedef enum LinkQualityAction
+{
+    LINK_QUALITY_HOLD = 0,      /**< Keep the current settings */
+    LINK_QUALITY_FASTER_DR,     /**< Step to the next faster data rate */
+    LINK_QUALITY_LOWER_EIRP,    /**< Lower EIRP by one step */
+    LINK_QUALITY_RAISE_EIRP,    /**< Raise EIRP by one step */
+    LINK_QUALITY_SLOWER_DR      /**< Step to the next slower data rate */
+} LinkQualityAction;
+
+/**
+ * @struct LinkQualityAdvice
+ * @brief Advised settings
+ */
+typedef struct LinkQualityAdvice
+{
+    LinkQualityAction action;   /**< Advised change */
+    uint8_t dataRate;           /**< Data rate after the change */
+    uint8_t eirp;               /**< EIRP after the change */
+    int16_t marginX10;          /**< SNR margin left over the target (0.1 dB) */
+} LinkQualityAdvice;
+
+/**
+ * @brief Initialize an estimator with an empty history
+ *
+ * @param lq Pointer to estimator instance
+ * @return true if initialized, false on invalid parameter
+ */
+bool link_quality_init( LinkQuality * lq );
+
+/**
+ * @brief Record one downlink's metrics
+ *
+ * The oldest sample is dropped once the window is full.
+ *
+ * @param lq Pointer to estimator instance
+ * @param rssi RSSI in dBm
+ * @param snr SNR in dB
+ * @return true if recorded, false on invalid parameter
+ */
+bool link_quality_add( LinkQuality * lq, int8_t rssi, int8_t snr );
+
+/**
+ * @brief Get a percentile of the window (nearest rank)
+ *
+ * @param lq Pointer to estimator instance
+ * @param pct Percentile (0-100)
+ * @param rssi Output RSSI percentile (may be NULL)
+ * @param snr Output SNR percentile (may be NULL)
+ * @return true if computed, false if empty or invalid
+ */
+bool link_quality_percentile( const LinkQuality * lq,
+                              uint8_t pct,
+                              int8_t * rssi,
+                              int8_t * snr );
+
+/**
+ * @brief Get the SNR trend over the window
+ *
+ * Least-squares slope of SNR against sample order.
+ *
+ * @param lq Pointer to estimator instance
+ * @return Slope in 0.1 dB per sample, 0 with fewer than two samples
+ */
+int16_t link_quality_snr_trend_x10( const LinkQuality * lq );
+
+/**
+ * @brief Get percentiles and trend in one call
+ *
+ * @param lq Pointer to estimator instance
+ * @param out Output summary
+ * @return true if computed, false if empty or invalid
+ */
+bool link_quality_summary( const LinkQuality * lq, LinkQualitySummary * out );
+
+/**
+ * @brief Advise the next DR/EIRP step
+ *
+ * Each data rate step is assumed to change the spreading factor by one,
+ * which holds for the 125 kHz uplink data rates of all supported regions.
+ * Stepping up is held back while the SNR trend is falling.
+ *
+ * @param lq Pointer to estimator instance
+ * @param limits Allowed range and target margin
+ * @param dataRate Current data rate
+ * @param sf Spreading factor of the current data rate (7-12)
+ * @param eirp Current EIRP in dBm
+ * @param out Output advice (HOLD with the current settings if no change)
+ * @return true if enough samples to advise, false otherwise or on invalid
+ *         parameter
+ */
+bool link_quality_advise( const LinkQuality * lq,
+                          const LinkQualityLimits * limits,
+                          uint8_t dataRate,
+                          uint8_t sf,
+                          uint8_t eirp,
+                          LinkQualityAdvice * out );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_LIB_LINK_QUALITY_H */
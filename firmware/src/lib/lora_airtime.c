@@ -0,0 +1,355 @@
+#include "lora_airtime.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define LORA_AIRTIME_US_PER_S           ( 1000000ULL )
+#define LORA_AIRTIME_US_PER_MS          ( 1000U )
+#define LORA_AIRTIME_BW_125K            ( 125000U )
+#define LORA_AIRTIME_BW_250K            ( 250000U )
+#define LORA_AIRTIME_BW_500K            ( 500000U )
+#define LORA_AIRTIME_CR                 ( 1U )      /* 4/5 */
+#define LORA_AIRTIME_CRC_ON             ( 1U )
+#define LORA_AIRTIME_LDRO_MIN_SF        ( 11U )     /* Low data rate optimization at 125 kHz */
+#define LORA_AIRTIME_MAX_BUCKET_MS      ( UINT32_MAX / LORA_AIRTIME_US_PER_MS )
+
+static const LoraDrParams euDrTable[] =
+{
+    { 12U, LORA_AIRTIME_BW_125K, 51U },     /* DR0 */
+    { 11U, LORA_AIRTIME_BW_125K, 51U },     /* DR1 */
+    { 10U, LORA_AIRTIME_BW_125K, 51U },     /* DR2 */
+    {  9U, LORA_AIRTIME_BW_125K, 115U },    /* DR3 */
+    {  8U, LORA_AIRTIME_BW_125K, 222U },    /* DR4 */
+    {  7U, LORA_AIRTIME_BW_125K, 222U },    /* DR5 */
+    {  7U, LORA_AIRTIME_BW_250K, 222U }     /* DR6 */
+};
+
+static const LoraDrParams usDrTable[] =
+{
+    { 10U, LORA_AIRTIME_BW_125K, 11U },     /* DR0 */
+    {  9U, LORA_AIRTIME_BW_125K, 53U },     /* DR1 */
+    {  8U, LORA_AIRTIME_BW_125K, 125U },    /* DR2 */
+    {  7U, LORA_AIRTIME_BW_125K, 242U },    /* DR3 */
+    {  8U, LORA_AIRTIME_BW_500K, 242U }     /* DR4 */
+};
+
+static const LoraDrParams cnDrTable[] =
+{
+    { 12U, LORA_AIRTIME_BW_125K, 51U },     /* DR0 */
+    { 11U, LORA_AIRTIME_BW_125K, 51U },     /* DR1 */
+    { 10U, LORA_AIRTIME_BW_125K, 51U },     /* DR2 */
+    {  9U, LORA_AIRTIME_BW_125K, 115U },    /* DR3 */
+    {  8U, LORA_AIRTIME_BW_125K, 222U },    /* DR4 */
+    {  7U, LORA_AIRTIME_BW_125K, 222U }     /* DR5 */
+};
+
+static void lora_airtime_bucket_init( LoraAirtimeBucket * const bucket,
+                                      uint32_t capacityUs,
+                                      uint32_t windowMs,
+                                      uint32_t nowMs );
+static void lora_airtime_bucket_refill( LoraAirtimeBucket * const bucket,
+                                        uint32_t nowMs );
+static uint32_t lora_airtime_bucket_wait_ms( const LoraAirtimeBucket * const bucket,
+                                             uint32_t airtimeUs );
+
+bool lora_airtime_dr_params( LwnodeRegion region,
+                             uint8_t dataRate,
+                             LoraDrParams * const out )
+{
+    bool result = false;
+    const LoraDrParams * table = NULL;
+    size_t count = 0U;
+
+    switch( region )
+    {
+        case LWNODE_REGION_EU868:
+            table = euDrTable;
+            count = sizeof( euDrTable ) / sizeof( euDrTable[ 0 ] );
+            break;
+        case LWNODE_REGION_US915:
+            table = usDrTable;
+            count = sizeof( usDrTable ) / sizeof( usDrTable[ 0 ] );
+            break;
+        case LWNODE_REGION_CN470:
+            table = cnDrTable;
+            count = sizeof( cnDrTable ) / sizeof( cnDrTable[ 0 ] );
+            break;
+        default:
+            /* Unknown region */
+            break;
+    }
+
+    if( ( out != NULL ) && ( table != NULL ) && ( dataRate < count ) )
+    {
+        *out = table[ dataRate ];
+        result = true;
+    }
+
+    return result;
+}
+
+uint32_t lora_airtime_frame_us( const LoraDrParams * const params, uint16_t phyLen )
+{
+    uint32_t airtimeUs = 0U;
+
+    if( ( params != NULL ) && ( params->sf >= 7U ) && ( params->sf <= 12U ) &&
+        ( params->bwHz != 0U ) )
+    {
+        const uint32_t sf = ( uint32_t ) params->sf;
+        const uint32_t de = ( ( sf >= LORA_AIRTIME_LDRO_MIN_SF ) &&
+                              ( params->bwHz == LORA_AIRTIME_BW_125K ) ) ? 1U : 0U;
+        const uint64_t symbolUs = ( ( 1ULL << sf ) * LORA_AIRTIME_US_PER_S ) / params->bwHz;
+
+        /* Semtech AN1200.13, explicit header (H = 0) */
+        const int32_t num = ( 8 * ( int32_t ) phyLen ) - ( 4 * ( int32_t ) sf ) + 28 +
+                            ( 16 * ( int32_t ) LORA_AIRTIME_CRC_ON );
+        const int32_t den = 4 * ( ( int32_t ) sf - ( 2 * ( int32_t ) de ) );
+        uint64_t payloadSymbols = 8U;
+
+        if( num > 0 )
+        {
+            const uint32_t blocks = ( uint32_t ) ( ( num + den - 1 ) / den );
+            payloadSymbols += ( uint64_t ) blocks * ( LORA_AIRTIME_CR + 4U );
+        }
+
+        /* Preamble is (n + 4.25) symbols, kept in quarter symbols */
+        const uint64_t preambleQuarters = ( 4U * LORA_AIRTIME_PREAMBLE_SYMBOLS ) + 17U;
+        const uint64_t totalUs = ( ( preambleQuarters * symbolUs ) / 4U ) +
+                                 ( payloadSymbols * symbolUs );
+
+        airtimeUs = ( totalUs > UINT32_MAX ) ? UINT32_MAX : ( uint32_t ) totalUs;
+    }
+
+    return airtimeUs;
+}
+
+uint32_t lora_airtime_uplink_us( LwnodeRegion region,
+                                 uint8_t dataRate,
+                                 uint8_t payloadLen )
+{
+    uint32_t airtimeUs = 0U;
+    LoraDrParams params = { 0 };
+
+    if( lora_airtime_dr_params( region, dataRate, &params ) )
+    {
+        airtimeUs = lora_airtime_frame_us( &params,
+                                           ( uint16_t ) ( payloadLen + LORA_AIRTIME_FRAME_OVERHEAD ) );
+    }
+
+    return airtimeUs;
+}
+
+bool lora_airtime_budget_init( LoraAirtimeBudget * const budget,
+                               LwnodeRegion region,
+                               uint32_t fairUseMsPerDay,
+                               uint32_t nowMs )
+{
+    bool result = false;
+
+    if( budget != NULL )
+    {
+        uint32_t dutyUs = 0U;
+        const uint32_t fairUseMs = ( fairUseMsPerDay > LORA_AIRTIME_MAX_BUCKET_MS ) ?
+                                   LORA_AIRTIME_MAX_BUCKET_MS : fairUseMsPerDay;
+
+        ( void ) memset( budget, 0, sizeof( *budget ) );
+
+        if( region == LWNODE_REGION_EU868 )
+        {
+            dutyUs = ( LORA_AIRTIME_DUTY_WINDOW_MS / 1000U ) * LORA_AIRTIME_EU868_DUTY_PERMILLE *
+                     LORA_AIRTIME_US_PER_MS;
+        }
+        else if( region == LWNODE_REGION_US915 )
+        {
+            budget->maxDwellUs = LORA_AIRTIME_US915_DWELL_US;
+        }
+        else
+        {
+            /* No regulatory airtime limit modelled */
+        }
+
+        lora_airtime_bucket_init( &budget->duty, dutyUs,
+                                  LORA_AIRTIME_DUTY_WINDOW_MS, nowMs );
+        lora_airtime_bucket_init( &budget->fairUse, fairUseMs * LORA_AIRTIME_US_PER_MS,
+                                  LORA_AIRTIME_FAIR_USE_WINDOW_MS, nowMs );
+        result = true;
+    }
+
+    return result;
+}
+
+LoraAirtimeVerdict lora_airtime_budget_check( LoraAirtimeBudget * const budget,
+                                              uint32_t airtimeUs,
+                                              uint32_t nowMs,
+                                              uint32_t * const waitMs )
+{
+    LoraAirtimeVerdict verdict = LORA_AIRTIME_DWELL;
+    uint32_t wait = 0U;
+
+    if( budget != NULL )
+    {
+        lora_airtime_bucket_refill( &budget->duty, nowMs );
+        lora_airtime_bucket_refill( &budget->fairUse, nowMs );
+
+        if( ( ( budget->maxDwellUs != 0U ) && ( airtimeUs > budget->maxDwellUs ) ) ||
+            ( ( budget->duty.capacityUs != 0U ) && ( airtimeUs > budget->duty.capacityUs ) ) ||
+            ( ( budget->fairUse.capacityUs != 0U ) && ( airtimeUs > budget->fairUse.capacityUs ) ) )
+        {
+            /* Cannot fit even with a full budget */
+        }
+        else
+        {
+            const uint32_t dutyWait = lora_airtime_bucket_wait_ms( &budget->duty, airtimeUs );
+            const uint32_t fairWait = lora_airtime_bucket_wait_ms( &budget->fairUse, airtimeUs );
+
+            wait = ( dutyWait > fairWait ) ? dutyWait : fairWait;
+            verdict = ( wait == 0U ) ? LORA_AIRTIME_OK : LORA_AIRTIME_WAIT;
+        }
+    }
+
+    if( waitMs != NULL )
+    {
+        *waitMs = wait;
+    }
+
+    return verdict;
+}
+
+void lora_airtime_budget_consume( LoraAirtimeBudget * const budget,
+                                  uint32_t airtimeUs,
+                                  uint32_t nowMs )
+{
+    if( budget != NULL )
+    {
+        LoraAirtimeBucket * const buckets[] = { &budget->duty, &budget->fairUse };
+
+        for( size_t i = 0U; i < ( sizeof( buckets ) / sizeof( buckets[ 0 ] ) ); ++i )
+        {
+            LoraAirtimeBucket * const bucket = buckets[ i ];
+
+            lora_airtime_bucket_refill( bucket, nowMs );
+            bucket->levelUs = ( bucket->levelUs > airtimeUs ) ?
+                              ( bucket->levelUs - airtimeUs ) : 0U;
+        }
+
+        budget->consumedMs += ( airtimeUs + ( LORA_AIRTIME_US_PER_MS / 2U ) ) / LORA_AIRTIME_US_PER_MS;
+    }
+}
+
+uint32_t lora_airtime_budget_remaining_ms( LoraAirtimeBudget * const budget,
+                                           uint32_t nowMs )
+{
+    uint32_t remainingMs = UINT32_MAX;
+
+    if( budget != NULL )
+    {
+        const LoraAirtimeBucket * const buckets[] = { &budget->duty, &budget->fairUse };
+
+        lora_airtime_bucket_refill( &budget->duty, nowMs );
+        lora_airtime_bucket_refill( &budget->fairUse, nowMs );
+
+        for( size_t i = 0U; i < ( sizeof( buckets ) / sizeof( buckets[ 0 ] ) ); ++i )
+        {
+            if( buckets[ i ]->capacityUs != 0U )
+            {
+                const uint32_t levelMs = buckets[ i ]->levelUs / LORA_AIRTIME_US_PER_MS;
+
+                if( levelMs < remainingMs )
+                {
+                    remainingMs = levelMs;
+                }
+            }
+        }
+    }
+
+    return remainingMs;
+}
+
+/**
+ * @brief Set up a full bucket.
+ *
+ * @param[out] bucket     Bucket instance.
+ * @param[in]  capacityUs Allowance per window (0 = unlimited).
+ * @param[in]  windowMs   Refill window.
+ * @param[in]  nowMs      Current time in milliseconds.
+ */
+static void lora_airtime_bucket_init( LoraAirtimeBucket * const bucket,
+                                      uint32_t capacityUs,
+                                      uint32_t windowMs,
+                                      uint32_t nowMs )
+{
+    bucket->capacityUs = capacityUs;
+    bucket->windowMs = windowMs;
+    bucket->levelUs = capacityUs;
+    bucket->refillRemainder = 0U;
+    bucket->lastMs = nowMs;
+}
+
+/**
+ * @brief Add the allowance accrued since the last refill.
+ *
+ * The fractional part of each refill is carried over so slow rates (e.g.
+ * 30 s per day) do not round down to zero.
+ *
+ * @param[in,out] bucket Bucket instance.
+ * @param[in]     nowMs  Current time in milliseconds.
+ */
+static void lora_airtime_bucket_refill( LoraAirtimeBucket * const bucket,
+                                        uint32_t nowMs )
+{
+    const uint32_t elapsedMs = nowMs - bucket->lastMs;
+
+    bucket->lastMs = nowMs;
+
+    if( bucket->capacityUs != 0U )
+    {
+        if( elapsedMs >= bucket->windowMs )
+        {
+            bucket->levelUs = bucket->capacityUs;
+            bucket->refillRemainder = 0U;
+        }
+        else
+        {
+            const uint64_t accrued = ( ( uint64_t ) elapsedMs * bucket->capacityUs ) +
+                                     bucket->refillRemainder;
+            const uint64_t addUs = accrued / bucket->windowMs;
+            const uint64_t levelUs = ( uint64_t ) bucket->levelUs + addUs;
+
+            bucket->refillRemainder = ( uint32_t ) ( accrued % bucket->windowMs );
+
+            if( levelUs >= bucket->capacityUs )
+            {
+                bucket->levelUs = bucket->capacityUs;
+                bucket->refillRemainder = 0U;
+            }
+            else
+            {
+                bucket->levelUs = ( uint32_t ) levelUs;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Time until a bucket holds enough airtime.
+ *
+ * @param[in] bucket    Refilled bucket instance.
+ * @param[in] airtimeUs Airtime required.
+ *
+ * @return Wait in milliseconds, 0 if it fits now or the bucket is unlimited.
+ */
+static uint32_t lora_airtime_bucket_wait_ms( const LoraAirtimeBucket * const bucket,
+                                             uint32_t airtimeUs )
+{
+    uint32_t waitMs = 0U;
+
+    if( ( bucket->capacityUs != 0U ) && ( bucket->levelUs < airtimeUs ) )
+    {
+        const uint64_t deficit = ( ( uint64_t ) ( airtimeUs - bucket->levelUs ) *
+                                   bucket->windowMs ) - bucket->refillRemainder;
+
+        waitMs = ( uint32_t ) ( ( deficit + bucket->capacityUs - 1U ) / bucket->capacityUs );
+    }
+
+    return waitMs;
+}
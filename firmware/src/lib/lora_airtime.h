@@ -0,0 +1,175 @@
+/******************************************************************************
+ * @file lora_airtime.h
+ * @brief LoRaWAN time-on-air model and airtime budget
+ *
+ * Computes the airtime of an uplink from the region's data rate table
+ * (spreading factor, bandwidth, coding rate 4/5, 8-symbol preamble,
+ * explicit header, CRC on) and tracks it against the regulatory duty-cycle
+ * limit, the per-transmission dwell time limit and an optional fair-use
+ * budget, so uplinks are only released when the budget allows it.
+ *
+ * Budgets are token buckets that refill continuously; they start full.
+ * The module is not thread-safe; the owner serializes access.
+ ******************************************************************************/
+
+#ifndef SRC_LIB_LORA_AIRTIME_H
+#define SRC_LIB_LORA_AIRTIME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lib/lwnode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup LoraAirtimeConfig LoRa Airtime Configuration Constants */
+/** @{ */
+#define LORA_AIRTIME_FRAME_OVERHEAD       ( 13U )       /**< MHDR + FHDR (no FOpts) + FPort + MIC */
+#define LORA_AIRTIME_PREAMBLE_SYMBOLS     ( 8U )        /**< LoRaWAN preamble length */
+#define LORA_AIRTIME_DUTY_WINDOW_MS       ( 3600000U )  /**< Duty-cycle averaging window (1 h) */
+#define LORA_AIRTIME_FAIR_USE_WINDOW_MS   ( 86400000U ) /**< Fair-use window (24 h) */
+#define LORA_AIRTIME_EU868_DUTY_PERMILLE  ( 10U )       /**< 1 % duty cycle (g1 sub-band) */
+#define LORA_AIRTIME_US915_DWELL_US       ( 400000U )   /**< FCC 400 ms dwell time */
+/** @} */
+
+/**
+ * @struct LoraDrParams
+ * @brief Modulation parameters of one data rate
+ */
+typedef struct LoraDrParams
+{
+    uint8_t sf;               /**< Spreading factor (7-12) */
+    uint32_t bwHz;            /**< Bandwidth in Hz */
+    uint8_t maxPayload;       /**< Maximum application payload (N) in bytes */
+} LoraDrParams;
+
+/**
+ * @enum LoraAirtimeVerdict
+ * @brief Result of a budget check
+ */
+typedef enum
+{
+    LORA_AIRTIME_OK = 0,      /**< Uplink fits in the budget */
+    LORA_AIRTIME_WAIT,        /**< Budget short; retry after the reported wait */
+    LORA_AIRTIME_DWELL        /**< Never fits: exceeds the dwell time or a whole budget window */
+} LoraAirtimeVerdict;
+
+/**
+ * @struct LoraAirtimeBucket
+ * @brief Continuously refilling airtime allowance
+ */
+typedef struct LoraAirtimeBucket
+{
+    uint32_t capacityUs;      /**< Allowance per window (0 = unlimited) */
+    uint32_t windowMs;        /**< Window the allowance refills over */
+    uint32_t levelUs;         /**< Airtime currently available */
+    uint32_t refillRemainder; /**< Sub-microsecond refill carry */
+    uint32_t lastMs;          /**< Timestamp of the last refill */
+} LoraAirtimeBucket;
+
+/**
+ * @struct LoraAirtimeBudget
+ * @brief Regional airtime limits and usage
+ */
+typedef struct LoraAirtimeBudget
+{
+    LoraAirtimeBucket duty;     /**< Regulatory duty cycle */
+    LoraAirtimeBucket fairUse;  /**< Network fair-use policy */
+    uint32_t maxDwellUs;        /**< Per-transmission limit (0 = none) */
+    uint32_t consumedMs;        /**< Total airtime consumed */
+} LoraAirtimeBudget;
+
+/**
+ * @brief Look up the modulation parameters of a region's uplink data rate
+ *
+ * @param region LoRaWAN region
+ * @param dataRate Uplink data rate index
+ * @param out Output parameters
+ * @return true if found, false for unknown region/DR or invalid parameter
+ */
+bool lora_airtime_dr_params( LwnodeRegion region,
+                             uint8_t dataRate,
+                             LoraDrParams * out );
+
+/**
+ * @brief Compute the time on air of a LoRa frame
+ *
+ * @param params Modulation parameters
+ * @param phyLen PHY payload length in bytes
+ * @return Airtime in microseconds, 0 on invalid parameter
+ */
+uint32_t lora_airtime_frame_us( const LoraDrParams * params, uint16_t phyLen );
+
+/**
+ * @brief Compute the time on air of an uplink
+ *
+ * Adds LORA_AIRTIME_FRAME_OVERHEAD to the application payload.
+ *
+ * @param region LoRaWAN region
+ * @param dataRate Uplink data rate index
+ * @param payloadLen Application payload length in bytes
+ * @return Airtime in microseconds, 0 for unknown region/DR
+ */
+uint32_t lora_airtime_uplink_us( LwnodeRegion region,
+                                 uint8_t dataRate,
+                                 uint8_t payloadLen );
+
+/**
+ * @brief Initialize an airtime budget for a region
+ *
+ * EU868 gets a 1 % duty cycle averaged over one hour, US915 a 400 ms dwell
+ * limit; CN470 has no regulatory budget here.
+ *
+ * @param budget Budget instance
+ * @param region LoRaWAN region
+ * @param fairUseMsPerDay Network fair-use allowance per 24 h (0 = none)
+ * @param nowMs Current time in milliseconds
+ * @return true if initialized, false on invalid parameter
+ */
+bool lora_airtime_budget_init( LoraAirtimeBudget * budget,
+                               LwnodeRegion region,
+                               uint32_t fairUseMsPerDay,
+                               uint32_t nowMs );
+
+/**
+ * @brief Check whether an uplink fits in the budget
+ *
+ * @param budget Budget instance
+ * @param airtimeUs Airtime of the uplink
+ * @param nowMs Current time in milliseconds
+ * @param waitMs Output: time until it fits (LORA_AIRTIME_WAIT only, optional)
+ * @return Verdict; LORA_AIRTIME_DWELL on invalid parameter
+ */
+LoraAirtimeVerdict lora_airtime_budget_check( LoraAirtimeBudget * budget,
+                                              uint32_t airtimeUs,
+                                              uint32_t nowMs,
+                                              uint32_t * waitMs );
+
+/**
+ * @brief Charge a transmitted uplink to the budget
+ *
+ * @param budget Budget instance
+ * @param airtimeUs Airtime of the uplink
+ * @param nowMs Current time in milliseconds
+ */
+void lora_airtime_budget_consume( LoraAirtimeBudget * budget,
+                                  uint32_t airtimeUs,
+                                  uint32_t nowMs );
+
+/**
+ * @brief Get the airtime currently available
+ *
+ * @param budget Budget instance
+ * @param nowMs Current time in milliseconds
+ * @return Remaining airtime in milliseconds (UINT32_MAX if unlimited)
+ */
+uint32_t lora_airtime_budget_remaining_ms( LoraAirtimeBudget * budget,
+                                           uint32_t nowMs );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_LIB_LORA_AIRTIME_H */
@@ -3,6 +3,8 @@
 #include <stddef.h>
 #include <string.h>
 
+#include "at_response.h"
+
 #include "utils/num_fmt.h"
 #include "utils/str_ext.h"
 #include "hal/lwnode.h"
@@ -17,72 +19,34 @@
 #define REG_READ_DATA_LEN 			       ( 0x47U )
 #define REG_READ_NEXT_DATA 			       ( 0x48U )
 
-#define LWNODE_AT_POST_WRITE_DELAY_MS      ( 800U )
-#define LWNODE_AT_ACK_POLL_DELAY_MS        ( 1U )
-#define LWNODE_AT_ACK_TIMEOUT_LOOPS        ( 250U )
+#define LWNODE_AT_ACK_POLL_MIN_MS          ( 2U )
+#define LWNODE_AT_ACK_POLL_MAX_MS          ( 50U )
+#define LWNODE_AT_ACK_SHORT_TIMEOUT_MS     ( 1500U )   /* AT, queries, setters */
+#define LWNODE_AT_ACK_LONG_TIMEOUT_MS      ( 10000U )  /* AT+JOIN, AT+SEND */
 #define LWNODE_BEGIN_RETRY_COUNT           ( 100U )
 
-#define LWNODE_APP_EUI_PREFIX              "AT+JOINEUI="
-#define LWNODE_APP_EUI_PREFIX_LEN          ( sizeof( LWNODE_APP_EUI_PREFIX ) - 1U )
-#define LWNODE_APP_EUI_CMD_LEN \
-    ( sizeof( LWNODE_APP_EUI_PREFIX ) + LWNODE_MAX_APP_EUI_HEX_CHARS )
-
-#define LWNODE_APP_KEY_PREFIX              "AT+APPKEY="
-#define LWNODE_APP_KEY_PREFIX_LEN          ( sizeof( LWNODE_APP_KEY_PREFIX ) - 1U )
-#define LWNODE_APP_KEY_CMD_LEN \
-    ( sizeof( LWNODE_APP_KEY_PREFIX ) + LWNODE_MAX_APP_KEY_HEX_CHARS )
-
-#define LWNODE_NWK_SKEY_PREFIX             "AT+NWKSKEY="
-#define LWNODE_NWK_SKEY_PREFIX_LEN         ( sizeof( LWNODE_NWK_SKEY_PREFIX ) - 1U )
-#define LWNODE_NWK_SKEY_CMD_LEN \
-    ( sizeof( LWNODE_NWK_SKEY_PREFIX ) + LWNODE_MAX_NWK_SKEY_HEX_CHARS )
-
-#define LWNODE_APP_SKEY_PREFIX             "AT+APPSKEY="
-#define LWNODE_APP_SKEY_PREFIX_LEN         ( sizeof( LWNODE_APP_SKEY_PREFIX ) - 1U )
-#define LWNODE_APP_SKEY_CMD_LEN \
-    ( sizeof( LWNODE_APP_SKEY_PREFIX ) + LWNODE_MAX_APP_SKEY_HEX_CHARS )
-
 #define LWNODE_RECV_PREFIX                 "+RECV="
 #define LWNODE_RECV_PREFIX_LEN             ( sizeof( LWNODE_RECV_PREFIX ) - 1U )
 
-#define LWNODE_DEVADDR_PREFIX              "AT+DEVADDR="
-#define LWNODE_DEVADDR_PREFIX_LEN          ( sizeof( LWNODE_DEVADDR_PREFIX ) - 1U )
-#define LWNODE_DEVADDR_HEX_LEN             ( 8U )
-#define LWNODE_DEVADDR_CMD_LEN \
-    ( sizeof( LWNODE_DEVADDR_PREFIX ) + LWNODE_DEVADDR_HEX_LEN )
-
-#define LWNODE_DATARATE_PREFIX             "AT+DATARATE=" 
-#define LWNODE_DATARATE_PREFIX_LEN         ( sizeof( LWNODE_DATARATE_PREFIX ) - 1U )
-#define LWNODE_DATARATE_MAX_DEC_CHARS      ( 3U )  /* 0–255 */
-#define LWNODE_DATARATE_CMD_LEN \
-    ( sizeof( LWNODE_DATARATE_PREFIX ) + LWNODE_DATARATE_MAX_DEC_CHARS )
-
-#define LWNODE_EIRP_PREFIX                 "AT+EIRP="
-#define LWNODE_EIRP_PREFIX_LEN             ( sizeof( LWNODE_EIRP_PREFIX ) - 1U )
-#define LWNODE_EIRP_MAX_DEC_CHARS          ( 3U )
-#define LWNODE_EIRP_CMD_LEN \
-    ( sizeof( LWNODE_EIRP_PREFIX ) + LWNODE_EIRP_MAX_DEC_CHARS )
-
-#define LWNODE_SUBBAND_PREFIX              "AT+SUBBAND="
-#define LWNODE_SUBBAND_PREFIX_LEN          ( sizeof( LWNODE_SUBBAND_PREFIX ) - 1U )
-#define LWNODE_SUBBAND_MAX_DEC_CHARS       ( 3U )
-#define LWNODE_SUBBAND_CMD_LEN \
-    ( sizeof( LWNODE_SUBBAND_PREFIX ) + LWNODE_SUBBAND_MAX_DEC_CHARS )
-
-#define LWNODE_ADR_PREFIX                  "AT+ADR="
-#define LWNODE_ADR_PREFIX_LEN              ( sizeof( LWNODE_ADR_PREFIX ) - 1U )
-#define LWNODE_ADR_VAL_LEN                 ( 1U )
-#define LWNODE_ADR_CMD_LEN \
-    ( sizeof( LWNODE_ADR_PREFIX ) + LWNODE_ADR_VAL_LEN )
+#define LWNODE_CFG_PREFIX_MAX_LEN          ( 12U )     /* "AT+DATARATE=" */
+#define LWNODE_DATARATE_REPLY              "+DATARATE="
+#define LWNODE_DATARATE_REPLY_LEN          ( sizeof( LWNODE_DATARATE_REPLY ) - 1U )
+#define LWNODE_DATARATE_MAX                ( 15U )
+#define LWNODE_CFG_VALUE_MAX_LEN \
+    ( LWNODE_MAX_CFG_CMD_BYTES - LWNODE_CFG_PREFIX_MAX_LEN - 1U )
+#define LWNODE_CFG_NO_STATE                ( 0xFFFFU )
+#define LWNODE_KEY_CRC_INIT                ( 0xFFFFFFFFUL )
+#define LWNODE_KEY_CRC_POLY                ( 0xEDB88320UL )   /* CRC-32 (IEEE), reflected */
 
 #define LWNODE_SEND_PREFIX                 "AT+SEND="
 #define LWNODE_SEND_PREFIX_LEN \
     (sizeof(LWNODE_SEND_PREFIX) - 1U)
 
-#define LWNODE_LORAWAN_RX_METADATA_OFFSET  ( 9U )
-#define LWNODE_RSSI_INDEX                  ( 6U )
-#define LWNODE_SNR_INDEX                   ( 7U )
-#define LWNODE_SNR_OFFSET                  ( 50 )
+#define LWNODE_JOIN_PREFIX                 "AT+JOIN="
+#define LWNODE_JOIN_PREFIX_LEN             ( sizeof( LWNODE_JOIN_PREFIX ) - 1U )
+#define LWNODE_JOIN_CMD_PREFIX             "AT+JOIN"   /* Request and status query */
+#define LWNODE_JOIN_CMD_PREFIX_LEN         ( sizeof( LWNODE_JOIN_CMD_PREFIX ) - 1U )
+
 
 #define LWNODE_RECV_RSSI_OFFSET            ( 0U )
 #define LWNODE_RECV_SNR_OFFSET             ( 1U )
@@ -91,31 +55,275 @@
 #define LWNODE_SNR_NORM_FACTOR             ( 50U )
 
 #define LWNODE_I2C_CHUNK_SIZE              ( 30U )
-#define LWNODE_I2C_CHUNK_DELAY_MS          ( 100U )
-#define LWNODE_MAX_LORA_PAYLOAD_LEN        ( 128U )
+#define LWNODE_I2C_CHUNK_DELAY_MS          ( 100U )    /* Conservative default gap */
+#define LWNODE_CHUNK_GAP_CAL_ROUNDS        ( 3U )
+#define LWNODE_CHUNK_GAP_MARGIN_MS         ( 2U )
+#define LWNODE_MAX_LORA_PAYLOAD_LEN        ( LWNODE_MAX_LORA_PAYLOAD_BYTES )
 #define LWNODE_READ_DATA_DELAY_MS          ( 100U )
 
-#define LWNODE_AT_ACK_MAX_LEN              ( 64U )
-#define LWNODE_AT_CMD_MAX_LEN              ( 520U )
+#define LWNODE_RX2_CLOSE_MS                ( 3500U )   /* RECEIVE_DELAY2 plus demod/queue time */
+#define LWNODE_JOIN_ACCEPT_MS              ( 5000U )   /* JOIN_ACCEPT_DELAY1 */
+#define LWNODE_JOIN_WINDOW_MS              ( 7000U )   /* JOIN_ACCEPT_DELAY2 plus demod/queue time */
+#define LWNODE_RX_WINDOW_POLL_MS           ( 20U )
+#define LWNODE_RX_IDLE_MIN_MS              ( 100U )
+#define LWNODE_RX_IDLE_MAX_MS              ( 1000U )
+#define LWNODE_RX_NO_CB_STEP_MS            ( 100U )
+
+#define LWNODE_SHADOW_REGION               ( 1U << 0 )
+#define LWNODE_SHADOW_RECV                 ( 1U << 1 )
+#define LWNODE_SHADOW_LORAMODE             ( 1U << 2 )
+#define LWNODE_SHADOW_JOINTYPE             ( 1U << 3 )
+#define LWNODE_SHADOW_CLASS                ( 1U << 4 )
+#define LWNODE_SHADOW_PACKET_TYPE          ( 1U << 5 )
+#define LWNODE_SHADOW_DATARATE             ( 1U << 6 )
+#define LWNODE_SHADOW_EIRP                 ( 1U << 7 )
+#define LWNODE_SHADOW_SUBBAND              ( 1U << 8 )
+#define LWNODE_SHADOW_ADR                  ( 1U << 9 )
+#define LWNODE_SHADOW_DEVADDR              ( 1U << 10 )
+#define LWNODE_SHADOW_APP_EUI              ( 1U << 11 )
+#define LWNODE_SHADOW_APP_KEY              ( 1U << 12 )
+#define LWNODE_SHADOW_NWK_SKEY             ( 1U << 13 )
+#define LWNODE_SHADOW_APP_SKEY             ( 1U << 14 )
+
+/* Tuned at runtime (link adaptation, DR hints, per-frame uplink type): kept
+ * in RAM to skip repeated commands, never trusted from NVS, so changing
+ * them does not write flash. Each is re-sent once per boot. */
+#define LWNODE_SHADOW_RUNTIME              ( LWNODE_SHADOW_PACKET_TYPE | \
+                                             LWNODE_SHADOW_DATARATE | \
+                                             LWNODE_SHADOW_EIRP )
+
+#define LWNODE_NVS_SHADOW_KEY              "shadow"
+#define LWNODE_NVS_SESSION_KEY             "session"
+
+#define LWNODE_STATS_P99_NUM               ( 99U )
+#define LWNODE_STATS_P99_DEN               ( 100U )
+
+#define LWNODE_AT_REPLY_MAX_LEN            ( LWNODE_MAX_RX_BYTES - 1U ) /* ACK plus interleaved URCs */
+#define LWNODE_AT_CMD_MAX_LEN              ( LWNODE_MAX_AT_CMD_BYTES )
+
+/* Settings written by lwnode_cfg_exec(), indexes into lwnodeCfgTable */
+typedef enum
+{
+    LWNODE_CFG_APP_EUI = 0,
+    LWNODE_CFG_APP_KEY,
+    LWNODE_CFG_NWK_SKEY,
+    LWNODE_CFG_APP_SKEY,
+    LWNODE_CFG_DEVADDR,
+    LWNODE_CFG_DATARATE,
+    LWNODE_CFG_EIRP,
+    LWNODE_CFG_SUBBAND,
+    LWNODE_CFG_ADR,
+    LWNODE_CFG_COUNT
+} LwnodeCfgId;
+
+/* How a setting's value is passed in and formatted after the prefix */
+typedef enum
+{
+    LWNODE_CFG_ARG_KEY = 0,     /* const uint8_t *, argLen bytes, sent as upper-case hex */
+    LWNODE_CFG_ARG_HEX32,       /* uint32_t, 8 hex digits */
+    LWNODE_CFG_ARG_U8,          /* uint8_t, decimal */
+    LWNODE_CFG_ARG_BOOL         /* uint8_t 0/1, '0' or '1' */
+} LwnodeCfgArg;
+
+/* One AT setter: command, expected ACK, shadow field and driver state field */
+typedef struct
+{
+    const char * prefix;        /* "AT+<KEY>=", at most LWNODE_CFG_PREFIX_MAX_LEN chars */
+    const char * ack;           /* Expected reply */
+    uint16_t shadowBit;         /* LWNODE_SHADOW_* */
+    uint8_t arg;                /* LwnodeCfgArg */
+    uint8_t argLen;             /* Bytes in an LWNODE_CFG_ARG_KEY value */
+    uint16_t shadowOffset;      /* Field in LwnodeConfigShadow */
+    uint16_t valueLen;          /* Bytes compared with and stored in the shadow (a key's CRC-32) */
+    uint16_t stateOffset;       /* Field in LwnodeDevice, or LWNODE_CFG_NO_STATE */
+    bool stateFirst;            /* Key: record it and set keyMask even if rejected */
+} LwnodeCfgDesc;
 
 static bool lwnode_at_test( LwnodeDevice * const device );
 static bool lwnode_write_at_bytes( const LwnodeDevice * const device,
                                    const uint8_t * const data,
-                                   uint16_t len );
+                                   uint16_t len,
+                                   bool isFinal );
+static bool lwnode_i2c_probe( void * const ctx );
+static bool lwnode_i2c_write_at( void * const ctx,
+                                 const uint8_t * const data,
+                                 size_t len,
+                                 bool final );
+static bool lwnode_i2c_read_at( void * const ctx,
+                                uint8_t * const buf,
+                                size_t cap,
+                                uint16_t * const outLen );
+static bool lwnode_wait_rx( LwnodeDevice * const device, uint32_t timeoutMs );
 static bool lwnode_read_ack_bytes( LwnodeDevice * const device,
                                    uint16_t * const outLen );
 static bool lwnode_send_at_cmd( LwnodeDevice * const device,
                                 const char * const cmdAscii,
-                                char * const ackBuf, size_t ackCap );
+                                const char * const expectedAck );
+static bool lwnode_apply_cfg( LwnodeDevice * const device,
+                              const char * const cmd,
+                              const char * const expectedAck,
+                              uint16_t field,
+                              void * const shadowValue,
+                              const void * const value,
+                              size_t valueLen );
+static bool lwnode_cfg_exec( LwnodeDevice * const device,
+                             LwnodeCfgId id,
+                             const void * const arg );
+static bool lwnode_set_key( LwnodeDevice * const device,
+                            LwnodeCfgId id,
+                            const char * const hex );
+static bool lwnode_cfg_format( const LwnodeCfgDesc * const desc,
+                               const void * const arg,
+                               char * const out );
+static uint32_t lwnode_key_crc32( const uint8_t * const key, size_t len );
+static void lwnode_shadow_reset( LwnodeDevice * const device );
+static void lwnode_shadow_sync( LwnodeDevice * const device );
+static bool lwnode_begin_internal( LwnodeDevice * const device,
+                                   uint32_t budgetMs );
+static uint32_t lwnode_budget_remaining_ms( const LwnodeDevice * const device );
+static void lwnode_budget_delay_ms( const LwnodeDevice * const device, uint32_t delayMs );
+static bool lwnode_session_can_resume( const LwnodeDevice * const device );
+static void lwnode_session_store( LwnodeDevice * const device );
+static void lwnode_session_on_query( LwnodeDevice * const device, bool joined );
 static bool lwnode_ack_equals( const char * const ack,
                                const char * const expected );
+static bool lwnode_send_accepted( const char * const ack );
+static bool lwnode_parse_datarate( const char * const ack,
+                                   uint8_t * const dataRate );
 static bool lwnode_read_lora_data( LwnodeDevice * const device,
                                    uint16_t * const outLen );
+static bool lwnode_read_data_chunks( LwnodeDevice * const device,
+                                     uint16_t len );
+static bool lwnode_read_queued_len( LwnodeDevice * const device,
+                                    uint8_t lenReg,
+                                    uint16_t * const outLen );
+static uint8_t lwnode_drain_queue( LwnodeDevice * const device,
+                                   LwnodeRxBatch * const batch );
+static uint16_t lwnode_recv_payload_bound( uint16_t frameLen );
 static bool lwnode_process_recv_frames( LwnodeDevice * const device,
                                         const uint8_t * const buf,
                                         uint16_t len );
-static bool lwnode_read_ack_with_yield( LwnodeDevice * const device,
-                                        uint16_t * const outLen );
+static uint16_t lwnode_at_route_urcs( LwnodeDevice * const device, uint16_t len );
+static bool lwnode_chunk_gap_passes( LwnodeDevice * const device,
+                                     const char * const probeCmd,
+                                     const char * const expectedAck,
+                                     uint32_t gapMs );
+static bool lwnode_at_arm( LwnodeDevice * const device,
+                           const char * const prefix,
+                           size_t prefixLen,
+                           const uint8_t * const payload,
+                           uint8_t payloadLen,
+                           LwnodeAtDoneCb doneCb,
+                           void * const ctx );
+static uint16_t lwnode_at_fill_chunk( const LwnodeAtTxn * const txn,
+                                      uint8_t * const chunk,
+                                      uint16_t chunkLen );
+static LwnodeAtStatus lwnode_at_wait( LwnodeDevice * const device );
+static bool lwnode_time_reached( uint32_t nowMs, uint32_t deadlineMs );
+static LwnodeBusyState lwnode_busy_state_at( const LwnodeDevice * const device,
+                                             uint32_t nowMs );
+static uint32_t lwnode_busy_release_ms( const LwnodeDevice * const device,
+                                        const char * const prefix,
+                                        size_t prefixLen,
+                                        uint32_t nowMs );
+static void lwnode_sleep_poll_legacy( LwnodeDevice * const device, uint32_t ms );
+static void lwnode_sleep_event( LwnodeDevice * const device, uint32_t ms );
+static bool lwnode_rx_poll_once( LwnodeDevice * const device );
+static bool lwnode_rx_allowed( LwnodeDevice * const device, uint32_t nowMs );
+static void lwnode_rx_schedule( LwnodeDevice * const device,
+                                uint32_t nowMs,
+                                bool gotFrame );
+static uint32_t lwnode_at_timeout_for( const uint8_t * const cmd,
+                                       uint16_t len );
+static void lwnode_at_step_write( LwnodeDevice * const device, uint32_t nowMs );
+static void lwnode_at_step_ack( LwnodeDevice * const device, uint32_t nowMs );
+static void lwnode_at_complete( LwnodeDevice * const device,
+                                LwnodeAtStatus status );
+
+#if ( LWNODE_STATS_ENABLED != 0 )
+static LwnodeCmdType lwnode_stats_classify( const uint8_t * const cmd, uint16_t len );
+static void lwnode_stats_on_arm( LwnodeDevice * const device, uint32_t nowMs );
+static void lwnode_stats_on_complete( LwnodeDevice * const device,
+                                      LwnodeAtStatus status,
+                                      uint32_t nowMs );
+static void lwnode_stats_record( LwnodeLatencyStats * const lat, uint32_t ms );
+static void lwnode_stats_summarize( const LwnodeLatencyStats * const lat,
+                                    LwnodeLatencySummary * const out );
+static bool lwnode_stats_append( char * const out,
+                                 size_t outCap,
+                                 size_t * const pos,
+                                 const char * const text );
+static bool lwnode_stats_append_u32( char * const out,
+                                     size_t outCap,
+                                     size_t * const pos,
+                                     uint32_t value );
+static bool lwnode_stats_append_latency( char * const out,
+                                         size_t outCap,
+                                         size_t * const pos,
+                                         const char * const tag,
+                                         const LwnodeLatencyStats * const lat );
+
+#define LWNODE_STATS_ADD( device, field, n ) \
+    ( ( device )->cmdStats[ ( device )->at.cmdType ].field += ( uint32_t ) ( n ) )
+#else
+#define LWNODE_STATS_ADD( device, field, n )    ( ( void ) 0 )
+#endif
+
+/*
+ * Setters that format one argument after a fixed prefix. Keys are recorded
+ * before the command goes out so that lwnode_begin() can replay them; the
+ * radio parameters only once the module accepted them.
+ */
+static const LwnodeCfgDesc lwnodeCfgTable[ LWNODE_CFG_COUNT ] =
+{
+    [ LWNODE_CFG_APP_EUI ] = { "AT+JOINEUI=", "+JOINEUI=OK\r\n", LWNODE_SHADOW_APP_EUI,
+                               LWNODE_CFG_ARG_KEY, LWNODE_APP_EUI_BYTES,
+                               offsetof( LwnodeConfigShadow, appEuiCrc ), sizeof( uint32_t ),
+                               offsetof( LwnodeDevice, appEui ), true },
+    [ LWNODE_CFG_APP_KEY ] = { "AT+APPKEY=", "+APPKEY=OK\r\n", LWNODE_SHADOW_APP_KEY,
+                               LWNODE_CFG_ARG_KEY, LWNODE_KEY_BYTES,
+                               offsetof( LwnodeConfigShadow, appKeyCrc ), sizeof( uint32_t ),
+                               offsetof( LwnodeDevice, appKey ), true },
+    [ LWNODE_CFG_NWK_SKEY ] = { "AT+NWKSKEY=", "+NWKSKEY=OK\r\n", LWNODE_SHADOW_NWK_SKEY,
+                                LWNODE_CFG_ARG_KEY, LWNODE_KEY_BYTES,
+                                offsetof( LwnodeConfigShadow, nwkSkeyCrc ), sizeof( uint32_t ),
+                                offsetof( LwnodeDevice, nwkSkey ), true },
+    [ LWNODE_CFG_APP_SKEY ] = { "AT+APPSKEY=", "+APPSKEY=OK\r\n", LWNODE_SHADOW_APP_SKEY,
+                                LWNODE_CFG_ARG_KEY, LWNODE_KEY_BYTES,
+                                offsetof( LwnodeConfigShadow, appSkeyCrc ), sizeof( uint32_t ),
+                                offsetof( LwnodeDevice, appSkey ), true },
+    [ LWNODE_CFG_DEVADDR ] = { "AT+DEVADDR=", "+DEVADDR=OK\r\n", LWNODE_SHADOW_DEVADDR,
+                               LWNODE_CFG_ARG_HEX32, 0U,
+                               offsetof( LwnodeConfigShadow, devAddr ), sizeof( uint32_t ),
+                               offsetof( LwnodeDevice, devAddr ), false },
+    [ LWNODE_CFG_DATARATE ] = { "AT+DATARATE=", "+DATARATE=OK\r\n", LWNODE_SHADOW_DATARATE,
+                                LWNODE_CFG_ARG_U8, 0U,
+                                offsetof( LwnodeConfigShadow, dataRate ), sizeof( uint8_t ),
+                                offsetof( LwnodeDevice, dataRate ), false },
+    [ LWNODE_CFG_EIRP ] = { "AT+EIRP=", "+EIRP=OK\r\n", LWNODE_SHADOW_EIRP,
+                            LWNODE_CFG_ARG_U8, 0U,
+                            offsetof( LwnodeConfigShadow, eirp ), sizeof( uint8_t ),
+                            offsetof( LwnodeDevice, txPower ), false },
+    [ LWNODE_CFG_SUBBAND ] = { "AT+SUBBAND=", "+SUBBAND=OK\r\n", LWNODE_SHADOW_SUBBAND,
+                               LWNODE_CFG_ARG_U8, 0U,
+                               offsetof( LwnodeConfigShadow, subBand ), sizeof( uint8_t ),
+                               offsetof( LwnodeDevice, subBand ), false },
+    [ LWNODE_CFG_ADR ] = { "AT+ADR=", "+ADR=OK\r\n", LWNODE_SHADOW_ADR,
+                           LWNODE_CFG_ARG_BOOL, 0U,
+                           offsetof( LwnodeConfigShadow, adr ), sizeof( uint8_t ),
+                           LWNODE_CFG_NO_STATE, false }
+};
+
+/* Default transport: AT registers over the I2C HAL, context is the device */
+static const LwnodeTransport lwnodeI2cTransport =
+{
+    .name = "i2c",
+    .stream = false,
+    .probe = lwnode_i2c_probe,
+    .write_at = lwnode_i2c_write_at,
+    .read_at = lwnode_i2c_read_at,
+    .wait_rx = NULL
+};
 
 bool lwnode_init( LwnodeDevice * const device, 
                   const LwnodeHw * const sensor )
@@ -126,10 +334,30 @@ bool lwnode_init( LwnodeDevice * const device,
     {
         ( void ) memset( device, 0, sizeof( *device ) );
         device->sensor = sensor;
+        device->transport = &lwnodeI2cTransport;
+        device->transportCtx = device;
         device->intEnabled = true;
+        device->chunkGapMs = LWNODE_I2C_CHUNK_DELAY_MS;
+        device->rxMode = LWNODE_RX_MODE_EVENT;
+        device->rxIdleIntervalMs = LWNODE_RX_IDLE_MIN_MS;
         device->region = LWNODE_REGION_US915;
         device->joinType = LWNODE_JOIN_OTAA;
 
+        /* Without a usable NVS copy every setting is re-sent once */
+        if( !lwnode_hal_nvs_load( LWNODE_NVS_SHADOW_KEY, &device->shadow, sizeof( device->shadow ) ) ||
+            ( device->shadow.version != LWNODE_SHADOW_VERSION ) )
+        {
+            lwnode_shadow_reset( device );
+        }
+        device->shadow.validMask = ( uint16_t ) ( device->shadow.validMask & ~LWNODE_SHADOW_RUNTIME );
+
+        if( !lwnode_hal_nvs_load( LWNODE_NVS_SESSION_KEY, &device->session, sizeof( device->session ) ) ||
+            ( device->session.version != LWNODE_SESSION_VERSION ) )
+        {
+            ( void ) memset( &device->session, 0, sizeof( device->session ) );
+            device->session.version = LWNODE_SESSION_VERSION;
+        }
+
         device->isInitialized = true;
         result = true;
     }
@@ -137,6 +365,35 @@ bool lwnode_init( LwnodeDevice * const device,
     return result;
 }
 
+bool lwnode_set_transport( LwnodeDevice * const device, 
+                           const LwnodeTransport * const transport, 
+                           void * const ctx )
+{
+    bool result = false;
+
+    if( ( device != NULL ) && ( device->at.phase == LWNODE_AT_PHASE_IDLE ) )
+    {
+        if( transport == NULL )
+        {
+            device->transport = &lwnodeI2cTransport;
+            device->transportCtx = device;
+            result = true;
+        }
+        else if( ( transport->write_at != NULL ) && ( transport->read_at != NULL ) )
+        {
+            device->transport = transport;
+            device->transportCtx = ctx;
+            result = true;
+        }
+        else
+        {
+            /* Incomplete transport */
+        }
+    }
+
+    return result;
+}
+
 bool lwnode_set_rx_cb( LwnodeDevice * const device, 
                        LwnodeRxCb callback )
 {
@@ -208,7 +465,6 @@ bool lwnode_set_region( LwnodeDevice * const device,
 
     if( device != NULL )
     {
-        char ack[ LWNODE_AT_ACK_MAX_LEN ] = {};
         const char * cmd = NULL;
 
         switch( region )
@@ -229,13 +485,14 @@ bool lwnode_set_region( LwnodeDevice * const device,
 
         if( cmd != NULL )
         {
-            if( lwnode_send_at_cmd( device, cmd, ack, sizeof( ack ) ) )
+            const uint8_t value = ( uint8_t ) region;
+
+            if( lwnode_apply_cfg( device, cmd, "+REGION=OK\r\n", LWNODE_SHADOW_REGION,
+                                  &device->shadow.region, &value,
+                                  sizeof( device->shadow.region ) ) )
             {
-                if( lwnode_ack_equals( ack, "+REGION=OK\r\n" ) )
-                {
-                    device->region = region;
-                    result = true;
-                }
+                device->region = region;
+                result = true;
             }
         }
     }
@@ -246,198 +503,31 @@ bool lwnode_set_region( LwnodeDevice * const device,
 bool lwnode_set_app_eui( LwnodeDevice * const device, 
                          const char * const joinEuiHex16 )
 {
-    bool result = false;
-
-    if( ( device != NULL ) && ( joinEuiHex16 != NULL ) )
-    {
-        const size_t n = str_ext_strnlen( joinEuiHex16, 
-                                          LWNODE_MAX_APP_EUI_HEX_CHARS + 1U );
-        if( n == LWNODE_MAX_APP_EUI_HEX_CHARS )
-        {    
-            char cmd[ LWNODE_APP_EUI_CMD_LEN ] = {};
-            char ack[ LWNODE_AT_ACK_MAX_LEN ] = {};
-
-            ( void ) memcpy( device->appEui, 
-                             joinEuiHex16, 
-                             LWNODE_MAX_APP_EUI_HEX_CHARS );
-            device->appEui[ LWNODE_MAX_APP_EUI_HEX_CHARS ] = '\0';
-
-            str_ext_to_upper_case(device->appEui);
-
-            ( void ) memcpy( cmd, 
-                            LWNODE_APP_EUI_PREFIX, 
-                            LWNODE_APP_EUI_PREFIX_LEN );
-            ( void ) memcpy( &cmd[ LWNODE_APP_EUI_PREFIX_LEN ], 
-                            device->appEui, 
-                            LWNODE_MAX_APP_EUI_HEX_CHARS );
-            cmd[ LWNODE_APP_EUI_CMD_LEN - 1U ] = '\0';
-
-            if( lwnode_send_at_cmd( device, cmd, ack, sizeof( ack ) ) )
-            {
-                if( lwnode_ack_equals( ack, "+JOINEUI=OK\r\n" ) )
-                {
-                    result = true;
-                }
-            }
-        }
-    }
-
-    return result;
+    return lwnode_set_key( device, LWNODE_CFG_APP_EUI, joinEuiHex16 );
 }
 
 bool lwnode_set_app_key( LwnodeDevice * const device, 
                          const char * const appKeyHex32 )
 {
-    bool result = false;
-
-    if( ( device != NULL ) && ( appKeyHex32 != NULL ) )
-    {
-        const size_t n = str_ext_strnlen( appKeyHex32, 
-                                          LWNODE_MAX_APP_KEY_HEX_CHARS + 1U );
-        if( n == LWNODE_MAX_APP_KEY_HEX_CHARS )
-        {    
-            char cmd[ LWNODE_APP_KEY_CMD_LEN ] = {};
-            char ack[ LWNODE_AT_ACK_MAX_LEN ] = {};
-
-            ( void ) memcpy( device->appKey, appKeyHex32, LWNODE_MAX_APP_KEY_HEX_CHARS );
-            device->appKey[ LWNODE_MAX_APP_KEY_HEX_CHARS ] = '\0';
-            str_ext_to_upper_case( device->appKey );
-
-            ( void ) memcpy( cmd, LWNODE_APP_KEY_PREFIX, LWNODE_APP_KEY_PREFIX_LEN );
-            ( void ) memcpy( &cmd[ LWNODE_APP_KEY_PREFIX_LEN ], 
-                             device->appKey, 
-                             LWNODE_MAX_APP_KEY_HEX_CHARS );
-            cmd[ LWNODE_APP_KEY_CMD_LEN - 1U ] = '\0' ;
-
-            if( lwnode_send_at_cmd( device, cmd, ack, sizeof( ack ) ) )
-            {
-                if( lwnode_ack_equals( ack, "+APPKEY=OK\r\n" ) )
-                {
-                    result = true;
-                }
-            }
-        }
-    }
-        
-    return result;
+    return lwnode_set_key( device, LWNODE_CFG_APP_KEY, appKeyHex32 );
 }
 
 bool lwnode_set_nwk_skey( LwnodeDevice * const device, 
                           const char * const nwkSkeyHex32 )
 {
-    bool result = false;
-
-    if( ( device != NULL ) && ( nwkSkeyHex32 != NULL ) )
-    {
-        const size_t n = str_ext_strnlen( nwkSkeyHex32, 
-                                          LWNODE_MAX_NWK_SKEY_HEX_CHARS + 1U );
-        if( n == LWNODE_MAX_NWK_SKEY_HEX_CHARS )
-        {
-            char cmd[ LWNODE_NWK_SKEY_CMD_LEN ] = {};
-            char ack[ LWNODE_AT_ACK_MAX_LEN ] = {};
-
-            ( void ) memcpy( device->nwkSkey, 
-                             nwkSkeyHex32, 
-                             LWNODE_MAX_NWK_SKEY_HEX_CHARS );
-            device->nwkSkey[ LWNODE_MAX_NWK_SKEY_HEX_CHARS ] = '\0';
-            str_ext_to_upper_case( device->nwkSkey );
-
-            ( void ) memcpy( cmd, 
-                             LWNODE_NWK_SKEY_PREFIX, 
-                             LWNODE_NWK_SKEY_PREFIX_LEN );
-            ( void ) memcpy( &cmd[ LWNODE_NWK_SKEY_PREFIX_LEN ], 
-                             device->nwkSkey, 
-                             LWNODE_MAX_NWK_SKEY_HEX_CHARS );
-            cmd[ LWNODE_NWK_SKEY_CMD_LEN - 1U ] = '\0';
-
-            if( lwnode_send_at_cmd( device, cmd, ack, sizeof( ack ) ) )
-            {
-                if( lwnode_ack_equals( ack, "+NWKSKEY=OK\r\n" ) )
-                {
-                    result = true;
-                }
-            }
-        }
-    }
-
-    return result;
+    return lwnode_set_key( device, LWNODE_CFG_NWK_SKEY, nwkSkeyHex32 );
 }
 
 bool lwnode_set_app_skey( LwnodeDevice * const device, 
                           const char * const appSkeyHex32 )
 {
-    bool result = false;
-
-    if ((device != NULL) && (appSkeyHex32 != NULL))
-    {
-        char cmd[ LWNODE_APP_SKEY_CMD_LEN ] = {};
-        char ack[ LWNODE_AT_ACK_MAX_LEN ] = {};
-
-        const size_t n = str_ext_strnlen( appSkeyHex32, 
-                                          LWNODE_MAX_APP_SKEY_HEX_CHARS + 1U );
-        if( n == LWNODE_MAX_APP_SKEY_HEX_CHARS )
-        {
-            ( void ) memcpy( device->appSkey, 
-                             appSkeyHex32, 
-                             LWNODE_MAX_APP_SKEY_HEX_CHARS );
-            device->appSkey[ LWNODE_MAX_APP_SKEY_HEX_CHARS ] = '\0';
-            str_ext_to_upper_case( device->appSkey );
-
-            ( void ) memcpy( cmd, 
-                             LWNODE_APP_SKEY_PREFIX, 
-                             LWNODE_APP_SKEY_PREFIX_LEN );
-            ( void ) memcpy( &cmd[ LWNODE_APP_SKEY_PREFIX_LEN ], 
-                             device->appSkey, 
-                             LWNODE_MAX_APP_SKEY_HEX_CHARS );
-            cmd[ LWNODE_APP_SKEY_CMD_LEN - 1U ] = '\0';
-
-            if( lwnode_send_at_cmd( device, cmd, ack, sizeof( ack ) ) )
-            {
-                if( lwnode_ack_equals( ack, "+APPSKEY=OK\r\n" ) )
-                {
-                    result = true;
-                }
-            }
-        }
-    }
-    
-    return result;
+    return lwnode_set_key( device, LWNODE_CFG_APP_SKEY, appSkeyHex32 );
 }
 
 bool lwnode_set_dev_addr( LwnodeDevice * const device, 
                           uint32_t devAddr )
 {
-    bool result = false;
-
-    if( device != NULL )
-    {   
-        char hexAddr[ 9 ] = {};
-
-        if( num_fmt_u32_to_hex8( devAddr, hexAddr, sizeof( hexAddr ) ) )
-        {
-            char cmd[ LWNODE_DEVADDR_CMD_LEN ] = {};
-            char ack[ LWNODE_AT_ACK_MAX_LEN ] = {};
-
-            ( void ) memcpy( cmd, 
-                             LWNODE_DEVADDR_PREFIX, 
-                             LWNODE_DEVADDR_PREFIX_LEN );
-            ( void ) memcpy( &cmd[ LWNODE_DEVADDR_PREFIX_LEN ], 
-                             hexAddr, 
-                             LWNODE_DEVADDR_HEX_LEN );
-            cmd[ LWNODE_DEVADDR_CMD_LEN - 1U ] = '\0';
-
-            if( lwnode_send_at_cmd( device, cmd, ack, sizeof( ack ) ) )
-            {
-                if( lwnode_ack_equals( ack, "+DEVADDR=OK\r\n" ) )
-                {
-                    device->devAddr = devAddr;
-                    result = true;
-                }
-            }
-        }
-    }
-
-    return result;
+    return lwnode_cfg_exec( device, LWNODE_CFG_DEVADDR, &devAddr );
 }
 
 bool lwnode_set_class( LwnodeDevice * const device, 
@@ -447,7 +537,6 @@ bool lwnode_set_class( LwnodeDevice * const device,
 
     if( device != NULL )
     {
-        char ack[ LWNODE_AT_ACK_MAX_LEN ] = {};
         const char * cmd = NULL;
 
         switch( classType )
@@ -466,12 +555,13 @@ bool lwnode_set_class( LwnodeDevice * const device,
 
         if( cmd != NULL )
         {
-            if( lwnode_send_at_cmd( device, cmd, ack, sizeof( ack ) ) )
+            const uint8_t value = ( uint8_t ) classType;
+
+            if( lwnode_apply_cfg( device, cmd, "+CLASS=OK\r\n", LWNODE_SHADOW_CLASS,
+                                  &device->shadow.classType, &value,
+                                  sizeof( device->shadow.classType ) ) )
             {
-                if( lwnode_ack_equals( ack, "+CLASS=OK\r\n" ) )
-                {
-                    result = true;
-                }
+                result = true;
             }
         }
     }
@@ -479,124 +569,42 @@ bool lwnode_set_class( LwnodeDevice * const device,
     return result;
 }
 
-//maybe ok
 bool lwnode_set_datarate( LwnodeDevice * const device, 
                           uint8_t dataRate )
+{
+    return lwnode_cfg_exec( device, LWNODE_CFG_DATARATE, &dataRate );
+}
+
+bool lwnode_get_datarate( LwnodeDevice * const device,
+                          uint8_t * const dataRate )
 {
     bool result = false;
 
-    if( device != NULL )
+    if( ( device != NULL ) && ( dataRate != NULL ) &&
+        lwnode_send_at_cmd( device, "AT+DATARATE?", NULL ) )
     {
-
-        char dataRateStr[ LWNODE_DATARATE_MAX_DEC_CHARS + 1U ];
-
-        if( num_fmt_u8toa( dataRate, dataRateStr, sizeof( dataRateStr ) ) )
-        {
-            char cmd[ LWNODE_DATARATE_CMD_LEN ] = {};
-            char ack[ LWNODE_AT_ACK_MAX_LEN ] = {};
-
-            const size_t len = str_ext_strnlen( dataRateStr, sizeof( dataRateStr ) );
-
-            ( void ) memcpy( cmd,
-                             LWNODE_DATARATE_PREFIX,
-                             LWNODE_DATARATE_PREFIX_LEN );
-
-            ( void ) memcpy( &cmd[ LWNODE_DATARATE_PREFIX_LEN ],
-                             dataRateStr,
-                             len );
-
-            cmd[ LWNODE_DATARATE_PREFIX_LEN + len ] = '\0';
-
-            if( lwnode_send_at_cmd( device, cmd, ack, sizeof( ack ) ) )
-            {
-                if( lwnode_ack_equals( ack, "+DATARATE=OK\r\n" ) )
-                {
-                    device->dataRate = dataRate;
-                    result = true;
-                }
-            }
-        }
+        /* The reply stays in rxBuf until the next transaction */
+        result = lwnode_parse_datarate( ( const char * ) device->rxBuf, dataRate );
     }
 
     return result;
 }
 
-//maybe ok
 bool lwnode_set_eirp( LwnodeDevice * const device, 
                       uint8_t eirp )
 {
-    bool result = false;
-
-    if( device != NULL )
-    {
-        char numStr[ LWNODE_EIRP_MAX_DEC_CHARS + 1U ];
-
-        if( num_fmt_u8toa( eirp, numStr, sizeof( numStr ) ) )
-        {
-            char cmd[ LWNODE_EIRP_CMD_LEN ] = {};
-            char ack[ LWNODE_AT_ACK_MAX_LEN ] = {};
-
-            const size_t len = str_ext_strnlen( numStr, sizeof( numStr ) );
-
-            ( void ) memcpy( cmd, 
-                             LWNODE_EIRP_PREFIX, 
-                             LWNODE_EIRP_PREFIX_LEN );
-
-            ( void ) memcpy( &cmd[ LWNODE_EIRP_PREFIX_LEN ], 
-                             numStr, 
-                             len );
-
-            cmd[ LWNODE_EIRP_PREFIX_LEN + len ] = '\0';
-
-            if( lwnode_send_at_cmd( device, cmd, ack, sizeof( ack ) ) )
-            {
-                if( lwnode_ack_equals( ack, "+EIRP=OK\r\n" ) )
-                {
-                    result = true;
-                }
-            }
-        }
-    }
-
-    return result;
+    return lwnode_cfg_exec( device, LWNODE_CFG_EIRP, &eirp );
 }
 
-//maybe ok
 bool lwnode_set_subband( LwnodeDevice * const device, 
                          uint8_t subBand )
 {
     bool result = false;
 
+    /* EU868 has no sub-bands */
     if( ( device != NULL ) && ( device->region != LWNODE_REGION_EU868 ) )
     {
-        char numStr[ LWNODE_SUBBAND_MAX_DEC_CHARS + 1U ];
-
-        if( num_fmt_u8toa( subBand, numStr, sizeof( numStr ) ) )
-        {
-            char cmd[ LWNODE_SUBBAND_CMD_LEN ] = {};
-            char ack[ LWNODE_AT_ACK_MAX_LEN ] = {};
-
-            const size_t len = str_ext_strnlen( numStr, sizeof( numStr ) );
-
-            ( void ) memcpy( cmd, 
-                             LWNODE_SUBBAND_PREFIX, 
-                             LWNODE_SUBBAND_PREFIX_LEN );
-
-            ( void ) memcpy( &cmd[ LWNODE_SUBBAND_PREFIX_LEN ], 
-                             numStr, 
-                             len );
-
-            cmd[ LWNODE_SUBBAND_PREFIX_LEN + len ] = '\0';
-
-            if( lwnode_send_at_cmd( device, cmd, ack, sizeof( ack ) ) )
-            {
-                if( lwnode_ack_equals( ack, "+SUBBAND=OK\r\n" ) )
-                {
-                    device->subBand = subBand;
-                    result = true;
-                }
-            }
-        }
+        result = lwnode_cfg_exec( device, LWNODE_CFG_SUBBAND, &subBand );
     }
 
     return result;
@@ -606,28 +614,12 @@ bool lwnode_enable_adr( LwnodeDevice * const device,
                         bool adr )
 {
     bool result = false;
+    const uint8_t value = adr ? 1U : 0U;
 
-    if( device != NULL )
+    if( lwnode_cfg_exec( device, LWNODE_CFG_ADR, &value ) )
     {
-        char cmd[ LWNODE_ADR_CMD_LEN ] = {};
-        char ack[ LWNODE_AT_ACK_MAX_LEN ] = {};
-
-        /* 1. Build Command: "AT+ADR=" + '0' or '1' */
-        ( void ) memcpy( cmd, 
-                         LWNODE_ADR_PREFIX, 
-                         LWNODE_ADR_PREFIX_LEN );
-
-        cmd[ LWNODE_ADR_PREFIX_LEN ] = adr ? ( uint8_t ) '1' : ( uint8_t ) '0';
-        cmd[ LWNODE_ADR_PREFIX_LEN + 1U ] = '\0';
-
-        if( lwnode_send_at_cmd( device, cmd, ack, sizeof( ack ) ) )
-        {
-            if( lwnode_ack_equals( ack, "+ADR=OK\r\n" ) )
-            {
-                device->adr = adr;
-                result = true;
-            }
-        }
+        device->adr = adr;
+        result = true;
     }
 
     return result;
@@ -657,14 +649,13 @@ bool lwnode_set_packet_type( LwnodeDevice * const device,
         
         if( cmd != NULL )
         {
-            char ack[ LWNODE_AT_ACK_MAX_LEN ] = {};
+            const uint8_t value = ( uint8_t ) type;
 
-            if( lwnode_send_at_cmd( device, cmd, ack, sizeof( ack ) ) )
+            if( lwnode_apply_cfg( device, cmd, "+UPLINKTYPE=OK\r\n", LWNODE_SHADOW_PACKET_TYPE,
+                                  &device->shadow.packetType, &value,
+                                  sizeof( device->shadow.packetType ) ) )
             {
-                if( lwnode_ack_equals( ack, "+UPLINKTYPE=OK\r\n") )
-                {
-                    result = true;
-                }
+                result = true;
             }
         }
     }
@@ -674,92 +665,40 @@ bool lwnode_set_packet_type( LwnodeDevice * const device,
 
 bool lwnode_begin( LwnodeDevice * const device )
 {
-    bool result = false;
-
-    if( ( device != NULL ) && ( device->sensor != NULL ) )
-    {    
-        char ack[ LWNODE_AT_ACK_MAX_LEN ] = {};
-        uint8_t retry = LWNODE_BEGIN_RETRY_COUNT;
-
-        ( void ) lwnode_send_at_cmd( device, "AT+REBOOT", ack, sizeof( ack ) );
-        lwnode_hal_delay_ms( 100U );
-
-        /* AT Test */
-        while( retry > 0U )
-        {
-            if( lwnode_at_test( device ) )
-            {
-                result = true;
-                break;
-            }
-            retry--;
-            lwnode_hal_delay_ms( 10U ); /* Small yield during init */
-        }
-
-        /* Global Configuration (Only if AT test passed) */
-        if( result )
-        {
-            /* Enable receive queue */
-            ( void ) lwnode_send_at_cmd( device, "AT+RECV=1", ack, sizeof( ack ) );
-            
-            /* Set mode to LoRaWAN: OTAA and ABP */
-            result = lwnode_send_at_cmd( device, "AT+LORAMODE=LORAWAN", ack, sizeof( ack ) );
-        }
-
-        /* Join Type Specific Configuration */
-        if( result )
-        {
-            if( device->joinType == LWNODE_JOIN_ABP )
-            {
-                result = lwnode_send_at_cmd( device, "AT+JOINTYPE=ABP", ack, sizeof( ack ) );
-                result = result && lwnode_ack_equals( ack, "+JOINTYPE=OK\r\n" );
+    return lwnode_begin_internal( device, 0U );
+}
 
-                if( result && ( device->nwkSkey[ 0 ] != '\0' ) )
-                {
-                    result = lwnode_set_nwk_skey( device, device->nwkSkey );
-                }
-                if( result && (device->appSkey[ 0 ] != '\0' ) )
-                {
-                    result = lwnode_set_app_skey( device, device->appSkey );
-                }
-                if( result && ( device->devAddr != 0U ) )
-                {
-                    result = lwnode_set_dev_addr( device, device->devAddr );
-                }
-            }
-            else /* LWNODE_JOIN_OTAA */
-            {
-                result = lwnode_send_at_cmd( device, "AT+JOINTYPE=OTAA", ack, sizeof( ack ) );
-                result = result && lwnode_ack_equals( ack, "+JOINTYPE=OK\r\n" );
+bool lwnode_begin_bounded( LwnodeDevice * const device, uint32_t budgetMs )
+{
+    bool result = false;
 
-                if( result && ( device->appEui[ 0 ] != '\0' ) )
-                {
-                    result = lwnode_set_app_eui( device, device->appEui );
-                }
-                if( result && ( device->appKey[ 0 ] != '\0' ) )
-                {
-                    result = lwnode_set_app_key( device, device->appKey );
-                }
-            }
-        }
+    if( budgetMs != 0U )
+    {
+        result = lwnode_begin_internal( device, budgetMs );
     }
 
     return result;
 }
 
+bool lwnode_is_ready( const LwnodeDevice * const device )
+{
+    return ( ( device != NULL ) && device->isReady );
+}
+
 bool lwnode_join( LwnodeDevice * const device )
 {
     bool result = false;
 
     if( device != NULL )
     {
-        char ack[ LWNODE_AT_ACK_MAX_LEN ] = {};
-        if( lwnode_send_at_cmd( device, "AT+JOIN=1", ack, sizeof( ack ) ))
+        if( lwnode_send_at_cmd( device, "AT+JOIN=1", "+JOIN=OK\r\n" ) )
         {
-            if( lwnode_ack_equals( ack, "+JOIN=OK\r\n") )
-            {
-                result = true;
-            }
+            device->joinPending = true;
+            device->joinStartMs = lwnode_hal_get_time_ms();
+            device->joinMetrics.joinsRequested++;
+            device->busyState = LWNODE_STATE_JOINING;
+            device->busyUntilMs = device->joinStartMs + LWNODE_JOIN_WINDOW_MS;
+            result = true;
         }
     }
 
@@ -772,17 +711,57 @@ bool lwnode_is_joined( LwnodeDevice * const device)
     
     if( device != NULL )
     {
-        char ack[ LWNODE_AT_ACK_MAX_LEN ] = {};
-        if( lwnode_send_at_cmd( device, "AT+JOIN?", ack, sizeof( ack ) ) )
+        const uint32_t nowMs = lwnode_hal_get_time_ms();
+
+        if( ( lwnode_busy_state_at( device, nowMs ) == LWNODE_STATE_JOINING ) &&
+            !lwnode_time_reached( nowMs, device->joinStartMs + LWNODE_JOIN_ACCEPT_MS ) )
+        {
+            /* The join accept cannot have arrived yet */
+            device->busyStats.joinQueriesSkipped++;
+        }
+        else if( lwnode_send_at_cmd( device, "AT+JOIN?", NULL ) )
         {
-            if( lwnode_ack_equals(ack, "+JOIN=1\r\n") )
+            /* The reply stays in rxBuf until the next transaction */
+            result = lwnode_ack_equals( ( const char * ) device->rxBuf, "+JOIN=1\r\n" );
+
+            if( result && ( device->busyState == LWNODE_STATE_JOINING ) )
             {
-                result = true;
+                device->busyState = LWNODE_STATE_IDLE;
             }
-        }
-    }
 
-    return result;
+            lwnode_session_on_query( device, result );
+        }
+        else
+        {
+            /* No reply */
+        }
+    }
+
+    return result;
+}
+
+bool lwnode_session_resumed( const LwnodeDevice * const device )
+{
+    return ( ( device != NULL ) && device->sessionResumed );
+}
+
+bool lwnode_session_joined( const LwnodeDevice * const device )
+{
+    return ( ( device != NULL ) && ( device->session.joined != 0U ) );
+}
+
+bool lwnode_get_join_metrics( const LwnodeDevice * const device,
+                              LwnodeJoinMetrics * const out )
+{
+    bool result = false;
+
+    if( ( device != NULL ) && ( out != NULL ) )
+    {
+        *out = device->joinMetrics;
+        result = true;
+    }
+
+    return result;
 }
 
 bool lwnode_send_packet_bytes( LwnodeDevice * const device, 
@@ -791,71 +770,189 @@ bool lwnode_send_packet_bytes( LwnodeDevice * const device,
 {
     bool result = false;
 
-    if( ( device != NULL ) && ( data != NULL ) && 
-        ( len != 0U ) && ( len <= LWNODE_MAX_RX_BYTES ) )
-    {    
-        char cmd[ LWNODE_AT_CMD_MAX_LEN ] = {}; 
-        char hex[ ( LWNODE_MAX_RX_BYTES * 2U ) + 1U ];
-        char ack[ LWNODE_AT_ACK_MAX_LEN ];
-
-        /* Hex encode the raw bytes into ASCII hex */
-        if( num_fmt_hex_encode( data, len, hex, sizeof( hex ) ) )
+    if( lwnode_send_packet_submit( device, data, len, NULL, NULL ) )
+    {
+        if( lwnode_at_wait( device ) == LWNODE_AT_STATUS_OK )
         {
-            size_t hexLen = str_ext_strnlen( hex, sizeof( hex ) );
-        
-            ( void ) memcpy( cmd, LWNODE_SEND_PREFIX, LWNODE_SEND_PREFIX_LEN );
-
-            if( ( 8U + hexLen ) < sizeof( cmd ) )
-            {
-                ( void ) strncat( cmd, hex, sizeof( cmd ) - 9U );
-
-                if( lwnode_send_at_cmd( device, cmd, ack, sizeof( ack ) ) )
-                {
-                    if( lwnode_ack_equals( ack, "+SEND=OK\r\n" ) || 
-                        lwnode_ack_equals( ack, "AT+SEND=OK\r\n" ) )
-                    {
-                        result = true;
-                    }
-                }
-            }
+            result = lwnode_send_accepted( ( const char * ) device->rxBuf );
         }
     }
 
     return result;
 }
 
+bool lwnode_send_packet_submit( LwnodeDevice * const device,
+                                const uint8_t * const data,
+                                uint8_t len,
+                                LwnodeAtDoneCb doneCb,
+                                void * const ctx )
+{
+    bool result = false;
+
+    if( ( data != NULL ) && ( len != 0U ) && ( len <= LWNODE_MAX_LORA_PAYLOAD_LEN ) )
+    {
+        result = lwnode_at_arm( device, 
+                                LWNODE_SEND_PREFIX, 
+                                LWNODE_SEND_PREFIX_LEN, 
+                                data, 
+                                len, 
+                                doneCb, 
+                                ctx );
+    }
+
+    return result;
+}
 
 bool lwnode_sleep_ms( LwnodeDevice * const device, uint32_t ms)
 {
     if( device != NULL )
     {
-        uint32_t t = 0U;
-        uint16_t rx_len;
-
-        while (t < ms)
+        if( device->rxCb == NULL )
         {
-            /* If no callbacks registered, just delay in bounded steps */
-            if( device->rxCb == NULL )
+            /* No callbacks registered, just delay in bounded steps */
+            uint32_t t = 0U;
+
+            while( t < ms )
             {
-                uint32_t remaining = ms - t;
-                uint32_t step = ( remaining > 100U ) ? 100U : remaining;
+                const uint32_t remaining = ms - t;
+                const uint32_t step = ( remaining > LWNODE_RX_NO_CB_STEP_MS ) ? 
+                                      LWNODE_RX_NO_CB_STEP_MS : remaining;
                 lwnode_hal_delay_ms( step );
                 t += step;
-                continue;
             }
+        }
+        else if( device->rxMode == LWNODE_RX_MODE_POLL )
+        {
+            lwnode_sleep_poll_legacy( device, ms );
+        }
+        else
+        {
+            lwnode_sleep_event( device, ms );
+        }
+    }
 
-            /* Poll for queued data */
-            if( lwnode_read_lora_data( device, &rx_len ) )
-            {
-                ( void ) lwnode_process_recv_frames( device, device->rxBuf, rx_len );
-            }
+    return true;
+}
+
+bool lwnode_shadow_invalidate( LwnodeDevice * const device )
+{
+    bool result = false;
+
+    if( device != NULL )
+    {
+        lwnode_shadow_reset( device );
+        lwnode_shadow_sync( device );
+        result = !device->shadowDirty;
+    }
+
+    return result;
+}
+
+uint8_t lwnode_drain_rx( LwnodeDevice * const device )
+{
+    uint8_t frames = 0U;
+
+    if( ( device != NULL ) && ( device->sensor != NULL ) && ( device->rxCb != NULL ) &&
+        lwnode_rx_allowed( device, lwnode_hal_get_time_ms() ) )
+    {
+        frames = lwnode_drain_queue( device, NULL );
+    }
+
+    return frames;
+}
+
+bool lwnode_read_data_batch( LwnodeDevice * const device, 
+                             LwnodeRxBatch * const batch )
+{
+    bool result = false;
 
-            lwnode_hal_delay_ms( 1U );
-            t += 1U;
+    if( ( device != NULL ) && ( device->sensor != NULL ) && ( batch != NULL ) &&
+        ( batch->buf != NULL ) && ( batch->frames != NULL ) && ( batch->maxFrames != 0U ) )
+    {
+        batch->frameCount = 0U;
+        batch->bufUsed = 0U;
+
+        if( lwnode_rx_allowed( device, lwnode_hal_get_time_ms() ) )
+        {
+            result = ( lwnode_drain_queue( device, batch ) != 0U );
         }
     }
 
-    return true;
+    return result;
+}
+
+bool lwnode_set_rx_mode( LwnodeDevice * const device, LwnodeRxMode mode )
+{
+    bool result = false;
+
+    if( ( device != NULL ) && 
+        ( ( mode == LWNODE_RX_MODE_EVENT ) || ( mode == LWNODE_RX_MODE_POLL ) ) )
+    {
+        device->rxMode = mode;
+        device->rxIdleIntervalMs = LWNODE_RX_IDLE_MIN_MS;
+        device->rxNextPollMs = lwnode_hal_get_time_ms();
+        result = true;
+    }
+
+    return result;
+}
+
+bool lwnode_get_rx_stats( const LwnodeDevice * const device, 
+                          LwnodeRxStats * const out )
+{
+    bool result = false;
+
+    if( ( device != NULL ) && ( out != NULL ) )
+    {
+        *out = device->rxStats;
+        result = true;
+    }
+
+    return result;
+}
+
+LwnodeBusyState lwnode_get_busy_state( const LwnodeDevice * const device )
+{
+    LwnodeBusyState state = LWNODE_STATE_IDLE;
+
+    if( device != NULL )
+    {
+        state = lwnode_busy_state_at( device, lwnode_hal_get_time_ms() );
+    }
+
+    return state;
+}
+
+uint32_t lwnode_busy_remaining_ms( const LwnodeDevice * const device )
+{
+    uint32_t remainingMs = 0U;
+
+    if( device != NULL )
+    {
+        const uint32_t nowMs = lwnode_hal_get_time_ms();
+        const LwnodeBusyState state = lwnode_busy_state_at( device, nowMs );
+
+        if( ( state == LWNODE_STATE_JOINING ) || ( state == LWNODE_STATE_RECV_WINDOW ) )
+        {
+            remainingMs = device->busyUntilMs - nowMs;
+        }
+    }
+
+    return remainingMs;
+}
+
+bool lwnode_get_busy_stats( const LwnodeDevice * const device,
+                            LwnodeBusyStats * const out )
+{
+    bool result = false;
+
+    if( ( device != NULL ) && ( out != NULL ) )
+    {
+        *out = device->busyStats;
+        result = true;
+    }
+
+    return result;
 }
 
 bool lwnode_read_data_bytes( LwnodeDevice * const device, 
@@ -867,543 +964,2525 @@ bool lwnode_read_data_bytes( LwnodeDevice * const device,
     
     if( ( device != NULL ) && ( out != NULL ) && ( outLen != NULL ) && ( outMax != 0U ) )
     {
-        uint16_t rxLen = 0U;
+        LwnodeRxFrame frame = { 0 };
         *outLen = 0U;
 
-        if( lwnode_read_lora_data( device, &rxLen ) )
+        /* Only an empty downlink carries nothing to copy */
+        if( lwnode_read_frame( device, &frame ) && ( frame.len > 0U ) )
         {
-            /* LoRaWAN frame validation (must exceed metadata header) */
-            if( rxLen > LWNODE_LORAWAN_RX_METADATA_OFFSET )
-            {
-                /* Extract Metadata (RSSI/SNR) */
-                device->lastRssi = ( int8_t ) ( -( int8_t ) device->rxBuf[ LWNODE_RSSI_INDEX ] );
-                device->lastSnr  = 
-                    ( int8_t ) ( ( int8_t ) device->rxBuf[ LWNODE_SNR_INDEX ] - LWNODE_SNR_OFFSET );
-
-                /* Calculate payload size and apply bounds checking */
-                rxLen = ( uint16_t ) ( rxLen - LWNODE_LORAWAN_RX_METADATA_OFFSET );
-                
-                if( rxLen > outMax )
-                {
-                    rxLen = outMax;
-                }
+            uint16_t copyLen = ( uint16_t ) frame.len;
 
-                /* Copy payload and update output length */
-                ( void ) memcpy( out, 
-                                 &device->rxBuf[ LWNODE_LORAWAN_RX_METADATA_OFFSET ], 
-                                 rxLen );
-                *outLen = rxLen;
-                result = true;
+            if( copyLen > outMax )
+            {
+                copyLen = outMax;
             }
+
+            ( void ) memcpy( out, frame.payload, copyLen );
+            *outLen = copyLen;
+            result = true;
         }
     }
 
     return result;
 }
 
-/**
- * @brief Send a basic "AT" command to verify node responsiveness.
- *
- * Sends the ASCII "AT" command and checks for a standard "OK\r\n" response.
- *
- * @param[in,out] device Pointer to the LoRa node device instance.
- *
- * @retval true  Node responded with a valid OK acknowledgment.
- * @retval false Device is NULL, communication failed, or unexpected response.
- */
-static bool lwnode_at_test( LwnodeDevice * const device )
+bool lwnode_read_frame( LwnodeDevice * const device, LwnodeRxFrame * const frame )
 {
     bool result = false;
-    
-    if( device != NULL )
+    uint16_t rxLen = 0U;
+    LwnodeRxFrameIter it = { 0 };
+
+    if( ( frame != NULL ) &&
+        lwnode_read_lora_data( device, &rxLen ) &&
+        lwnode_rx_frames_begin( &it, device->rxBuf, rxLen ) &&
+        lwnode_rx_frames_next( &it, frame ) )
     {
-        char ack[ LWNODE_AT_ACK_MAX_LEN ] = {};
-        if( lwnode_send_at_cmd( device, "AT", ack, sizeof( ack ) ) )
-        {
-            if( lwnode_ack_equals( ack, "OK\r\n" ) )
-            {
-                result = true;
-            }
-        }
+        device->lastRssi = frame->rssi;
+        device->lastSnr  = frame->snr;
+        result = true;
     }
 
     return result;
 }
 
-/**
- * @brief Write an AT command payload to the node over I2C.
- *
- * The payload is written in fixed-size chunks due to I2C transfer limits.
- * All chunks except the final one are written using the long-write register.
- *
- * @param[in] device Pointer to the LoRa node device instance.
- * @param[in] data   Pointer to the AT command byte buffer.
- * @param[in] len    Total number of bytes to write.
- *
- * @retval true  All bytes were written successfully.
- * @retval false Invalid arguments or an I2C write failure occurred.
- */
-static bool lwnode_write_at_bytes( const LwnodeDevice * const device, 
-                                   const uint8_t * const data, 
-                                   uint16_t len )
+bool lwnode_rx_frames_begin( LwnodeRxFrameIter * const it, 
+                             const uint8_t * const buf, 
+                             uint16_t len )
 {
     bool result = false;
 
-    if( ( device != NULL ) && ( device->sensor != NULL ) && ( data != NULL ) )
+    if( ( it != NULL ) && ( ( buf != NULL ) || ( len == 0U ) ) )
     {
-        uint16_t left = len;
-        uint16_t offset = 0U;
-        bool writeFailed = false;
+        it->buf = buf;
+        it->len = len;
+        it->pos = 0U;
+        it->malformed = false;
+        result = true;
+    }
 
-        /* Process data in 30-byte chunks */
-        while( ( left > LWNODE_I2C_CHUNK_SIZE ) && ( !writeFailed ) )
-        {
-            if( lwnode_hal_write( device->sensor, 
-                                  REG_WRITE_AT_LONG,
-                                  &data[ offset ], 
-                                  LWNODE_I2C_CHUNK_SIZE ) )
-            {
-                offset = ( uint16_t ) ( offset + LWNODE_I2C_CHUNK_SIZE );
-                left   = ( uint16_t ) ( left - LWNODE_I2C_CHUNK_SIZE );
-                lwnode_hal_delay_ms( LWNODE_I2C_CHUNK_DELAY_MS );
-            }
-            else
-            {
-                writeFailed = true;
-            }
-        }
+    return result;
+}
 
-        /* Process the remaining bytes (final chunk) */
-        if( ( !writeFailed ) && ( left > 0U ) )
+bool lwnode_rx_frames_next( LwnodeRxFrameIter * const it, LwnodeRxFrame * const frame )
+{
+    bool result = false;
+
+    if( ( it != NULL ) && ( frame != NULL ) && ( it->pos < it->len ) )
+    {
+        const uint8_t * const p = &it->buf[ it->pos ];
+        const uint16_t left = ( uint16_t ) ( it->len - it->pos );
+        const uint16_t headerEnd = ( uint16_t ) ( LWNODE_RECV_PREFIX_LEN + LWNODE_RECV_HEADER_SIZE );
+
+        if( ( left >= headerEnd ) &&
+            str_ext_starts_with( p, ( size_t ) left, LWNODE_RECV_PREFIX, LWNODE_RECV_PREFIX_LEN ) &&
+            ( left >= ( uint16_t ) ( headerEnd + p[ LWNODE_RECV_PREFIX_LEN + LWNODE_RECV_PAYLEN_OFFSET ] ) ) )
         {
-            if( lwnode_hal_write( device->sensor, 
-                                  REG_WRITE_AT, 
-                                  &data[ offset ], 
-                                  ( size_t ) left ) )
+            const uint8_t * const header = &p[ LWNODE_RECV_PREFIX_LEN ];
+            uint16_t step = ( uint16_t ) ( headerEnd + header[ LWNODE_RECV_PAYLEN_OFFSET ] );
+
+            frame->payload = &p[ headerEnd ];
+            frame->len = header[ LWNODE_RECV_PAYLEN_OFFSET ];
+            frame->rssi = ( int8_t ) ( -( int8_t ) header[ LWNODE_RECV_RSSI_OFFSET ] );
+            frame->snr = ( int8_t ) ( ( int8_t ) header[ LWNODE_RECV_SNR_OFFSET ] - LWNODE_SNR_NORM_FACTOR );
+
+            /* Optional CR LF between frames */
+            if( ( left >= ( uint16_t ) ( step + 2U ) ) &&
+                ( p[ step ] == ( uint8_t ) '\r' ) && ( p[ step + 1U ] == ( uint8_t ) '\n' ) )
             {
-                result = true;
+                step = ( uint16_t ) ( step + 2U );
             }
-        }
-        else if( !writeFailed )
-        {
-            /* Len was exactly a multiple of 30 and no bytes are left */
+
+            it->pos = ( uint16_t ) ( it->pos + step );
             result = true;
         }
         else
         {
-            /* Result remains false due to writeFailed */
+            /* Misaligned or truncated: nothing after this point is trusted */
+            it->malformed = true;
+            it->pos = it->len;
         }
     }
 
     return result;
 }
 
-/**
- * @brief Read an AT command acknowledgment from the node.
- *
- * Reads the pending ACK length first, then retrieves the ACK data into
- * the device RX buffer in bounded chunks.
- *
- * @param[in,out] device Pointer to the LoRa node device instance.
- * @param[out]    outLen Number of bytes read into the RX buffer.
- *
- * @retval true  A valid acknowledgment was read successfully.
- * @retval false Invalid arguments, no ACK available, or read failure.
- */
-static bool lwnode_read_ack_bytes( LwnodeDevice * const device, 
-                                   uint16_t * const outLen )
+bool lwnode_at_submit( LwnodeDevice * const device,
+                       const char * const cmdAscii,
+                       LwnodeAtDoneCb doneCb,
+                       void * const ctx )
 {
     bool result = false;
-    
 
-    if( ( device != NULL ) && ( device->sensor != NULL ) && ( outLen != NULL ) )
+    if( cmdAscii != NULL )
     {
-        uint8_t ucLen = 0U;
-        *outLen = 0U;
+        const size_t cmdLen = str_ext_strnlen( cmdAscii, LWNODE_AT_CMD_MAX_LEN + 1U );
 
-        /* Read the length of the pending ACK */
-        if( lwnode_hal_read( device->sensor, REG_READ_AT_LEN, &ucLen, 1U ) )
-        {
-            const uint16_t usLen = ( uint16_t ) ucLen;
+        result = lwnode_at_arm( device, cmdAscii, cmdLen, NULL, 0U, doneCb, ctx );
+    }
 
-            /* Validate length bounds */
-            if( ( usLen > 0U ) && ( usLen <= LWNODE_AT_ACK_MAX_LEN ) )
-            {
-                uint16_t left = usLen;
-                uint16_t offset = 0U;
-                bool readFailed = false;
+    return result;
+}
 
-                /* Read ACK data in chunks */
-                while( ( left > LWNODE_I2C_CHUNK_SIZE ) && ( !readFailed ) )
-                {
-                    if( lwnode_hal_read( device->sensor, 
-                                         REG_READ_AT, 
-                                         &device->rxBuf[ offset ], 
-                                         LWNODE_I2C_CHUNK_SIZE ) )
-                    {
-                        offset = ( uint16_t ) ( offset + LWNODE_I2C_CHUNK_SIZE );
-                        left   = ( uint16_t ) ( left - LWNODE_I2C_CHUNK_SIZE );
-                    }
-                    else
-                    {
-                        readFailed = true;
-                    }
-                }
+LwnodeAtStatus lwnode_at_poll( LwnodeDevice * const device )
+{
+    LwnodeAtStatus status = LWNODE_AT_STATUS_IDLE;
 
-                /* Read final partial chunk */
-                if( ( !readFailed ) && ( left > 0U ) )
-                {
-                    if( lwnode_hal_read( device->sensor, 
-                                         REG_READ_AT, 
-                                         &device->rxBuf[ offset ], 
-                                         ( size_t ) left ) )
-                    {
-                        *outLen = usLen;
-                        result = true;
-                    }
-                }
-                else if( !readFailed )
-                {
-                    /* Len was exactly a multiple of chunk size */
-                    *outLen = usLen;
-                    result = true;
-                }
-                else
-                {
-                    /* Result remains false due to readFailed */
-                }
-            }
+    if( device != NULL )
+    {
+        const uint32_t nowMs = lwnode_hal_get_time_ms();
 
-            if( result )
+        if( ( device->at.phase != LWNODE_AT_PHASE_IDLE ) && 
+            lwnode_time_reached( nowMs, device->at.nextActionMs ) )
+        {
+            switch( device->at.phase )
             {
-                if( usLen < LWNODE_MAX_RX_BYTES )
-                {
-                    device->rxBuf[ usLen ] = '\0';
-                }
+                case LWNODE_AT_PHASE_WRITE:
+                    lwnode_at_step_write( device, nowMs );
+                    break;
+                case LWNODE_AT_PHASE_WAIT_ACK:
+                    lwnode_at_step_ack( device, nowMs );
+                    break;
+                default:
+                    /* Nothing in flight */
+                    break;
             }
         }
+
+        status = device->at.status;
     }
 
-    return result;
+    return status;
 }
 
-/**
- * @brief Compare an AT acknowledgment string against an expected value.
- *
- * Performs a full string comparison, including line terminators.
- *
- * @param[in] ack      Pointer to the received ACK string.
- * @param[in] expected Pointer to the expected ACK string.
- *
- * @retval true  Strings match exactly.
- * @retval false One or both pointers are NULL or strings differ.
- */
-static bool lwnode_ack_equals( const char * const ack, 
-                               const char * const expected )
+uint32_t lwnode_at_next_poll_ms( const LwnodeDevice * const device )
 {
-    bool result = false;
+    uint32_t waitMs = 0U;
 
-    if( ( ack != NULL ) && ( expected != NULL ) )
+    if( ( device != NULL ) && ( device->at.phase != LWNODE_AT_PHASE_IDLE ) )
     {
-        if( strcmp( ack, expected ) == 0 )
+        const uint32_t nowMs = lwnode_hal_get_time_ms();
+
+        if( !lwnode_time_reached( nowMs, device->at.nextActionMs ) )
         {
-            result = true;
+            waitMs = device->at.nextActionMs - nowMs;
         }
     }
-    return result;
+
+    return waitMs;
 }
 
-/**
- * @brief Read a queued LoRa payload from the node.
- *
- * Reads the length of the pending data packet, validates it against
- * hardware and buffer limits, and then reads the payload into the RX buffer.
- *
- * @param[in,out] device Pointer to the LoRa node device instance.
- * @param[out]    outLen Number of bytes read into the RX buffer.
- *
- * @retval true  A complete LoRa packet was read successfully.
- * @retval false Invalid arguments, no data available, or read failure.
- */
-static bool lwnode_read_lora_data( LwnodeDevice * const device, 
-                                   uint16_t * const outLen )
+uint32_t lwnode_at_last_ack_latency_ms( const LwnodeDevice * const device )
+{
+    uint32_t latencyMs = 0U;
+
+    if( device != NULL )
+    {
+        latencyMs = device->at.ackLatencyMs;
+    }
+
+    return latencyMs;
+}
+
+bool lwnode_set_chunk_gap_ms( LwnodeDevice * const device, uint32_t gapMs )
 {
     bool result = false;
-    uint8_t ucLen = 0U;
 
-    if ( ( device != NULL ) && ( device->sensor != NULL ) && ( outLen != NULL ) )
+    if( device != NULL )
     {
-        *outLen = 0U;
+        device->chunkGapMs = gapMs;
+        result = true;
+    }
 
-        /* Read the length of the data packet in the queue */
-        if( lwnode_hal_read( device->sensor, REG_READ_DATA_LEN, &ucLen, 1U ) )
-        {
-            const uint16_t usLen = ( uint16_t ) ucLen;
+    return result;
+}
 
-            /* Validate length against hardware limits and buffer capacity */
-            if( ( usLen > 0U ) && 
-                ( usLen <= LWNODE_MAX_LORA_PAYLOAD_LEN ) && 
-                ( usLen <= LWNODE_MAX_RX_BYTES ) )
-            {
-                uint16_t left = usLen;
-                uint16_t offset = 0U;
-                bool readFailed = false;
+bool lwnode_calibrate_chunk_gap( LwnodeDevice * const device,
+                                 const char * const probeCmd,
+                                 const char * const expectedAck,
+                                 uint32_t * const gapMsOut )
+{
+    bool result = false;
 
-                lwnode_hal_delay_ms( LWNODE_READ_DATA_DELAY_MS );
+    if( ( device != NULL ) && ( probeCmd != NULL ) && ( expectedAck != NULL ) &&
+        ( str_ext_strnlen( probeCmd, LWNODE_AT_CMD_MAX_LEN ) >= LWNODE_I2C_CHUNK_SIZE ) )
+    {
+        const uint32_t previousGapMs = device->chunkGapMs;
+        uint32_t lo = 0U;
+        uint32_t hi = LWNODE_I2C_CHUNK_DELAY_MS;
 
-                /* Read packet data in chunks */
-                while( ( left > LWNODE_I2C_CHUNK_SIZE ) && ( !readFailed ) )
-                {
-                    if( lwnode_hal_read( device->sensor, 
-                                         REG_READ_DATA, 
-                                         &device->rxBuf[ offset ], 
-                                         LWNODE_I2C_CHUNK_SIZE ) )
-                    {
-                        offset = ( uint16_t ) ( offset + LWNODE_I2C_CHUNK_SIZE );
-                        left   = ( uint16_t ) ( left - LWNODE_I2C_CHUNK_SIZE );
-                    }
-                    else
-                    {
-                        readFailed = true;
-                    }
-                }
+        /* The conservative default must work, otherwise the probe is bad */
+        if( lwnode_chunk_gap_passes( device, probeCmd, expectedAck, hi ) )
+        {
+            while( lo < hi )
+            {
+                const uint32_t mid = lo + ( ( hi - lo ) / 2U );
 
-                /* Read final partial chunk */
-                if( ( !readFailed ) && ( left > 0U ) )
-                {
-                    if( lwnode_hal_read( device->sensor,
-                                         REG_READ_DATA, 
-                                         &device->rxBuf[ offset ], 
-                                         ( size_t ) left ) )
-                    {
-                        *outLen = usLen;
-                        result = true;
-                    }
-                }
-                else if( !readFailed )
+                if( lwnode_chunk_gap_passes( device, probeCmd, expectedAck, mid ) )
                 {
-                    /* Exact multiple of chunk size */
-                    *outLen = usLen;
-                    result = true;
+                    hi = mid;
                 }
                 else
                 {
-                    /* Result remains false due to readFailed */
+                    lo = mid + 1U;
                 }
             }
+
+            device->chunkGapMs = hi + LWNODE_CHUNK_GAP_MARGIN_MS;
+
+            if( device->chunkGapMs > LWNODE_I2C_CHUNK_DELAY_MS )
+            {
+                device->chunkGapMs = LWNODE_I2C_CHUNK_DELAY_MS;
+            }
+
+            if( gapMsOut != NULL )
+            {
+                *gapMsOut = hi;
+            }
+            result = true;
+        }
+        else
+        {
+            device->chunkGapMs = previousGapMs;
         }
     }
 
     return result;
 }
 
-/**
- * @brief Parse "+RECV=" frames and dispatch received payloads.
- *
- * Parses one or more "+RECV=" frames from a raw buffer, extracts RSSI,
- * SNR, and payload data, and invokes the registered RX callback.
- *
- * Expected frame format:
- *   "+RECV=" [RSSI][SNR][LEN][PAYLOAD][\\r\\n]
- *
- * @param[in,out] device Pointer to the LoRa node device instance.
- * @param[in]     buf    Pointer to the received data buffer.
- * @param[in]     len    Length of the received buffer in bytes.
- *
- * @retval true  All frames were parsed and processed successfully.
- * @retval false Protocol error, malformed frame, or invalid arguments.
- */
-static bool lwnode_process_recv_frames( LwnodeDevice * const device, 
-                                        const uint8_t * const buf, 
-                                        uint16_t len )
+bool lwnode_at_busy( const LwnodeDevice * const device )
+{
+    bool result = false;
+
+    if( ( device != NULL ) && ( device->at.phase != LWNODE_AT_PHASE_IDLE ) )
+    {
+        result = true;
+    }
+
+    return result;
+}
+
+bool lwnode_get_cmd_stats( const LwnodeDevice * const device,
+                           LwnodeCmdType type,
+                           LwnodeCmdReport * const out )
+{
+    bool result = false;
+
+#if ( LWNODE_STATS_ENABLED != 0 )
+    if( ( device != NULL ) && ( out != NULL ) && ( ( uint32_t ) type < LWNODE_CMD_TYPE_COUNT ) )
+    {
+        const LwnodeCmdStats * const stats = &device->cmdStats[ type ];
+
+        out->count = stats->count;
+        out->failures = stats->failures;
+        out->retries = stats->retries;
+        lwnode_stats_summarize( &stats->write, &out->write );
+        lwnode_stats_summarize( &stats->ack, &out->ack );
+        lwnode_stats_summarize( &stats->total, &out->total );
+        out->bytesWritten = stats->bytesWritten;
+        out->bytesRead = stats->bytesRead;
+        out->ackPolls = stats->ackPolls;
+        result = true;
+    }
+#else
+    ( void ) device;
+    ( void ) type;
+    ( void ) out;
+#endif
+
+    return result;
+}
+
+bool lwnode_reset_cmd_stats( LwnodeDevice * const device )
 {
     bool result = false;
-    const uint8_t *p = buf;
-    uint16_t left = len;
-    bool processActive = false;
 
-    if( ( device != NULL ) && ( buf != NULL ) && ( len != 0U ) && ( device->rxCb != NULL ) )
+#if ( LWNODE_STATS_ENABLED != 0 )
+    if( device != NULL )
     {
-        processActive = true;
-        /* Default to true once we start,only set false if protocol error */
+        ( void ) memset( device->cmdStats, 0, sizeof( device->cmdStats ) );
+        device->statsLastFailed = false;
         result = true;
     }
+#else
+    ( void ) device;
+#endif
+
+    return result;
+}
+
+size_t lwnode_dump_cmd_stats( const LwnodeDevice * const device,
+                              char * const out,
+                              size_t outCap )
+{
+    size_t len = 0U;
+
+#if ( LWNODE_STATS_ENABLED != 0 )
+    static const char * const typeNames[ LWNODE_CMD_TYPE_COUNT ] =
+    {
+        "AT", "REBOOT", "JOIN", "JOIN?", "SEND", "CFG", "OTHER"
+    };
 
-    /* Frame Parsing Loop */
-    while( ( processActive ) && ( left >= LWNODE_RECV_PREFIX_LEN ) )
+    if( ( device != NULL ) && ( out != NULL ) && ( outCap > 0U ) )
     {
-        /* Sync to the next "+RECV=" prefix */
-        if( str_ext_starts_with( p, ( size_t ) left, LWNODE_RECV_PREFIX, LWNODE_RECV_PREFIX_LEN ) )
+        size_t pos = 0U;
+        bool fits = true;
+
+        out[ 0 ] = '\0';
+
+        for( uint32_t type = 0U; ( type < LWNODE_CMD_TYPE_COUNT ) && fits; type++ )
         {
-            p    = &p[ LWNODE_RECV_PREFIX_LEN ];
-            left = ( uint16_t )( left - LWNODE_RECV_PREFIX_LEN );
+            const LwnodeCmdStats * const stats = &device->cmdStats[ type ];
 
-            /* Validate Metadata Header presence */
-            if( left >= LWNODE_RECV_HEADER_SIZE )
+            if( stats->count > 0U )
             {
-                const int8_t rssi = ( int8_t ) ( -( int8_t ) p[ LWNODE_RECV_RSSI_OFFSET ] );
-                const int8_t snr = 
-                    ( int8_t ) ( ( int8_t ) p[ LWNODE_RECV_SNR_OFFSET ] - LWNODE_SNR_NORM_FACTOR );
-                const uint8_t payLen = p[ LWNODE_RECV_PAYLEN_OFFSET ];
+                fits = ( ( pos == 0U ) || lwnode_stats_append( out, outCap, &pos, ";" ) ) &&
+                       lwnode_stats_append( out, outCap, &pos, typeNames[ type ] ) &&
+                       lwnode_stats_append( out, outCap, &pos, " c=" ) &&
+                       lwnode_stats_append_u32( out, outCap, &pos, stats->count ) &&
+                       lwnode_stats_append( out, outCap, &pos, " f=" ) &&
+                       lwnode_stats_append_u32( out, outCap, &pos, stats->failures ) &&
+                       lwnode_stats_append( out, outCap, &pos, " r=" ) &&
+                       lwnode_stats_append_u32( out, outCap, &pos, stats->retries ) &&
+                       lwnode_stats_append_latency( out, outCap, &pos, " w=", &stats->write ) &&
+                       lwnode_stats_append_latency( out, outCap, &pos, " a=", &stats->ack ) &&
+                       lwnode_stats_append_latency( out, outCap, &pos, " t=", &stats->total ) &&
+                       lwnode_stats_append( out, outCap, &pos, " b=" ) &&
+                       lwnode_stats_append_u32( out, outCap, &pos, stats->bytesWritten ) &&
+                       lwnode_stats_append( out, outCap, &pos, "/" ) &&
+                       lwnode_stats_append_u32( out, outCap, &pos, stats->bytesRead ) &&
+                       lwnode_stats_append( out, outCap, &pos, " p=" ) &&
+                       lwnode_stats_append_u32( out, outCap, &pos, stats->ackPolls );
+            }
+        }
 
-                /* Validate Payload exists in the remaining buffer */
-                if( left >= ( uint16_t ) ( LWNODE_RECV_HEADER_SIZE + ( uint16_t ) payLen ) )
-                {
-                    device->lastRssi = rssi;
-                    device->lastSnr  = snr;
+        if( fits )
+        {
+            len = pos;
+        }
+        else
+        {
+            out[ 0 ] = '\0';
+        }
+    }
+#else
+    ( void ) device;
+    ( void ) out;
+    ( void ) outCap;
+#endif
 
-                    if( payLen > 0U )
-                    {
-                        device->rxCb( &p[ LWNODE_RECV_HEADER_SIZE ], payLen, rssi, snr );
-                    }
+    return len;
+}
 
-                    uint16_t step = ( uint16_t ) ( ( uint16_t ) payLen + LWNODE_RECV_HEADER_SIZE );
+/**
+ * @brief Shared implementation of lwnode_begin() and lwnode_begin_bounded().
+ *
+ * @param[in,out] device   Pointer to the LoRa node device instance.
+ * @param[in]     budgetMs Total time budget, 0 for the unbounded legacy
+ *                         behaviour.
+ *
+ * @retval true  Module is configured and ready.
+ * @retval false Communication failed, was rejected, or ran out of budget.
+ */
+static bool lwnode_begin_internal( LwnodeDevice * const device,
+                                   uint32_t budgetMs )
+{
+    bool result = false;
 
-                    /* Check for trailing \r\n */
-                    if( ( left > ( uint16_t ) ( step + 1U ) ) && 
-                        ( p[ step ] == ( uint8_t ) '\r' ) )
-                    {
-                        step = ( uint16_t ) ( step + 2U );
-                    }
+    if( ( device != NULL ) && ( device->sensor != NULL ) )
+    {    
+        uint8_t retry = LWNODE_BEGIN_RETRY_COUNT;
+        bool warm = false;
+        uint32_t appliedBefore = 0U;
 
-                    if( left >= step )
-                    {
-                        p = &p[ step ];
-                        left = ( uint16_t ) ( left - step );
-                    }
-                    else
-                    {
-                        /* Logic error or buffer underflow */
-                        processActive = false;
-                        result = false;
-                    }
+        device->beginStartMs = lwnode_hal_get_time_ms();
+        device->sessionResumed = false;
+        device->joinPending = false;
+        device->isReady = false;
+        device->busyState = LWNODE_STATE_IDLE;
+
+        if( budgetMs != 0U )
+        {
+            device->budgetArmed = true;
+            device->budgetDeadlineMs = device->beginStartMs + budgetMs;
+
+            /* Fast fail: an absent module NACKs its address */
+            if( ( device->transport->probe != NULL ) &&
+                !device->transport->probe( device->transportCtx ) )
+            {
+                retry = 0U;
+            }
+        }
+
+        /* Keep a live session instead of rebooting the module out of it */
+        if( ( retry > 0U ) && lwnode_session_can_resume( device ) )
+        {
+            warm = lwnode_is_joined( device );
+        }
+
+        if( ( retry > 0U ) && !warm )
+        {
+            ( void ) lwnode_send_at_cmd( device, "AT+REBOOT", NULL );
+            lwnode_budget_delay_ms( device, 100U );
+        }
+
+        /* AT Test */
+        while( ( retry > 0U ) && ( lwnode_budget_remaining_ms( device ) > 0U ) )
+        {
+            if( lwnode_at_test( device ) )
+            {
+                result = true;
+                break;
+            }
+            retry--;
+            lwnode_budget_delay_ms( device, 10U ); /* Small yield during init */
+        }
+
+        /* Store the shadow once at the end instead of per command */
+        device->shadowDeferStore = true;
+        appliedBefore = device->shadowApplied;
+
+        /* Global Configuration (Only if AT test passed) */
+        if( result )
+        {
+            /* Enable receive queue */
+            ( void ) lwnode_apply_cfg( device, "AT+RECV=1", NULL, LWNODE_SHADOW_RECV,
+                                       NULL, NULL, 0U );
+            
+            /* Set mode to LoRaWAN: OTAA and ABP */
+            result = lwnode_apply_cfg( device, "AT+LORAMODE=LORAWAN", NULL, LWNODE_SHADOW_LORAMODE,
+                                       NULL, NULL, 0U );
+        }
+
+        /* Join Type Specific Configuration */
+        if( result )
+        {
+            const uint8_t joinType = ( uint8_t ) device->joinType;
+
+            if( device->joinType == LWNODE_JOIN_ABP )
+            {
+                result = lwnode_apply_cfg( device, "AT+JOINTYPE=ABP", "+JOINTYPE=OK\r\n",
+                                           LWNODE_SHADOW_JOINTYPE,
+                                           &device->shadow.joinType, &joinType,
+                                           sizeof( device->shadow.joinType ) );
+
+                if( result && ( ( device->keyMask & LWNODE_SHADOW_NWK_SKEY ) != 0U ) )
+                {
+                    result = lwnode_cfg_exec( device, LWNODE_CFG_NWK_SKEY, device->nwkSkey );
                 }
-                else
+                if( result && ( ( device->keyMask & LWNODE_SHADOW_APP_SKEY ) != 0U ) )
+                {
+                    result = lwnode_cfg_exec( device, LWNODE_CFG_APP_SKEY, device->appSkey );
+                }
+                if( result && ( device->devAddr != 0U ) )
                 {
-                    /* Incomplete payload */
-                    processActive = false; 
-                    result = false;
+                    result = lwnode_set_dev_addr( device, device->devAddr );
                 }
             }
-            else
+            else /* LWNODE_JOIN_OTAA */
             {
-                /* Incomplete header */
-                processActive = false; 
-                result = false;
+                result = lwnode_apply_cfg( device, "AT+JOINTYPE=OTAA", "+JOINTYPE=OK\r\n",
+                                           LWNODE_SHADOW_JOINTYPE,
+                                           &device->shadow.joinType, &joinType,
+                                           sizeof( device->shadow.joinType ) );
+
+                if( result && ( ( device->keyMask & LWNODE_SHADOW_APP_EUI ) != 0U ) )
+                {
+                    result = lwnode_cfg_exec( device, LWNODE_CFG_APP_EUI, device->appEui );
+                }
+                if( result && ( ( device->keyMask & LWNODE_SHADOW_APP_KEY ) != 0U ) )
+                {
+                    result = lwnode_cfg_exec( device, LWNODE_CFG_APP_KEY, device->appKey );
+                }
             }
         }
-        else
+
+        device->shadowDeferStore = false;
+        lwnode_shadow_sync( device );
+
+        if( result )
         {
-            /* Misalignment: The buffer does not start with +RECV= as expected */
-            processActive = false;
-            result = false;
+            const uint32_t elapsedMs = lwnode_hal_get_time_ms() - device->beginStartMs;
+
+            /* A re-sent setting may not apply to the running session */
+            if( warm && ( device->shadowApplied == appliedBefore ) )
+            {
+                device->sessionResumed = true;
+                device->session.warmBoots++;
+                device->joinMetrics.warmBoots++;
+                device->joinMetrics.lastReadyMs = elapsedMs;
+            }
+            else
+            {
+                device->session.joined = 0U;
+                device->joinMetrics.coldBoots++;
+            }
+
+            device->joinMetrics.lastBeginMs = elapsedMs;
+            device->joinMetrics.lastBootWarm = device->sessionResumed;
+            lwnode_session_store( device );
         }
+
+        device->budgetArmed = false;
+        device->isReady = result;
     }
 
     return result;
 }
 
 /**
- * @brief Poll for an AT acknowledgment with cooperative task yielding.
- *
- * Repeatedly attempts to read an ACK, yielding between attempts to allow
- * other tasks to execute.
+ * @brief Time left in the lwnode_begin_bounded() budget.
  *
- * @param[in,out] device Pointer to the LoRa node device instance.
- * @param[out]    outLen Number of bytes read into the RX buffer.
+ * @param[in] device Pointer to the LoRa node device instance.
  *
- * @retval true  An acknowledgment was received within the timeout window.
- * @retval false Timeout expired or read failure occurred.
+ * @return Remaining milliseconds, 0 once expired, UINT32_MAX if no budget
+ *         is armed.
  */
-static bool lwnode_read_ack_with_yield( LwnodeDevice * const device,
-                                        uint16_t * const outLen )
+static uint32_t lwnode_budget_remaining_ms( const LwnodeDevice * const device )
 {
-    bool result = false;
-    uint16_t attempts = 0U;
+    uint32_t remainingMs = UINT32_MAX;
 
-    while( attempts < LWNODE_AT_ACK_TIMEOUT_LOOPS )
+    if( device->budgetArmed )
     {
-        if( lwnode_read_ack_bytes( device, outLen ) )
+        const uint32_t nowMs = lwnode_hal_get_time_ms();
+
+        if( lwnode_time_reached( nowMs, device->budgetDeadlineMs ) )
         {
-            result = true;
-            break;
+            remainingMs = 0U;
+        }
+        else
+        {
+            remainingMs = device->budgetDeadlineMs - nowMs;
         }
-        
-        // Yield for 1ms to let other tasks run
-        lwnode_hal_delay_ms( LWNODE_AT_ACK_POLL_DELAY_MS );
-        attempts++;
     }
-    return result;
+
+    return remainingMs;
 }
 
 /**
- * @brief Send an ASCII AT command and retrieve its acknowledgment.
+ * @brief Delay, but never past the end of the lwnode_begin_bounded() budget.
  *
- * Appends CRLF to the command, writes it to the node, then polls for
- * the acknowledgment. The ACK is copied into a caller-provided buffer
- * and null-terminated.
+ * @param[in] device  Pointer to the LoRa node device instance.
+ * @param[in] delayMs Requested delay in milliseconds.
+ */
+static void lwnode_budget_delay_ms( const LwnodeDevice * const device, uint32_t delayMs )
+{
+    const uint32_t remainingMs = lwnode_budget_remaining_ms( device );
+
+    lwnode_hal_delay_ms( ( remainingMs < delayMs ) ? remainingMs : delayMs );
+}
+
+/**
+ * @brief Send a basic "AT" command to verify node responsiveness.
  *
- * Interrupt-driven processing is temporarily disabled during the
- * transaction.
+ * Sends the ASCII "AT" command and checks for a standard "OK\r\n" response.
  *
  * @param[in,out] device Pointer to the LoRa node device instance.
- * @param[in]     cmdAscii Null-terminated ASCII AT command (without CRLF).
- * @param[out]    ackBuf   Buffer to receive the acknowledgment string.
- * @param[in]     ackCap   Capacity of the acknowledgment buffer.
  *
- * @retval true  Command sent and acknowledgment received successfully.
- * @retval false Invalid arguments, write failure, or timeout.
+ * @retval true  Node responded with a valid OK acknowledgment.
+ * @retval false Device is NULL, communication failed, or unexpected response.
  */
-static bool lwnode_send_at_cmd( LwnodeDevice * const device,
-                                const char * const cmdAscii,
-                                char * const ackBuf,
-                                size_t ackCap )
+static bool lwnode_at_test( LwnodeDevice * const device )
 {
     bool result = false;
-
-    if( ( device != NULL ) && ( device->sensor != NULL ) && ( cmdAscii != NULL ) && 
-        ( ackBuf != NULL ) && ( ackCap >= 2U ) ) 
+    
+    if( device != NULL )
     {
-        const size_t cmdLen = str_ext_strnlen( cmdAscii, 
-                                               ( size_t ) ( LWNODE_AT_CMD_MAX_LEN - 3U ) );
-        
-        if( cmdLen > 0U ) 
-        {
-            uint8_t tx[ LWNODE_AT_CMD_MAX_LEN ] = {};
-
-            ( void ) memcpy( tx, cmdAscii, cmdLen );
-            tx[ cmdLen ]      = ( uint8_t ) '\r';
-            tx[ cmdLen + 1U ] = ( uint8_t ) '\n';
+        result = lwnode_send_at_cmd( device, "AT", "OK\r\n" );
+    }
 
-            device->intEnabled = false;
+    return result;
+}
 
-            if( lwnode_write_at_bytes( device, tx, ( uint16_t ) ( cmdLen + 2U ) ) ) 
-            {
-                lwnode_hal_delay_ms( LWNODE_AT_POST_WRITE_DELAY_MS );
-                
-                uint16_t actualAckLen = 0;
-                /* Poll for Response */
-                if( lwnode_read_ack_with_yield( device, &actualAckLen ) ) 
-                {
-                    /* Buffer Copy */
-                    if( actualAckLen >= ( uint16_t ) ackCap ) 
-                    {
-                        actualAckLen = ( uint16_t ) ( ackCap - 1U );
-                    }
+/**
+ * @brief Write one AT command chunk through the selected transport.
+ *
+ * @param[in] device  Pointer to the LoRa node device instance.
+ * @param[in] data    Pointer to the chunk bytes.
+ * @param[in] len     Number of bytes in the chunk.
+ * @param[in] isFinal true if this chunk completes the command.
+ *
+ * @retval true  The chunk was written successfully.
+ * @retval false Invalid arguments or a transport write failure occurred.
+ */
+static bool lwnode_write_at_bytes( const LwnodeDevice * const device, 
+                                   const uint8_t * const data, 
+                                   uint16_t len,
+                                   bool isFinal )
+{
+    bool result = false;
 
-                    for( uint16_t i = 0U; i < actualAckLen; ++i ) 
-                    {
-                        ackBuf[ i ] = ( char ) device->rxBuf[ i ];
-                    }
-                    ackBuf[ actualAckLen ] = '\0';
-                    
-                    result = true;
-                }
-            }
+    if( ( device != NULL ) && ( device->sensor != NULL ) && ( data != NULL ) &&
+        ( len != 0U ) && ( len <= LWNODE_I2C_CHUNK_SIZE ) )
+    {
+        result = device->transport->write_at( device->transportCtx, data, ( size_t ) len, isFinal );
+    }
 
-            device->intEnabled = true;
+    return result;
+}
+
+/**
+ * @brief Read an AT command acknowledgment from the node.
+ *
+ * Retrieves the pending reply through the selected transport into the
+ * device RX buffer and null-terminates it.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[out]    outLen Number of bytes read into the RX buffer.
+ *
+ * @retval true  A valid acknowledgment was read successfully.
+ * @retval false Invalid arguments, no ACK available, or read failure.
+ */
+static bool lwnode_read_ack_bytes( LwnodeDevice * const device, 
+                                   uint16_t * const outLen )
+{
+    bool result = false;
+
+    if( ( device != NULL ) && ( device->sensor != NULL ) && ( outLen != NULL ) )
+    {
+        *outLen = 0U;
+
+        if( device->transport->read_at( device->transportCtx, 
+                                        device->rxBuf, 
+                                        LWNODE_AT_REPLY_MAX_LEN, 
+                                        outLen ) &&
+            ( *outLen > 0U ) && ( *outLen <= LWNODE_AT_REPLY_MAX_LEN ) )
+        {
+            LWNODE_STATS_ADD( device, bytesRead, *outLen );
+            device->rxBuf[ *outLen ] = '\0';
+            result = true;
+        }
+        else
+        {
+            *outLen = 0U;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Check that the module acknowledges its I2C address.
+ *
+ * @param[in] ctx Device instance.
+ *
+ * @retval true  The module ACKed its address.
+ * @retval false No module on the bus.
+ */
+static bool lwnode_i2c_probe( void * const ctx )
+{
+    const LwnodeDevice * const device = ( const LwnodeDevice * ) ctx;
+
+    return lwnode_hal_probe( device->sensor );
+}
+
+/**
+ * @brief Write one AT command chunk to the node over I2C.
+ *
+ * The module accepts at most LWNODE_I2C_CHUNK_SIZE bytes per transfer.
+ * Intermediate chunks use the long-write register, the final chunk uses
+ * the regular write register which triggers command execution.
+ *
+ * @param[in] ctx   Device instance.
+ * @param[in] data  Pointer to the chunk bytes.
+ * @param[in] len   Number of bytes in the chunk.
+ * @param[in] final true if this chunk completes the command.
+ *
+ * @retval true  The chunk was written successfully.
+ * @retval false An I2C write failure occurred.
+ */
+static bool lwnode_i2c_write_at( void * const ctx,
+                                 const uint8_t * const data,
+                                 size_t len,
+                                 bool final )
+{
+    const LwnodeDevice * const device = ( const LwnodeDevice * ) ctx;
+    const uint8_t reg = final ? REG_WRITE_AT : REG_WRITE_AT_LONG;
+
+    return lwnode_hal_write( device->sensor, reg, data, len );
+}
+
+/**
+ * @brief Read a pending AT reply from the ACK registers.
+ *
+ * Reads the pending ACK length first, then retrieves the ACK data in
+ * bounded chunks.
+ *
+ * @param[in,out] ctx    Device instance.
+ * @param[out]    buf    Destination buffer.
+ * @param[in]     cap    Capacity of buf in bytes.
+ * @param[out]    outLen Number of bytes read.
+ *
+ * @retval true  A reply was read.
+ * @retval false No reply pending, reply too long, or read failure.
+ */
+static bool lwnode_i2c_read_at( void * const ctx,
+                                uint8_t * const buf,
+                                size_t cap,
+                                uint16_t * const outLen )
+{
+    LwnodeDevice * const device = ( LwnodeDevice * ) ctx;
+    bool result = false;
+    uint8_t ucLen = 0U;
+
+    /* Read the length of the pending ACK */
+    if( lwnode_hal_read( device->sensor, REG_READ_AT_LEN, &ucLen, 1U ) )
+    {
+        const uint16_t usLen = ( uint16_t ) ucLen;
+
+        LWNODE_STATS_ADD( device, bytesRead, 1U );
+
+        /* Validate length bounds */
+        if( ( usLen > 0U ) && ( ( size_t ) usLen <= cap ) )
+        {
+            uint16_t left = usLen;
+            uint16_t offset = 0U;
+            bool readFailed = false;
+
+            /* Read ACK data in chunks */
+            while( ( left > 0U ) && ( !readFailed ) )
+            {
+                const uint16_t chunk = ( left > LWNODE_I2C_CHUNK_SIZE ) ? 
+                                       ( uint16_t ) LWNODE_I2C_CHUNK_SIZE : left;
+
+                if( lwnode_hal_read( device->sensor, REG_READ_AT, &buf[ offset ], ( size_t ) chunk ) )
+                {
+                    offset = ( uint16_t ) ( offset + chunk );
+                    left   = ( uint16_t ) ( left - chunk );
+                }
+                else
+                {
+                    readFailed = true;
+                }
+            }
+
+            if( !readFailed )
+            {
+                *outLen = usLen;
+                result = true;
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Block until the module has data for the driver.
+ *
+ * Stream transports signal replies and downlinks themselves; register
+ * transports use the module IRQ line when the board wires one.
+ *
+ * @param[in,out] device    Pointer to the LoRa node device instance.
+ * @param[in]     timeoutMs Maximum time to wait in milliseconds.
+ *
+ * @retval true  Data is pending.
+ * @retval false Timeout.
+ */
+static bool lwnode_wait_rx( LwnodeDevice * const device, uint32_t timeoutMs )
+{
+    bool result = false;
+
+    if( device->transport->wait_rx != NULL )
+    {
+        result = device->transport->wait_rx( device->transportCtx, timeoutMs );
+    }
+    else
+    {
+        result = lwnode_hal_wait_irq( device->sensor, timeoutMs );
+    }
+
+    return result;
+}
+
+/**
+ * @brief Run a table-driven setter.
+ *
+ * Formats the argument after the descriptor's prefix in the device's
+ * scratch arena, skips the command when the shadow already holds the
+ * value, and records the value in the driver state.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[in]     id     Setting to write.
+ * @param[in]     arg    Value as described by the descriptor's argument kind.
+ *
+ * @retval true  Setting is applied on the module.
+ * @retval false Invalid argument, or the command failed or was rejected.
+ */
+static bool lwnode_cfg_exec( LwnodeDevice * const device,
+                             LwnodeCfgId id,
+                             const void * const arg )
+{
+    bool result = false;
+
+    if( ( device != NULL ) && ( arg != NULL ) && ( id < LWNODE_CFG_COUNT ) )
+    {
+        const LwnodeCfgDesc * const desc = &lwnodeCfgTable[ id ];
+        const size_t prefixLen = strlen( desc->prefix );
+        char * const cmd = device->scratch;
+
+        if( prefixLen <= LWNODE_CFG_PREFIX_MAX_LEN )
+        {
+            ( void ) memcpy( cmd, desc->prefix, prefixLen );
+
+            /* The argument is formatted in place, straight after the prefix */
+            if( lwnode_cfg_format( desc, arg, &cmd[ prefixLen ] ) )
+            {
+                const bool hasState = ( desc->stateOffset != LWNODE_CFG_NO_STATE );
+                uint32_t keyCrc = 0U;
+                const void * shadowArg = arg;
+
+                /* Keys stay in RAM; the persisted shadow only sees their CRC */
+                if( desc->arg == LWNODE_CFG_ARG_KEY )
+                {
+                    keyCrc = lwnode_key_crc32( ( const uint8_t * ) arg, desc->argLen );
+                    shadowArg = &keyCrc;
+                }
+
+                /* arg may already be the state field when lwnode_begin() replays a key */
+                if( hasState && desc->stateFirst )
+                {
+                    ( void ) memmove( ( uint8_t * ) device + desc->stateOffset, arg, desc->argLen );
+                    device->keyMask = ( uint16_t ) ( device->keyMask | desc->shadowBit );
+                }
+
+                result = lwnode_apply_cfg( device, cmd, desc->ack, desc->shadowBit,
+                                           ( uint8_t * ) &device->shadow + desc->shadowOffset,
+                                           shadowArg, desc->valueLen );
+
+                if( result && hasState && !desc->stateFirst )
+                {
+                    ( void ) memcpy( ( uint8_t * ) device + desc->stateOffset, arg, desc->valueLen );
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Parse a hex key and write it through its descriptor.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[in]     id     Key setting to write.
+ * @param[in]     hex    Null-terminated hex string of 2 * argLen chars.
+ *
+ * @retval true  Key is applied on the module.
+ * @retval false Invalid hex string, or the command failed or was rejected.
+ */
+static bool lwnode_set_key( LwnodeDevice * const device,
+                            LwnodeCfgId id,
+                            const char * const hex )
+{
+    bool result = false;
+    const size_t hexLen = ( size_t ) lwnodeCfgTable[ id ].argLen * 2U;
+    uint8_t key[ LWNODE_KEY_BYTES ] = { 0U };
+
+    if( ( hex != NULL ) && ( str_ext_strnlen( hex, hexLen + 1U ) == hexLen ) &&
+        num_fmt_hex_decode( hex, hexLen, key, lwnodeCfgTable[ id ].argLen ) )
+    {
+        result = lwnode_cfg_exec( device, id, key );
+    }
+
+    return result;
+}
+
+/**
+ * @brief Format a setter argument as the module expects it.
+ *
+ * @param[in]  desc Setter descriptor.
+ * @param[in]  arg  Value as described by desc->arg.
+ * @param[out] out  Null-terminated text, LWNODE_CFG_VALUE_MAX_LEN + 1 bytes.
+ *
+ * @retval true  Argument formatted.
+ * @retval false Formatting failure.
+ */
+static bool lwnode_cfg_format( const LwnodeCfgDesc * const desc,
+                               const void * const arg,
+                               char * const out )
+{
+    bool result = false;
+
+    switch( ( LwnodeCfgArg ) desc->arg )
+    {
+        case LWNODE_CFG_ARG_KEY:
+            result = num_fmt_hex_encode( ( const uint8_t * ) arg, desc->argLen, out, LWNODE_CFG_VALUE_MAX_LEN + 1U );
+            break;
+        case LWNODE_CFG_ARG_HEX32:
+            result = num_fmt_u32_to_hex8( *( const uint32_t * ) arg, out, LWNODE_CFG_VALUE_MAX_LEN + 1U );
+            break;
+        case LWNODE_CFG_ARG_U8:
+            result = num_fmt_u8toa( *( const uint8_t * ) arg, out, LWNODE_CFG_VALUE_MAX_LEN + 1U );
+            break;
+        case LWNODE_CFG_ARG_BOOL:
+            out[ 0 ] = ( *( const uint8_t * ) arg != 0U ) ? '1' : '0';
+            out[ 1 ] = '\0';
+            result = true;
+            break;
+        default:
+            /* Unknown argument kind */
+            break;
+    }
+
+    return result;
+}
+
+/**
+ * @brief CRC-32 of a key, kept in the persisted shadow instead of the key.
+ *
+ * Only detects whether the key on the module changed; it is not a secret
+ * and does not protect the key.
+ *
+ * @param[in] key Key bytes.
+ * @param[in] len Key length in bytes.
+ *
+ * @return CRC-32 (IEEE) of the key.
+ */
+static uint32_t lwnode_key_crc32( const uint8_t * const key, size_t len )
+{
+    uint32_t crc = LWNODE_KEY_CRC_INIT;
+
+    for( size_t i = 0U; i < len; ++i )
+    {
+        crc ^= key[ i ];
+
+        for( uint8_t bit = 0U; bit < 8U; ++bit )
+        {
+            crc = ( ( crc & 1UL ) != 0UL ) ? ( ( crc >> 1 ) ^ LWNODE_KEY_CRC_POLY ) : ( crc >> 1 );
+        }
+    }
+
+    return ~crc;
+}
+
+/**
+ * @brief Send a configuration command unless the shadow says it is applied.
+ *
+ * The command is skipped when the field is marked valid and the shadowed
+ * value equals the requested one. Otherwise it is sent; an expected ACK
+ * records the value as applied, anything else marks the field unknown so
+ * the next attempt re-sends it. Changes to boot-relevant settings are
+ * written to NVS unless lwnode_begin() is batching them; runtime-tuned
+ * ones (LWNODE_SHADOW_RUNTIME) only update the RAM copy.
+ *
+ * @param[in,out] device      Pointer to the LoRa node device instance.
+ * @param[in]     cmd         Null-terminated AT command.
+ * @param[in]     expectedAck Required ACK, or NULL to accept any ACK.
+ * @param[in]     field       LWNODE_SHADOW_* bit of the setting.
+ * @param[out]    shadowValue Shadow storage of the setting (NULL if valueless).
+ * @param[in]     value       Requested value (NULL if valueless).
+ * @param[in]     valueLen    Size of the value in bytes.
+ *
+ * @retval true  Setting is applied on the module.
+ * @retval false Command failed or was rejected.
+ */
+static bool lwnode_apply_cfg( LwnodeDevice * const device,
+                              const char * const cmd,
+                              const char * const expectedAck,
+                              uint16_t field,
+                              void * const shadowValue,
+                              const void * const value,
+                              size_t valueLen )
+{
+    bool result = false;
+    const bool known = ( ( device->shadow.validMask & field ) != 0U );
+    const bool persisted = ( ( field & LWNODE_SHADOW_RUNTIME ) == 0U );
+
+    if( known && ( ( valueLen == 0U ) || ( memcmp( shadowValue, value, valueLen ) == 0 ) ) )
+    {
+        device->shadowSkips++;
+        result = true;
+    }
+    else
+    {
+        device->shadowApplied++;
+
+        result = lwnode_send_at_cmd( device, cmd, expectedAck );
+
+        if( result )
+        {
+            if( valueLen > 0U )
+            {
+                ( void ) memcpy( shadowValue, value, valueLen );
+            }
+            device->shadow.validMask = ( uint16_t ) ( device->shadow.validMask | field );
+            device->shadowDirty = device->shadowDirty || persisted;
+        }
+        else if( known )
+        {
+            device->shadow.validMask = ( uint16_t ) ( device->shadow.validMask & ~field );
+            device->shadowDirty = device->shadowDirty || persisted;
+        }
+        else
+        {
+            /* Already unknown, nothing to persist */
+        }
+
+        if( !device->shadowDeferStore )
+        {
+            lwnode_shadow_sync( device );
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Mark every shadowed setting as unknown.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ */
+static void lwnode_shadow_reset( LwnodeDevice * const device )
+{
+    ( void ) memset( &device->shadow, 0, sizeof( device->shadow ) );
+    device->shadow.version = LWNODE_SHADOW_VERSION;
+    device->shadowDirty = true;
+}
+
+/**
+ * @brief Write the shadow to NVS if it changed.
+ *
+ * A failed write leaves the shadow dirty so the next change retries it.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ */
+static void lwnode_shadow_sync( LwnodeDevice * const device )
+{
+    if( device->shadowDirty )
+    {
+        if( lwnode_hal_nvs_store( LWNODE_NVS_SHADOW_KEY, &device->shadow, sizeof( device->shadow ) ) )
+        {
+            device->shadowDirty = false;
+        }
+    }
+}
+
+/**
+ * @brief Check whether the persisted session is worth probing on boot.
+ *
+ * @param[in] device Pointer to the LoRa node device instance.
+ *
+ * @retval true  Session was joined with the current join type and has not
+ *               exhausted its warm-boot budget.
+ * @retval false A cold start (reboot and join) is required.
+ */
+static bool lwnode_session_can_resume( const LwnodeDevice * const device )
+{
+    return ( device->session.joined != 0U ) &&
+           ( device->session.joinType == ( uint8_t ) device->joinType ) &&
+           ( device->session.warmBoots <
+             ( LWNODE_SESSION_MAX_WARM_BOOTS - ( lwnode_hal_device_id() % LWNODE_SESSION_WARM_BOOT_JITTER ) ) );
+}
+
+/**
+ * @brief Persist the join session.
+ *
+ * @param[in] device Pointer to the LoRa node device instance.
+ */
+static void lwnode_session_store( LwnodeDevice * const device )
+{
+    ( void ) lwnode_hal_nvs_store( LWNODE_NVS_SESSION_KEY, 
+                                   &device->session, 
+                                   sizeof( device->session ) );
+}
+
+/**
+ * @brief Track the join state reported by AT+JOIN?.
+ *
+ * Records join timing when a requested join is confirmed, and persists
+ * the session whenever the module's answer changes it.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[in]     joined Module reported a joined session.
+ */
+static void lwnode_session_on_query( LwnodeDevice * const device, bool joined )
+{
+    if( joined && device->joinPending )
+    {
+        const uint32_t nowMs = lwnode_hal_get_time_ms();
+
+        device->joinPending = false;
+        device->joinMetrics.joinsCompleted++;
+        device->joinMetrics.lastJoinMs = nowMs - device->joinStartMs;
+        device->joinMetrics.lastReadyMs = nowMs - device->beginStartMs;
+
+        device->session.joined = 1U;
+        device->session.joinType = ( uint8_t ) device->joinType;
+        device->session.joinCount++;
+        device->session.warmBoots = 0U;
+        device->session.joinedAtMs = nowMs;
+        lwnode_session_store( device );
+    }
+    else if( joined != ( device->session.joined != 0U ) )
+    {
+        /* Joined outside lwnode_join() or lost the session */
+        device->session.joined = joined ? 1U : 0U;
+        device->session.joinType = ( uint8_t ) device->joinType;
+        device->session.warmBoots = 0U;
+        lwnode_session_store( device );
+    }
+    else
+    {
+        /* No change */
+    }
+}
+
+/**
+ * @brief Check an acknowledgment against the expected reply.
+ *
+ * The ACK is tokenized into lines and matches when any line other than an
+ * unsolicited frame equals the expected reply, so an information line
+ * before the result code does not count as a failure. Line terminators are
+ * not significant.
+ *
+ * @param[in] ack      Pointer to the received ACK string.
+ * @param[in] expected Pointer to the expected ACK string.
+ *
+ * @retval true  The ACK contains the expected reply.
+ * @retval false One or both pointers are NULL or no line matches.
+ */
+static bool lwnode_ack_equals( const char * const ack, 
+                               const char * const expected )
+{
+    bool result = false;
+
+    if( ( ack != NULL ) && ( expected != NULL ) )
+    {
+        result = at_response_contains( ( const uint8_t * ) ack,
+                                       ( uint16_t ) str_ext_strnlen( ack, LWNODE_AT_REPLY_MAX_LEN ),
+                                       expected );
+    }
+    return result;
+}
+
+/**
+ * @brief Check whether an AT+SEND reply reports the uplink as accepted.
+ *
+ * Any other reply (+SEND=ERROR, busy, not joined) means nothing went on
+ * air, so no RX windows follow.
+ *
+ * @param[in] ack Null-terminated reply.
+ *
+ * @retval true  The module accepted the uplink.
+ * @retval false Any other reply.
+ */
+static bool lwnode_send_accepted( const char * const ack )
+{
+    return ( lwnode_ack_equals( ack, "+SEND=OK\r\n" ) ||
+             lwnode_ack_equals( ack, "AT+SEND=OK\r\n" ) );
+}
+
+/**
+ * @brief Extract the data rate from an AT+DATARATE? reply.
+ *
+ * @param[in]  ack      Null-terminated reply.
+ * @param[out] dataRate Data rate index from the "+DATARATE=<n>" line.
+ *
+ * @retval true  A valid data rate was found.
+ * @retval false No such line, or the value is not a data rate.
+ */
+static bool lwnode_parse_datarate( const char * const ack,
+                                   uint8_t * const dataRate )
+{
+    bool result = false;
+    AtResponseTokenizer tok = { 0 };
+    AtResponseLine line = { 0 };
+
+    ( void ) at_response_init( &tok, ( const uint8_t * ) ack,
+                               ( uint16_t ) str_ext_strnlen( ack, LWNODE_AT_REPLY_MAX_LEN ) );
+
+    while( !result && at_response_next( &tok, &line ) )
+    {
+        if( ( line.kind == AT_RESPONSE_INFO ) && ( line.len > LWNODE_DATARATE_REPLY_LEN ) &&
+            str_ext_starts_with( line.data, line.len,
+                                 LWNODE_DATARATE_REPLY, LWNODE_DATARATE_REPLY_LEN ) )
+        {
+            uint32_t value = 0U;
+            uint16_t i = ( uint16_t ) LWNODE_DATARATE_REPLY_LEN;
+
+            while( ( i < line.len ) && ( line.data[ i ] >= ( uint8_t ) '0' ) &&
+                   ( line.data[ i ] <= ( uint8_t ) '9' ) && ( value <= LWNODE_DATARATE_MAX ) )
+            {
+                value = ( value * 10U ) + ( uint32_t ) ( line.data[ i ] - ( uint8_t ) '0' );
+                i++;
+            }
+
+            if( ( i == line.len ) && ( value <= LWNODE_DATARATE_MAX ) )
+            {
+                *dataRate = ( uint8_t ) value;
+                result = true;
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Read a queued LoRa payload from the node.
+ *
+ * Reads the length of the pending data packet, validates it against
+ * hardware and buffer limits, and then reads the payload into the RX buffer.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[out]    outLen Number of bytes read into the RX buffer.
+ *
+ * @retval true  A complete LoRa packet was read successfully.
+ * @retval false Invalid arguments, no data available, or read failure.
+ */
+static bool lwnode_read_lora_data( LwnodeDevice * const device, 
+                                   uint16_t * const outLen )
+{
+    bool result = false;
+    uint8_t ucLen = 0U;
+
+    if ( ( device != NULL ) && ( device->sensor != NULL ) && ( outLen != NULL ) &&
+         ( !device->transport->stream ) )
+    {
+        *outLen = 0U;
+
+        /* Read the length of the data packet in the queue */
+        if( lwnode_hal_read( device->sensor, REG_READ_DATA_LEN, &ucLen, 1U ) )
+        {
+            const uint16_t usLen = ( uint16_t ) ucLen;
+
+            /* Validate length against hardware limits and buffer capacity */
+            if( ( usLen > 0U ) && 
+                ( usLen <= LWNODE_MAX_LORA_PAYLOAD_LEN ) && 
+                ( usLen <= LWNODE_MAX_RX_BYTES ) )
+            {
+                lwnode_hal_delay_ms( LWNODE_READ_DATA_DELAY_MS );
+
+                if( lwnode_read_data_chunks( device, usLen ) )
+                {
+                    *outLen = usLen;
+                    result = true;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Read the head frame of the module queue into the RX buffer.
+ *
+ * Reading the full frame through REG_READ_DATA removes it from the module
+ * queue.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[in]     len    Frame length reported by the module.
+ *
+ * @retval true  All bytes were read.
+ * @retval false I2C read failure.
+ */
+static bool lwnode_read_data_chunks( LwnodeDevice * const device,
+                                     uint16_t len )
+{
+    uint16_t left = len;
+    uint16_t offset = 0U;
+    bool readFailed = false;
+
+    /* Read packet data in chunks */
+    while( ( left > 0U ) && ( !readFailed ) )
+    {
+        const uint16_t chunk = ( left > LWNODE_I2C_CHUNK_SIZE ) ? 
+                               ( uint16_t ) LWNODE_I2C_CHUNK_SIZE : left;
+
+        if( lwnode_hal_read( device->sensor, 
+                             REG_READ_DATA, 
+                             &device->rxBuf[ offset ], 
+                             ( size_t ) chunk ) )
+        {
+            offset = ( uint16_t ) ( offset + chunk );
+            left   = ( uint16_t ) ( left - chunk );
+        }
+        else
+        {
+            readFailed = true;
+        }
+    }
+
+    return !readFailed;
+}
+
+/**
+ * @brief Read the length of the head queued frame without consuming it.
+ *
+ * Used by the batch drain, where the queue depth register has already
+ * confirmed that complete frames are waiting. The first frame's length is
+ * read from REG_READ_DATA_LEN, subsequent ones from REG_READ_NEXT_DATA,
+ * which reports the length of the frame that became head after the
+ * previous read. The frame leaves the module queue only once its bytes
+ * are read with lwnode_read_data_chunks().
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[in]     lenReg Register holding the frame length.
+ * @param[out]    outLen Raw frame length in bytes, "+RECV=" header included.
+ *
+ * @retval true  A frame of valid length is waiting.
+ * @retval false No frame, invalid length, or read failure.
+ */
+static bool lwnode_read_queued_len( LwnodeDevice * const device,
+                                    uint8_t lenReg,
+                                    uint16_t * const outLen )
+{
+    bool result = false;
+    uint8_t ucLen = 0U;
+
+    *outLen = 0U;
+
+    if( lwnode_hal_read( device->sensor, lenReg, &ucLen, 1U ) )
+    {
+        const uint16_t usLen = ( uint16_t ) ucLen;
+
+        if( ( usLen > 0U ) && ( usLen <= LWNODE_MAX_RX_BYTES ) )
+        {
+            *outLen = usLen;
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Pull every queued frame in one pass.
+ *
+ * Frames go to the RX callback when batch is NULL, otherwise their
+ * payloads are packed into the caller's batch storage.
+ *
+ * Stream transports have no queue registers: pending stream bytes are
+ * read and their "+RECV=" frames routed to the RX callback instead.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[in,out] batch  Caller storage, or NULL for callback dispatch.
+ *
+ * @return Number of frames read from the module.
+ */
+static uint8_t lwnode_drain_queue( LwnodeDevice * const device,
+                                   LwnodeRxBatch * const batch )
+{
+    uint8_t frames = 0U;
+    uint8_t queued = 0U;
+
+    if( device->transport->stream )
+    {
+        /* Downlinks arrive in the reply stream; leave it to a command in flight */
+        if( ( batch == NULL ) && ( device->at.phase == LWNODE_AT_PHASE_IDLE ) )
+        {
+            const uint32_t urcBefore = device->rxStats.urcFrames;
+            uint16_t rxLen = 0U;
+
+            if( lwnode_read_ack_bytes( device, &rxLen ) )
+            {
+                ( void ) lwnode_at_route_urcs( device, rxLen );
+                frames = ( uint8_t ) ( device->rxStats.urcFrames - urcBefore );
+            }
+        }
+    }
+    else if( lwnode_hal_read( device->sensor, REG_READ_NUM_QUEUE, &queued, 1U ) )
+    {
+        bool draining = true;
+
+        if( queued > LWNODE_MAX_RX_BATCH_FRAMES )
+        {
+            queued = LWNODE_MAX_RX_BATCH_FRAMES;
+        }
+
+        while( draining && ( frames < queued ) )
+        {
+            const uint8_t lenReg = ( frames == 0U ) ? REG_READ_DATA_LEN : REG_READ_NEXT_DATA;
+            uint16_t rxLen = 0U;
+
+            if( ( batch != NULL ) && ( batch->frameCount >= batch->maxFrames ) )
+            {
+                /* Caller storage full, leave the rest queued */
+                draining = false;
+            }
+            else if( !lwnode_read_queued_len( device, lenReg, &rxLen ) )
+            {
+                draining = false;
+            }
+            else if( ( batch != NULL ) &&
+                     ( ( ( uint32_t ) batch->bufUsed + lwnode_recv_payload_bound( rxLen ) ) >
+                       batch->bufCap ) )
+            {
+                /* Payload may not fit: stop before consuming it, leave it queued */
+                draining = false;
+            }
+            else if( !lwnode_read_data_chunks( device, rxLen ) )
+            {
+                draining = false;
+            }
+            else
+            {
+                LwnodeRxFrameIter it = { 0 };
+                LwnodeRxFrame frame = { 0 };
+
+                frames++;
+                device->rxStats.framesReceived++;
+
+                if( batch == NULL )
+                {
+                    if( !lwnode_process_recv_frames( device, device->rxBuf, rxLen ) )
+                    {
+                        device->rxStats.malformedFrames++;
+                    }
+                }
+                else if( lwnode_rx_frames_begin( &it, device->rxBuf, rxLen ) &&
+                         lwnode_rx_frames_next( &it, &frame ) )
+                {
+                    /* Fits: the payload is never longer than its bound */
+                    LwnodeRxFrameInfo * const info = &batch->frames[ batch->frameCount ];
+
+                    device->lastRssi = frame.rssi;
+                    device->lastSnr  = frame.snr;
+
+                    ( void ) memcpy( &batch->buf[ batch->bufUsed ], frame.payload, frame.len );
+                    info->offset = batch->bufUsed;
+                    info->len = frame.len;
+                    info->rssi = frame.rssi;
+                    info->snr = frame.snr;
+                    batch->frameCount++;
+                    batch->bufUsed = ( uint16_t ) ( batch->bufUsed + frame.len );
+                }
+                else
+                {
+                    /* Consumed but not a "+RECV=" frame: count it and go on */
+                    device->rxStats.malformedFrames++;
+                }
+            }
+        }
+    }
+
+    return frames;
+}
+
+/**
+ * @brief Largest payload a queued frame of a given raw length can carry.
+ *
+ * @param[in] frameLen Raw frame length, "+RECV=" header included.
+ *
+ * @return Payload bound in bytes (the frame may also end in CRLF).
+ */
+static uint16_t lwnode_recv_payload_bound( uint16_t frameLen )
+{
+    const uint16_t overhead = ( uint16_t ) ( LWNODE_RECV_PREFIX_LEN + LWNODE_RECV_HEADER_SIZE );
+
+    return ( frameLen > overhead ) ? ( uint16_t ) ( frameLen - overhead ) : 0U;
+}
+
+/**
+ * @brief Dispatch "+RECV=" frames to the RX callback.
+ *
+ * Walks one or more back-to-back frames with the frame iterator and hands
+ * each payload to the registered callback as a view into buf; nothing is
+ * copied.
+ *
+ * Expected frame format:
+ *   "+RECV=" [RSSI][SNR][LEN][PAYLOAD][\\r\\n]
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[in]     buf    Pointer to the received data buffer.
+ * @param[in]     len    Length of the received buffer in bytes.
+ *
+ * @retval true  All frames were parsed and processed successfully.
+ * @retval false Protocol error, malformed frame, or invalid arguments.
+ */
+static bool lwnode_process_recv_frames( LwnodeDevice * const device, 
+                                        const uint8_t * const buf, 
+                                        uint16_t len )
+{
+    bool result = false;
+    LwnodeRxFrameIter it = { 0 };
+    LwnodeRxFrame frame = { 0 };
+
+    if( ( device != NULL ) && ( device->rxCb != NULL ) && ( len != 0U ) &&
+        lwnode_rx_frames_begin( &it, buf, len ) )
+    {
+        while( lwnode_rx_frames_next( &it, &frame ) )
+        {
+            device->lastRssi = frame.rssi;
+            device->lastSnr  = frame.snr;
+
+            if( frame.len > 0U )
+            {
+                device->rxCb( frame.payload, frame.len, frame.rssi, frame.snr );
+            }
+        }
+
+        result = !it.malformed;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Route unsolicited frames out of an AT reply.
+ *
+ * A downlink that arrives while a command is in flight is queued behind
+ * the reply in the AT registers. Each "+RECV=" frame is dispatched like a
+ * queued downlink and removed, leaving only the command's own lines in the
+ * RX buffer.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[in]     len    Reply length in the RX buffer.
+ *
+ * @return Length of the reply left after removing the frames.
+ */
+static uint16_t lwnode_at_route_urcs( LwnodeDevice * const device, uint16_t len )
+{
+    AtResponseTokenizer tok = { 0 };
+    AtResponseLine line = { 0 };
+    uint16_t kept = 0U;
+
+    ( void ) at_response_init( &tok, device->rxBuf, len );
+
+    while( at_response_next( &tok, &line ) )
+    {
+        if( line.kind == AT_RESPONSE_URC )
+        {
+            device->rxStats.framesReceived++;
+            device->rxStats.urcFrames++;
+            ( void ) lwnode_process_recv_frames( device, line.data, line.len );
+        }
+        else
+        {
+            /* Compact in place, the tokenizer is already past this line */
+            ( void ) memmove( &device->rxBuf[ kept ], line.data, line.span );
+            kept = ( uint16_t ) ( kept + line.span );
+        }
+    }
+
+    device->rxBuf[ kept ] = 0U;
+
+    return kept;
+}
+
+/**
+ * @brief Check whether a chunk gap passes all calibration rounds.
+ *
+ * On a failed round the module's command parser may hold a partial
+ * command, so a plain "AT" is sent to resynchronize it.
+ *
+ * @param[in,out] device      Pointer to the LoRa node device instance.
+ * @param[in]     probeCmd    Multi-chunk probe command.
+ * @param[in]     expectedAck Expected ACK string.
+ * @param[in]     gapMs       Candidate inter-chunk gap.
+ *
+ * @retval true  Every round was acknowledged as expected.
+ * @retval false At least one round failed.
+ */
+static bool lwnode_chunk_gap_passes( LwnodeDevice * const device,
+                                     const char * const probeCmd,
+                                     const char * const expectedAck,
+                                     uint32_t gapMs )
+{
+    bool result = true;
+    device->chunkGapMs = gapMs;
+
+    for( uint8_t round = 0U; ( round < LWNODE_CHUNK_GAP_CAL_ROUNDS ) && result; ++round )
+    {
+        if( !lwnode_send_at_cmd( device, probeCmd, expectedAck ) )
+        {
+            result = false;
+            ( void ) lwnode_at_test( device );
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Arm the transaction state machine for a new command.
+ *
+ * The streamed command is prefix + hex(payload) + CRLF; only the prefix is
+ * copied into the device, the payload is encoded chunk by chunk.
+ *
+ * @param[in,out] device     Pointer to the LoRa node device instance.
+ * @param[in]     prefix     Command text without CRLF.
+ * @param[in]     prefixLen  Length of the command text.
+ * @param[in]     payload    Binary payload to hex-encode (NULL for none).
+ * @param[in]     payloadLen Payload length in bytes.
+ * @param[in]     doneCb     Completion callback (optional).
+ * @param[in]     ctx        Completion callback context.
+ *
+ * @retval true  Transaction armed.
+ * @retval false Invalid arguments, a transaction is already in flight, or
+ *               the lwnode_begin_bounded() budget is exhausted.
+ *
+ * While the module is busy the first write is scheduled for the moment it
+ * becomes idle, so the command is not lost to an unanswered transfer.
+ */
+static bool lwnode_at_arm( LwnodeDevice * const device,
+                           const char * const prefix,
+                           size_t prefixLen,
+                           const uint8_t * const payload,
+                           uint8_t payloadLen,
+                           LwnodeAtDoneCb doneCb,
+                           void * const ctx )
+{
+    bool result = false;
+
+    if( ( device != NULL ) && ( device->sensor != NULL ) && ( prefix != NULL ) &&
+        ( prefixLen > 0U ) && ( prefixLen <= LWNODE_AT_CMD_MAX_LEN ) &&
+        ( device->at.phase == LWNODE_AT_PHASE_IDLE ) &&
+        ( lwnode_budget_remaining_ms( device ) > 0U ) )
+    {
+        LwnodeAtTxn * const txn = &device->at;
+        const uint32_t budgetMs = lwnode_budget_remaining_ms( device );
+        const uint32_t nowMs = lwnode_hal_get_time_ms();
+
+        ( void ) memcpy( txn->txBuf, prefix, prefixLen );
+        txn->prefixLen    = ( uint16_t ) prefixLen;
+        txn->payload      = ( payloadLen != 0U ) ? payload : NULL;
+        txn->payloadLen   = ( txn->payload != NULL ) ? payloadLen : 0U;
+        txn->txLen        = ( uint16_t ) ( prefixLen + 
+                                           ( 2U * ( size_t ) txn->payloadLen ) + 2U );
+        txn->txOffset     = 0U;
+        txn->chunkGapMs   = device->chunkGapMs;
+        txn->ackLen       = 0U;
+        txn->ackPolls     = 0U;
+        txn->ackTimeoutMs = lwnode_at_timeout_for( txn->txBuf, txn->prefixLen );
+        if( txn->ackTimeoutMs > budgetMs )
+        {
+            txn->ackTimeoutMs = budgetMs;
+        }
+        txn->pollIntervalMs = LWNODE_AT_ACK_POLL_MIN_MS;
+        txn->doneCb       = doneCb;
+        txn->doneCtx      = ctx;
+        txn->status       = LWNODE_AT_STATUS_PENDING;
+        txn->phase        = LWNODE_AT_PHASE_WRITE;
+        txn->nextActionMs = lwnode_busy_release_ms( device, prefix, prefixLen, nowMs );
+        if( txn->nextActionMs != nowMs )
+        {
+            /* Module busy: the first chunk goes out once it is idle */
+            device->busyStats.cmdsParked++;
+            device->busyStats.parkedMs += txn->nextActionMs - nowMs;
+        }
+#if ( LWNODE_STATS_ENABLED != 0 )
+        lwnode_stats_on_arm( device, txn->nextActionMs );
+#endif
+
+        device->intEnabled = false;
+        result = true;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Produce the next bytes of the streamed command.
+ *
+ * Maps the transaction's write offset onto the virtual stream
+ * [prefix][hex(payload)][CRLF] and encodes only the requested window.
+ *
+ * @param[in]  txn      In-flight transaction.
+ * @param[out] chunk    Destination for the chunk bytes.
+ * @param[in]  chunkLen Number of bytes to produce.
+ *
+ * @return Number of bytes written to chunk.
+ */
+static uint16_t lwnode_at_fill_chunk( const LwnodeAtTxn * const txn,
+                                      uint8_t * const chunk,
+                                      uint16_t chunkLen )
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+    const uint16_t hexEnd = ( uint16_t ) ( txn->prefixLen + ( 2U * txn->payloadLen ) );
+    uint16_t produced = 0U;
+
+    while( ( produced < chunkLen ) && ( ( txn->txOffset + produced ) < txn->txLen ) )
+    {
+        const uint16_t pos = ( uint16_t ) ( txn->txOffset + produced );
+
+        if( pos < txn->prefixLen )
+        {
+            chunk[ produced ] = txn->txBuf[ pos ];
+        }
+        else if( pos < hexEnd )
+        {
+            const uint16_t nibbleIdx = ( uint16_t ) ( pos - txn->prefixLen );
+            const uint8_t byte = txn->payload[ nibbleIdx / 2U ];
+            const uint8_t nibble = ( ( nibbleIdx & 1U ) == 0U ) ? 
+                                   ( uint8_t ) ( byte >> 4U ) : ( uint8_t ) ( byte & 0x0FU );
+
+            chunk[ produced ] = ( uint8_t ) hexDigits[ nibble ];
+        }
+        else
+        {
+            chunk[ produced ] = ( pos == hexEnd ) ? ( uint8_t ) '\r' : ( uint8_t ) '\n';
+        }
+
+        produced++;
+    }
+
+    return produced;
+}
+
+/**
+ * @brief Drive the in-flight transaction to completion.
+ *
+ * Sleeps between poll steps for exactly as long as the state machine
+ * reports it has nothing to do. Transports that can signal a reply are
+ * waited on instead of polled.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ *
+ * @return Final transaction status.
+ */
+static LwnodeAtStatus lwnode_at_wait( LwnodeDevice * const device )
+{
+    LwnodeAtStatus status = lwnode_at_poll( device );
+
+    while( status == LWNODE_AT_STATUS_PENDING )
+    {
+        LwnodeAtTxn * const txn = &device->at;
+
+        if( ( device->transport->wait_rx != NULL ) && ( txn->phase == LWNODE_AT_PHASE_WAIT_ACK ) )
+        {
+            /* The transport wakes us when the reply lands, no poll backoff */
+            const uint32_t deadlineMs = txn->writeDoneMs + txn->ackTimeoutMs;
+            const uint32_t nowMs = lwnode_hal_get_time_ms();
+            const uint32_t waitMs = lwnode_time_reached( nowMs, deadlineMs ) ? 0U : ( deadlineMs - nowMs );
+
+            txn->nextActionMs = lwnode_wait_rx( device, waitMs ) ? lwnode_hal_get_time_ms() : deadlineMs;
+        }
+        else
+        {
+            lwnode_hal_delay_ms( lwnode_at_next_poll_ms( device ) );
+        }
+
+        status = lwnode_at_poll( device );
+    }
+
+    return status;
+}
+
+/**
+ * @brief Legacy receive loop: poll the module every millisecond.
+ *
+ * Polls are skipped while the module is busy.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[in]     ms     Sleep duration in milliseconds.
+ */
+static void lwnode_sleep_poll_legacy( LwnodeDevice * const device, uint32_t ms )
+{
+    uint32_t t = 0U;
+
+    while( t < ms )
+    {
+        if( lwnode_rx_allowed( device, lwnode_hal_get_time_ms() ) )
+        {
+            ( void ) lwnode_rx_poll_once( device );
+        }
+        lwnode_hal_delay_ms( 1U );
+        t += 1U;
+    }
+}
+
+/**
+ * @brief Event-driven receive loop.
+ *
+ * With an IRQ line the task sleeps on it and only touches the bus when the
+ * module signals data, leaving a signal raised during the join/RX windows
+ * pending until they close. Otherwise polls follow the schedule computed
+ * by lwnode_rx_schedule(). Reads saved against the legacy one-per-millisecond
+ * loop are accumulated in rxStats.pollsAvoided.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[in]     ms     Sleep duration in milliseconds.
+ */
+static void lwnode_sleep_event( LwnodeDevice * const device, uint32_t ms )
+{
+    const uint32_t startMs = lwnode_hal_get_time_ms();
+    const uint32_t endMs = startMs + ms;
+    const uint32_t pollsBefore = device->rxStats.pollsIssued;
+    const bool useIrq = ( device->transport->wait_rx != NULL ) ||
+                        lwnode_hal_irq_available( device->sensor );
+    uint32_t nowMs = startMs;
+    uint32_t issued = 0U;
+
+    while( !lwnode_time_reached( nowMs, endMs ) )
+    {
+        if( useIrq )
+        {
+            if( !lwnode_rx_allowed( device, nowMs ) )
+            {
+                /* The IRQ stays pending: take it once the windows close */
+                uint32_t waitMs = endMs - nowMs;
+
+                if( ( device->busyState != LWNODE_STATE_IDLE ) &&
+                    !lwnode_time_reached( nowMs, device->busyUntilMs ) &&
+                    ( ( device->busyUntilMs - nowMs ) < waitMs ) )
+                {
+                    waitMs = device->busyUntilMs - nowMs;
+                }
+                else if( waitMs > LWNODE_RX_WINDOW_POLL_MS )
+                {
+                    /* Uplink in flight, no end time to wait for */
+                    waitMs = LWNODE_RX_WINDOW_POLL_MS;
+                }
+                else
+                {
+                    /* Sleep ends first */
+                }
+
+                lwnode_hal_delay_ms( waitMs );
+            }
+            else if( lwnode_wait_rx( device, endMs - nowMs ) )
+            {
+                device->rxStats.irqWakeups++;
+                ( void ) lwnode_rx_poll_once( device );
+            }
+            else
+            {
+                /* Slept to the end without a downlink */
+            }
+        }
+        else
+        {
+            if( lwnode_time_reached( nowMs, device->rxNextPollMs ) )
+            {
+                const bool gotFrame = lwnode_rx_poll_once( device );
+                nowMs = lwnode_hal_get_time_ms();
+                lwnode_rx_schedule( device, nowMs, gotFrame );
+            }
+
+            if( !lwnode_time_reached( nowMs, endMs ) )
+            {
+                uint32_t waitMs = endMs - nowMs;
+
+                if( ( device->rxNextPollMs - nowMs ) < waitMs )
+                {
+                    waitMs = device->rxNextPollMs - nowMs;
+                }
+
+                lwnode_hal_delay_ms( waitMs );
+            }
+        }
+
+        nowMs = lwnode_hal_get_time_ms();
+    }
+
+    issued = device->rxStats.pollsIssued - pollsBefore;
+
+    if( ( nowMs - startMs ) > issued )
+    {
+        device->rxStats.pollsAvoided += ( ( nowMs - startMs ) - issued );
+    }
+}
+
+/**
+ * @brief Poll the module queue once and dispatch every pending downlink.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ *
+ * @retval true  A downlink was read.
+ * @retval false Nothing queued or read failure.
+ */
+static bool lwnode_rx_poll_once( LwnodeDevice * const device )
+{
+    device->rxStats.pollsIssued++;
+
+    return ( lwnode_drain_queue( device, NULL ) != 0U );
+}
+
+/**
+ * @brief Check whether the module queue may be read now.
+ *
+ * Nothing is read while an uplink is in flight or the join/RX windows are
+ * open; each refused read is counted in busyStats.pollsDeferred.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[in]     nowMs  Current time.
+ *
+ * @retval true  The module is idle.
+ * @retval false The module is busy, the read was deferred.
+ */
+static bool lwnode_rx_allowed( LwnodeDevice * const device, uint32_t nowMs )
+{
+    const bool allowed = ( lwnode_busy_state_at( device, nowMs ) == LWNODE_STATE_IDLE );
+
+    if( !allowed )
+    {
+        device->busyStats.pollsDeferred++;
+    }
+
+    return allowed;
+}
+
+/**
+ * @brief Compute when the next downlink poll is due.
+ *
+ * Class A downlinks can only arrive in the RX1/RX2 windows that follow an
+ * uplink, and the module does not answer reliably while they are open, so
+ * the first poll after an uplink (or a join) is deferred until they have
+ * closed; a frame received in either window is read then. Outside the
+ * windows (or in Class C) the interval backs off exponentially and resets
+ * whenever a frame arrives.
+ *
+ * @param[in,out] device   Pointer to the LoRa node device instance.
+ * @param[in]     nowMs    Current time.
+ * @param[in]     gotFrame true if the last poll returned data.
+ */
+static void lwnode_rx_schedule( LwnodeDevice * const device,
+                                uint32_t nowMs,
+                                bool gotFrame )
+{
+    const LwnodeBusyState state = lwnode_busy_state_at( device, nowMs );
+    uint32_t intervalMs = device->rxIdleIntervalMs;
+
+    if( ( state == LWNODE_STATE_JOINING ) || ( state == LWNODE_STATE_RECV_WINDOW ) )
+    {
+        intervalMs = device->busyUntilMs - nowMs;
+        device->busyStats.pollsDeferred++;
+    }
+    else if( gotFrame )
+    {
+        /* More frames may be queued right behind this one */
+        device->rxIdleIntervalMs = LWNODE_RX_IDLE_MIN_MS;
+        intervalMs = LWNODE_RX_WINDOW_POLL_MS;
+    }
+    else
+    {
+        device->rxIdleIntervalMs = device->rxIdleIntervalMs * 2U;
+
+        if( device->rxIdleIntervalMs > LWNODE_RX_IDLE_MAX_MS )
+        {
+            device->rxIdleIntervalMs = LWNODE_RX_IDLE_MAX_MS;
         }
     }
 
+    device->rxNextPollMs = nowMs + intervalMs;
+}
+
+/**
+ * @brief Compare two millisecond timestamps with wrap-around handling.
+ *
+ * @param[in] nowMs      Current time.
+ * @param[in] deadlineMs Time to compare against.
+ *
+ * @retval true  nowMs is at or past deadlineMs.
+ * @retval false deadlineMs is still in the future.
+ */
+static bool lwnode_time_reached( uint32_t nowMs, uint32_t deadlineMs )
+{
+    return ( ( nowMs - deadlineMs ) < 0x80000000UL );
+}
+
+/**
+ * @brief Work out what the module is busy with at a given time.
+ *
+ * @param[in] device Pointer to the LoRa node device instance.
+ * @param[in] nowMs  Current time.
+ *
+ * @return SENDING while an uplink transaction is in flight, the latched
+ *         JOINING/RECV_WINDOW state until it expires, IDLE otherwise.
+ */
+static LwnodeBusyState lwnode_busy_state_at( const LwnodeDevice * const device,
+                                             uint32_t nowMs )
+{
+    LwnodeBusyState state = LWNODE_STATE_IDLE;
+
+    if( ( device->at.phase != LWNODE_AT_PHASE_IDLE ) && ( device->at.payload != NULL ) )
+    {
+        state = LWNODE_STATE_SENDING;
+    }
+    else if( ( device->busyState != LWNODE_STATE_IDLE ) &&
+             !lwnode_time_reached( nowMs, device->busyUntilMs ) )
+    {
+        state = device->busyState;
+    }
+    else
+    {
+        /* Idle */
+    }
+
+    return state;
+}
+
+/**
+ * @brief Find when a new command may be written to the module.
+ *
+ * Join requests and status queries may go out while a join is pending;
+ * everything else waits until the module is idle.
+ *
+ * @param[in] device    Pointer to the LoRa node device instance.
+ * @param[in] prefix    Command text.
+ * @param[in] prefixLen Length of the command text.
+ * @param[in] nowMs     Current time.
+ *
+ * @return nowMs if the command can go out now, else the end of the busy period.
+ */
+static uint32_t lwnode_busy_release_ms( const LwnodeDevice * const device,
+                                        const char * const prefix,
+                                        size_t prefixLen,
+                                        uint32_t nowMs )
+{
+    const LwnodeBusyState state = lwnode_busy_state_at( device, nowMs );
+    uint32_t releaseMs = nowMs;
+
+    if( ( state == LWNODE_STATE_RECV_WINDOW ) ||
+        ( ( state == LWNODE_STATE_JOINING ) &&
+          !str_ext_starts_with( ( const uint8_t * ) prefix, prefixLen,
+                                LWNODE_JOIN_CMD_PREFIX, LWNODE_JOIN_CMD_PREFIX_LEN ) ) )
+    {
+        releaseMs = device->busyUntilMs;
+    }
+
+    return releaseMs;
+}
+
+/**
+ * @brief Select the ACK budget for an AT command.
+ *
+ * Join and send requests make the module talk to the radio before it
+ * answers, everything else is answered from the module's command parser.
+ *
+ * @param[in] cmd Command bytes.
+ * @param[in] len Command length in bytes.
+ *
+ * @return ACK timeout in milliseconds.
+ */
+static uint32_t lwnode_at_timeout_for( const uint8_t * const cmd,
+                                       uint16_t len )
+{
+    uint32_t timeoutMs = LWNODE_AT_ACK_SHORT_TIMEOUT_MS;
+
+    if( str_ext_starts_with( cmd, ( size_t ) len, 
+                             LWNODE_JOIN_PREFIX, LWNODE_JOIN_PREFIX_LEN ) ||
+        str_ext_starts_with( cmd, ( size_t ) len, 
+                             LWNODE_SEND_PREFIX, LWNODE_SEND_PREFIX_LEN ) )
+    {
+        timeoutMs = LWNODE_AT_ACK_LONG_TIMEOUT_MS;
+    }
+
+    return timeoutMs;
+}
+
+/**
+ * @brief Write the next command chunk of the in-flight transaction.
+ *
+ * Schedules the next chunk after the gap latched for this transfer. Once
+ * the final chunk has been written, ACK polling starts immediately.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[in]     nowMs  Current time.
+ */
+static void lwnode_at_step_write( LwnodeDevice * const device, uint32_t nowMs )
+{
+    LwnodeAtTxn * const txn = &device->at;
+    bool writing = true;
+
+    /* Stream transports take the whole command in one burst */
+    while( writing )
+    {
+        const uint16_t left = ( uint16_t ) ( txn->txLen - txn->txOffset );
+        const bool isFinal = ( left <= LWNODE_I2C_CHUNK_SIZE );
+        uint8_t chunkBuf[ LWNODE_I2C_CHUNK_SIZE ];
+        const uint16_t chunk = lwnode_at_fill_chunk( txn, 
+                                                     chunkBuf, 
+                                                     isFinal ? left : ( uint16_t ) LWNODE_I2C_CHUNK_SIZE );
+
+        writing = false;
+
+        if( lwnode_write_at_bytes( device, chunkBuf, chunk, isFinal ) )
+        {
+            txn->txOffset = ( uint16_t ) ( txn->txOffset + chunk );
+            LWNODE_STATS_ADD( device, bytesWritten, chunk );
+
+            if( isFinal )
+            {
+                txn->phase = LWNODE_AT_PHASE_WAIT_ACK;
+                txn->writeDoneMs = nowMs;
+                txn->nextActionMs = nowMs + txn->pollIntervalMs;
+            }
+            else if( device->transport->stream )
+            {
+                writing = true;
+            }
+            else
+            {
+                txn->nextActionMs = nowMs + txn->chunkGapMs;
+            }
+        }
+        else
+        {
+            lwnode_at_complete( device, LWNODE_AT_STATUS_WRITE_ERROR );
+        }
+    }
+}
+
+/**
+ * @brief Perform one ACK poll for the in-flight transaction.
+ *
+ * Completes the transaction when an ACK is available or when the command
+ * budget is exhausted. Otherwise the poll interval doubles, up to
+ * LWNODE_AT_ACK_POLL_MAX_MS, so fast replies are seen within a few
+ * milliseconds while slow ones do not hammer the bus.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[in]     nowMs  Current time.
+ */
+static void lwnode_at_step_ack( LwnodeDevice * const device, uint32_t nowMs )
+{
+    LwnodeAtTxn * const txn = &device->at;
+    uint16_t ackLen = 0U;
+    bool gotAck = false;
+
+    txn->ackPolls++;
+
+    if( lwnode_read_ack_bytes( device, &ackLen ) )
+    {
+        /* A reply that only carried downlinks is not the answer yet */
+        ackLen = lwnode_at_route_urcs( device, ackLen );
+        gotAck = ( ackLen > 0U );
+    }
+
+    if( gotAck )
+    {
+        txn->ackLen = ackLen;
+        txn->ackLatencyMs = nowMs - txn->writeDoneMs;
+        lwnode_at_complete( device, LWNODE_AT_STATUS_OK );
+    }
+    else if( ( nowMs - txn->writeDoneMs ) >= txn->ackTimeoutMs )
+    {
+        lwnode_at_complete( device, LWNODE_AT_STATUS_TIMEOUT );
+    }
+    else
+    {
+        txn->pollIntervalMs = txn->pollIntervalMs * 2U;
+
+        if( txn->pollIntervalMs > LWNODE_AT_ACK_POLL_MAX_MS )
+        {
+            txn->pollIntervalMs = LWNODE_AT_ACK_POLL_MAX_MS;
+        }
+
+        txn->nextActionMs = nowMs + txn->pollIntervalMs;
+
+        /* Make the last poll land on the deadline rather than past it */
+        if( lwnode_time_reached( txn->nextActionMs, 
+                                 txn->writeDoneMs + txn->ackTimeoutMs ) )
+        {
+            txn->nextActionMs = txn->writeDoneMs + txn->ackTimeoutMs;
+        }
+    }
+}
+
+/**
+ * @brief Finish the in-flight transaction and notify the owner.
+ *
+ * Returns the state machine to idle before invoking the completion
+ * callback, so the callback may submit the next command.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[in]     status Final transaction status.
+ */
+static void lwnode_at_complete( LwnodeDevice * const device,
+                                LwnodeAtStatus status )
+{
+    LwnodeAtTxn * const txn = &device->at;
+    const LwnodeAtDoneCb doneCb = txn->doneCb;
+    void * const doneCtx = txn->doneCtx;
+
+    if( status != LWNODE_AT_STATUS_OK )
+    {
+        txn->ackLen = 0U;
+        device->rxBuf[ 0 ] = 0U;
+    }
+
+    if( ( status == LWNODE_AT_STATUS_OK ) && ( txn->payload != NULL ) &&
+        lwnode_send_accepted( ( const char * ) device->rxBuf ) )
+    {
+        /* Uplink accepted: the RX windows are now ahead of us */
+        device->lastUplinkMs = lwnode_hal_get_time_ms();
+        device->busyState = LWNODE_STATE_RECV_WINDOW;
+        device->busyUntilMs = device->lastUplinkMs + LWNODE_RX2_CLOSE_MS;
+        /* Downlinks from either window are read once RX2 has closed */
+        device->rxNextPollMs = device->busyUntilMs;
+        device->busyStats.pollsDeferred++;
+    }
+
+#if ( LWNODE_STATS_ENABLED != 0 )
+    lwnode_stats_on_complete( device, status, lwnode_hal_get_time_ms() );
+#endif
+
+    txn->status = status;
+    txn->phase  = LWNODE_AT_PHASE_IDLE;
+    txn->doneCb = NULL;
+    txn->doneCtx = NULL;
+    device->intEnabled = true;
+
+    if( doneCb != NULL )
+    {
+        doneCb( device, status, ( const char * ) device->rxBuf, txn->ackLen, doneCtx );
+    }
+}
+
+/**
+ * @brief Send an ASCII AT command and check its acknowledgment.
+ *
+ * Blocking wrapper over the asynchronous transaction API: submits the
+ * command, then sleeps between lwnode_at_poll() steps until it completes.
+ * The reply is checked where it was read, in the device RX buffer, and
+ * stays there until the next transaction.
+ *
+ * Interrupt-driven processing is temporarily disabled during the
+ * transaction.
+ *
+ * @param[in,out] device      Pointer to the LoRa node device instance.
+ * @param[in]     cmdAscii    Null-terminated ASCII AT command (without CRLF).
+ * @param[in]     expectedAck Reply line to require, or NULL to accept any reply.
+ *
+ * @retval true  Command sent and the expected acknowledgment received.
+ * @retval false Invalid arguments, write failure, timeout or other reply.
+ */
+static bool lwnode_send_at_cmd( LwnodeDevice * const device,
+                                const char * const cmdAscii,
+                                const char * const expectedAck )
+{
+    bool result = false;
+
+    if( lwnode_at_submit( device, cmdAscii, NULL, NULL ) &&
+        ( lwnode_at_wait( device ) == LWNODE_AT_STATUS_OK ) )
+    {
+        result = ( expectedAck == NULL ) ||
+                 lwnode_ack_equals( ( const char * ) device->rxBuf, expectedAck );
+    }
+
+    return result;
+}
+
+#if ( LWNODE_STATS_ENABLED != 0 )
+/**
+ * @brief Map an AT command onto its instrumentation class.
+ *
+ * @param[in] cmd Command bytes.
+ * @param[in] len Command length in bytes.
+ *
+ * @return Command class.
+ */
+static LwnodeCmdType lwnode_stats_classify( const uint8_t * const cmd, uint16_t len )
+{
+    LwnodeCmdType type = LWNODE_CMD_OTHER;
+
+    if( ( len == 2U ) && ( cmd[ 0 ] == ( uint8_t ) 'A' ) && ( cmd[ 1 ] == ( uint8_t ) 'T' ) )
+    {
+        type = LWNODE_CMD_TEST;
+    }
+    else if( str_ext_starts_with( cmd, ( size_t ) len, "AT+REBOOT", 9U ) )
+    {
+        type = LWNODE_CMD_REBOOT;
+    }
+    else if( str_ext_starts_with( cmd, ( size_t ) len, "AT+JOIN?", 8U ) )
+    {
+        type = LWNODE_CMD_JOIN_QUERY;
+    }
+    else if( str_ext_starts_with( cmd, ( size_t ) len, 
+                                  LWNODE_JOIN_PREFIX, LWNODE_JOIN_PREFIX_LEN ) )
+    {
+        type = LWNODE_CMD_JOIN;
+    }
+    else if( str_ext_starts_with( cmd, ( size_t ) len, 
+                                  LWNODE_SEND_PREFIX, LWNODE_SEND_PREFIX_LEN ) )
+    {
+        type = LWNODE_CMD_SEND;
+    }
+    else if( ( memchr( cmd, '=', len ) != NULL ) &&
+             str_ext_starts_with( cmd, ( size_t ) len, "AT+", 3U ) )
+    {
+        type = LWNODE_CMD_CONFIG;
+    }
+    else
+    {
+        /* Queries and unknown commands */
+    }
+
+    return type;
+}
+
+/**
+ * @brief Start instrumenting a newly armed transaction.
+ *
+ * A command of the same class armed right after that class failed counts
+ * as a retry.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[in]     nowMs  Arm timestamp.
+ */
+static void lwnode_stats_on_arm( LwnodeDevice * const device, uint32_t nowMs )
+{
+    LwnodeAtTxn * const txn = &device->at;
+
+    txn->cmdType = lwnode_stats_classify( txn->txBuf, txn->prefixLen );
+    txn->armMs = nowMs;
+
+    if( device->statsLastFailed && ( device->statsLastType == txn->cmdType ) )
+    {
+        device->cmdStats[ txn->cmdType ].retries++;
+    }
+}
+
+/**
+ * @brief Account a finished transaction to its command class.
+ *
+ * @param[in,out] device Pointer to the LoRa node device instance.
+ * @param[in]     status Final transaction status.
+ * @param[in]     nowMs  Completion timestamp.
+ */
+static void lwnode_stats_on_complete( LwnodeDevice * const device,
+                                      LwnodeAtStatus status,
+                                      uint32_t nowMs )
+{
+    const LwnodeAtTxn * const txn = &device->at;
+    LwnodeCmdStats * const stats = &device->cmdStats[ txn->cmdType ];
+
+    stats->count++;
+    stats->ackPolls += txn->ackPolls;
+    lwnode_stats_record( &stats->total, nowMs - txn->armMs );
+
+    if( txn->phase == LWNODE_AT_PHASE_WAIT_ACK )
+    {
+        lwnode_stats_record( &stats->write, txn->writeDoneMs - txn->armMs );
+        lwnode_stats_record( &stats->ack, nowMs - txn->writeDoneMs );
+    }
+
+    if( status != LWNODE_AT_STATUS_OK )
+    {
+        stats->failures++;
+    }
+
+    device->statsLastType = txn->cmdType;
+    device->statsLastFailed = ( status != LWNODE_AT_STATUS_OK );
+}
+
+/**
+ * @brief Add one latency sample.
+ *
+ * @param[in,out] lat Latency accumulator.
+ * @param[in]     ms  Sample in milliseconds.
+ */
+static void lwnode_stats_record( LwnodeLatencyStats * const lat, uint32_t ms )
+{
+    uint32_t bucket = 0U;
+
+    while( ( bucket < ( LWNODE_STATS_LATENCY_BUCKETS - 1U ) ) && ( ( ms >> bucket ) != 0U ) )
+    {
+        bucket++;
+    }
+
+    if( ( lat->samples == 0U ) || ( ms < lat->minMs ) )
+    {
+        lat->minMs = ms;
+    }
+
+    if( ms > lat->maxMs )
+    {
+        lat->maxMs = ms;
+    }
+
+    lat->samples++;
+    lat->sumMs += ms;
+
+    if( lat->hist[ bucket ] < UINT16_MAX )
+    {
+        lat->hist[ bucket ]++;
+    }
+}
+
+/**
+ * @brief Reduce a latency accumulator to min/avg/max/p99.
+ *
+ * The p99 is the upper bound of the histogram bucket holding the 99th
+ * percentile, clamped to the observed range.
+ *
+ * @param[in]  lat Latency accumulator.
+ * @param[out] out Summary (all zero without samples).
+ */
+static void lwnode_stats_summarize( const LwnodeLatencyStats * const lat,
+                                    LwnodeLatencySummary * const out )
+{
+    ( void ) memset( out, 0, sizeof( *out ) );
+
+    if( lat->samples > 0U )
+    {
+        uint32_t histTotal = 0U;
+        uint32_t seen = 0U;
+        uint32_t bucket = 0U;
+
+        for( uint32_t i = 0U; i < LWNODE_STATS_LATENCY_BUCKETS; i++ )
+        {
+            histTotal += lat->hist[ i ];
+        }
+
+        while( ( bucket < ( LWNODE_STATS_LATENCY_BUCKETS - 1U ) ) &&
+               ( ( ( seen + lat->hist[ bucket ] ) * LWNODE_STATS_P99_DEN ) <
+                 ( histTotal * LWNODE_STATS_P99_NUM ) ) )
+        {
+            seen += lat->hist[ bucket ];
+            bucket++;
+        }
+
+        out->minMs = lat->minMs;
+        out->avgMs = lat->sumMs / lat->samples;
+        out->maxMs = lat->maxMs;
+        out->p99Ms = ( bucket == 0U ) ? 0U : ( ( 1UL << bucket ) - 1U );
+
+        if( out->p99Ms > lat->maxMs )
+        {
+            out->p99Ms = lat->maxMs;
+        }
+        if( out->p99Ms < lat->minMs )
+        {
+            out->p99Ms = lat->minMs;
+        }
+    }
+}
+
+/**
+ * @brief Append a string to a bounded text record.
+ *
+ * @param[out]    out    Record buffer.
+ * @param[in]     outCap Capacity of out.
+ * @param[in,out] pos    Current record length.
+ * @param[in]     text   Null-terminated text.
+ *
+ * @retval true  Appended and still null-terminated.
+ * @retval false The text does not fit.
+ */
+static bool lwnode_stats_append( char * const out,
+                                 size_t outCap,
+                                 size_t * const pos,
+                                 const char * const text )
+{
+    bool result = false;
+    const size_t len = str_ext_strnlen( text, outCap );
+
+    if( ( *pos + len ) < outCap )
+    {
+        ( void ) memcpy( &out[ *pos ], text, len );
+        *pos += len;
+        out[ *pos ] = '\0';
+        result = true;
+    }
+
     return result;
 }
+
+/**
+ * @brief Append a decimal number to a bounded text record.
+ *
+ * @param[out]    out    Record buffer.
+ * @param[in]     outCap Capacity of out.
+ * @param[in,out] pos    Current record length.
+ * @param[in]     value  Value to format.
+ *
+ * @retval true  Appended.
+ * @retval false The number does not fit.
+ */
+static bool lwnode_stats_append_u32( char * const out,
+                                     size_t outCap,
+                                     size_t * const pos,
+                                     uint32_t value )
+{
+    char digits[ 11 ] = { '\0' };
+
+    return num_fmt_u32toa( value, digits, sizeof( digits ) ) &&
+           lwnode_stats_append( out, outCap, pos, digits );
+}
+
+/**
+ * @brief Append "<tag>min/avg/max/p99" to a bounded text record.
+ *
+ * @param[out]    out    Record buffer.
+ * @param[in]     outCap Capacity of out.
+ * @param[in,out] pos    Current record length.
+ * @param[in]     tag    Field tag, e.g. " w=".
+ * @param[in]     lat    Latency accumulator.
+ *
+ * @retval true  Appended.
+ * @retval false The field does not fit.
+ */
+static bool lwnode_stats_append_latency( char * const out,
+                                         size_t outCap,
+                                         size_t * const pos,
+                                         const char * const tag,
+                                         const LwnodeLatencyStats * const lat )
+{
+    LwnodeLatencySummary sum = { 0 };
+
+    lwnode_stats_summarize( lat, &sum );
+
+    return lwnode_stats_append( out, outCap, pos, tag ) &&
+           lwnode_stats_append_u32( out, outCap, pos, sum.minMs ) &&
+           lwnode_stats_append( out, outCap, pos, "/" ) &&
+           lwnode_stats_append_u32( out, outCap, pos, sum.avgMs ) &&
+           lwnode_stats_append( out, outCap, pos, "/" ) &&
+           lwnode_stats_append_u32( out, outCap, pos, sum.maxMs ) &&
+           lwnode_stats_append( out, outCap, pos, "/" ) &&
+           lwnode_stats_append_u32( out, outCap, pos, sum.p99Ms );
+}
+#endif
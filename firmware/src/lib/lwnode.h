@@ -26,13 +26,36 @@ extern "C" {
 #define LWNODE_MAX_APP_KEY_HEX_CHARS     ( 32U )   /**< Application Key hex string length */
 #define LWNODE_MAX_NWK_SKEY_HEX_CHARS    ( 32U )   /**< Network Session Key hex string length */
 #define LWNODE_MAX_APP_SKEY_HEX_CHARS    ( 32U )   /**< Application Session Key hex string length */
+#define LWNODE_APP_EUI_BYTES             ( 8U )    /**< Application EUI in binary */
+#define LWNODE_KEY_BYTES                 ( 16U )   /**< AES-128 key in binary */
+#define LWNODE_MAX_AT_CMD_BYTES          ( 64U )   /**< Maximum buffered AT command length (excluding CRLF) */
+#define LWNODE_MAX_CFG_CMD_BYTES         ( 12U + LWNODE_MAX_APP_KEY_HEX_CHARS + 1U ) /**< Longest setter prefix plus a key and NUL */
+#define LWNODE_MAX_LORA_PAYLOAD_BYTES    ( 128U )  /**< Maximum uplink payload accepted by the module */
+#define LWNODE_MAX_RX_BATCH_FRAMES       ( 16U )   /**< Maximum downlinks drained per batch */
+#define LWNODE_SHADOW_VERSION            ( 3U )    /**< Layout version of the persisted config shadow */
+#define LWNODE_SESSION_VERSION           ( 1U )    /**< Layout version of the persisted join session */
+#define LWNODE_SESSION_MAX_WARM_BOOTS    ( 64U )   /**< Boots a session may be resumed before a forced re-join */
+#define LWNODE_SESSION_WARM_BOOT_JITTER  ( 16U )   /**< Per-device reduction of that limit, 0 to 15 boots */
+#define LWNODE_STATS_LATENCY_BUCKETS     ( 16U )   /**< Power-of-two latency histogram buckets */
+
+/** Per-command instrumentation (1184 B of device RAM); build with -DLWNODE_STATS_ENABLED=1 to compile it in */
+#ifndef LWNODE_STATS_ENABLED
+#define LWNODE_STATS_ENABLED             ( 0 )
+#endif
 /** @} */
 
 typedef struct LwnodeHw LwnodeHw;
+typedef struct LwnodeDevice LwnodeDevice;
 
 /**
  * @enum LwnodeBusyState
  * @brief Device operational state enumeration
+ *
+ * Derived from the command flow: a send in flight is SENDING, an accepted
+ * uplink opens RECV_WINDOW until RX2 has closed, and an accepted join
+ * request is JOINING until the join is confirmed or its accept windows
+ * have passed. The module does not answer reliably outside IDLE, so the
+ * driver holds commands and downlink polls back until then.
  */
 typedef enum {
     LWNODE_STATE_IDLE,           /**< Device is idle */
@@ -96,24 +119,361 @@ typedef void (*LwnodeRxCb)( const uint8_t * payload,
                             int8_t rssi,
                             int8_t snr );
 
+/**
+ * @enum LwnodeRxMode
+ * @brief Downlink reception strategy used by lwnode_sleep_ms()
+ */
+typedef enum
+{
+    LWNODE_RX_MODE_EVENT = 0,    /**< Poll around RX windows, back off when idle, use IRQ if wired */
+    LWNODE_RX_MODE_POLL  = 1     /**< Legacy: poll the data length register every millisecond */
+} LwnodeRxMode;
+
+/**
+ * @struct LwnodeRxStats
+ * @brief Downlink polling counters
+ */
+typedef struct LwnodeRxStats
+{
+    uint32_t pollsIssued;        /**< Data-length register reads performed while sleeping */
+    uint32_t pollsAvoided;       /**< Reads the legacy 1 ms polling would have added */
+    uint32_t irqWakeups;         /**< Wake-ups caused by the module IRQ line */
+    uint32_t framesReceived;     /**< Downlink reads that returned data */
+    uint32_t urcFrames;          /**< Downlinks that arrived inside an AT reply */
+    uint32_t malformedFrames;    /**< Queued frames read but not parsable as "+RECV=" */
+} LwnodeRxStats;
+
+/**
+ * @struct LwnodeBusyStats
+ * @brief Work held back while the module was busy
+ */
+typedef struct LwnodeBusyStats
+{
+    uint32_t cmdsParked;         /**< AT commands whose first write waited for IDLE */
+    uint32_t parkedMs;           /**< Total time commands waited */
+    uint32_t pollsDeferred;      /**< Downlink polls and reads moved past a busy period */
+    uint32_t joinQueriesSkipped; /**< lwnode_is_joined() answered without the bus */
+} LwnodeBusyStats;
+
+/**
+ * @struct LwnodeConfigShadow
+ * @brief Last configuration acknowledged by the module
+ *
+ * Persisted in NVS so that a reboot only re-sends the AT commands whose
+ * values changed. A field is trusted only while its bit is set in
+ * validMask; a failed or unacknowledged command clears the bit.
+ * packetType, dataRate and eirp change at runtime and are only tracked
+ * in RAM: changing them never writes NVS, and they are re-sent once
+ * after each boot. Keys are never persisted: the shadow only holds a
+ * CRC-32 of each, enough to tell whether the module already has it.
+ */
+typedef struct LwnodeConfigShadow
+{
+    uint16_t version;               /**< LWNODE_SHADOW_VERSION */
+    uint16_t validMask;             /**< Fields known to be applied on the module */
+    uint8_t region;                 /**< LwnodeRegion */
+    uint8_t joinType;               /**< LwnodeJoinType */
+    uint8_t classType;              /**< LwnodeClass */
+    uint8_t packetType;             /**< LwnodePacketType */
+    uint8_t dataRate;               /**< Datarate index */
+    uint8_t eirp;                   /**< EIRP in dBm */
+    uint8_t subBand;                /**< Sub-band */
+    uint8_t adr;                    /**< ADR enabled (0/1) */
+    uint32_t devAddr;               /**< Device address (ABP) */
+    uint32_t appEuiCrc;             /**< CRC-32 of the Application EUI */
+    uint32_t appKeyCrc;             /**< CRC-32 of the Application Key */
+    uint32_t nwkSkeyCrc;            /**< CRC-32 of the Network Session Key */
+    uint32_t appSkeyCrc;            /**< CRC-32 of the Application Session Key */
+} LwnodeConfigShadow;
+
+/**
+ * @struct LwnodeSession
+ * @brief Persisted join state used to resume a session on warm boot
+ */
+typedef struct LwnodeSession
+{
+    uint16_t version;               /**< LWNODE_SESSION_VERSION */
+    uint8_t joined;                 /**< Module held a joined session at last check */
+    uint8_t joinType;               /**< LwnodeJoinType the session was joined with */
+    uint32_t joinCount;             /**< Successful joins since the record was created */
+    uint32_t warmBoots;             /**< Boots that resumed the current session */
+    uint32_t joinedAtMs;            /**< Uptime at join, in the boot that joined */
+} LwnodeSession;
+
+/**
+ * @struct LwnodeJoinMetrics
+ * @brief Boot and join timing, for comparing cold and warm starts
+ */
+typedef struct LwnodeJoinMetrics
+{
+    uint32_t coldBoots;             /**< lwnode_begin() calls that did not resume a session */
+    uint32_t warmBoots;             /**< lwnode_begin() calls that resumed a session */
+    uint32_t joinsRequested;        /**< Join requests accepted by the module */
+    uint32_t joinsCompleted;        /**< Joins confirmed by lwnode_is_joined() */
+    uint32_t lastBeginMs;           /**< Duration of the last lwnode_begin() */
+    uint32_t lastJoinMs;            /**< Join request to confirmed join */
+    uint32_t lastReadyMs;           /**< lwnode_begin() start to joined */
+    bool lastBootWarm;              /**< Last lwnode_begin() resumed a session */
+} LwnodeJoinMetrics;
+
+/**
+ * @struct LwnodeRxFrameInfo
+ * @brief Location and link metrics of one downlink in a batch buffer
+ */
+typedef struct LwnodeRxFrameInfo
+{
+    uint16_t offset;             /**< Payload offset in the batch buffer */
+    uint8_t len;                 /**< Payload length in bytes */
+    int8_t rssi;                 /**< Signal strength in dBm */
+    int8_t snr;                  /**< Signal-to-noise ratio in dB */
+} LwnodeRxFrameInfo;
+
+/**
+ * @struct LwnodeRxBatch
+ * @brief Caller-provided storage for lwnode_read_data_batch()
+ */
+typedef struct LwnodeRxBatch
+{
+    uint8_t * buf;               /**< Payload storage (frames are packed back to back) */
+    uint16_t bufCap;             /**< Capacity of buf in bytes */
+    LwnodeRxFrameInfo * frames;  /**< Frame descriptors */
+    uint8_t maxFrames;           /**< Capacity of frames */
+    uint8_t frameCount;          /**< Output: frames stored */
+    uint16_t bufUsed;            /**< Output: bytes of buf used */
+} LwnodeRxBatch;
+
+/**
+ * @struct LwnodeRxFrame
+ * @brief View of one downlink inside a receive buffer
+ *
+ * payload points into the buffer being iterated (usually the driver RX
+ * buffer) and is valid until the next driver call that reads the module.
+ * The DFR1115 "+RECV=" frame carries no FPort, so none is reported.
+ */
+typedef struct LwnodeRxFrame
+{
+    const uint8_t * payload;     /**< First payload byte, not copied */
+    uint8_t len;                 /**< Payload length in bytes */
+    int8_t rssi;                 /**< Signal strength in dBm */
+    int8_t snr;                  /**< Signal-to-noise ratio in dB */
+} LwnodeRxFrame;
+
+/**
+ * @struct LwnodeRxFrameIter
+ * @brief Cursor over back-to-back "+RECV=" frames
+ */
+typedef struct LwnodeRxFrameIter
+{
+    const uint8_t * buf;         /**< Frame bytes */
+    uint16_t len;                /**< Length of buf in bytes */
+    uint16_t pos;                /**< Offset of the next frame */
+    bool malformed;              /**< Iteration stopped at a bad frame */
+} LwnodeRxFrameIter;
+
+/**
+ * @enum LwnodeCmdType
+ * @brief AT command classes tracked by the instrumentation
+ */
+typedef enum
+{
+    LWNODE_CMD_TEST = 0,         /**< "AT" liveness probe */
+    LWNODE_CMD_REBOOT,           /**< AT+REBOOT */
+    LWNODE_CMD_JOIN,             /**< AT+JOIN= */
+    LWNODE_CMD_JOIN_QUERY,       /**< AT+JOIN? */
+    LWNODE_CMD_SEND,             /**< AT+SEND= */
+    LWNODE_CMD_CONFIG,           /**< Any other AT+<name>= setter */
+    LWNODE_CMD_OTHER,            /**< Anything else */
+    LWNODE_CMD_TYPE_COUNT        /**< Number of command classes */
+} LwnodeCmdType;
+
+/**
+ * @struct LwnodeLatencyStats
+ * @brief Latency accumulator with a power-of-two histogram
+ *
+ * Bucket 0 holds 0 ms samples, bucket b holds [2^(b-1), 2^b) ms; the last
+ * bucket also holds everything longer.
+ */
+typedef struct LwnodeLatencyStats
+{
+    uint32_t samples;            /**< Samples recorded */
+    uint32_t minMs;              /**< Shortest sample */
+    uint32_t maxMs;              /**< Longest sample */
+    uint32_t sumMs;              /**< Sum of all samples */
+    uint16_t hist[ LWNODE_STATS_LATENCY_BUCKETS ]; /**< Histogram counts */
+} LwnodeLatencyStats;
+
+/**
+ * @struct LwnodeCmdStats
+ * @brief Raw counters of one command class
+ */
+typedef struct LwnodeCmdStats
+{
+    uint32_t count;              /**< Transactions completed */
+    uint32_t failures;           /**< Transactions that failed (write error or timeout) */
+    uint32_t retries;            /**< Transactions re-issued right after the same class failed */
+    LwnodeLatencyStats write;    /**< Arm to final chunk written */
+    LwnodeLatencyStats ack;      /**< Final chunk written to ACK read */
+    LwnodeLatencyStats total;    /**< Arm to completion */
+    uint32_t bytesWritten;       /**< I2C command bytes written */
+    uint32_t bytesRead;          /**< I2C ACK bytes read, length reads included */
+    uint32_t ackPolls;           /**< ACK poll iterations */
+} LwnodeCmdStats;
+
+/**
+ * @struct LwnodeLatencySummary
+ * @brief Latency figures in milliseconds
+ */
+typedef struct LwnodeLatencySummary
+{
+    uint32_t minMs;              /**< Shortest sample */
+    uint32_t avgMs;              /**< Mean sample */
+    uint32_t maxMs;              /**< Longest sample */
+    uint32_t p99Ms;              /**< 99th percentile (histogram bucket bound) */
+} LwnodeLatencySummary;
+
+/**
+ * @struct LwnodeCmdReport
+ * @brief Summarized statistics of one command class
+ */
+typedef struct LwnodeCmdReport
+{
+    uint32_t count;              /**< Transactions completed */
+    uint32_t failures;           /**< Transactions that failed */
+    uint32_t retries;            /**< Transactions re-issued after a failure */
+    LwnodeLatencySummary write;  /**< Write phase latency */
+    LwnodeLatencySummary ack;    /**< ACK wait latency */
+    LwnodeLatencySummary total;  /**< End-to-end latency */
+    uint32_t bytesWritten;       /**< I2C command bytes written */
+    uint32_t bytesRead;          /**< I2C ACK bytes read */
+    uint32_t ackPolls;           /**< ACK poll iterations */
+} LwnodeCmdReport;
+
+/**
+ * @enum LwnodeAtStatus
+ * @brief Outcome of an asynchronous AT transaction
+ */
+typedef enum
+{
+    LWNODE_AT_STATUS_IDLE = 0,     /**< No transaction has been submitted */
+    LWNODE_AT_STATUS_PENDING,      /**< Transaction is in flight */
+    LWNODE_AT_STATUS_OK,           /**< ACK received and stored in rxBuf */
+    LWNODE_AT_STATUS_WRITE_ERROR,  /**< I2C write of the command failed */
+    LWNODE_AT_STATUS_TIMEOUT       /**< No ACK received within the command budget */
+} LwnodeAtStatus;
+
+/**
+ * @enum LwnodeAtPhase
+ * @brief Internal state of the AT transaction state machine
+ */
+typedef enum
+{
+    LWNODE_AT_PHASE_IDLE = 0,      /**< No transaction in flight */
+    LWNODE_AT_PHASE_WRITE,         /**< Writing command chunks */
+    LWNODE_AT_PHASE_WAIT_ACK       /**< Polling for the ACK with backoff */
+} LwnodeAtPhase;
+
+/**
+ * @typedef LwnodeAtDoneCb
+ * @brief AT transaction completion callback
+ *
+ * Invoked from lwnode_at_poll() in the context of the polling task.
+ *
+ * @param device Device instance that owns the transaction
+ * @param status Final transaction status
+ * @param ack Null-terminated ACK string (valid only during the callback)
+ * @param ackLen ACK length in bytes (0 unless status is OK)
+ * @param ctx User context passed to lwnode_at_submit()
+ */
+typedef void (*LwnodeAtDoneCb)( LwnodeDevice * device,
+                                LwnodeAtStatus status,
+                                const char * ack,
+                                uint16_t ackLen,
+                                void * ctx );
+
+/**
+ * @struct LwnodeTransport
+ * @brief Byte transport between the driver and the module
+ *
+ * Register transports (the default I2C one) move AT commands in chunks
+ * written with a gap between them, read replies from the ACK registers and
+ * keep downlinks in the module's queue registers. Stream transports (UART,
+ * loopback) take a command in one burst and deliver replies and "+RECV="
+ * frames in a single byte stream; the queue registers are not used.
+ *
+ * All callbacks receive the context passed to lwnode_set_transport().
+ */
+typedef struct LwnodeTransport
+{
+    const char * name;           /**< Short name for logs and benchmarks */
+    bool stream;                 /**< Burst writes, downlinks inside the reply stream */
+
+    /** Optional fast presence check (NULL: rely on the AT test) */
+    bool ( *probe )( void * ctx );
+
+    /** Write up to LWNODE_I2C_CHUNK_SIZE command bytes; final ends the command */
+    bool ( *write_at )( void * ctx, const uint8_t * data, size_t len, bool final );
+
+    /** Read the pending reply bytes; false if nothing is pending */
+    bool ( *read_at )( void * ctx, uint8_t * buf, size_t cap, uint16_t * outLen );
+
+    /** Optional: block until read_at() has data or the timeout expires */
+    bool ( *wait_rx )( void * ctx, uint32_t timeoutMs );
+} LwnodeTransport;
+
+/**
+ * @struct LwnodeAtTxn
+ * @brief In-flight AT transaction bookkeeping
+ */
+typedef struct LwnodeAtTxn
+{
+    LwnodeAtPhase phase;            /**< Current state machine phase */
+    LwnodeAtStatus status;          /**< Status of the current or last transaction */
+    uint8_t txBuf[ LWNODE_MAX_AT_CMD_BYTES ]; /**< Command prefix bytes (no CRLF) */
+    uint16_t prefixLen;             /**< Bytes used in txBuf */
+    const uint8_t * payload;        /**< Binary payload hex-encoded on the fly (optional) */
+    uint8_t payloadLen;             /**< Payload length in bytes */
+    uint16_t txLen;                 /**< Total streamed length: prefix + hex + CRLF */
+    uint16_t txOffset;              /**< Bytes already written */
+    uint32_t chunkGapMs;            /**< Inter-chunk gap latched for this transfer */
+    uint16_t ackLen;                /**< Length of the received ACK */
+    uint16_t ackPolls;              /**< ACK poll attempts so far */
+    uint32_t ackTimeoutMs;          /**< ACK budget for this command */
+    uint32_t pollIntervalMs;        /**< Current ACK poll interval (backs off) */
+    uint32_t writeDoneMs;           /**< Timestamp of the final chunk write */
+    uint32_t ackLatencyMs;          /**< Write-to-ACK latency of the last OK transaction */
+    uint32_t nextActionMs;          /**< Timestamp of the next state machine step */
+#if ( LWNODE_STATS_ENABLED != 0 )
+    LwnodeCmdType cmdType;          /**< Instrumentation class of the command */
+    uint32_t armMs;                 /**< Timestamp the transaction was armed */
+#endif
+    LwnodeAtDoneCb doneCb;          /**< Completion callback (optional) */
+    void * doneCtx;                 /**< Completion callback context */
+} LwnodeAtTxn;
+
 /**
  * @struct LwnodeDevice
  * @brief LoRaWAN device instance and state management
+ *
+ * Not thread-safe: one task owns the device and makes every driver call.
+ * Other tasks submit operations through lib/lwnode_mailbox.
  */
-typedef struct LwnodeDevice
+struct LwnodeDevice
 {
     const LwnodeHw * sensor;        /**< Hardware interface pointer */
+    const LwnodeTransport * transport; /**< AT byte transport (I2C registers by default) */
+    void * transportCtx;            /**< Context passed to the transport callbacks */
 
     /* Device config/state */
     LwnodeJoinType joinType;        /**< Join method (OTAA or ABP) */
     LwnodeRegion region;            /**< LoRaWAN region */
     uint32_t devAddr;               /**< Device address (ABP only) */
 
-    /* Keys stored as HEX ASCII (null-terminated) */
-    char appEui[ LWNODE_MAX_APP_EUI_HEX_CHARS + 1U ];     /**< Application EUI (OTAA) */
-    char appKey[ LWNODE_MAX_APP_KEY_HEX_CHARS + 1U ];     /**< Application Key (OTAA) */
-    char nwkSkey[ LWNODE_MAX_NWK_SKEY_HEX_CHARS + 1U ];   /**< Network Session Key (ABP) */
-    char appSkey[ LWNODE_MAX_APP_SKEY_HEX_CHARS + 1U ];   /**< Application Session Key (ABP) */
+    /* Keys stored in binary, hex-encoded only into the command being sent */
+    uint8_t appEui[ LWNODE_APP_EUI_BYTES ];     /**< Application EUI (OTAA) */
+    uint8_t appKey[ LWNODE_KEY_BYTES ];         /**< Application Key (OTAA) */
+    uint8_t nwkSkey[ LWNODE_KEY_BYTES ];        /**< Network Session Key (ABP) */
+    uint8_t appSkey[ LWNODE_KEY_BYTES ];        /**< Application Session Key (ABP) */
+    uint16_t keyMask;               /**< Internal: keys set, replayed by lwnode_begin() */
 
     /* radio params (optional) */
     uint8_t dataRate;               /**< “LoRaWAN datarate index (region-dependent) */
@@ -128,14 +488,62 @@ typedef struct LwnodeDevice
     /* callbacks */
     LwnodeRxCb  rxCb;               /**< Receive data callback */
 
+    /* downlink reception */
+    LwnodeRxMode rxMode;            /**< Reception strategy */
+    uint32_t lastUplinkMs;          /**< Timestamp of the last accepted uplink */
+    uint32_t rxIdleIntervalMs;      /**< Current idle poll interval (backs off) */
+    uint32_t rxNextPollMs;          /**< Timestamp of the next scheduled poll */
+    LwnodeRxStats rxStats;          /**< Polling counters */
+
+    /* module activity */
+    LwnodeBusyState busyState;      /**< Internal: JOINING or RECV_WINDOW until busyUntilMs, else IDLE */
+    uint32_t busyUntilMs;           /**< Internal: end of the busy period */
+    LwnodeBusyStats busyStats;      /**< Work held back while busy */
+
+    /* I2C flow control */
+    uint32_t chunkGapMs;            /**< Minimum gap between command chunks */
+
+    /* module configuration shadow */
+    LwnodeConfigShadow shadow;      /**< Last configuration applied on the module */
+    bool shadowDirty;               /**< Shadow differs from the NVS copy */
+    bool shadowDeferStore;          /**< Internal: batch NVS writes during lwnode_begin() */
+    uint32_t shadowSkips;           /**< AT commands skipped because the shadow matched */
+    uint32_t shadowApplied;         /**< AT configuration commands actually sent */
+
+    /* join session persistence */
+    LwnodeSession session;          /**< Persisted join state */
+    LwnodeJoinMetrics joinMetrics;  /**< Boot and join timing */
+    bool sessionResumed;            /**< Last lwnode_begin() kept the module's session */
+    bool joinPending;               /**< Internal: join requested, not yet confirmed */
+    uint32_t beginStartMs;          /**< Internal: start of the last lwnode_begin() */
+    uint32_t joinStartMs;           /**< Internal: time of the last join request */
+
+    /* bounded bring-up */
+    bool isReady;                   /**< Last lwnode_begin() succeeded */
+    bool budgetArmed;               /**< Internal: AT commands must finish by budgetDeadlineMs */
+    uint32_t budgetDeadlineMs;      /**< Internal: end of the lwnode_begin_bounded() budget */
+
     /* internal: gate receive parsing during AT transactions */
     bool intEnabled;                /**< Internal: Interrupt enable flag */
 
     /* internal RX scratch buffer */
-    uint8_t rxBuf[ LWNODE_MAX_RX_BYTES ];  /**< Internal: Receive buffer */
+    uint8_t rxBuf[ LWNODE_MAX_RX_BYTES ];  /**< Internal: Receive buffer, holds the last reply */
+
+    /* internal: command formatting arena shared by the setters */
+    char scratch[ LWNODE_MAX_CFG_CMD_BYTES ];  /**< Internal: Formatted setter command */
+
+    /* internal: asynchronous AT transaction */
+    LwnodeAtTxn at;                 /**< Internal: In-flight AT transaction */
+
+#if ( LWNODE_STATS_ENABLED != 0 )
+    /* per-command instrumentation */
+    LwnodeCmdStats cmdStats[ LWNODE_CMD_TYPE_COUNT ]; /**< Counters per command class */
+    LwnodeCmdType statsLastType;    /**< Internal: class of the last completed command */
+    bool statsLastFailed;           /**< Internal: the last completed command failed */
+#endif
 
     bool isInitialized;              /**< Device initialization flag */
-} LwnodeDevice;
+};
 
 /** @defgroup LwnodeInitialization Initialization and Configuration */
 /** @{ */
@@ -149,6 +557,21 @@ typedef struct LwnodeDevice
  */
 bool lwnode_init( LwnodeDevice * device, const LwnodeHw * sensor );
 
+/**
+ * @brief Select the transport used to talk to the module
+ *
+ * lwnode_init() selects the I2C register transport over the HAL. Call this
+ * before lwnode_begin() to use a UART or loopback backend instead. On
+ * stream transports lwnode_read_data_batch() and lwnode_read_frame() are
+ * not available; downlinks reach the RX callback from the reply stream.
+ *
+ * @param device Device instance
+ * @param transport Transport callbacks, or NULL for the default I2C one
+ * @param ctx Context passed to the callbacks
+ * @return true if selected, false if invalid or a transaction is in flight
+ */
+bool lwnode_set_transport( LwnodeDevice * device, const LwnodeTransport * transport, void * ctx );
+
 /** @} */
 
 /** @defgroup LwnodeConfiguration Configuration Functions */
@@ -226,6 +649,18 @@ bool lwnode_set_class( LwnodeDevice * device, LwnodeClass classType );
  */
 bool lwnode_set_datarate( LwnodeDevice * device, uint8_t dataRate );
 
+/**
+ * @brief Query the data rate the module currently uses
+ *
+ * With ADR on, the network moves the data rate, so the configured value
+ * in the device may be stale. The configured value is left unchanged.
+ *
+ * @param device Device instance
+ * @param dataRate Output data rate index
+ * @return true if the module reported a valid data rate, false otherwise
+ */
+bool lwnode_get_datarate( LwnodeDevice * device, uint8_t * dataRate );
+
 /**
  * @brief Set Equivalent Isotropic Radiated Power (EIRP)
  * 
@@ -256,6 +691,10 @@ bool lwnode_enable_adr( LwnodeDevice * device, bool adr );
 /**
  * @brief Set uplink transmission type (confirmed or unconfirmed)
  * 
+ * AT+UPLINKTYPE is only sent when the type differs from the one last
+ * applied, and the type is never written to NVS, so calling this before
+ * every uplink costs nothing while a run of frames keeps the same type.
+ *
  * @param device Device instance
  * @param type Packet type (confirmed or unconfirmed)
  * @return true if set successfully, false otherwise
@@ -288,12 +727,45 @@ bool lwnode_config_abp( LwnodeDevice * device );
  * 
  * Performs hardware reset, verifies communication, configures join mode,
  * and applies stored credentials. Must be called before join or send operations.
+ * Commands whose values match the persisted configuration shadow are
+ * skipped (see lwnode_shadow_invalidate()).
+ *
+ * Warm start: if the persisted session says the module was joined and
+ * AT+JOIN? confirms it, the module is not rebooted and the session is
+ * kept, so the caller can skip lwnode_join() (see lwnode_session_resumed()).
+ * A session is resumed at most LWNODE_SESSION_MAX_WARM_BOOTS times, less a
+ * per-device jitter from lwnode_hal_device_id() so that nodes powered on
+ * together do not re-join at the same boot. It is dropped if any
+ * configuration command had to be re-sent.
  * 
  * @param device Device instance
  * @return true if initialization successful, false otherwise
  */
 bool lwnode_begin( LwnodeDevice * device );
 
+/**
+ * @brief lwnode_begin() with a total time budget
+ *
+ * Fails immediately if the module does not ACK its I2C address, and
+ * otherwise gives up once budgetMs has elapsed: AT retries stop and ACK
+ * timeouts are shortened to the remaining budget. Intended for boot, so a
+ * missing or wedged radio cannot hold up the rest of the system; retry
+ * later (e.g. from the radio task) until it succeeds.
+ *
+ * @param device Device instance
+ * @param budgetMs Total time budget in milliseconds (must be > 0)
+ * @return true if the module is ready, false on NACK, error or timeout
+ */
+bool lwnode_begin_bounded( LwnodeDevice * device, uint32_t budgetMs );
+
+/**
+ * @brief Check whether the last lwnode_begin() call succeeded
+ *
+ * @param device Device instance
+ * @return true if the module is configured and ready
+ */
+bool lwnode_is_ready( const LwnodeDevice * device );
+
 /**
  * @brief Request network join (OTAA or ABP)
  * 
@@ -305,6 +777,9 @@ bool lwnode_join( LwnodeDevice * device );
 /**
  * @brief Query current network join status
  * 
+ * While a join is pending the module is not asked before the join accept
+ * can have arrived; until then the call returns false without bus traffic.
+ *
  * @param device Device instance
  * @return true if device is currently joined to network, false otherwise
  */
@@ -339,6 +814,131 @@ bool lwnode_send_packet_bytes( LwnodeDevice * device, const uint8_t * data, uint
  */
 bool lwnode_sleep_ms( LwnodeDevice * device, uint32_t sleepMs);
 
+/**
+ * @brief Check whether the last lwnode_begin() resumed a joined session
+ *
+ * @param device Device instance
+ * @return true if the module kept its session and no join is needed
+ */
+bool lwnode_session_resumed( const LwnodeDevice * device );
+
+/**
+ * @brief Get the cached join state without asking the module
+ *
+ * Set when lwnode_begin() resumes a session or lwnode_is_joined() sees
+ * the module joined; cleared by a cold lwnode_begin() or when
+ * lwnode_is_joined() sees the session lost.
+ *
+ * @param device Device instance
+ * @return true if the module held a joined session at the last check
+ */
+bool lwnode_session_joined( const LwnodeDevice * device );
+
+/**
+ * @brief Get boot and join timing metrics
+ *
+ * @param device Device instance
+ * @param out Output metrics
+ * @return true if copied, false on invalid parameter
+ */
+bool lwnode_get_join_metrics( const LwnodeDevice * device,
+                              LwnodeJoinMetrics * out );
+
+/**
+ * @brief Forget the persisted module configuration
+ *
+ * Forces the next lwnode_begin() and every setter to re-send their AT
+ * commands. Use after replacing or factory-resetting the module.
+ *
+ * @param device Device instance
+ * @return true if the shadow was cleared and stored, false otherwise
+ */
+bool lwnode_shadow_invalidate( LwnodeDevice * device );
+
+/**
+ * @brief Drain every queued downlink into the RX callback
+ *
+ * Reads the module queue depth once and pulls all pending frames in a
+ * single pass (bounded by LWNODE_MAX_RX_BATCH_FRAMES), without the settle
+ * delay used by single-frame reads. Each frame is passed to the
+ * registered RX callback. Nothing is read while an uplink is in flight
+ * or the join/RX windows are open; the call is counted in
+ * busyStats.pollsDeferred and the frames stay queued.
+ *
+ * @param device Device instance
+ * @return Number of frames read (0 if none, busy, on error, or no callback)
+ */
+uint8_t lwnode_drain_rx( LwnodeDevice * device );
+
+/**
+ * @brief Drain every queued downlink into a caller buffer
+ *
+ * Same single-pass drain as lwnode_drain_rx(), but payloads are packed
+ * into batch->buf and described by batch->frames. Draining stops early
+ * when either the buffer or the frame table is full. A frame is checked
+ * against the free buffer space from its length register before it is
+ * read, so a frame that does not fit stays queued in the module with the
+ * ones behind it. Frames that do not parse are counted in
+ * rxStats.malformedFrames. Like lwnode_drain_rx(), nothing is read while
+ * the module is busy.
+ *
+ * @param device Device instance
+ * @param batch Caller storage; frameCount and bufUsed are outputs
+ * @return true if at least one frame was stored, false otherwise
+ */
+bool lwnode_read_data_batch( LwnodeDevice * device, LwnodeRxBatch * batch );
+
+/**
+ * @brief Select the downlink reception strategy
+ *
+ * In event mode lwnode_sleep_ms() does not touch the module queue until
+ * the join or Class A RX windows after an uplink have closed, reads once
+ * then to collect anything they delivered, and backs off exponentially
+ * when idle. When the board wires an IRQ line (or the transport can wait
+ * for data) it sleeps on it instead, and an IRQ raised during the windows
+ * is taken once they close. Deferred reads are counted in
+ * busyStats.pollsDeferred.
+ *
+ * @param device Device instance
+ * @param mode Reception strategy
+ * @return true if set successfully, false otherwise
+ */
+bool lwnode_set_rx_mode( LwnodeDevice * device, LwnodeRxMode mode );
+
+/**
+ * @brief Get downlink polling counters
+ *
+ * @param device Device instance
+ * @param out Output counters
+ * @return true if copied, false on invalid parameter
+ */
+bool lwnode_get_rx_stats( const LwnodeDevice * device, LwnodeRxStats * out );
+
+/**
+ * @brief Get what the module is busy with
+ *
+ * @param device Device instance
+ * @return Current state, LWNODE_STATE_IDLE if idle or invalid
+ */
+LwnodeBusyState lwnode_get_busy_state( const LwnodeDevice * device );
+
+/**
+ * @brief Get the time until the module is idle again
+ *
+ * @param device Device instance
+ * @return Milliseconds until IDLE, 0 if idle, sending or invalid
+ */
+uint32_t lwnode_busy_remaining_ms( const LwnodeDevice * device );
+
+/**
+ * @brief Get counters of work held back while the module was busy
+ *
+ * @param device Device instance
+ * @param out Output counters
+ * @return true if copied, false on invalid parameter
+ */
+bool lwnode_get_busy_stats( const LwnodeDevice * device, LwnodeBusyStats * out );
+
 /**
  * @brief Read received data (polling mode)
  * 
@@ -353,6 +953,164 @@ bool lwnode_sleep_ms( LwnodeDevice * device, uint32_t sleepMs);
  */
 bool lwnode_read_data_bytes( LwnodeDevice * device, uint8_t * out, uint16_t outMax, uint16_t * outLen);
 
+/**
+ * @brief Read the next queued downlink without copying it
+ *
+ * Same read as lwnode_read_data_bytes(), but the frame is returned as a
+ * view into the driver RX buffer. The view is valid until the next driver
+ * call that reads the module.
+ *
+ * @param device Device instance
+ * @param frame Output frame view
+ * @return true if a well-formed frame was read, false otherwise
+ */
+bool lwnode_read_frame( LwnodeDevice * device, LwnodeRxFrame * frame );
+
+/**
+ * @brief Start iterating "+RECV=" frames in a buffer
+ *
+ * @param it Iterator to initialize
+ * @param buf Frame bytes (may be NULL if len is 0)
+ * @param len Length of buf in bytes
+ * @return true if initialized, false on invalid parameter
+ */
+bool lwnode_rx_frames_begin( LwnodeRxFrameIter * it, const uint8_t * buf, uint16_t len );
+
+/**
+ * @brief Get the next frame of an iteration
+ *
+ * Frames may follow each other directly or be separated by CR LF. A
+ * missing prefix or a truncated header or payload ends the iteration and
+ * sets it->malformed.
+ *
+ * @param it Iterator
+ * @param frame Output view into the iterated buffer
+ * @return true if a frame was produced, false at the end or on error
+ */
+bool lwnode_rx_frames_next( LwnodeRxFrameIter * it, LwnodeRxFrame * frame );
+
+/** @} */
+
+/** @defgroup LwnodeAsync Asynchronous AT Transactions */
+/** @{ */
+
+/**
+ * @brief Submit an AT command without blocking
+ *
+ * Copies the command into the device, appends CRLF and arms the transaction
+ * state machine. No bus traffic happens until lwnode_at_poll() is called.
+ * Only one transaction can be in flight per device. While the module is
+ * busy (RX windows, join) the first write is held until it is idle;
+ * lwnode_at_next_poll_ms() reports the wait.
+ *
+ * @param device Device instance
+ * @param cmdAscii Null-terminated AT command without CRLF
+ * @param doneCb Completion callback (NULL to rely on lwnode_at_poll() status)
+ * @param ctx User context passed to the callback
+ * @return true if the transaction was armed, false if busy or invalid
+ */
+bool lwnode_at_submit( LwnodeDevice * device,
+                       const char * cmdAscii,
+                       LwnodeAtDoneCb doneCb,
+                       void * ctx );
+
+/**
+ * @brief Submit an uplink without blocking
+ *
+ * Streams "AT+SEND=", the hex encoding of the payload and CRLF straight
+ * into I2C chunks; no full-size command buffer is built. The payload is
+ * read while the transaction is in flight and must stay valid and
+ * unmodified until it completes.
+ *
+ * @param device Device instance
+ * @param data Pointer to binary payload
+ * @param len Payload length (1-128 bytes)
+ * @param doneCb Completion callback (NULL to rely on lwnode_at_poll() status)
+ * @param ctx User context passed to the callback
+ * @return true if the transaction was armed, false if busy or invalid
+ */
+bool lwnode_send_packet_submit( LwnodeDevice * device,
+                                const uint8_t * data,
+                                uint8_t len,
+                                LwnodeAtDoneCb doneCb,
+                                void * ctx );
+
+/**
+ * @brief Advance the in-flight AT transaction
+ *
+ * Performs at most one bus operation (a chunk write or an ACK poll) and
+ * returns immediately. The completion callback fires from this call when
+ * the transaction finishes.
+ *
+ * @param device Device instance
+ * @return LWNODE_AT_STATUS_PENDING while in flight, the final status once
+ *         the transaction completes, or the last status if idle
+ */
+LwnodeAtStatus lwnode_at_poll( LwnodeDevice * device );
+
+/**
+ * @brief Get the time until the transaction needs the next poll
+ *
+ * @param device Device instance
+ * @return Milliseconds until lwnode_at_poll() has work to do, 0 if idle
+ *         or due now
+ */
+uint32_t lwnode_at_next_poll_ms( const LwnodeDevice * device );
+
+/**
+ * @brief Get the measured ACK latency of the last successful command
+ *
+ * Latency is measured from the final chunk write to the first poll that
+ * found the ACK, so it is bounded below by the poll backoff granularity.
+ *
+ * @param device Device instance
+ * @return Latency in milliseconds, 0 if no command has completed yet
+ */
+uint32_t lwnode_at_last_ack_latency_ms( const LwnodeDevice * device );
+
+/**
+ * @brief Check whether an AT transaction is in flight
+ *
+ * @param device Device instance
+ * @return true if a transaction is in flight, false otherwise
+ */
+bool lwnode_at_busy( const LwnodeDevice * device );
+
+/**
+ * @brief Set the minimum gap between I2C command chunks
+ *
+ * Commands longer than one I2C chunk (30 bytes) are written in several
+ * transfers; the module needs time to drain its buffer between them.
+ * The gap is latched when a transaction is submitted.
+ *
+ * @param device Device instance
+ * @param gapMs Gap in milliseconds (defaults to the conservative 100 ms)
+ * @return true if set successfully, false otherwise
+ */
+bool lwnode_set_chunk_gap_ms( LwnodeDevice * device, uint32_t gapMs );
+
+/**
+ * @brief Find the smallest safe inter-chunk gap for the attached module
+ *
+ * Benchmark mode: binary-searches the gap between 0 and the default by
+ * repeatedly sending a multi-chunk probe command and checking its ACK.
+ * On success the found gap plus a safety margin is applied to the device,
+ * otherwise the previous gap is kept.
+ *
+ * The probe must be longer than one chunk and safe to repeat, e.g.
+ * re-applying the currently configured AppKey.
+ *
+ * @param device Device instance
+ * @param probeCmd Null-terminated probe command without CRLF
+ * @param expectedAck Expected ACK string including CRLF
+ * @param gapMsOut Optional output of the smallest passing gap (before margin)
+ * @return true if a safe gap was found and applied, false otherwise
+ */
+bool lwnode_calibrate_chunk_gap( LwnodeDevice * device,
+                                 const char * probeCmd,
+                                 const char * expectedAck,
+                                 uint32_t * gapMsOut );
+
 /** @} */
 
 /** @defgroup LwnodeCallbacks Callback Registration */
@@ -393,6 +1151,50 @@ int8_t lwnode_last_snr( const LwnodeDevice * device );
 
 /** @} */
 
+/** @defgroup LwnodeStats Command Instrumentation */
+/** @{ */
+
+/**
+ * @brief Get the statistics of one AT command class
+ *
+ * @param device Device instance
+ * @param type Command class
+ * @param out Output report
+ * @return true if copied, false on invalid parameter or if the driver was
+ *         built without LWNODE_STATS_ENABLED
+ */
+bool lwnode_get_cmd_stats( const LwnodeDevice * device,
+                           LwnodeCmdType type,
+                           LwnodeCmdReport * out );
+
+/**
+ * @brief Clear all command statistics
+ *
+ * @param device Device instance
+ * @return true if cleared, false on invalid parameter or stats disabled
+ */
+bool lwnode_reset_cmd_stats( LwnodeDevice * device );
+
+/**
+ * @brief Format all used command classes as one compact text record
+ *
+ * One entry per class that has completed a command, separated by ';':
+ * "SEND c=12 f=1 r=1 w=0/2/9/15 a=8/40/63/63 t=9/43/72/127 b=480/264 p=41".
+ * c/f/r are count/failures/retries; w/a/t are write/ACK/total latency as
+ * min/avg/max/p99 ms; b is bytes written/read; p is ACK polls.
+ *
+ * @param device Device instance
+ * @param out Output buffer (null-terminated)
+ * @param outCap Capacity of out in bytes
+ * @return Record length without the terminator, 0 on invalid parameter,
+ *         insufficient capacity or stats disabled
+ */
+size_t lwnode_dump_cmd_stats( const LwnodeDevice * device,
+                              char * out,
+                              size_t outCap );
+
+/** @} */
+
 #ifdef __cplusplus
 }
 #endif 
@@ -0,0 +1,266 @@
+#include "lwnode_loopback.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "hal/lwnode.h"
+
+static bool lwnode_loopback_write_at( void * const ctx,
+                                      const uint8_t * const data,
+                                      size_t len,
+                                      bool final );
+static bool lwnode_loopback_read_at( void * const ctx,
+                                     uint8_t * const buf,
+                                     size_t cap,
+                                     uint16_t * const outLen );
+static bool lwnode_loopback_wait_rx( void * const ctx, uint32_t timeoutMs );
+static uint16_t lwnode_loopback_default_reply( void * ctx,
+                                               const char * cmd,
+                                               uint8_t * reply,
+                                               uint16_t replyCap );
+static uint16_t lwnode_loopback_append( uint8_t * const out,
+                                        uint16_t used,
+                                        uint16_t cap,
+                                        const char * const text,
+                                        size_t len );
+
+const LwnodeTransport lwnodeLoopbackTransport =
+{
+    .name = "loopback",
+    .stream = true,
+    .probe = NULL,
+    .write_at = lwnode_loopback_write_at,
+    .read_at = lwnode_loopback_read_at,
+    .wait_rx = lwnode_loopback_wait_rx
+};
+
+bool lwnode_loopback_init( LwnodeLoopback * const lb,
+                           LwnodeLoopbackResponder responder,
+                           void * const ctx )
+{
+    bool result = false;
+
+    if( lb != NULL )
+    {
+        ( void ) memset( lb, 0, sizeof( *lb ) );
+        lb->responder = ( responder != NULL ) ? responder : lwnode_loopback_default_reply;
+        lb->responderCtx = ctx;
+        result = true;
+    }
+
+    return result;
+}
+
+bool lwnode_loopback_inject( LwnodeLoopback * const lb,
+                             const uint8_t * const data,
+                             uint16_t len )
+{
+    bool result = false;
+
+    if( ( lb != NULL ) && ( data != NULL ) &&
+        ( ( uint32_t ) lb->rxLen + len <= LWNODE_LOOPBACK_RX_CAP ) )
+    {
+        ( void ) memcpy( &lb->rx[ lb->rxLen ], data, len );
+        lb->rxLen = ( uint16_t ) ( lb->rxLen + len );
+        result = true;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Collect command bytes and answer the completed command.
+ *
+ * @param[in,out] ctx   Loopback instance.
+ * @param[in]     data  Command bytes.
+ * @param[in]     len   Number of bytes.
+ * @param[in]     final true if the command is complete.
+ *
+ * @retval true  Always; an oversized command is answered with "ERROR".
+ * @retval false Invalid parameter.
+ */
+static bool lwnode_loopback_write_at( void * const ctx,
+                                      const uint8_t * const data,
+                                      size_t len,
+                                      bool final )
+{
+    LwnodeLoopback * const lb = ( LwnodeLoopback * ) ctx;
+    bool result = false;
+
+    if( ( lb != NULL ) && ( data != NULL ) )
+    {
+        if( ( ( size_t ) lb->cmdLen + len ) <= LWNODE_LOOPBACK_CMD_CAP )
+        {
+            ( void ) memcpy( &lb->cmd[ lb->cmdLen ], data, len );
+            lb->cmdLen = ( uint16_t ) ( lb->cmdLen + len );
+        }
+        else
+        {
+            lb->cmdOverflow = true;
+        }
+
+        if( final )
+        {
+            uint16_t cmdLen = lb->cmdLen;
+            uint16_t replyLen = 0U;
+            const uint16_t replyCap = ( uint16_t ) ( LWNODE_LOOPBACK_RX_CAP - lb->rxLen );
+
+            /* Strip the CRLF the driver appends */
+            while( ( cmdLen > 0U ) && ( ( lb->cmd[ cmdLen - 1U ] == '\r' ) || ( lb->cmd[ cmdLen - 1U ] == '\n' ) ) )
+            {
+                cmdLen--;
+            }
+            lb->cmd[ cmdLen ] = '\0';
+
+            if( lb->cmdOverflow )
+            {
+                replyLen = lwnode_loopback_append( &lb->rx[ lb->rxLen ], 0U, replyCap, "ERROR\r\n", 7U );
+            }
+            else
+            {
+                replyLen = lb->responder( lb->responderCtx, lb->cmd, &lb->rx[ lb->rxLen ], replyCap );
+            }
+
+            lb->rxLen = ( uint16_t ) ( lb->rxLen + ( ( replyLen <= replyCap ) ? replyLen : replyCap ) );
+            lb->cmdLen = 0U;
+            lb->cmdOverflow = false;
+            lb->commands++;
+        }
+
+        result = true;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Hand the pending reply stream to the driver.
+ *
+ * @param[in,out] ctx    Loopback instance.
+ * @param[out]    buf    Destination buffer.
+ * @param[in]     cap    Capacity of buf in bytes.
+ * @param[out]    outLen Number of bytes returned.
+ *
+ * @retval true  Bytes were returned.
+ * @retval false Nothing pending.
+ */
+static bool lwnode_loopback_read_at( void * const ctx,
+                                     uint8_t * const buf,
+                                     size_t cap,
+                                     uint16_t * const outLen )
+{
+    LwnodeLoopback * const lb = ( LwnodeLoopback * ) ctx;
+    bool result = false;
+
+    if( ( lb != NULL ) && ( buf != NULL ) && ( outLen != NULL ) && ( lb->rxLen > 0U ) && ( cap > 0U ) )
+    {
+        const uint16_t n = ( ( size_t ) lb->rxLen <= cap ) ? lb->rxLen : ( uint16_t ) cap;
+
+        ( void ) memcpy( buf, lb->rx, n );
+        ( void ) memmove( lb->rx, &lb->rx[ n ], ( size_t ) ( lb->rxLen - n ) );
+        lb->rxLen = ( uint16_t ) ( lb->rxLen - n );
+        *outLen = n;
+        result = true;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Report pending bytes, or sleep out the timeout when there are none.
+ *
+ * @param[in] ctx       Loopback instance.
+ * @param[in] timeoutMs Maximum time to wait in milliseconds.
+ *
+ * @retval true  Bytes are pending.
+ * @retval false Nothing arrived within the timeout.
+ */
+static bool lwnode_loopback_wait_rx( void * const ctx, uint32_t timeoutMs )
+{
+    const LwnodeLoopback * const lb = ( const LwnodeLoopback * ) ctx;
+    const bool pending = ( lb != NULL ) && ( lb->rxLen > 0U );
+
+    /* Nothing else can produce bytes while the caller waits */
+    if( !pending )
+    {
+        lwnode_hal_delay_ms( timeoutMs );
+    }
+
+    return pending;
+}
+
+/**
+ * @brief Acknowledge commands like a joined module.
+ *
+ * @param[in]  ctx      Unused.
+ * @param[in]  cmd      Null-terminated command without CRLF.
+ * @param[out] reply    Reply buffer.
+ * @param[in]  replyCap Capacity of reply in bytes.
+ *
+ * @return Reply length in bytes.
+ */
+static uint16_t lwnode_loopback_default_reply( void * ctx,
+                                               const char * cmd,
+                                               uint8_t * reply,
+                                               uint16_t replyCap )
+{
+    const size_t cmdLen = strlen( cmd );
+    const char * const eq = strchr( cmd, '=' );
+    uint16_t len = 0U;
+
+    ( void ) ctx;
+
+    if( strcmp( cmd, "AT" ) == 0 )
+    {
+        len = lwnode_loopback_append( reply, len, replyCap, "OK\r\n", 4U );
+    }
+    else if( ( strncmp( cmd, "AT+", 3U ) == 0 ) && ( cmd[ cmdLen - 1U ] == '?' ) )
+    {
+        /* "AT+KEY?" -> "+KEY=1" */
+        len = lwnode_loopback_append( reply, len, replyCap, &cmd[ 2 ], cmdLen - 3U );
+        len = lwnode_loopback_append( reply, len, replyCap, "=1\r\n", 4U );
+    }
+    else if( ( strncmp( cmd, "AT+", 3U ) == 0 ) && ( cmdLen > 3U ) )
+    {
+        /* "AT+KEY=value" and "AT+KEY" -> "+KEY=OK" */
+        const size_t keyEnd = ( eq != NULL ) ? ( size_t ) ( eq - cmd ) : cmdLen;
+
+        len = lwnode_loopback_append( reply, len, replyCap, &cmd[ 2 ], keyEnd - 2U );
+        len = lwnode_loopback_append( reply, len, replyCap, "=OK\r\n", 5U );
+    }
+    else
+    {
+        len = lwnode_loopback_append( reply, len, replyCap, "ERROR\r\n", 7U );
+    }
+
+    return len;
+}
+
+/**
+ * @brief Append text to a reply, truncating at the capacity.
+ *
+ * @param[out] out  Reply buffer.
+ * @param[in]  used Bytes already in out.
+ * @param[in]  cap  Capacity of out in bytes.
+ * @param[in]  text Text to append.
+ * @param[in]  len  Length of text.
+ *
+ * @return New reply length.
+ */
+static uint16_t lwnode_loopback_append( uint8_t * const out,
+                                        uint16_t used,
+                                        uint16_t cap,
+                                        const char * const text,
+                                        size_t len )
+{
+    size_t n = len;
+
+    if( ( ( size_t ) used + n ) > cap )
+    {
+        n = ( size_t ) ( cap - used );
+    }
+
+    ( void ) memcpy( &out[ used ], text, n );
+
+    return ( uint16_t ) ( used + n );
+}
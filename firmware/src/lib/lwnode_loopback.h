@@ -0,0 +1,94 @@
+/******************************************************************************
+ * @file lwnode_loopback.h
+ * @brief In-memory stream transport for the LWNode driver
+ *
+ * Hands every AT command the driver writes to a responder function and
+ * returns its reply on the next read, without any bus or timing. Meant for
+ * host tests and for measuring the driver's own overhead; unsolicited
+ * bytes such as "+RECV=" frames can be injected into the reply stream.
+ *
+ * Select it with
+ *   lwnode_set_transport( &device, &lwnodeLoopbackTransport, &loopback );
+ ******************************************************************************/
+
+#ifndef SRC_LIB_LWNODE_LOOPBACK_H
+#define SRC_LIB_LWNODE_LOOPBACK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lwnode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup LwnodeLoopbackConfig Loopback Configuration Constants */
+/** @{ */
+#define LWNODE_LOOPBACK_CMD_CAP  ( 16U + ( 2U * LWNODE_MAX_LORA_PAYLOAD_BYTES ) ) /**< Longest AT+SEND */
+#define LWNODE_LOOPBACK_RX_CAP   ( LWNODE_MAX_RX_BYTES - 1U )  /**< Pending reply bytes */
+/** @} */
+
+/**
+ * @typedef LwnodeLoopbackResponder
+ * @brief Produces the module's reply to one command
+ *
+ * @param ctx Responder context
+ * @param cmd Null-terminated command without CRLF
+ * @param reply Reply buffer
+ * @param replyCap Capacity of reply in bytes
+ * @return Reply length in bytes (0 for no reply)
+ */
+typedef uint16_t (*LwnodeLoopbackResponder)( void * ctx,
+                                             const char * cmd,
+                                             uint8_t * reply,
+                                             uint16_t replyCap );
+
+/**
+ * @struct LwnodeLoopback
+ * @brief Loopback instance, passed as the transport context
+ */
+typedef struct LwnodeLoopback
+{
+    char cmd[ LWNODE_LOOPBACK_CMD_CAP + 1U ];   /**< Command being assembled */
+    uint16_t cmdLen;                            /**< Bytes in cmd */
+    bool cmdOverflow;                           /**< Command did not fit */
+    uint8_t rx[ LWNODE_LOOPBACK_RX_CAP ];       /**< Pending reply stream */
+    uint16_t rxLen;                             /**< Bytes in rx */
+    LwnodeLoopbackResponder responder;          /**< Reply generator */
+    void * responderCtx;                        /**< Responder context */
+    uint32_t commands;                          /**< Commands answered */
+} LwnodeLoopback;
+
+/** Stream transport callbacks; the context is an LwnodeLoopback */
+extern const LwnodeTransport lwnodeLoopbackTransport;
+
+/**
+ * @brief Initialize a loopback
+ *
+ * The default responder acknowledges like a joined module: "AT" gets
+ * "OK", "AT+<KEY>=<value>" and "AT+<KEY>" get "+<KEY>=OK" and
+ * "AT+<KEY>?" gets "+<KEY>=1".
+ *
+ * @param lb Pointer to loopback instance
+ * @param responder Reply generator, or NULL for the default
+ * @param ctx Responder context
+ * @return true if initialized, false on invalid parameter
+ */
+bool lwnode_loopback_init( LwnodeLoopback * lb, LwnodeLoopbackResponder responder, void * ctx );
+
+/**
+ * @brief Append unsolicited bytes to the reply stream
+ *
+ * @param lb Pointer to loopback instance
+ * @param data Bytes to append, e.g. a "+RECV=" frame
+ * @param len Number of bytes
+ * @return true if appended, false if they do not fit or on invalid parameter
+ */
+bool lwnode_loopback_inject( LwnodeLoopback * lb, const uint8_t * data, uint16_t len );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_LIB_LWNODE_LOOPBACK_H */
@@ -0,0 +1,191 @@
+#include "lwnode_mailbox.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define LWNODE_MAILBOX_MASK  ( LWNODE_MAILBOX_DEPTH - 1U )
+
+static bool lwnode_mailbox_execute( LwnodeDevice * const device,
+                                    const LwnodeMailboxReq * const req );
+
+bool lwnode_mailbox_init( LwnodeMailbox * const mailbox )
+{
+    bool result = false;
+
+    if( mailbox != NULL )
+    {
+        ( void ) memset( mailbox, 0, sizeof( *mailbox ) );
+
+        for( uint32_t i = 0U; i < LWNODE_MAILBOX_DEPTH; ++i )
+        {
+            mailbox->slots[ i ].seq = i;
+        }
+
+        /* Publish the empty ring before any producer can see it */
+        __atomic_thread_fence( __ATOMIC_RELEASE );
+        result = true;
+    }
+
+    return result;
+}
+
+bool lwnode_mailbox_submit( LwnodeMailbox * const mailbox, const LwnodeMailboxReq * const req )
+{
+    bool result = false;
+
+    if( ( mailbox != NULL ) && ( req != NULL ) && ( req->op < LWNODE_MAILBOX_OP_COUNT ) )
+    {
+        uint32_t pos = __atomic_load_n( &mailbox->enqueuePos, __ATOMIC_RELAXED );
+        LwnodeMailboxSlot * slot = NULL;
+        bool full = false;
+
+        while( ( slot == NULL ) && !full )
+        {
+            LwnodeMailboxSlot * const candidate = &mailbox->slots[ pos & LWNODE_MAILBOX_MASK ];
+            const uint32_t seq = __atomic_load_n( &candidate->seq, __ATOMIC_ACQUIRE );
+            const int32_t diff = ( int32_t ) ( seq - pos );
+
+            if( diff == 0 )
+            {
+                /* Free for this position: claim it, or retry from the winner's position */
+                if( __atomic_compare_exchange_n( &mailbox->enqueuePos, &pos, pos + 1U, true,
+                                                 __ATOMIC_RELAXED, __ATOMIC_RELAXED ) )
+                {
+                    slot = candidate;
+                }
+            }
+            else if( diff < 0 )
+            {
+                /* Still holds the request one lap behind: the owner has not executed it */
+                full = true;
+            }
+            else
+            {
+                /* Another producer claimed this position first */
+                pos = __atomic_load_n( &mailbox->enqueuePos, __ATOMIC_RELAXED );
+            }
+        }
+
+        if( slot != NULL )
+        {
+            slot->req = *req;
+            __atomic_store_n( &slot->seq, pos + 1U, __ATOMIC_RELEASE );
+            ( void ) __atomic_fetch_add( &mailbox->submitted, 1U, __ATOMIC_RELAXED );
+            result = true;
+        }
+        else
+        {
+            ( void ) __atomic_fetch_add( &mailbox->full, 1U, __ATOMIC_RELAXED );
+        }
+    }
+
+    return result;
+}
+
+uint8_t lwnode_mailbox_service( LwnodeMailbox * const mailbox,
+                                LwnodeDevice * const device,
+                                uint8_t maxOps )
+{
+    uint8_t executed = 0U;
+
+    if( ( mailbox != NULL ) && ( device != NULL ) )
+    {
+        while( ( executed < maxOps ) && lwnode_mailbox_pending( mailbox ) )
+        {
+            const uint32_t pos = mailbox->dequeuePos;
+            LwnodeMailboxSlot * const slot = &mailbox->slots[ pos & LWNODE_MAILBOX_MASK ];
+            const bool ok = lwnode_mailbox_execute( device, &slot->req );
+            const LwnodeMailboxDoneFn done = slot->req.done;
+            void * const ctx = slot->req.ctx;
+            const LwnodeMailboxOp op = slot->req.op;
+
+            /* Hand the slot back before the callback, which may submit again */
+            mailbox->dequeuePos = pos + 1U;
+            __atomic_store_n( &slot->seq, pos + LWNODE_MAILBOX_DEPTH, __ATOMIC_RELEASE );
+
+            ( void ) __atomic_fetch_add( &mailbox->executed, 1U, __ATOMIC_RELAXED );
+            if( !ok )
+            {
+                ( void ) __atomic_fetch_add( &mailbox->failed, 1U, __ATOMIC_RELAXED );
+            }
+
+            if( done != NULL )
+            {
+                done( ctx, op, ok );
+            }
+
+            executed++;
+        }
+    }
+
+    return executed;
+}
+
+bool lwnode_mailbox_pending( const LwnodeMailbox * const mailbox )
+{
+    bool result = false;
+
+    if( mailbox != NULL )
+    {
+        const uint32_t pos = mailbox->dequeuePos;
+        const LwnodeMailboxSlot * const slot = &mailbox->slots[ pos & LWNODE_MAILBOX_MASK ];
+
+        result = ( __atomic_load_n( &slot->seq, __ATOMIC_ACQUIRE ) == ( pos + 1U ) );
+    }
+
+    return result;
+}
+
+bool lwnode_mailbox_get_stats( const LwnodeMailbox * const mailbox, LwnodeMailboxStats * const out )
+{
+    bool result = false;
+
+    if( ( mailbox != NULL ) && ( out != NULL ) )
+    {
+        out->submitted = __atomic_load_n( &mailbox->submitted, __ATOMIC_RELAXED );
+        out->full = __atomic_load_n( &mailbox->full, __ATOMIC_RELAXED );
+        out->executed = __atomic_load_n( &mailbox->executed, __ATOMIC_RELAXED );
+        out->failed = __atomic_load_n( &mailbox->failed, __ATOMIC_RELAXED );
+        result = true;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Run the driver call of one request.
+ *
+ * @param[in] device Device owned by the calling task.
+ * @param[in] req    Published request.
+ *
+ * @return Result of the driver call.
+ */
+static bool lwnode_mailbox_execute( LwnodeDevice * const device,
+                                    const LwnodeMailboxReq * const req )
+{
+    bool result = false;
+
+    switch( req->op )
+    {
+        case LWNODE_MAILBOX_SET_DATARATE:
+            result = lwnode_set_datarate( device, req->arg );
+            break;
+        case LWNODE_MAILBOX_SET_EIRP:
+            result = lwnode_set_eirp( device, req->arg );
+            break;
+        case LWNODE_MAILBOX_ENABLE_ADR:
+            result = lwnode_enable_adr( device, req->arg != 0U );
+            break;
+        case LWNODE_MAILBOX_SET_CLASS:
+            result = lwnode_set_class( device, ( LwnodeClass ) req->arg );
+            break;
+        case LWNODE_MAILBOX_JOIN:
+            result = lwnode_join( device );
+            break;
+        default:
+            /* Rejected on submission */
+            break;
+    }
+
+    return result;
+}
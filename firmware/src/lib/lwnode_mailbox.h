@@ -0,0 +1,172 @@
+/******************************************************************************
+ * @file lwnode_mailbox.h
+ * @brief Lock-free command mailbox in front of an LWNode device
+ *
+ * LwnodeDevice is not thread-safe: an AT transaction toggles intEnabled
+ * and shares rxBuf between ACK and downlink reads, so only one task may
+ * call the driver. Other tasks (FSM, diagnostics, configuration) submit
+ * operations to a mailbox instead; the radio task that owns the device
+ * executes them one at a time, in submission order, and reports each
+ * outcome through the request's completion callback.
+ *
+ * The mailbox is a bounded ring of request slots, each with a sequence
+ * number. Producers claim a slot with one compare-and-swap on the enqueue
+ * position, copy the request in and publish it by advancing the slot's
+ * sequence, so any number of tasks can submit concurrently without a lock
+ * and a producer never waits for the radio. A full mailbox rejects the
+ * request at once. Only the owning task may call lwnode_mailbox_service().
+ ******************************************************************************/
+
+#ifndef SRC_LIB_LWNODE_MAILBOX_H
+#define SRC_LIB_LWNODE_MAILBOX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lwnode.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup LwnodeMailboxConfig LWNode Mailbox Configuration Constants */
+/** @{ */
+#define LWNODE_MAILBOX_DEPTH        ( 8U )  /**< Request slots (power of two) */
+/** @} */
+
+/**
+ * @enum LwnodeMailboxOp
+ * @brief Driver operation carried by a request
+ */
+typedef enum
+{
+    LWNODE_MAILBOX_SET_DATARATE = 0, /**< lwnode_set_datarate(), arg is the DR index */
+    LWNODE_MAILBOX_SET_EIRP,        /**< lwnode_set_eirp(), arg is the EIRP in dBm */
+    LWNODE_MAILBOX_ENABLE_ADR,      /**< lwnode_enable_adr(), arg is 0 or 1 */
+    LWNODE_MAILBOX_SET_CLASS,       /**< lwnode_set_class(), arg is the LwnodeClass */
+    LWNODE_MAILBOX_JOIN,            /**< lwnode_join(), arg unused */
+    LWNODE_MAILBOX_OP_COUNT         /**< Number of operations, not an operation */
+} LwnodeMailboxOp;
+
+/**
+ * @brief Completion callback, called from the owning task
+ *
+ * Must not block and must not call the driver.
+ *
+ * @param ctx Context of the request
+ * @param op Operation that completed
+ * @param ok Result of the driver call
+ */
+typedef void (*LwnodeMailboxDoneFn)( void * ctx, LwnodeMailboxOp op, bool ok );
+
+/**
+ * @struct LwnodeMailboxReq
+ * @brief Request, copied into the mailbox on submission
+ */
+typedef struct LwnodeMailboxReq
+{
+    LwnodeMailboxOp op;             /**< Operation */
+    uint8_t arg;                    /**< Operation argument, see LwnodeMailboxOp */
+    LwnodeMailboxDoneFn done;       /**< Completion callback (optional) */
+    void * ctx;                     /**< Completion callback context */
+} LwnodeMailboxReq;
+
+/**
+ * @struct LwnodeMailboxStats
+ * @brief Mailbox counters
+ */
+typedef struct LwnodeMailboxStats
+{
+    uint32_t submitted;             /**< Requests accepted */
+    uint32_t full;                  /**< Requests rejected because every slot was taken */
+    uint32_t executed;              /**< Requests executed by the owning task */
+    uint32_t failed;                /**< Executed requests whose driver call failed */
+} LwnodeMailboxStats;
+
+/**
+ * @struct LwnodeMailboxSlot
+ * @brief Request slot with its publication sequence
+ */
+typedef struct LwnodeMailboxSlot
+{
+    uint32_t seq;                   /**< Internal: position that may use the slot next */
+    LwnodeMailboxReq req;           /**< Internal: request */
+} LwnodeMailboxSlot;
+
+/**
+ * @struct LwnodeMailbox
+ * @brief Mailbox instance
+ *
+ * Shared fields are only accessed atomically; do not read them directly.
+ */
+typedef struct LwnodeMailbox
+{
+    LwnodeMailboxSlot slots[ LWNODE_MAILBOX_DEPTH ]; /**< Internal: request ring */
+    uint32_t enqueuePos;            /**< Internal: next position claimed by a producer */
+    uint32_t dequeuePos;            /**< Internal: next position executed (owner only) */
+    uint32_t submitted;             /**< Internal: requests accepted */
+    uint32_t full;                  /**< Internal: requests rejected */
+    uint32_t executed;              /**< Internal: requests executed */
+    uint32_t failed;                /**< Internal: executed requests that failed */
+} LwnodeMailbox;
+
+/**
+ * @brief Initialize an empty mailbox
+ *
+ * Must complete before any task submits.
+ *
+ * @param mailbox Pointer to mailbox instance
+ * @return true if initialized, false on invalid parameter
+ */
+bool lwnode_mailbox_init( LwnodeMailbox * mailbox );
+
+/**
+ * @brief Submit a request from any task
+ *
+ * Lock-free and non-blocking; safe to call concurrently from several
+ * tasks. The request is copied, so it may live on the caller's stack.
+ *
+ * @param mailbox Pointer to mailbox instance
+ * @param req Request
+ * @return true if queued, false if the mailbox is full or the request is
+ *         invalid
+ */
+bool lwnode_mailbox_submit( LwnodeMailbox * mailbox, const LwnodeMailboxReq * req );
+
+/**
+ * @brief Execute queued requests on the device (owning task only)
+ *
+ * Runs the blocking driver call of each request in submission order, then
+ * its completion callback.
+ *
+ * @param mailbox Pointer to mailbox instance
+ * @param device Device owned by the calling task
+ * @param maxOps Largest number of requests to execute in this call
+ * @return Number of requests executed
+ */
+uint8_t lwnode_mailbox_service( LwnodeMailbox * mailbox,
+                                LwnodeDevice * device,
+                                uint8_t maxOps );
+
+/**
+ * @brief Check whether a request is waiting (owning task only)
+ *
+ * @param mailbox Pointer to mailbox instance
+ * @return true if the next slot holds a published request
+ */
+bool lwnode_mailbox_pending( const LwnodeMailbox * mailbox );
+
+/**
+ * @brief Get mailbox counters from any task
+ *
+ * @param mailbox Pointer to mailbox instance
+ * @param out Output counters
+ * @return true if copied, false on invalid parameter
+ */
+bool lwnode_mailbox_get_stats( const LwnodeMailbox * mailbox, LwnodeMailboxStats * out );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_LIB_LWNODE_MAILBOX_H */
@@ -0,0 +1,138 @@
+#include "uplink_confirm.h"
+
+#include <stddef.h>
+#include <string.h>
+
+static UplinkConfirmEvent uplink_confirm_attempt_failed( UplinkConfirm * const tracker,
+                                                         UplinkEntry * const out );
+
+bool uplink_confirm_init( UplinkConfirm * const tracker, uint8_t maxAttempts )
+{
+    bool result = false;
+
+    if( ( tracker != NULL ) && ( maxAttempts != 0U ) &&
+        ( maxAttempts <= UPLINK_CONFIRM_MAX_ATTEMPTS ) )
+    {
+        ( void ) memset( tracker, 0, sizeof( *tracker ) );
+        tracker->maxAttempts = maxAttempts;
+        result = true;
+    }
+
+    return result;
+}
+
+bool uplink_confirm_sent( UplinkConfirm * const tracker,
+                          const UplinkEntry * const entry,
+                          uint32_t timeoutMs,
+                          uint32_t nowMs )
+{
+    bool result = false;
+
+    if( ( tracker != NULL ) && ( entry != NULL ) && entry->confirmed &&
+        !tracker->waiting )
+    {
+        tracker->entry = *entry;
+        tracker->entry.attempts++;
+        tracker->sentMs = nowMs;
+        tracker->timeoutMs = timeoutMs;
+        tracker->waiting = true;
+        tracker->stats.sent++;
+        result = true;
+    }
+
+    return result;
+}
+
+UplinkConfirmEvent uplink_confirm_send_failed( UplinkConfirm * const tracker,
+                                               const UplinkEntry * const entry,
+                                               UplinkEntry * const out )
+{
+    UplinkConfirmEvent event = UPLINK_CONFIRM_NONE;
+
+    if( ( tracker != NULL ) && ( entry != NULL ) && ( out != NULL ) && entry->confirmed )
+    {
+        *out = *entry;
+        out->attempts++;
+        event = uplink_confirm_attempt_failed( tracker, out );
+    }
+
+    return event;
+}
+
+UplinkConfirmEvent uplink_confirm_on_ack( UplinkConfirm * const tracker, uint32_t nowMs )
+{
+    UplinkConfirmEvent event = UPLINK_CONFIRM_NONE;
+
+    if( ( tracker != NULL ) && tracker->waiting )
+    {
+        tracker->waiting = false;
+        tracker->stats.acked++;
+        tracker->stats.lastAckMs = nowMs - tracker->sentMs;
+        event = UPLINK_CONFIRM_ACKED;
+    }
+
+    return event;
+}
+
+UplinkConfirmEvent uplink_confirm_poll( UplinkConfirm * const tracker,
+                                        uint32_t nowMs,
+                                        UplinkEntry * const out )
+{
+    UplinkConfirmEvent event = UPLINK_CONFIRM_NONE;
+
+    if( ( tracker != NULL ) && ( out != NULL ) && tracker->waiting &&
+        ( ( nowMs - tracker->sentMs ) >= tracker->timeoutMs ) )
+    {
+        tracker->waiting = false;
+        tracker->stats.unverified++;
+        *out = tracker->entry;
+        event = UPLINK_CONFIRM_UNVERIFIED;
+    }
+
+    return event;
+}
+
+bool uplink_confirm_busy( const UplinkConfirm * const tracker )
+{
+    return ( tracker != NULL ) && tracker->waiting;
+}
+
+bool uplink_confirm_get_stats( const UplinkConfirm * const tracker,
+                               UplinkConfirmStats * const out )
+{
+    bool result = false;
+
+    if( ( tracker != NULL ) && ( out != NULL ) )
+    {
+        *out = tracker->stats;
+        result = true;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Decide between a retry and giving up on a frame the radio rejected.
+ *
+ * @param[in] tracker Pointer to tracker instance.
+ * @param[in] out     Frame with its attempts counted.
+ *
+ * @return UPLINK_CONFIRM_RETRY or UPLINK_CONFIRM_FAILED.
+ */
+static UplinkConfirmEvent uplink_confirm_attempt_failed( UplinkConfirm * const tracker,
+                                                         UplinkEntry * const out )
+{
+    UplinkConfirmEvent event = UPLINK_CONFIRM_FAILED;
+
+    if( out->attempts < tracker->maxAttempts )
+    {
+        tracker->stats.retries++;
+        event = UPLINK_CONFIRM_RETRY;
+    }
+    else
+    {
+        tracker->stats.failed++;
+    }
+
+    return event;
+}
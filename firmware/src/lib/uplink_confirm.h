@@ -0,0 +1,167 @@
+/******************************************************************************
+ * @file uplink_confirm.h
+ * @brief Delivery tracking for confirmed uplinks
+ *
+ * LoRaWAN acknowledges a confirmed uplink with the ACK bit of the next
+ * downlink, so only one confirmed uplink can be outstanding at a time. The
+ * tracker holds a copy of that uplink, its send time and its own timeout,
+ * and turns an acknowledgement, a timeout or a failed send into an event
+ * the radio task acts on.
+ *
+ * The radio may not report every acknowledgement: the DFR1115 has no ACK
+ * flag and an ACK without payload produces no "+RECV=" frame. A timeout
+ * therefore only marks the frame unverified; it is not sent again, which
+ * would duplicate a frame the network most likely received. Only a send
+ * the radio did not accept is retried, up to a bounded number of attempts.
+ *
+ * Nothing here blocks: the owner reports sends and downlinks and polls the
+ * tracker from its loop. The tracker is not thread-safe; the owner
+ * serializes access.
+ ******************************************************************************/
+
+#ifndef SRC_LIB_UPLINK_CONFIRM_H
+#define SRC_LIB_UPLINK_CONFIRM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "uplink_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup UplinkConfirmConfig Uplink Confirm Configuration Constants */
+/** @{ */
+#define UPLINK_CONFIRM_MAX_ATTEMPTS  ( 8U )  /**< Largest transmission count per frame */
+/** @} */
+
+/**
+ * @enum UplinkConfirmEvent
+ * @brief Outcome reported by the tracker
+ */
+typedef enum
+{
+    UPLINK_CONFIRM_NONE = 0,    /**< Nothing to do */
+    UPLINK_CONFIRM_ACKED,       /**< The outstanding frame was acknowledged */
+    UPLINK_CONFIRM_UNVERIFIED,  /**< Sent, but no acknowledgement seen before the timeout */
+    UPLINK_CONFIRM_RETRY,       /**< Radio did not accept the frame; send it again */
+    UPLINK_CONFIRM_FAILED       /**< Radio did not accept the frame on the last attempt */
+} UplinkConfirmEvent;
+
+/**
+ * @struct UplinkConfirmStats
+ * @brief Confirmed uplink counters
+ */
+typedef struct UplinkConfirmStats
+{
+    uint32_t sent;          /**< Confirmed transmissions, retries included */
+    uint32_t acked;         /**< Frames acknowledged by the network */
+    uint32_t unverified;    /**< Frames sent without an acknowledgement seen */
+    uint32_t retries;       /**< Frames handed back for another attempt */
+    uint32_t failed;        /**< Frames given up on */
+    uint32_t lastAckMs;     /**< Send-to-acknowledgement time of the last ACK */
+} UplinkConfirmStats;
+
+/**
+ * @struct UplinkConfirm
+ * @brief Tracker instance
+ */
+typedef struct UplinkConfirm
+{
+    UplinkEntry entry;          /**< Outstanding frame, attempts counted */
+    uint32_t sentMs;            /**< Time the outstanding frame was sent */
+    uint32_t timeoutMs;         /**< Acknowledgement timeout of the outstanding frame */
+    uint8_t maxAttempts;        /**< Transmissions allowed per frame */
+    bool waiting;               /**< A frame is waiting for its acknowledgement */
+    UplinkConfirmStats stats;   /**< Counters */
+} UplinkConfirm;
+
+/**
+ * @brief Initialize a tracker
+ *
+ * @param tracker Pointer to tracker instance
+ * @param maxAttempts Transmissions allowed per frame (1-UPLINK_CONFIRM_MAX_ATTEMPTS)
+ * @return true if initialized, false on invalid parameter
+ */
+bool uplink_confirm_init( UplinkConfirm * tracker, uint8_t maxAttempts );
+
+/**
+ * @brief Start waiting for the acknowledgement of a sent frame
+ *
+ * Counts one attempt on the frame. Unconfirmed frames are not tracked.
+ *
+ * @param tracker Pointer to tracker instance
+ * @param entry Frame the radio accepted (copied)
+ * @param timeoutMs Time to wait for the acknowledgement of this frame
+ * @param nowMs Current time in milliseconds
+ * @return true if tracked, false if unconfirmed, already waiting or invalid
+ */
+bool uplink_confirm_sent( UplinkConfirm * tracker,
+                          const UplinkEntry * entry,
+                          uint32_t timeoutMs,
+                          uint32_t nowMs );
+
+/**
+ * @brief Account for a confirmed frame the radio did not accept
+ *
+ * Counts one attempt on the frame.
+ *
+ * @param tracker Pointer to tracker instance
+ * @param entry Frame that failed to send
+ * @param out Output copy of the frame with its attempt counted
+ * @return UPLINK_CONFIRM_RETRY or UPLINK_CONFIRM_FAILED, NONE if the frame
+ *         is unconfirmed or on invalid parameter
+ */
+UplinkConfirmEvent uplink_confirm_send_failed( UplinkConfirm * tracker,
+                                               const UplinkEntry * entry,
+                                               UplinkEntry * out );
+
+/**
+ * @brief Report a network acknowledgement
+ *
+ * @param tracker Pointer to tracker instance
+ * @param nowMs Current time in milliseconds
+ * @return UPLINK_CONFIRM_ACKED if a frame was waiting, NONE otherwise
+ */
+UplinkConfirmEvent uplink_confirm_on_ack( UplinkConfirm * tracker, uint32_t nowMs );
+
+/**
+ * @brief Check the outstanding frame for a timeout
+ *
+ * A frame whose timeout passes without an acknowledgement is released as
+ * unverified and not retried.
+ *
+ * @param tracker Pointer to tracker instance
+ * @param nowMs Current time in milliseconds
+ * @param out Output copy of the timed-out frame (UNVERIFIED only)
+ * @return UPLINK_CONFIRM_UNVERIFIED once the timeout has passed, NONE
+ *         while waiting or idle
+ */
+UplinkConfirmEvent uplink_confirm_poll( UplinkConfirm * tracker,
+                                        uint32_t nowMs,
+                                        UplinkEntry * out );
+
+/**
+ * @brief Check whether a frame is waiting for its acknowledgement
+ *
+ * @param tracker Pointer to tracker instance
+ * @return true if waiting, false if idle or invalid
+ */
+bool uplink_confirm_busy( const UplinkConfirm * tracker );
+
+/**
+ * @brief Get tracker counters
+ *
+ * @param tracker Pointer to tracker instance
+ * @param out Output counters
+ * @return true if copied, false on invalid parameter
+ */
+bool uplink_confirm_get_stats( const UplinkConfirm * tracker,
+                               UplinkConfirmStats * out );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_LIB_UPLINK_CONFIRM_H */
@@ -0,0 +1,743 @@
+#include "uplink_journal.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define UPLINK_JOURNAL_SECTOR_MAGIC    ( 0x314A4C55UL )  /* "ULJ1" */
+#define UPLINK_JOURNAL_COMMITTED       ( 0x5AU )
+#define UPLINK_JOURNAL_ERASED          ( 0xFFU )
+#define UPLINK_JOURNAL_ACKED           ( 0x00U )
+#define UPLINK_JOURNAL_ALIGN           ( 4U )
+#define UPLINK_JOURNAL_MIN_SECTOR_SIZE ( 256U )
+#define UPLINK_JOURNAL_CRC_CHUNK       ( 32U )
+#define UPLINK_JOURNAL_CRC_INIT        ( 0xFFFFFFFFUL )
+#define UPLINK_JOURNAL_CRC_POLY        ( 0xEDB88320UL )   /* CRC-32 (IEEE), reflected */
+
+/* Byte 0 is programmed last and commits the record; byte 1 is cleared on
+ * acknowledge and is not covered by the CRC */
+typedef struct UplinkJournalRecordHdr
+{
+    uint8_t commit;     /* UPLINK_JOURNAL_COMMITTED once complete */
+    uint8_t ack;        /* UPLINK_JOURNAL_ERASED while pending */
+    uint8_t len;        /* Payload length */
+    uint8_t reserved;   /* 0xFF */
+    uint32_t seq;       /* Record sequence number */
+    uint32_t crc;       /* CRC-32 over len, seq and payload */
+} UplinkJournalRecordHdr;
+
+/* drained is programmed to 0 once every record in the sector is
+ * acknowledged, so mount can skip the sector without reading it */
+typedef struct UplinkJournalSectorHdr
+{
+    uint32_t magic;     /* UPLINK_JOURNAL_SECTOR_MAGIC */
+    uint32_t gen;       /* Increases by one for every sector opened */
+    uint32_t erases;    /* Erase count of this sector */
+    uint32_t firstSeq;  /* Sequence number of the sector's first record */
+    uint32_t crc;       /* CRC-32 over the fields above */
+    uint32_t drained;   /* 0xFFFFFFFF while records may be pending */
+} UplinkJournalSectorHdr;
+
+typedef struct UplinkJournalCursor
+{
+    uint16_t sector;
+    uint32_t offset;
+} UplinkJournalCursor;
+
+static bool uplink_journal_next( UplinkJournal * const journal,
+                                 UplinkJournalCursor * const cur,
+                                 UplinkJournalRecordHdr * const hdr );
+static bool uplink_journal_record_ok( UplinkJournal * const journal,
+                                      const UplinkJournalCursor * const cur,
+                                      const UplinkJournalRecordHdr * const hdr,
+                                      uint8_t * const payload );
+static void uplink_journal_retire( UplinkJournal * const journal,
+                                   const UplinkJournalCursor * const cur );
+static void uplink_journal_mark_drained( UplinkJournal * const journal,
+                                         uint16_t from,
+                                         uint16_t to );
+static bool uplink_journal_open_sector( UplinkJournal * const journal );
+static void uplink_journal_reclaim( UplinkJournal * const journal, uint16_t sector );
+static bool uplink_journal_read_sector_hdr( UplinkJournal * const journal,
+                                            uint16_t sector,
+                                            UplinkJournalSectorHdr * const hdr );
+static uint16_t uplink_journal_next_sector( UplinkJournal * const journal, uint16_t sector );
+static uint32_t uplink_journal_span( uint8_t len );
+static uint32_t uplink_journal_addr( const UplinkJournal * const journal,
+                                     uint16_t sector,
+                                     uint32_t offset );
+static uint32_t uplink_journal_crc32( uint32_t crc, const uint8_t * const data, size_t len );
+
+bool uplink_journal_mount( UplinkJournal * const journal,
+                           const UplinkJournalFlash * const flash,
+                           void * const flashCtx,
+                           uint32_t sectorSize,
+                           uint16_t sectorCount )
+{
+    bool result = false;
+
+    if( ( journal != NULL ) && ( flash != NULL ) && ( flash->read != NULL ) &&
+        ( flash->write != NULL ) && ( flash->erase != NULL ) &&
+        ( sectorSize >= UPLINK_JOURNAL_MIN_SECTOR_SIZE ) &&
+        ( ( sectorSize % UPLINK_JOURNAL_ALIGN ) == 0U ) &&
+        ( sectorCount >= UPLINK_JOURNAL_MIN_SECTORS ) )
+    {
+        UplinkJournalSectorHdr sectorHdr;
+        bool anyValid = false;
+
+        ( void ) memset( journal, 0, sizeof( *journal ) );
+        journal->flash = flash;
+        journal->flashCtx = flashCtx;
+        journal->sectorSize = sectorSize;
+        journal->sectorCount = sectorCount;
+
+        /* The newest generation is the head; a blank ring opens sector 0 first */
+        journal->headSector = ( uint16_t ) ( sectorCount - 1U );
+        journal->headOffset = sectorSize;
+
+        for( uint16_t s = 0U; s < sectorCount; s++ )
+        {
+            if( uplink_journal_read_sector_hdr( journal, s, &sectorHdr ) )
+            {
+                if( !anyValid || ( ( int32_t ) ( sectorHdr.gen - journal->headGen ) > 0 ) )
+                {
+                    journal->headSector = s;
+                    journal->headGen = sectorHdr.gen;
+                    journal->headErases = sectorHdr.erases;
+                    journal->nextSeq = sectorHdr.firstSeq;
+                }
+                if( sectorHdr.erases > journal->stats.maxSectorErases )
+                {
+                    journal->stats.maxSectorErases = sectorHdr.erases;
+                }
+                anyValid = true;
+            }
+        }
+
+        if( anyValid )
+        {
+            UplinkJournalRecordHdr hdr;
+            UplinkJournalCursor cur =
+            {
+                .sector = uplink_journal_next_sector( journal, journal->headSector ),
+                .offset = UPLINK_JOURNAL_SECTOR_HDR_LEN
+            };
+            bool tailFound = false;
+
+            /* Oldest undrained sector first, ending in the head sector. Only
+             * headers are read; payload CRCs are checked on replay. */
+            while( uplink_journal_next( journal, &cur, &hdr ) )
+            {
+                if( ( int32_t ) ( hdr.seq + 1U - journal->nextSeq ) > 0 )
+                {
+                    journal->nextSeq = hdr.seq + 1U;
+                }
+
+                if( hdr.ack == UPLINK_JOURNAL_ERASED )
+                {
+                    if( !tailFound )
+                    {
+                        journal->tailSector = cur.sector;
+                        journal->tailOffset = cur.offset;
+                        tailFound = true;
+                    }
+                    journal->stats.pending++;
+                }
+
+                cur.offset += uplink_journal_span( hdr.len );
+            }
+
+            journal->headOffset = cur.offset;
+            journal->headOpen = true;
+
+            /* Bytes after the last record must still be erased, otherwise
+             * an append was torn before its commit: seal the sector */
+            if( ( journal->headOffset + UPLINK_JOURNAL_RECORD_HDR_LEN ) <= sectorSize )
+            {
+                uint8_t slot[ UPLINK_JOURNAL_RECORD_HDR_LEN ];
+
+                if( flash->read( flashCtx,
+                                 uplink_journal_addr( journal, journal->headSector, journal->headOffset ),
+                                 slot, sizeof( slot ) ) )
+                {
+                    for( size_t i = 0U; i < sizeof( slot ); i++ )
+                    {
+                        if( slot[ i ] != UPLINK_JOURNAL_ERASED )
+                        {
+                            journal->headOpen = false;
+                        }
+                    }
+                }
+                else
+                {
+                    journal->headOpen = false;
+                }
+            }
+        }
+
+        journal->mounted = true;
+        result = true;
+    }
+
+    return result;
+}
+
+bool uplink_journal_append( UplinkJournal * const journal,
+                            const uint8_t * const data,
+                            uint8_t len )
+{
+    bool result = false;
+
+    if( ( journal != NULL ) && journal->mounted && ( data != NULL ) &&
+        ( len != 0U ) && ( len <= UPLINK_JOURNAL_MAX_RECORD ) )
+    {
+        const uint32_t span = uplink_journal_span( len );
+        bool ready = journal->headOpen && ( ( journal->headOffset + span ) <= journal->sectorSize );
+
+        if( !ready )
+        {
+            ready = uplink_journal_open_sector( journal );
+        }
+
+        if( ready )
+        {
+            /* Body first: header fields after the ack byte, then the payload */
+            uint8_t body[ UPLINK_JOURNAL_RECORD_HDR_LEN - 2U + UPLINK_JOURNAL_MAX_RECORD ];
+            UplinkJournalRecordHdr hdr =
+            {
+                .commit = UPLINK_JOURNAL_COMMITTED,
+                .ack = UPLINK_JOURNAL_ERASED,
+                .len = len,
+                .reserved = UPLINK_JOURNAL_ERASED,
+                .seq = journal->nextSeq,
+                .crc = 0U
+            };
+            const uint32_t addr = uplink_journal_addr( journal, journal->headSector, journal->headOffset );
+
+            hdr.crc = uplink_journal_crc32( UPLINK_JOURNAL_CRC_INIT, &hdr.len, 1U );
+            hdr.crc = uplink_journal_crc32( hdr.crc, ( const uint8_t * ) &hdr.seq, sizeof( hdr.seq ) );
+            hdr.crc = ~uplink_journal_crc32( hdr.crc, data, len );
+
+            ( void ) memcpy( body, &hdr.len, UPLINK_JOURNAL_RECORD_HDR_LEN - 2U );
+            ( void ) memcpy( &body[ UPLINK_JOURNAL_RECORD_HDR_LEN - 2U ], data, len );
+
+            if( journal->flash->write( journal->flashCtx, addr + 2U, body,
+                                       ( size_t ) ( UPLINK_JOURNAL_RECORD_HDR_LEN - 2U ) + len ) &&
+                journal->flash->write( journal->flashCtx, addr, &hdr.commit, 1U ) )
+            {
+                if( journal->stats.pending == 0U )
+                {
+                    journal->tailSector = journal->headSector;
+                    journal->tailOffset = journal->headOffset;
+                }
+
+                journal->headOffset += span;
+                journal->nextSeq++;
+                journal->stats.pending++;
+                journal->stats.appended++;
+                result = true;
+            }
+            else
+            {
+                /* The slot may be half programmed; never write it again */
+                journal->headOpen = false;
+            }
+        }
+    }
+
+    return result;
+}
+
+uint16_t uplink_journal_peek_batch( UplinkJournal * const journal,
+                                    uint8_t * const out,
+                                    size_t outCap,
+                                    uint16_t maxLen,
+                                    uint8_t * const records,
+                                    uint32_t * const firstSeq )
+{
+    uint16_t total = 0U;
+
+    if( ( journal != NULL ) && journal->mounted && ( out != NULL ) && ( records != NULL ) )
+    {
+        UplinkJournalCursor cur = { journal->tailSector, journal->tailOffset };
+        UplinkJournalRecordHdr hdr;
+        uint8_t count = 0U;
+        uint32_t seq = 0U;
+
+        while( ( journal->stats.pending > count ) && ( count < UINT8_MAX ) &&
+               uplink_journal_next( journal, &cur, &hdr ) )
+        {
+            if( hdr.ack == UPLINK_JOURNAL_ERASED )
+            {
+                if( ( ( uint32_t ) total + hdr.len > maxLen ) ||
+                    ( ( size_t ) total + hdr.len > outCap ) ||
+                    ( ( count > 0U ) && ( hdr.seq != ( seq + count ) ) ) )
+                {
+                    break;
+                }
+
+                if( uplink_journal_record_ok( journal, &cur, &hdr, &out[ total ] ) )
+                {
+                    seq = ( count == 0U ) ? hdr.seq : seq;
+                    total = ( uint16_t ) ( total + hdr.len );
+                    count++;
+                }
+                else
+                {
+                    uplink_journal_retire( journal, &cur );
+                }
+            }
+
+            cur.offset += uplink_journal_span( hdr.len );
+        }
+
+        *records = count;
+        if( firstSeq != NULL )
+        {
+            *firstSeq = seq;
+        }
+    }
+
+    return total;
+}
+
+bool uplink_journal_ack( UplinkJournal * const journal, uint8_t records )
+{
+    bool result = false;
+
+    if( ( journal != NULL ) && journal->mounted && ( records <= journal->stats.pending ) )
+    {
+        UplinkJournalCursor cur = { journal->tailSector, journal->tailOffset };
+        UplinkJournalRecordHdr hdr;
+        const uint8_t acked = UPLINK_JOURNAL_ACKED;
+        uint8_t done = 0U;
+        bool ok = true;
+
+        while( ok && ( done < records ) && uplink_journal_next( journal, &cur, &hdr ) )
+        {
+            if( hdr.ack != UPLINK_JOURNAL_ERASED )
+            {
+                /* Already acknowledged */
+            }
+            else if( uplink_journal_record_ok( journal, &cur, &hdr, NULL ) )
+            {
+                ok = journal->flash->write( journal->flashCtx,
+                                            uplink_journal_addr( journal, cur.sector, cur.offset ) + 1U,
+                                            &acked, 1U );
+                if( ok )
+                {
+                    done++;
+                    journal->stats.pending--;
+                    journal->stats.replayed++;
+                }
+            }
+            else
+            {
+                uplink_journal_retire( journal, &cur );
+            }
+
+            if( ok )
+            {
+                cur.offset += uplink_journal_span( hdr.len );
+            }
+        }
+
+        uplink_journal_mark_drained( journal, journal->tailSector, cur.sector );
+        journal->tailSector = cur.sector;
+        journal->tailOffset = cur.offset;
+        result = ( done == records );
+    }
+
+    return result;
+}
+
+uint32_t uplink_journal_pending( const UplinkJournal * const journal )
+{
+    uint32_t pending = 0U;
+
+    if( ( journal != NULL ) && journal->mounted )
+    {
+        pending = journal->stats.pending;
+    }
+
+    return pending;
+}
+
+bool uplink_journal_get_stats( const UplinkJournal * const journal,
+                               UplinkJournalStats * const out )
+{
+    bool result = false;
+
+    if( ( journal != NULL ) && ( out != NULL ) )
+    {
+        *out = journal->stats;
+        result = true;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Find the next committed record at or after a cursor.
+ *
+ * Moves to the following valid sector at the end of a sector and stops at
+ * the head's append position.
+ *
+ * @param[in]     journal Journal instance.
+ * @param[in,out] cur     Cursor, left on the record found or where the walk ended.
+ * @param[out]    hdr     Header of the record found.
+ *
+ * @retval true  A record is at cur.
+ * @retval false End of the journal or read failure.
+ */
+static bool uplink_journal_next( UplinkJournal * const journal,
+                                 UplinkJournalCursor * const cur,
+                                 UplinkJournalRecordHdr * const hdr )
+{
+    bool found = false;
+    bool done = false;
+
+    while( !found && !done )
+    {
+        const bool inHead = ( cur->sector == journal->headSector );
+        bool endOfSector = true;
+
+        if( inHead && ( cur->offset >= journal->headOffset ) )
+        {
+            done = true;
+            endOfSector = false;
+        }
+        else if( ( cur->offset + UPLINK_JOURNAL_RECORD_HDR_LEN ) <= journal->sectorSize )
+        {
+            if( !journal->flash->read( journal->flashCtx,
+                                       uplink_journal_addr( journal, cur->sector, cur->offset ),
+                                       hdr, sizeof( *hdr ) ) )
+            {
+                done = true;
+                endOfSector = false;
+            }
+            else if( ( hdr->commit == UPLINK_JOURNAL_COMMITTED ) && ( hdr->len != 0U ) &&
+                     ( hdr->len <= UPLINK_JOURNAL_MAX_RECORD ) &&
+                     ( ( cur->offset + uplink_journal_span( hdr->len ) ) <= journal->sectorSize ) )
+            {
+                found = true;
+                endOfSector = false;
+            }
+            else
+            {
+                /* Erased or torn slot: nothing further in this sector */
+            }
+        }
+        else
+        {
+            /* No room for another record */
+        }
+
+        if( endOfSector )
+        {
+            if( inHead )
+            {
+                done = true;
+            }
+            else
+            {
+                cur->sector = uplink_journal_next_sector( journal, cur->sector );
+                cur->offset = UPLINK_JOURNAL_SECTOR_HDR_LEN;
+            }
+        }
+    }
+
+    return found;
+}
+
+/**
+ * @brief Verify a record's CRC, optionally copying its payload.
+ *
+ * @param[in]  journal Journal instance.
+ * @param[in]  cur     Position of the record.
+ * @param[in]  hdr     Record header.
+ * @param[out] payload hdr->len bytes, or NULL to only verify.
+ *
+ * @retval true  The payload matches the CRC.
+ * @retval false CRC mismatch or read failure.
+ */
+static bool uplink_journal_record_ok( UplinkJournal * const journal,
+                                      const UplinkJournalCursor * const cur,
+                                      const UplinkJournalRecordHdr * const hdr,
+                                      uint8_t * const payload )
+{
+    const uint32_t addr = uplink_journal_addr( journal, cur->sector, cur->offset ) +
+                          UPLINK_JOURNAL_RECORD_HDR_LEN;
+    uint32_t crc = uplink_journal_crc32( UPLINK_JOURNAL_CRC_INIT, &hdr->len, 1U );
+    bool ok = true;
+
+    crc = uplink_journal_crc32( crc, ( const uint8_t * ) &hdr->seq, sizeof( hdr->seq ) );
+
+    if( payload != NULL )
+    {
+        ok = journal->flash->read( journal->flashCtx, addr, payload, hdr->len );
+        crc = uplink_journal_crc32( crc, payload, hdr->len );
+    }
+    else
+    {
+        uint8_t chunk[ UPLINK_JOURNAL_CRC_CHUNK ];
+
+        for( uint32_t done = 0U; ok && ( done < hdr->len ); done += UPLINK_JOURNAL_CRC_CHUNK )
+        {
+            const size_t n = ( ( hdr->len - done ) < UPLINK_JOURNAL_CRC_CHUNK ) ?
+                             ( size_t ) ( hdr->len - done ) : UPLINK_JOURNAL_CRC_CHUNK;
+
+            ok = journal->flash->read( journal->flashCtx, addr + done, chunk, n );
+            crc = uplink_journal_crc32( crc, chunk, n );
+        }
+    }
+
+    return ok && ( ~crc == hdr->crc );
+}
+
+/**
+ * @brief Retire a pending record whose payload fails its CRC.
+ *
+ * The record is acknowledged in place so it is never read again.
+ *
+ * @param[in,out] journal Journal instance.
+ * @param[in]     cur     Position of the record.
+ */
+static void uplink_journal_retire( UplinkJournal * const journal,
+                                   const UplinkJournalCursor * const cur )
+{
+    const uint8_t acked = UPLINK_JOURNAL_ACKED;
+
+    ( void ) journal->flash->write( journal->flashCtx,
+                                    uplink_journal_addr( journal, cur->sector, cur->offset ) + 1U,
+                                    &acked, 1U );
+    journal->stats.pending--;
+    journal->stats.corrupt++;
+}
+
+/**
+ * @brief Mark the sectors the tail has left as drained.
+ *
+ * @param[in,out] journal Journal instance.
+ * @param[in]     from    Tail sector before the walk.
+ * @param[in]     to      Tail sector after the walk (not marked).
+ */
+static void uplink_journal_mark_drained( UplinkJournal * const journal,
+                                         uint16_t from,
+                                         uint16_t to )
+{
+    const uint32_t drained = 0U;
+    uint16_t s = from;
+
+    while( s != to )
+    {
+        ( void ) journal->flash->write( journal->flashCtx,
+                                        uplink_journal_addr( journal, s, offsetof( UplinkJournalSectorHdr, drained ) ),
+                                        &drained, sizeof( drained ) );
+        s = uplink_journal_next_sector( journal, s );
+    }
+}
+
+/**
+ * @brief Erase the sector after the head and make it the new head.
+ *
+ * @param[in,out] journal Journal instance.
+ *
+ * @retval true  The new head accepts appends.
+ * @retval false Erase or header write failed.
+ */
+static bool uplink_journal_open_sector( UplinkJournal * const journal )
+{
+    bool result = false;
+    const uint16_t next = ( uint16_t ) ( ( journal->headSector + 1U ) % journal->sectorCount );
+    UplinkJournalSectorHdr hdr;
+    uint32_t erases = 1U;
+
+    if( uplink_journal_read_sector_hdr( journal, next, &hdr ) )
+    {
+        erases = hdr.erases + 1U;
+        if( ( journal->stats.pending > 0U ) && ( journal->tailSector == next ) )
+        {
+            uplink_journal_reclaim( journal, next );
+        }
+    }
+    else if( journal->headErases > erases )
+    {
+        /* Count lost with a torn header; round-robin keeps neighbours level */
+        erases = journal->headErases;
+    }
+    else
+    {
+        /* First use */
+    }
+
+    journal->headOpen = false;
+
+    hdr.magic = UPLINK_JOURNAL_SECTOR_MAGIC;
+    hdr.gen = journal->headGen + 1U;
+    hdr.erases = erases;
+    hdr.firstSeq = journal->nextSeq;
+    hdr.crc = ~uplink_journal_crc32( UPLINK_JOURNAL_CRC_INIT, ( const uint8_t * ) &hdr,
+                                     offsetof( UplinkJournalSectorHdr, crc ) );
+    hdr.drained = UINT32_MAX;
+
+    if( journal->flash->erase( journal->flashCtx,
+                               uplink_journal_addr( journal, next, 0U ),
+                               journal->sectorSize ) )
+    {
+        journal->stats.erases++;
+
+        if( journal->flash->write( journal->flashCtx,
+                                   uplink_journal_addr( journal, next, 0U ),
+                                   &hdr, sizeof( hdr ) ) )
+        {
+            journal->headSector = next;
+            journal->headOffset = UPLINK_JOURNAL_SECTOR_HDR_LEN;
+            journal->headGen = hdr.gen;
+            journal->headErases = erases;
+            journal->headOpen = true;
+            if( erases > journal->stats.maxSectorErases )
+            {
+                journal->stats.maxSectorErases = erases;
+            }
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Drop the pending records of the oldest sector before it is erased.
+ *
+ * Moves the tail to the start of the following sector.
+ *
+ * @param[in,out] journal Journal instance.
+ * @param[in]     sector  Sector about to be erased; holds the tail.
+ */
+static void uplink_journal_reclaim( UplinkJournal * const journal, uint16_t sector )
+{
+    UplinkJournalCursor cur = { sector, journal->tailOffset };
+    UplinkJournalRecordHdr hdr;
+
+    while( ( cur.sector == sector ) && uplink_journal_next( journal, &cur, &hdr ) &&
+           ( cur.sector == sector ) )
+    {
+        if( hdr.ack == UPLINK_JOURNAL_ERASED )
+        {
+            journal->stats.pending--;
+            journal->stats.dropped++;
+        }
+
+        cur.offset += uplink_journal_span( hdr.len );
+    }
+
+    journal->tailSector = uplink_journal_next_sector( journal, sector );
+    journal->tailOffset = UPLINK_JOURNAL_SECTOR_HDR_LEN;
+}
+
+/**
+ * @brief Read and validate a sector header.
+ *
+ * @param[in]  journal Journal instance.
+ * @param[in]  sector  Sector index.
+ * @param[out] hdr     Header read.
+ *
+ * @retval true  The header is intact.
+ * @retval false Blank, torn or foreign sector, or read failure.
+ */
+static bool uplink_journal_read_sector_hdr( UplinkJournal * const journal,
+                                            uint16_t sector,
+                                            UplinkJournalSectorHdr * const hdr )
+{
+    bool result = false;
+
+    if( journal->flash->read( journal->flashCtx, uplink_journal_addr( journal, sector, 0U ),
+                              hdr, sizeof( *hdr ) ) )
+    {
+        result = ( hdr->magic == UPLINK_JOURNAL_SECTOR_MAGIC ) &&
+                 ( ~uplink_journal_crc32( UPLINK_JOURNAL_CRC_INIT, ( const uint8_t * ) hdr,
+                                          offsetof( UplinkJournalSectorHdr, crc ) ) == hdr->crc );
+    }
+
+    return result;
+}
+
+/**
+ * @brief Next sector in ring order that may hold pending records.
+ *
+ * Skips unused and drained sectors and ends at the head.
+ *
+ * @param[in] journal Journal instance.
+ * @param[in] sector  Current sector.
+ *
+ * @return Following undrained sector with a valid header, or the head sector.
+ */
+static uint16_t uplink_journal_next_sector( UplinkJournal * const journal, uint16_t sector )
+{
+    UplinkJournalSectorHdr hdr;
+    uint16_t s = ( uint16_t ) ( ( sector + 1U ) % journal->sectorCount );
+
+    while( ( s != journal->headSector ) &&
+           ( !uplink_journal_read_sector_hdr( journal, s, &hdr ) || ( hdr.drained != UINT32_MAX ) ) )
+    {
+        s = ( uint16_t ) ( ( s + 1U ) % journal->sectorCount );
+    }
+
+    return s;
+}
+
+/**
+ * @brief Flash bytes taken by a record.
+ *
+ * @param[in] len Payload length.
+ *
+ * @return Header plus payload, rounded up to the write alignment.
+ */
+static uint32_t uplink_journal_span( uint8_t len )
+{
+    return UPLINK_JOURNAL_RECORD_HDR_LEN +
+           ( ( ( uint32_t ) len + UPLINK_JOURNAL_ALIGN - 1U ) & ~( UPLINK_JOURNAL_ALIGN - 1U ) );
+}
+
+/**
+ * @brief Journal-relative address of a sector offset.
+ *
+ * @param[in] journal Journal instance.
+ * @param[in] sector  Sector index.
+ * @param[in] offset  Offset inside the sector.
+ *
+ * @return Byte address.
+ */
+static uint32_t uplink_journal_addr( const UplinkJournal * const journal,
+                                     uint16_t sector,
+                                     uint32_t offset )
+{
+    return ( ( uint32_t ) sector * journal->sectorSize ) + offset;
+}
+
+/**
+ * @brief Update a CRC-32 (IEEE) with more bytes.
+ *
+ * Start from UPLINK_JOURNAL_CRC_INIT and invert the final value.
+ *
+ * @param[in] crc  Running CRC.
+ * @param[in] data Bytes to add.
+ * @param[in] len  Number of bytes.
+ *
+ * @return Updated running CRC.
+ */
+static uint32_t uplink_journal_crc32( uint32_t crc, const uint8_t * const data, size_t len )
+{
+    uint32_t c = crc;
+
+    for( size_t i = 0U; i < len; i++ )
+    {
+        c ^= data[ i ];
+        for( uint8_t bit = 0U; bit < 8U; bit++ )
+        {
+            c = ( ( c & 1U ) != 0U ) ? ( ( c >> 1 ) ^ UPLINK_JOURNAL_CRC_POLY ) : ( c >> 1 );
+        }
+    }
+
+    return c;
+}
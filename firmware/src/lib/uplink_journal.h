@@ -0,0 +1,198 @@
+/******************************************************************************
+ * @file uplink_journal.h
+ * @brief Append-only flash journal for uplink records (store and forward)
+ *
+ * Keeps uplink records that could not be sent in a ring of flash sectors
+ * until the link is back, then hands them out oldest first in batches
+ * sized to one uplink.
+ *
+ * Layout: every sector starts with a header carrying a generation number,
+ * the sector's erase count and a drained marker that is cleared once all
+ * its records are acknowledged, so mount reads only sectors that may
+ * still hold pending records. Records follow back to back, 4-byte
+ * aligned. A record holds a commit byte, an acknowledge byte, its length,
+ * a sequence number and a CRC-32 over length, sequence and payload.
+ *
+ * Power-fail safety relies only on NOR semantics (programming clears
+ * bits, erase sets them):
+ * - A record's body is programmed before its commit byte, so a torn
+ *   append is absent after mount. A payload failing its CRC is skipped
+ *   and counted when it is replayed.
+ * - Acknowledging clears one byte in place; no sector is rewritten.
+ * - A torn erase or sector header leaves an invalid header, and the sector
+ *   is treated as unused.
+ * Delivery is at-least-once: a reset between sending a batch and
+ * acknowledging it replays the batch.
+ *
+ * Wear: sectors are opened strictly round-robin, so erases spread evenly
+ * over the ring, and each sector's erase count travels in its header.
+ * When the ring is full the oldest sector is reclaimed and its
+ * unacknowledged records are counted as dropped.
+ *
+ * The journal itself is not thread-safe; the owner serializes access.
+ ******************************************************************************/
+
+#ifndef SRC_LIB_UPLINK_JOURNAL_H
+#define SRC_LIB_UPLINK_JOURNAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup UplinkJournalConfig Uplink Journal Configuration Constants */
+/** @{ */
+#define UPLINK_JOURNAL_MAX_RECORD      ( 128U )  /**< Largest record payload in bytes */
+#define UPLINK_JOURNAL_MIN_SECTORS     ( 2U )    /**< Smallest usable ring */
+#define UPLINK_JOURNAL_SECTOR_HDR_LEN  ( 24U )   /**< Bytes of a sector header */
+#define UPLINK_JOURNAL_RECORD_HDR_LEN  ( 12U )   /**< Bytes of a record header */
+/** @} */
+
+/**
+ * @struct UplinkJournalFlash
+ * @brief Flash access callbacks
+ *
+ * Offsets are relative to the start of the journal area. Writes only ever
+ * clear bits of erased bytes; erases cover whole sectors.
+ */
+typedef struct UplinkJournalFlash
+{
+    bool (*read)( void * ctx, uint32_t offset, void * buf, size_t len );           /**< Read bytes */
+    bool (*write)( void * ctx, uint32_t offset, const void * data, size_t len );   /**< Program bytes */
+    bool (*erase)( void * ctx, uint32_t offset, uint32_t len );                     /**< Erase sectors to 0xFF */
+} UplinkJournalFlash;
+
+/**
+ * @struct UplinkJournalStats
+ * @brief Journal counters
+ */
+typedef struct UplinkJournalStats
+{
+    uint32_t pending;         /**< Records waiting to be replayed */
+    uint32_t appended;        /**< Records written since mount */
+    uint32_t replayed;        /**< Records acknowledged since mount */
+    uint32_t dropped;         /**< Unacknowledged records lost to sector reclaim */
+    uint32_t corrupt;         /**< Pending records skipped for a bad CRC */
+    uint32_t erases;          /**< Sector erases since mount */
+    uint32_t maxSectorErases; /**< Highest erase count of any sector seen */
+} UplinkJournalStats;
+
+/**
+ * @struct UplinkJournal
+ * @brief Journal instance
+ */
+typedef struct UplinkJournal
+{
+    const UplinkJournalFlash * flash;   /**< Flash callbacks */
+    void * flashCtx;                    /**< Flash callback context */
+    uint32_t sectorSize;                /**< Erase unit in bytes */
+    uint16_t sectorCount;               /**< Sectors in the ring */
+
+    uint16_t headSector;                /**< Sector being appended to */
+    uint32_t headOffset;                /**< Next free byte in headSector */
+    uint32_t headGen;                   /**< Generation of headSector */
+    uint32_t headErases;                /**< Erase count of headSector */
+    bool headOpen;                      /**< headSector accepts appends */
+
+    uint16_t tailSector;                /**< Sector of the oldest pending record */
+    uint32_t tailOffset;                /**< Offset of the oldest pending record */
+
+    uint32_t nextSeq;                   /**< Sequence number of the next record */
+    UplinkJournalStats stats;           /**< Counters */
+    bool mounted;                       /**< Mounted and usable */
+} UplinkJournal;
+
+/**
+ * @brief Mount a journal, recovering its state from flash
+ *
+ * Blank or foreign flash mounts as an empty journal; sectors are erased
+ * only when they are first appended to.
+ *
+ * @param journal Pointer to journal instance
+ * @param flash Flash callbacks
+ * @param flashCtx Context passed to the callbacks
+ * @param sectorSize Erase unit in bytes (multiple of 4)
+ * @param sectorCount Sectors in the journal area (at least UPLINK_JOURNAL_MIN_SECTORS)
+ * @return true if mounted, false on invalid parameter or read failure
+ */
+bool uplink_journal_mount( UplinkJournal * journal,
+                           const UplinkJournalFlash * flash,
+                           void * flashCtx,
+                           uint32_t sectorSize,
+                           uint16_t sectorCount );
+
+/**
+ * @brief Append one record
+ *
+ * Opens the next sector when the current one is full, reclaiming the
+ * oldest sector if the ring has wrapped.
+ *
+ * @param journal Pointer to journal instance
+ * @param data Record payload
+ * @param len Payload length (1-UPLINK_JOURNAL_MAX_RECORD bytes)
+ * @return true if the record is committed, false on invalid parameter or
+ *         flash failure
+ */
+bool uplink_journal_append( UplinkJournal * journal,
+                            const uint8_t * data,
+                            uint8_t len );
+
+/**
+ * @brief Copy the oldest pending records into one payload
+ *
+ * Records are concatenated oldest first while the total fits in maxLen,
+ * matching the packed uplink format for fixed-size records. A batch holds
+ * consecutive sequence numbers only: it ends before a gap left by a
+ * corrupt record. Nothing is consumed; call uplink_journal_ack() once the
+ * payload is sent.
+ *
+ * @param journal Pointer to journal instance
+ * @param out Output payload buffer
+ * @param outCap Capacity of out in bytes
+ * @param maxLen Largest payload the current data rate can carry
+ * @param records Output number of records in the payload
+ * @param firstSeq Output sequence number of the first record (may be NULL)
+ * @return Payload length in bytes, 0 if nothing is pending or on error
+ */
+uint16_t uplink_journal_peek_batch( UplinkJournal * journal,
+                                    uint8_t * out,
+                                    size_t outCap,
+                                    uint16_t maxLen,
+                                    uint8_t * records,
+                                    uint32_t * firstSeq );
+
+/**
+ * @brief Mark the oldest pending records as sent
+ *
+ * @param journal Pointer to journal instance
+ * @param records Number of records, as returned by uplink_journal_peek_batch()
+ * @return true if acknowledged, false on invalid parameter or flash failure
+ */
+bool uplink_journal_ack( UplinkJournal * journal, uint8_t records );
+
+/**
+ * @brief Get the number of records waiting to be replayed
+ *
+ * @param journal Pointer to journal instance
+ * @return Pending records, 0 if not mounted
+ */
+uint32_t uplink_journal_pending( const UplinkJournal * journal );
+
+/**
+ * @brief Get journal counters
+ *
+ * @param journal Pointer to journal instance
+ * @param out Output counters
+ * @return true if copied, false on invalid parameter
+ */
+bool uplink_journal_get_stats( const UplinkJournal * journal,
+                               UplinkJournalStats * out );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_LIB_UPLINK_JOURNAL_H */
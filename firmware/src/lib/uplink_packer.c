@@ -0,0 +1,180 @@
+#include "uplink_packer.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define UPLINK_PACKER_AGE_MAX_S      ( 0xFFFFU )
+
+static void uplink_packer_write_header( uint8_t * const out,
+                                        uint8_t kind,
+                                        uint16_t value );
+
+bool uplink_packer_init( UplinkPacker * const packer, uint32_t deadlineMs )
+{
+    bool result = false;
+
+    if( packer != NULL )
+    {
+        ( void ) memset( packer, 0, sizeof( *packer ) );
+        packer->perUplink = UPLINK_PACKER_MAX_RECORDS;
+        packer->deadlineMs = deadlineMs;
+        result = true;
+    }
+
+    return result;
+}
+
+bool uplink_packer_set_deadline( UplinkPacker * const packer, uint32_t deadlineMs )
+{
+    bool result = false;
+
+    if( packer != NULL )
+    {
+        packer->deadlineMs = deadlineMs;
+        result = true;
+    }
+
+    return result;
+}
+
+bool uplink_packer_set_max_payload( UplinkPacker * const packer, uint8_t maxPayload )
+{
+    bool result = false;
+
+    if( ( packer != NULL ) &&
+        ( maxPayload >= ( UPLINK_PACKER_HEADER_SIZE + UPLINK_PACKER_RECORD_SIZE ) ) )
+    {
+        const uint8_t limit = ( maxPayload > UPLINK_PACKER_MAX_PAYLOAD ) ?
+                              ( uint8_t ) UPLINK_PACKER_MAX_PAYLOAD : maxPayload;
+
+        packer->perUplink = ( uint8_t ) ( ( limit - UPLINK_PACKER_HEADER_SIZE ) /
+                                          UPLINK_PACKER_RECORD_SIZE );
+        result = true;
+    }
+
+    return result;
+}
+
+bool uplink_packer_add( UplinkPacker * const packer,
+                        const uint8_t * const record,
+                        uint32_t nowMs )
+{
+    bool result = false;
+
+    if( ( packer != NULL ) && ( record != NULL ) )
+    {
+        if( packer->count < UPLINK_PACKER_MAX_RECORDS )
+        {
+            ( void ) memcpy( &packer->buf[ ( size_t ) packer->count * UPLINK_PACKER_RECORD_SIZE ],
+                             record,
+                             UPLINK_PACKER_RECORD_SIZE );
+            packer->addedMs[ packer->count ] = nowMs;
+            packer->count++;
+            packer->stats.records++;
+            result = true;
+        }
+        else
+        {
+            packer->stats.rejected++;
+        }
+    }
+
+    return result;
+}
+
+bool uplink_packer_ready( const UplinkPacker * const packer, uint32_t nowMs )
+{
+    bool result = false;
+
+    if( ( packer != NULL ) && ( packer->count > 0U ) )
+    {
+        result = ( packer->count >= packer->perUplink ) ||
+                 ( ( nowMs - packer->addedMs[ 0 ] ) >= packer->deadlineMs );
+    }
+
+    return result;
+}
+
+uint8_t uplink_packer_flush( UplinkPacker * const packer,
+                             uint8_t * const out,
+                             size_t outCap,
+                             uint32_t nowMs )
+{
+    uint8_t len = 0U;
+
+    if( ( packer != NULL ) && ( out != NULL ) && ( packer->count > 0U ) &&
+        ( outCap > UPLINK_PACKER_HEADER_SIZE ) )
+    {
+        uint8_t take = ( packer->count < packer->perUplink ) ? packer->count : packer->perUplink;
+
+        if( ( ( size_t ) take * UPLINK_PACKER_RECORD_SIZE ) > ( outCap - UPLINK_PACKER_HEADER_SIZE ) )
+        {
+            take = ( uint8_t ) ( ( outCap - UPLINK_PACKER_HEADER_SIZE ) / UPLINK_PACKER_RECORD_SIZE );
+        }
+
+        if( take > 0U )
+        {
+            const uint8_t left = ( uint8_t ) ( packer->count - take );
+            const uint8_t bytes = ( uint8_t ) ( take * UPLINK_PACKER_RECORD_SIZE );
+            const uint32_t ageS = ( nowMs - packer->addedMs[ take - 1U ] ) / 1000U;
+
+            uplink_packer_write_header( out, UPLINK_PACKER_KIND_LIVE,
+                                        ( uint16_t ) ( ( ageS > UPLINK_PACKER_AGE_MAX_S ) ?
+                                                       UPLINK_PACKER_AGE_MAX_S : ageS ) );
+            ( void ) memcpy( &out[ UPLINK_PACKER_HEADER_SIZE ], packer->buf, bytes );
+            len = ( uint8_t ) ( UPLINK_PACKER_HEADER_SIZE + bytes );
+
+            if( take >= packer->perUplink )
+            {
+                packer->stats.flushesFull++;
+            }
+            else
+            {
+                packer->stats.flushesDeadline++;
+            }
+
+            /* Keep the remainder oldest first */
+            ( void ) memmove( packer->buf,
+                              &packer->buf[ bytes ],
+                              ( size_t ) left * UPLINK_PACKER_RECORD_SIZE );
+            ( void ) memmove( packer->addedMs,
+                              &packer->addedMs[ take ],
+                              ( size_t ) left * sizeof( packer->addedMs[ 0 ] ) );
+            packer->count = left;
+        }
+    }
+
+    return len;
+}
+
+uint8_t uplink_packer_replay_header( uint8_t * const out,
+                                     size_t outCap,
+                                     uint32_t firstSeq )
+{
+    uint8_t len = 0U;
+
+    if( ( out != NULL ) && ( outCap >= UPLINK_PACKER_HEADER_SIZE ) )
+    {
+        /* The low 16 bits are enough for the backend to order and dedupe */
+        uplink_packer_write_header( out, UPLINK_PACKER_KIND_REPLAY, ( uint16_t ) firstSeq );
+        len = ( uint8_t ) UPLINK_PACKER_HEADER_SIZE;
+    }
+
+    return len;
+}
+
+/**
+ * @brief Write a batch header.
+ *
+ * @param[out] out   Output buffer, at least UPLINK_PACKER_HEADER_SIZE bytes.
+ * @param[in]  kind  UPLINK_PACKER_KIND_LIVE or UPLINK_PACKER_KIND_REPLAY.
+ * @param[in]  value Age or sequence, written big-endian.
+ */
+static void uplink_packer_write_header( uint8_t * const out,
+                                        uint8_t kind,
+                                        uint16_t value )
+{
+    out[ 0 ] = kind;
+    out[ 1 ] = ( uint8_t ) ( value >> 8 );
+    out[ 2 ] = ( uint8_t ) ( value & 0xFFU );
+}
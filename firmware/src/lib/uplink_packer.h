@@ -0,0 +1,156 @@
+/******************************************************************************
+ * @file uplink_packer.h
+ * @brief Packs successive fixed-size telemetry records into one uplink
+ *
+ * Every LoRaWAN uplink pays 13 bytes of frame overhead plus preamble and
+ * header airtime, which dwarfs a 6-byte v1 record. The packer buffers
+ * records and releases them as one payload once it holds as many as the
+ * current data rate can carry, or once the oldest record has waited for
+ * the configured latency deadline.
+ *
+ * Packed payload: a 3-byte batch header, then the records concatenated
+ * oldest first (see docs/lorawan/uplink-payload-v1.md). The header tells
+ * a live batch, stamped with the age of its newest record, from a batch
+ * replayed from the journal, stamped with the journal sequence of its
+ * oldest record, so replayed records are never taken for fresh samples.
+ *
+ * The packer itself is not thread-safe; the owner serializes access.
+ ******************************************************************************/
+
+#ifndef SRC_LIB_UPLINK_PACKER_H
+#define SRC_LIB_UPLINK_PACKER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup UplinkPackerConfig Uplink Packer Configuration Constants */
+/** @{ */
+#define UPLINK_PACKER_RECORD_SIZE    ( 6U )    /**< v1 record size in bytes */
+#define UPLINK_PACKER_HEADER_SIZE    ( 3U )    /**< Batch header: kind, then a big-endian uint16 */
+#define UPLINK_PACKER_KIND_LIVE      ( 0x00U ) /**< Header value: newest record's age in seconds */
+#define UPLINK_PACKER_KIND_REPLAY    ( 0x01U ) /**< Header value: oldest record's journal sequence */
+#define UPLINK_PACKER_MAX_PAYLOAD    ( 128U )  /**< Largest payload the module accepts */
+#define UPLINK_PACKER_MAX_RECORDS \
+    ( ( UPLINK_PACKER_MAX_PAYLOAD - UPLINK_PACKER_HEADER_SIZE ) / UPLINK_PACKER_RECORD_SIZE )  /**< Buffer capacity in records */
+/** @} */
+
+/**
+ * @struct UplinkPackerStats
+ * @brief Packing efficiency counters
+ */
+typedef struct UplinkPackerStats
+{
+    uint32_t records;         /**< Records accepted */
+    uint32_t rejected;        /**< Records refused because the buffer was full */
+    uint32_t flushesFull;     /**< Payloads released because the DR limit was reached */
+    uint32_t flushesDeadline; /**< Payloads released by the latency deadline */
+} UplinkPackerStats;
+
+/**
+ * @struct UplinkPacker
+ * @brief Packer instance
+ */
+typedef struct UplinkPacker
+{
+    uint8_t buf[ UPLINK_PACKER_MAX_RECORDS * UPLINK_PACKER_RECORD_SIZE ]; /**< Buffered records */
+    uint8_t count;            /**< Records buffered */
+    uint8_t perUplink;        /**< Records that fit in one uplink at the current DR */
+    uint32_t addedMs[ UPLINK_PACKER_MAX_RECORDS ]; /**< Time each buffered record was added */
+    uint32_t deadlineMs;      /**< Maximum time a record may wait */
+    UplinkPackerStats stats;  /**< Counters */
+} UplinkPacker;
+
+/**
+ * @brief Initialize a packer
+ *
+ * Starts with room for UPLINK_PACKER_MAX_RECORDS per uplink; call
+ * uplink_packer_set_max_payload() with the DR limit.
+ *
+ * @param packer Pointer to packer instance
+ * @param deadlineMs Maximum time a record may wait before it is sent
+ * @return true if initialized, false on invalid parameter
+ */
+bool uplink_packer_init( UplinkPacker * packer, uint32_t deadlineMs );
+
+/**
+ * @brief Change the latency deadline
+ *
+ * @param packer Pointer to packer instance
+ * @param deadlineMs Maximum time a record may wait before it is sent
+ * @return true if set, false on invalid parameter
+ */
+bool uplink_packer_set_deadline( UplinkPacker * packer, uint32_t deadlineMs );
+
+/**
+ * @brief Size uplinks to the current data rate
+ *
+ * @param packer Pointer to packer instance
+ * @param maxPayload Maximum application payload at the current region/DR
+ * @return true if set, false on invalid parameter
+ */
+bool uplink_packer_set_max_payload( UplinkPacker * packer, uint8_t maxPayload );
+
+/**
+ * @brief Buffer one record
+ *
+ * @param packer Pointer to packer instance
+ * @param record UPLINK_PACKER_RECORD_SIZE bytes (copied)
+ * @param nowMs Current time in milliseconds
+ * @return true if buffered, false if full or invalid
+ */
+bool uplink_packer_add( UplinkPacker * packer,
+                        const uint8_t * record,
+                        uint32_t nowMs );
+
+/**
+ * @brief Check whether a payload should be released now
+ *
+ * @param packer Pointer to packer instance
+ * @param nowMs Current time in milliseconds
+ * @return true if an uplink's worth of records is buffered or the oldest
+ *         record reached the deadline
+ */
+bool uplink_packer_ready( const UplinkPacker * packer, uint32_t nowMs );
+
+/**
+ * @brief Release the oldest records as one payload
+ *
+ * Takes at most one uplink's worth of records; any remainder stays
+ * buffered. The payload starts with a live batch header.
+ *
+ * @param packer Pointer to packer instance
+ * @param out Output payload buffer
+ * @param outCap Capacity of out in bytes
+ * @param nowMs Current time in milliseconds
+ * @return Payload length in bytes, 0 if empty or invalid
+ */
+uint8_t uplink_packer_flush( UplinkPacker * packer,
+                             uint8_t * out,
+                             size_t outCap,
+                             uint32_t nowMs );
+
+/**
+ * @brief Write the header of a batch replayed from the journal
+ *
+ * The records follow at out + UPLINK_PACKER_HEADER_SIZE, oldest first,
+ * with consecutive journal sequence numbers.
+ *
+ * @param out Output payload buffer
+ * @param outCap Capacity of out in bytes
+ * @param firstSeq Journal sequence number of the oldest record
+ * @return UPLINK_PACKER_HEADER_SIZE, 0 on invalid parameter
+ */
+uint8_t uplink_packer_replay_header( uint8_t * out,
+                                     size_t outCap,
+                                     uint32_t firstSeq );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_LIB_UPLINK_PACKER_H */
@@ -0,0 +1,417 @@
+#include "uplink_queue.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define UPLINK_QUEUE_NO_SLOT    ( UPLINK_QUEUE_CAPACITY )
+
+static UplinkQueueStatus uplink_queue_insert( UplinkQueue * const queue,
+                                              UplinkPriority priority,
+                                              uint8_t streamId,
+                                              const uint8_t * const data,
+                                              uint8_t len,
+                                              bool confirmed );
+static size_t uplink_queue_find_stream( const UplinkQueue * const queue,
+                                        uint8_t streamId );
+static size_t uplink_queue_find_free( const UplinkQueue * const queue );
+static size_t uplink_queue_claim( UplinkQueue * const queue,
+                                  UplinkPriority priority );
+static size_t uplink_queue_find_oldest( const UplinkQueue * const queue,
+                                        UplinkPriority priority );
+static size_t uplink_queue_find_victim( const UplinkQueue * const queue );
+
+bool uplink_queue_init( UplinkQueue * const queue )
+{
+    bool result = false;
+
+    if( queue != NULL )
+    {
+        ( void ) memset( queue, 0, sizeof( *queue ) );
+        result = true;
+    }
+
+    return result;
+}
+
+UplinkQueueStatus uplink_queue_push( UplinkQueue * const queue,
+                                     UplinkPriority priority,
+                                     uint8_t streamId,
+                                     const uint8_t * const data,
+                                     uint8_t len )
+{
+    return uplink_queue_insert( queue, priority, streamId, data, len, false );
+}
+
+UplinkQueueStatus uplink_queue_push_confirmed( UplinkQueue * const queue,
+                                               UplinkPriority priority,
+                                               uint8_t streamId,
+                                               const uint8_t * const data,
+                                               uint8_t len )
+{
+    return uplink_queue_insert( queue, priority, streamId, data, len, true );
+}
+
+UplinkQueueStatus uplink_queue_requeue( UplinkQueue * const queue,
+                                        const UplinkEntry * const entry )
+{
+    UplinkQueueStatus status = UPLINK_QUEUE_INVALID;
+
+    if( ( queue != NULL ) && ( entry != NULL ) && ( entry->len != 0U ) &&
+        ( entry->len <= UPLINK_QUEUE_MAX_PAYLOAD ) &&
+        ( ( entry->priority == UPLINK_PRIORITY_TELEMETRY ) ||
+          ( entry->priority == UPLINK_PRIORITY_ALARM ) ) )
+    {
+        const size_t slot = uplink_queue_claim( queue, entry->priority );
+
+        if( slot != UPLINK_QUEUE_NO_SLOT )
+        {
+            queue->entries[ slot ] = *entry;
+            queue->entries[ slot ].used = true;
+            queue->stats.requeued++;
+            status = UPLINK_QUEUE_OK;
+        }
+        else
+        {
+            queue->stats.dropped++;
+            status = UPLINK_QUEUE_FULL;
+        }
+    }
+
+    return status;
+}
+
+bool uplink_queue_pop( UplinkQueue * const queue, UplinkEntry * const out )
+{
+    bool result = false;
+
+    if( ( queue != NULL ) && ( out != NULL ) )
+    {
+        size_t slot = uplink_queue_find_oldest( queue, UPLINK_PRIORITY_ALARM );
+
+        if( slot == UPLINK_QUEUE_NO_SLOT )
+        {
+            slot = uplink_queue_find_oldest( queue, UPLINK_PRIORITY_TELEMETRY );
+        }
+
+        if( slot != UPLINK_QUEUE_NO_SLOT )
+        {
+            *out = queue->entries[ slot ];
+            queue->entries[ slot ].used = false;
+            queue->stats.depth--;
+            queue->stats.dequeued++;
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+const UplinkEntry * uplink_queue_peek( const UplinkQueue * const queue )
+{
+    const UplinkEntry * entry = NULL;
+
+    if( queue != NULL )
+    {
+        size_t slot = uplink_queue_find_oldest( queue, UPLINK_PRIORITY_ALARM );
+
+        if( slot == UPLINK_QUEUE_NO_SLOT )
+        {
+            slot = uplink_queue_find_oldest( queue, UPLINK_PRIORITY_TELEMETRY );
+        }
+
+        if( slot != UPLINK_QUEUE_NO_SLOT )
+        {
+            entry = &queue->entries[ slot ];
+        }
+    }
+
+    return entry;
+}
+
+bool uplink_queue_take_spill( UplinkQueue * const queue, UplinkEntry * const out )
+{
+    bool result = false;
+
+    if( ( queue != NULL ) && ( out != NULL ) && queue->spill.used )
+    {
+        *out = queue->spill;
+        out->used = false;
+        queue->spill.used = false;
+        result = true;
+    }
+
+    return result;
+}
+
+size_t uplink_queue_depth( const UplinkQueue * const queue )
+{
+    size_t depth = 0U;
+
+    if( queue != NULL )
+    {
+        depth = ( size_t ) queue->stats.depth;
+    }
+
+    return depth;
+}
+
+bool uplink_queue_get_stats( const UplinkQueue * const queue,
+                             UplinkQueueStats * const out )
+{
+    bool result = false;
+
+    if( ( queue != NULL ) && ( out != NULL ) )
+    {
+        *out = queue->stats;
+        result = true;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Enqueue a new frame.
+ *
+ * @param[in] queue     Pointer to queue instance.
+ * @param[in] priority  Scheduling class.
+ * @param[in] streamId  Telemetry stream identifier.
+ * @param[in] data      Payload bytes.
+ * @param[in] len       Payload length.
+ * @param[in] confirmed Network acknowledgement requested; disables coalescing.
+ *
+ * @return Enqueue status.
+ */
+static UplinkQueueStatus uplink_queue_insert( UplinkQueue * const queue,
+                                              UplinkPriority priority,
+                                              uint8_t streamId,
+                                              const uint8_t * const data,
+                                              uint8_t len,
+                                              bool confirmed )
+{
+    UplinkQueueStatus status = UPLINK_QUEUE_INVALID;
+
+    if( ( queue != NULL ) && ( data != NULL ) && ( len != 0U ) &&
+        ( len <= UPLINK_QUEUE_MAX_PAYLOAD ) &&
+        ( ( priority == UPLINK_PRIORITY_TELEMETRY ) ||
+          ( priority == UPLINK_PRIORITY_ALARM ) ) )
+    {
+        size_t slot = UPLINK_QUEUE_NO_SLOT;
+
+        if( ( priority == UPLINK_PRIORITY_TELEMETRY ) && !confirmed )
+        {
+            slot = uplink_queue_find_stream( queue, streamId );
+        }
+
+        if( slot != UPLINK_QUEUE_NO_SLOT )
+        {
+            /* Stale sample: keep its queue position, refresh the payload */
+            status = UPLINK_QUEUE_COALESCED;
+            queue->stats.coalesced++;
+        }
+        else
+        {
+            slot = uplink_queue_claim( queue, priority );
+
+            if( slot != UPLINK_QUEUE_NO_SLOT )
+            {
+                UplinkEntry * const entry = &queue->entries[ slot ];
+
+                entry->seq       = queue->nextSeq;
+                entry->priority  = priority;
+                entry->streamId  = streamId;
+                entry->confirmed = confirmed;
+                entry->attempts  = 0U;
+                entry->used      = true;
+                queue->nextSeq++;
+
+                queue->stats.enqueued++;
+                status = UPLINK_QUEUE_OK;
+            }
+            else
+            {
+                queue->stats.dropped++;
+                status = UPLINK_QUEUE_FULL;
+            }
+        }
+
+        if( status != UPLINK_QUEUE_FULL )
+        {
+            ( void ) memcpy( queue->entries[ slot ].payload, data, len );
+            queue->entries[ slot ].len = len;
+        }
+    }
+
+    return status;
+}
+
+/**
+ * @brief Take a slot for a frame, evicting telemetry for an alarm.
+ *
+ * An evicted batch is moved to the spill for the owner. The returned slot is counted in the queue depth; the caller fills it.
+ *
+ * @param[in] queue    Pointer to queue instance.
+ * @param[in] priority Scheduling class of the frame.
+ *
+ * @return Slot index, or UPLINK_QUEUE_NO_SLOT if the frame must be dropped.
+ */
+static size_t uplink_queue_claim( UplinkQueue * const queue,
+                                  UplinkPriority priority )
+{
+    size_t slot = uplink_queue_find_free( queue );
+
+    if( ( slot == UPLINK_QUEUE_NO_SLOT ) && ( priority == UPLINK_PRIORITY_ALARM ) )
+    {
+        slot = uplink_queue_find_victim( queue );
+
+        if( slot != UPLINK_QUEUE_NO_SLOT )
+        {
+            if( queue->entries[ slot ].streamId >= UPLINK_QUEUE_BATCH_STREAM_FIRST )
+            {
+                queue->spill = queue->entries[ slot ];
+                queue->stats.spilled++;
+            }
+
+            queue->entries[ slot ].used = false;
+            queue->stats.evicted++;
+            queue->stats.depth--;
+        }
+    }
+
+    if( slot != UPLINK_QUEUE_NO_SLOT )
+    {
+        queue->stats.depth++;
+
+        if( queue->stats.depth > queue->stats.highWater )
+        {
+            queue->stats.highWater = queue->stats.depth;
+        }
+    }
+
+    return slot;
+}
+
+/**
+ * @brief Find the pending unconfirmed telemetry frame of a stream.
+ *
+ * @param[in] queue    Pointer to queue instance.
+ * @param[in] streamId Telemetry stream identifier.
+ *
+ * @return Slot index, or UPLINK_QUEUE_NO_SLOT if the stream has no frame.
+ */
+static size_t uplink_queue_find_stream( const UplinkQueue * const queue,
+                                        uint8_t streamId )
+{
+    size_t slot = UPLINK_QUEUE_NO_SLOT;
+
+    for( size_t i = 0U; i < UPLINK_QUEUE_CAPACITY; ++i )
+    {
+        const UplinkEntry * const entry = &queue->entries[ i ];
+
+        if( entry->used && !entry->confirmed &&
+            ( entry->priority == UPLINK_PRIORITY_TELEMETRY ) &&
+            ( entry->streamId == streamId ) )
+        {
+            slot = i;
+            break;
+        }
+    }
+
+    return slot;
+}
+
+/**
+ * @brief Find an unused slot.
+ *
+ * @param[in] queue Pointer to queue instance.
+ *
+ * @return Slot index, or UPLINK_QUEUE_NO_SLOT if the queue is full.
+ */
+static size_t uplink_queue_find_free( const UplinkQueue * const queue )
+{
+    size_t slot = UPLINK_QUEUE_NO_SLOT;
+
+    for( size_t i = 0U; i < UPLINK_QUEUE_CAPACITY; ++i )
+    {
+        if( !queue->entries[ i ].used )
+        {
+            slot = i;
+            break;
+        }
+    }
+
+    return slot;
+}
+
+/**
+ * @brief Find the oldest frame of a priority class.
+ *
+ * Sequence numbers are compared as unsigned differences against the next
+ * sequence, so ordering survives counter wrap-around.
+ *
+ * @param[in] queue    Pointer to queue instance.
+ * @param[in] priority Scheduling class to search.
+ *
+ * @return Slot index, or UPLINK_QUEUE_NO_SLOT if the class has no frame.
+ */
+static size_t uplink_queue_find_oldest( const UplinkQueue * const queue,
+                                        UplinkPriority priority )
+{
+    size_t slot = UPLINK_QUEUE_NO_SLOT;
+    uint32_t bestAge = 0U;
+
+    for( size_t i = 0U; i < UPLINK_QUEUE_CAPACITY; ++i )
+    {
+        const UplinkEntry * const entry = &queue->entries[ i ];
+
+        if( entry->used && ( entry->priority == priority ) )
+        {
+            const uint32_t age = queue->nextSeq - entry->seq;
+
+            if( ( slot == UPLINK_QUEUE_NO_SLOT ) || ( age > bestAge ) )
+            {
+                slot = i;
+                bestAge = age;
+            }
+        }
+    }
+
+    return slot;
+}
+
+/**
+ * @brief Find the telemetry frame an alarm evicts.
+ *
+ * A single frame only loses one sample, a batch several records, so the
+ * oldest single frame goes first and the oldest batch only if none is left.
+ *
+ * @param[in] queue Pointer to queue instance.
+ *
+ * @return Slot index, or UPLINK_QUEUE_NO_SLOT if there is no telemetry.
+ */
+static size_t uplink_queue_find_victim( const UplinkQueue * const queue )
+{
+    size_t slot = UPLINK_QUEUE_NO_SLOT;
+    bool batch = true;
+    uint32_t bestAge = 0U;
+
+    for( size_t i = 0U; i < UPLINK_QUEUE_CAPACITY; ++i )
+    {
+        const UplinkEntry * const entry = &queue->entries[ i ];
+
+        if( entry->used && ( entry->priority == UPLINK_PRIORITY_TELEMETRY ) )
+        {
+            const bool isBatch = ( entry->streamId >= UPLINK_QUEUE_BATCH_STREAM_FIRST );
+            const uint32_t age = queue->nextSeq - entry->seq;
+
+            if( ( slot == UPLINK_QUEUE_NO_SLOT ) || ( batch && !isBatch ) ||
+                ( ( batch == isBatch ) && ( age > bestAge ) ) )
+            {
+                slot = i;
+                batch = isBatch;
+                bestAge = age;
+            }
+        }
+    }
+
+    return slot;
+}
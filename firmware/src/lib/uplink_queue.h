@@ -0,0 +1,222 @@
+/******************************************************************************
+ * @file uplink_queue.h
+ * @brief Bounded priority queue for LoRaWAN uplinks
+ *
+ * Holds uplinks waiting for the radio-owner task. Alarm frames are always
+ * dequeued ahead of telemetry, telemetry for the same stream is coalesced
+ * so only the freshest sample waits in the queue, and producers get an
+ * explicit status when the queue cannot take their frame. Frames that
+ * need a network acknowledgement are marked confirmed per enqueue; they
+ * are never coalesced and can be put back at the head of their class for
+ * a retry. Streams from UPLINK_QUEUE_BATCH_STREAM_FIRST up carry packed
+ * record batches: an alarm evicts single telemetry frames before them and
+ * hands an evicted batch back to the owner instead of losing it.
+ *
+ * The queue itself is not thread-safe; the owner serializes access.
+ ******************************************************************************/
+
+#ifndef SRC_LIB_UPLINK_QUEUE_H
+#define SRC_LIB_UPLINK_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @defgroup UplinkQueueConfig Uplink Queue Configuration Constants */
+/** @{ */
+#define UPLINK_QUEUE_CAPACITY           ( 8U )    /**< Maximum queued uplinks */
+#define UPLINK_QUEUE_MAX_PAYLOAD        ( 128U )  /**< Maximum uplink payload in bytes */
+#define UPLINK_QUEUE_BATCH_STREAM_FIRST ( 0x80U ) /**< First stream of packed record batches */
+/** @} */
+
+/**
+ * @enum UplinkPriority
+ * @brief Uplink scheduling class
+ */
+typedef enum
+{
+    UPLINK_PRIORITY_TELEMETRY = 0,  /**< Periodic telemetry, coalesced per stream */
+    UPLINK_PRIORITY_ALARM     = 1   /**< Alarm frames, never coalesced */
+} UplinkPriority;
+
+/**
+ * @enum UplinkQueueStatus
+ * @brief Result of an enqueue attempt (backpressure signal)
+ */
+typedef enum
+{
+    UPLINK_QUEUE_OK = 0,        /**< Frame queued */
+    UPLINK_QUEUE_COALESCED,     /**< Frame replaced a pending frame of the same stream */
+    UPLINK_QUEUE_FULL,          /**< Queue full, frame dropped */
+    UPLINK_QUEUE_INVALID        /**< Invalid arguments, frame dropped */
+} UplinkQueueStatus;
+
+/**
+ * @struct UplinkEntry
+ * @brief One queued uplink
+ */
+typedef struct UplinkEntry
+{
+    uint32_t seq;                                 /**< Enqueue order */
+    UplinkPriority priority;                      /**< Scheduling class */
+    uint8_t streamId;                             /**< Telemetry stream for coalescing */
+    uint8_t len;                                  /**< Payload length */
+    bool confirmed;                               /**< Network acknowledgement requested */
+    uint8_t attempts;                             /**< Transmissions so far (confirmed frames) */
+    uint8_t payload[ UPLINK_QUEUE_MAX_PAYLOAD ];  /**< Payload bytes */
+    bool used;                                    /**< Slot occupied */
+} UplinkEntry;
+
+/**
+ * @struct UplinkQueueStats
+ * @brief Counters for sizing the queue against uplink rates
+ */
+typedef struct UplinkQueueStats
+{
+    uint32_t enqueued;      /**< Frames accepted into a free slot */
+    uint32_t coalesced;     /**< Telemetry frames merged into a pending frame */
+    uint32_t dropped;       /**< Frames rejected because the queue was full */
+    uint32_t evicted;       /**< Telemetry frames evicted to make room for alarms */
+    uint32_t spilled;       /**< Evicted batches handed back to the owner */
+    uint32_t dequeued;      /**< Frames handed to the radio */
+    uint32_t requeued;      /**< Confirmed frames put back for a retry */
+    uint8_t depth;          /**< Current queue depth */
+    uint8_t highWater;      /**< Maximum observed queue depth */
+} UplinkQueueStats;
+
+/**
+ * @struct UplinkQueue
+ * @brief Uplink queue instance
+ */
+typedef struct UplinkQueue
+{
+    UplinkEntry entries[ UPLINK_QUEUE_CAPACITY ];  /**< Entry slots */
+    uint32_t nextSeq;                              /**< Next enqueue sequence */
+    UplinkEntry spill;                             /**< Last evicted batch, until taken */
+    UplinkQueueStats stats;                        /**< Queue counters */
+} UplinkQueue;
+
+/**
+ * @brief Initialize an uplink queue
+ *
+ * @param queue Pointer to queue instance
+ * @return true if initialized, false on invalid parameter
+ */
+bool uplink_queue_init( UplinkQueue * queue );
+
+/**
+ * @brief Enqueue an uplink
+ *
+ * Telemetry replaces a pending telemetry frame of the same stream in place.
+ * When the queue is full an alarm evicts the oldest single telemetry frame,
+ * or else the oldest batch, which is kept for uplink_queue_take_spill();
+ * telemetry is rejected.
+ *
+ * @param queue Pointer to queue instance
+ * @param priority Scheduling class
+ * @param streamId Telemetry stream identifier (ignored for alarms)
+ * @param data Payload bytes
+ * @param len Payload length (1-128 bytes)
+ * @return Enqueue status; FULL and INVALID mean the frame was dropped
+ */
+UplinkQueueStatus uplink_queue_push( UplinkQueue * queue,
+                                     UplinkPriority priority,
+                                     uint8_t streamId,
+                                     const uint8_t * data,
+                                     uint8_t len );
+
+/**
+ * @brief Enqueue an uplink that must be acknowledged by the network
+ *
+ * Same as uplink_queue_push(), except that the frame is never coalesced
+ * with another frame of its stream.
+ *
+ * @param queue Pointer to queue instance
+ * @param priority Scheduling class
+ * @param streamId Telemetry stream identifier (ignored for alarms)
+ * @param data Payload bytes
+ * @param len Payload length (1-128 bytes)
+ * @return Enqueue status; FULL and INVALID mean the frame was dropped
+ */
+UplinkQueueStatus uplink_queue_push_confirmed( UplinkQueue * queue,
+                                               UplinkPriority priority,
+                                               uint8_t streamId,
+                                               const uint8_t * data,
+                                               uint8_t len );
+
+/**
+ * @brief Put a dequeued uplink back for a retry
+ *
+ * The entry keeps its sequence number, so it is dequeued ahead of every
+ * frame of its class that was enqueued after it. When the queue is full
+ * an alarm evicts telemetry as for uplink_queue_push(), while telemetry
+ * is rejected.
+ *
+ * @param queue Pointer to queue instance
+ * @param entry Entry returned by uplink_queue_pop() (copied)
+ * @return UPLINK_QUEUE_OK, or FULL/INVALID if the entry was dropped
+ */
+UplinkQueueStatus uplink_queue_requeue( UplinkQueue * queue,
+                                        const UplinkEntry * entry );
+
+/**
+ * @brief Dequeue the next uplink to transmit
+ *
+ * Returns the oldest alarm if any, otherwise the oldest telemetry frame.
+ *
+ * @param queue Pointer to queue instance
+ * @param out Output entry (copied, the slot is freed)
+ * @return true if an entry was dequeued, false if empty or invalid
+ */
+bool uplink_queue_pop( UplinkQueue * queue, UplinkEntry * out );
+
+/**
+ * @brief Look at the next uplink without dequeuing it
+ *
+ * Same selection as uplink_queue_pop().
+ *
+ * @param queue Pointer to queue instance
+ * @return Pointer to the next entry (valid until the queue is modified),
+ *         NULL if empty or invalid
+ */
+const UplinkEntry * uplink_queue_peek( const UplinkQueue * queue );
+
+/**
+ * @brief Take the batch an alarm evicted
+ *
+ * Only the latest evicted batch is kept; an earlier one not taken yet is
+ * lost. The owner should journal the batch so its records are not lost.
+ *
+ * @param queue Pointer to queue instance
+ * @param out Output entry (copied, the spill is cleared)
+ * @return true if a batch was taken, false if none or invalid
+ */
+bool uplink_queue_take_spill( UplinkQueue * queue, UplinkEntry * out );
+
+/**
+ * @brief Get the number of queued uplinks
+ *
+ * @param queue Pointer to queue instance
+ * @return Queue depth, 0 on invalid parameter
+ */
+size_t uplink_queue_depth( const UplinkQueue * queue );
+
+/**
+ * @brief Get queue counters
+ *
+ * @param queue Pointer to queue instance
+ * @param out Output counters
+ * @return true if copied, false on invalid parameter
+ */
+bool uplink_queue_get_stats( const UplinkQueue * queue,
+                             UplinkQueueStats * out );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_LIB_UPLINK_QUEUE_H */
@@ -1,5 +1,16 @@
+#include <esp_err.h>
+#include <nvs_flash.h>
 
 extern "C" void app_main( void )
 {
+    /* NVS is shared by every module and the PHY calibration: only startup
+     * may erase it, drivers just open their namespace */
+    esp_err_t err = nvs_flash_init();
 
+    if( ( err == ESP_ERR_NVS_NO_FREE_PAGES ) || ( err == ESP_ERR_NVS_NEW_VERSION_FOUND ) )
+    {
+        ESP_ERROR_CHECK( nvs_flash_erase() );
+        err = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK( err );
 }
@@ -0,0 +1,1069 @@
+#include "lorawan.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <stddef.h>
+#include <string.h>
+
+#include "hal/uplink_journal_flash.h"
+#include "lib/lora_airtime.h"
+
+#define LORAWAN_TASK_STACK_SIZE      ( 4096U )
+#define LORAWAN_TASK_PRIORITY        ( 3U )
+#define LORAWAN_RX_SLICE_MS          ( 100U )
+#define LORAWAN_PROBE_BUDGET_MS      ( 3000U )
+#define LORAWAN_PROBE_BACKOFF_MIN_MS ( 1000U )
+#define LORAWAN_PROBE_BACKOFF_MAX_MS ( 60000U )
+#define LORAWAN_FAIR_USE_MS_PER_DAY  ( 30000U )
+#define LORAWAN_FALLBACK_DR          ( 0U )     /* Slowest DR when the DR is unknown */
+#define LORAWAN_PACK_DEADLINE_MS     ( 60000U )
+#define LORAWAN_PACK_STREAM_FIRST    ( UPLINK_QUEUE_BATCH_STREAM_FIRST ) /* Packed uplinks use streams 0x80-0xFF */
+#define LORAWAN_LINK_MARGIN_DB       ( 10U )    /* SNR margin kept by link adaptation */
+#define LORAWAN_REPLAY_RETRY_MS      ( 60000U ) /* Journal replay pause after a failed uplink */
+#define LORAWAN_CONFIRM_ATTEMPTS     ( 4U )     /* Send attempts per confirmed uplink */
+#define LORAWAN_CONFIRM_RX_MS        ( 4000U )  /* RX windows close, then the downlink is read */
+#define LORAWAN_MAILBOX_OPS_PER_PASS ( 2U )     /* Mailbox requests executed per task pass */
+#define LORAWAN_SEND_ATTEMPTS        ( 4U )     /* Send attempts per plain telemetry uplink */
+#define LORAWAN_JOIN_POLL_MS         ( 1000U )  /* AT+JOIN? interval while a join is pending */
+#define LORAWAN_JOIN_BACKOFF_MIN_MS  ( 10000U )
+#define LORAWAN_JOIN_BACKOFF_MAX_MS  ( 600000U )
+
+/* Link adaptation range per region (125 kHz DRs, EIRP caps in dBm) */
+static const LinkQualityLimits lorawanLinkLimits[] =
+{
+    [ LWNODE_REGION_EU868 ] = { 0U, 5U, 2U, 16U, LORAWAN_LINK_MARGIN_DB },
+    [ LWNODE_REGION_US915 ] = { 0U, 3U, 2U, 20U, LORAWAN_LINK_MARGIN_DB },
+    [ LWNODE_REGION_CN470 ] = { 0U, 5U, 2U, 19U, LORAWAN_LINK_MARGIN_DB },
+};
+
+static LwnodeDevice * lorawanDevice = NULL;
+static UplinkQueue uplinkQueue;
+static uint32_t uplinksSent = 0U;
+static uint32_t uplinkFailures = 0U;
+static uint32_t probeFailures = 0U;
+static LoraAirtimeBudget airtimeBudget;
+static uint32_t airtimeDeferrals = 0U;
+static uint32_t airtimeRejected = 0U;
+static UplinkPacker recordPacker;
+static uint8_t packStreamId = LORAWAN_PACK_STREAM_FIRST;
+static LinkQuality linkQuality;
+static uint32_t linkFramesSeen = 0U;
+static LinkQualityAction linkAdvice = LINK_QUALITY_HOLD;
+static uint32_t linkAdjustments = 0U;
+static UplinkJournal uplinkJournal;
+static bool journalReady = false;
+static bool replayHeld = false;
+static uint32_t replayRetryAtMs = 0U;
+static UplinkConfirm uplinkConfirm;
+static uint32_t confirmFramesSeen = 0U;
+static DownlinkCmdDispatcher downlinkDispatcher;
+static DownlinkCmdEvent drHint;
+static bool drHintPending = false;
+static uint32_t drHintsApplied = 0U;
+static LwnodeMailbox driverMailbox;
+static uint8_t moduleDataRate = LORAWAN_FALLBACK_DR;
+static bool moduleDataRateStale = true;
+static bool joinPending = false;
+static uint32_t joinActionAtMs = 0U;
+static uint32_t joinBackoffMs = LORAWAN_JOIN_BACKOFF_MIN_MS;
+static uint32_t joinRequests = 0U;
+
+static SemaphoreHandle_t queueMutex = NULL;
+static StaticSemaphore_t queueMutexBuffer;
+/* Guards uplinkJournal. Flash writes and erases run under it alone, never
+ * with queueMutex held, so producers never wait for a sector erase. */
+static SemaphoreHandle_t journalMutex = NULL;
+static StaticSemaphore_t journalMutexBuffer;
+
+static TaskHandle_t lorawanTask = NULL;
+static StaticTask_t lorawanTaskBuffer;
+static StackType_t lorawanTaskStack[ LORAWAN_TASK_STACK_SIZE ];
+
+static void lorawan_task( void * pvParameters );
+static UplinkQueueStatus lorawan_enqueue( UplinkPriority priority,
+                                          uint8_t streamId,
+                                          const uint8_t * const data,
+                                          uint8_t len,
+                                          bool confirmed );
+static bool lorawan_dequeue( UplinkEntry * const entry,
+                             uint32_t * const airtimeUs,
+                             uint32_t * const waitMs,
+                             bool * const rejected );
+static uint32_t lorawan_now_ms( void );
+static uint8_t lorawan_data_rate( void );
+static void lorawan_refresh_data_rate( void );
+static void lorawan_pack_resize( void );
+static void lorawan_pack_flush( void );
+static void lorawan_link_adapt( void );
+static void lorawan_journal_payload( const UplinkEntry * const entry );
+static void lorawan_journal_records( const UplinkEntry * const entry );
+static void lorawan_confirm_poll( void );
+static void lorawan_confirm_settle( UplinkConfirmEvent event,
+                                    const UplinkEntry * const entry );
+static bool lorawan_replay( void );
+static void lorawan_on_downlink( const uint8_t * payload, uint8_t len, int8_t rssi, int8_t snr );
+static bool lorawan_post_dr_hint( void * ctx, const DownlinkCmdEvent * event );
+static void lorawan_apply_dr_hint( void );
+static void lorawan_bring_up( void );
+static bool lorawan_join_step( void );
+static bool lorawan_send_frame( const uint8_t * const payload,
+                                uint8_t len,
+                                LwnodePacketType type,
+                                bool * const onAir );
+
+bool lorawan_start( LwnodeDevice * const device )
+{
+    bool result = false;
+
+    if( ( device != NULL ) && ( lorawanTask == NULL ) )
+    {
+        lorawanDevice = device;
+        ( void ) uplink_queue_init( &uplinkQueue );
+        ( void ) uplink_packer_init( &recordPacker, LORAWAN_PACK_DEADLINE_MS );
+        ( void ) link_quality_init( &linkQuality );
+        ( void ) uplink_confirm_init( &uplinkConfirm, LORAWAN_CONFIRM_ATTEMPTS );
+        ( void ) downlink_cmd_init( &downlinkDispatcher );
+        ( void ) downlink_cmd_route( &downlinkDispatcher, DOWNLINK_CMD_DR_HINT,
+                                     lorawan_post_dr_hint, NULL );
+        ( void ) lwnode_set_rx_cb( device, lorawan_on_downlink );
+        ( void ) lwnode_mailbox_init( &driverMailbox );
+        journalReady = uplink_journal_flash_mount( &uplinkJournal );
+
+        queueMutex = xSemaphoreCreateMutexStatic( &queueMutexBuffer );
+        configASSERT( queueMutex != NULL );
+        journalMutex = xSemaphoreCreateMutexStatic( &journalMutexBuffer );
+        configASSERT( journalMutex != NULL );
+
+        lorawanTask = xTaskCreateStatic( lorawan_task,
+                                         "lorawan",
+                                         LORAWAN_TASK_STACK_SIZE,
+                                         NULL,
+                                         LORAWAN_TASK_PRIORITY,
+                                         lorawanTaskStack,
+                                         &lorawanTaskBuffer );
+        configASSERT( lorawanTask != NULL );
+
+        result = true;
+    }
+
+    return result;
+}
+
+UplinkQueueStatus lorawan_send_alarm( const uint8_t * const data, uint8_t len )
+{
+    return lorawan_enqueue( UPLINK_PRIORITY_ALARM, 0U, data, len, true );
+}
+
+UplinkQueueStatus lorawan_send_telemetry( uint8_t streamId,
+                                          const uint8_t * const data,
+                                          uint8_t len )
+{
+    return lorawan_enqueue( UPLINK_PRIORITY_TELEMETRY, streamId, data, len, false );
+}
+
+UplinkQueueStatus lorawan_send_record( const uint8_t * const record )
+{
+    UplinkQueueStatus status = UPLINK_QUEUE_INVALID;
+
+    if( ( record != NULL ) && ( queueMutex != NULL ) )
+    {
+        ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+        if( uplink_packer_add( &recordPacker, record, lorawan_now_ms() ) )
+        {
+            lorawan_pack_flush();
+            status = UPLINK_QUEUE_OK;
+        }
+        ( void ) xSemaphoreGive( queueMutex );
+
+        if( status != UPLINK_QUEUE_OK )
+        {
+            status = UPLINK_QUEUE_FULL;
+
+            /* Radio backed up: keep the record for replay */
+            ( void ) xSemaphoreTake( journalMutex, portMAX_DELAY );
+            if( journalReady &&
+                uplink_journal_append( &uplinkJournal, record, UPLINK_PACKER_RECORD_SIZE ) )
+            {
+                status = UPLINK_QUEUE_OK;
+            }
+            ( void ) xSemaphoreGive( journalMutex );
+        }
+    }
+
+    return status;
+}
+
+bool lorawan_set_pack_deadline( uint32_t deadlineMs )
+{
+    bool result = false;
+
+    if( queueMutex != NULL )
+    {
+        ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+        result = uplink_packer_set_deadline( &recordPacker, deadlineMs );
+        ( void ) xSemaphoreGive( queueMutex );
+    }
+
+    return result;
+}
+
+bool lorawan_route_downlink( DownlinkCmdOpcode opcode,
+                             DownlinkCmdPostFn post,
+                             void * const ctx )
+{
+    bool result = false;
+
+    if( queueMutex != NULL )
+    {
+        ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+        result = downlink_cmd_route( &downlinkDispatcher, opcode, post, ctx );
+        ( void ) xSemaphoreGive( queueMutex );
+    }
+
+    return result;
+}
+
+bool lorawan_submit( const LwnodeMailboxReq * const req )
+{
+    bool result = false;
+
+    if( ( req != NULL ) && ( queueMutex != NULL ) )
+    {
+        result = lwnode_mailbox_submit( &driverMailbox, req );
+    }
+
+    return result;
+}
+
+bool lorawan_get_stats( LorawanStats * const out )
+{
+    bool result = false;
+
+    if( ( out != NULL ) && ( queueMutex != NULL ) )
+    {
+        ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+        ( void ) uplink_queue_get_stats( &uplinkQueue, &out->queue );
+        out->sent = uplinksSent;
+        out->sendFailures = uplinkFailures;
+        out->probeFailures = probeFailures;
+        out->radioReady = lwnode_is_ready( lorawanDevice );
+        out->joined = lwnode_session_joined( lorawanDevice );
+        out->joinRequests = joinRequests;
+        out->airtimeRemainingMs = lora_airtime_budget_remaining_ms( &airtimeBudget,
+                                                                    lorawan_now_ms() );
+        out->airtimeConsumedMs = airtimeBudget.consumedMs;
+        out->airtimeDeferrals = airtimeDeferrals;
+        out->airtimeRejected = airtimeRejected;
+        out->packer = recordPacker.stats;
+        if( !link_quality_summary( &linkQuality, &out->link ) )
+        {
+            ( void ) memset( &out->link, 0, sizeof( out->link ) );
+        }
+        out->linkAdvice = linkAdvice;
+        out->linkAdjustments = linkAdjustments;
+        ( void ) uplink_confirm_get_stats( &uplinkConfirm, &out->confirm );
+        ( void ) downlink_cmd_get_stats( &downlinkDispatcher, &out->downlink );
+        out->drHintsApplied = drHintsApplied;
+        ( void ) lwnode_mailbox_get_stats( &driverMailbox, &out->mailbox );
+        ( void ) xSemaphoreGive( queueMutex );
+
+        ( void ) xSemaphoreTake( journalMutex, portMAX_DELAY );
+        if( !journalReady || !uplink_journal_get_stats( &uplinkJournal, &out->journal ) )
+        {
+            ( void ) memset( &out->journal, 0, sizeof( out->journal ) );
+        }
+        ( void ) xSemaphoreGive( journalMutex );
+
+        result = true;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Radio-owner task.
+ *
+ * Brings the module up if needed and joins the network, then transmits
+ * queued uplinks one at a time, replays journaled records while the queue is empty and otherwise
+ * polls for downlinks. Packed records are released into the queue on each
+ * pass once due, and a packed batch an alarm evicted is journaled. While a confirmed uplink waits for its acknowledgement
+ * nothing else is sent, so the next downlink's ACK can only refer to it.
+ * Nothing is dequeued while the module is not joined, joining or in its
+ * RX windows; frames wait in the queue, where alarms can still overtake
+ * telemetry.
+ * Downlink commands are decoded while the task sleeps or sends. Driver
+ * operations other tasks submitted to the mailbox run at the end of each
+ * pass while the module is idle, a few at a time, so uplinks are not
+ * starved.
+ *
+ * @param[in] pvParameters Unused.
+ */
+static void lorawan_task( void * pvParameters )
+{
+    static UplinkEntry entry;
+
+    ( void ) pvParameters;
+
+    lorawan_bring_up();
+
+    ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+    ( void ) lora_airtime_budget_init( &airtimeBudget,
+                                       lorawanDevice->region,
+                                       LORAWAN_FAIR_USE_MS_PER_DAY,
+                                       lorawan_now_ms() );
+    ( void ) xSemaphoreGive( queueMutex );
+
+    for( ;; )
+    {
+        uint32_t airtimeUs = 0U;
+        uint32_t waitMs = 0U;
+        bool rejected = false;
+
+        ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+        lorawan_pack_resize();
+        lorawan_pack_flush();
+        const bool spilled = uplink_queue_take_spill( &uplinkQueue, &entry );
+        ( void ) xSemaphoreGive( queueMutex );
+
+        if( spilled )
+        {
+            /* An alarm evicted a packed batch: keep its records for replay */
+            lorawan_journal_records( &entry );
+        }
+
+        lorawan_confirm_poll();
+
+        const bool hold = !lorawan_join_step() ||
+                          uplink_confirm_busy( &uplinkConfirm ) ||
+                          ( lwnode_get_busy_state( lorawanDevice ) != LWNODE_STATE_IDLE );
+
+        if( !hold && lorawan_dequeue( &entry, &airtimeUs, &waitMs, &rejected ) )
+        {
+            bool journal = false;
+            bool onAir = false;
+
+            const bool sent = lorawan_send_frame( entry.payload, entry.len,
+                                                  entry.confirmed ? LWNODE_PACKET_CONFIRMED :
+                                                                    LWNODE_PACKET_UNCONFIRMED,
+                                                  &onAir );
+
+            ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+            if( onAir )
+            {
+                lora_airtime_budget_consume( &airtimeBudget, airtimeUs, lorawan_now_ms() );
+            }
+            if( sent )
+            {
+                uplinksSent++;
+                replayHeld = false;
+                moduleDataRateStale = true;
+                /* Only downlinks after the accepted send can acknowledge it */
+                confirmFramesSeen = lorawanDevice->rxStats.framesReceived;
+                ( void ) uplink_confirm_sent( &uplinkConfirm, &entry,
+                                              ( airtimeUs / 1000U ) + LORAWAN_CONFIRM_RX_MS,
+                                              lorawan_now_ms() );
+            }
+            else
+            {
+                uplinkFailures++;
+                if( entry.confirmed )
+                {
+                    lorawan_confirm_settle( uplink_confirm_send_failed( &uplinkConfirm, &entry, &entry ),
+                                            &entry );
+                }
+                else if( entry.streamId >= LORAWAN_PACK_STREAM_FIRST )
+                {
+                    journal = true;
+                }
+                else
+                {
+                    /* A plain sample cannot be journaled: retry it ahead of newer frames */
+                    entry.attempts++;
+                    if( entry.attempts < LORAWAN_SEND_ATTEMPTS )
+                    {
+                        ( void ) uplink_queue_requeue( &uplinkQueue, &entry );
+                    }
+                }
+            }
+            ( void ) xSemaphoreGive( queueMutex );
+
+            if( journal )
+            {
+                lorawan_journal_payload( &entry );
+            }
+        }
+        else if( rejected )
+        {
+            /* Sized for a faster DR: the records are re-batched on replay */
+            lorawan_journal_records( &entry );
+        }
+        else if( ( waitMs == 0U ) && !hold && lorawan_replay() )
+        {
+            /* A journaled batch was sent; look at the queue again first */
+        }
+        else
+        {
+            const uint32_t sliceMs = ( ( waitMs != 0U ) && ( waitMs < LORAWAN_RX_SLICE_MS ) ) ?
+                                     waitMs : LORAWAN_RX_SLICE_MS;
+
+            ( void ) lwnode_sleep_ms( lorawanDevice, sliceMs );
+        }
+
+        lorawan_link_adapt();
+        lorawan_apply_dr_hint();
+
+        if( lwnode_get_busy_state( lorawanDevice ) == LWNODE_STATE_IDLE )
+        {
+            lorawan_refresh_data_rate();
+            ( void ) lwnode_mailbox_service( &driverMailbox, lorawanDevice,
+                                             LORAWAN_MAILBOX_OPS_PER_PASS );
+        }
+    }
+}
+
+/**
+ * @brief Retry the module bring-up until it succeeds.
+ *
+ * Each attempt is bounded by LORAWAN_PROBE_BUDGET_MS and fails fast when
+ * the module is absent. The interval between attempts doubles up to
+ * LORAWAN_PROBE_BACKOFF_MAX_MS so a missing radio costs little bus time.
+ */
+static void lorawan_bring_up( void )
+{
+    uint32_t backoffMs = LORAWAN_PROBE_BACKOFF_MIN_MS;
+
+    while( !lwnode_is_ready( lorawanDevice ) )
+    {
+        if( !lwnode_begin_bounded( lorawanDevice, LORAWAN_PROBE_BUDGET_MS ) )
+        {
+            ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+            probeFailures++;
+            ( void ) xSemaphoreGive( queueMutex );
+
+            vTaskDelay( pdMS_TO_TICKS( backoffMs ) );
+
+            backoffMs = ( backoffMs >= ( LORAWAN_PROBE_BACKOFF_MAX_MS / 2U ) ) ?
+                        LORAWAN_PROBE_BACKOFF_MAX_MS : ( backoffMs * 2U );
+        }
+    }
+}
+
+/**
+ * @brief Join the network if needed and report the cached join state.
+ *
+ * Answers from the session state the driver caches, so a joined module
+ * costs no bus traffic. Otherwise a join is requested and polled once a
+ * second; the driver skips the poll until the accept can have arrived.
+ * A join window that closes without an accept is retried after a backoff
+ * doubling up to LORAWAN_JOIN_BACKOFF_MAX_MS. A join another task
+ * submitted to the mailbox is polled the same way.
+ *
+ * @return true if the module holds a joined session.
+ */
+static bool lorawan_join_step( void )
+{
+    const uint32_t nowMs = lorawan_now_ms();
+    bool joined = lwnode_session_joined( lorawanDevice );
+
+    if( !joined && ( ( int32_t ) ( nowMs - joinActionAtMs ) >= 0 ) )
+    {
+        const LwnodeBusyState busy = lwnode_get_busy_state( lorawanDevice );
+        bool backOff = false;
+
+        if( joinPending || ( busy == LWNODE_STATE_JOINING ) )
+        {
+            joined = lwnode_is_joined( lorawanDevice );
+            joinActionAtMs = nowMs + LORAWAN_JOIN_POLL_MS;
+
+            if( joined )
+            {
+                joinPending = false;
+                joinBackoffMs = LORAWAN_JOIN_BACKOFF_MIN_MS;
+            }
+            else if( busy != LWNODE_STATE_JOINING )
+            {
+                /* The join window closed without an accept */
+                joinPending = false;
+                backOff = true;
+            }
+            else
+            {
+                /* Accept still possible */
+            }
+        }
+        else if( busy == LWNODE_STATE_IDLE )
+        {
+            joinPending = lwnode_join( lorawanDevice );
+            joinActionAtMs = nowMs + LORAWAN_JOIN_POLL_MS;
+            backOff = !joinPending;
+
+            ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+            joinRequests++;
+            ( void ) xSemaphoreGive( queueMutex );
+        }
+        else
+        {
+            /* RX windows of an earlier uplink */
+        }
+
+        if( backOff )
+        {
+            joinActionAtMs = nowMs + joinBackoffMs;
+            joinBackoffMs = ( joinBackoffMs >= ( LORAWAN_JOIN_BACKOFF_MAX_MS / 2U ) ) ?
+                            LORAWAN_JOIN_BACKOFF_MAX_MS : ( joinBackoffMs * 2U );
+        }
+    }
+
+    return joined;
+}
+
+/**
+ * @brief Hand one uplink to the radio.
+ *
+ * The driver only switches the module's uplink type when it changes. A
+ * send the module answered with an error never went on air; the cached
+ * join state is then refreshed, since a lost session is the usual cause.
+ * A send without a reply may have gone on air. Called without the queue
+ * mutex.
+ *
+ * @param[in]  payload Payload bytes.
+ * @param[in]  len     Payload length.
+ * @param[in]  type    Confirmed or unconfirmed uplink.
+ * @param[out] onAir   Set if the frame may have been transmitted.
+ *
+ * @return true if the module accepted the uplink.
+ */
+static bool lorawan_send_frame( const uint8_t * const payload,
+                                uint8_t len,
+                                LwnodePacketType type,
+                                bool * const onAir )
+{
+    const bool typed = lwnode_set_packet_type( lorawanDevice, type );
+    const bool sent = typed && lwnode_send_packet_bytes( lorawanDevice, payload, len );
+    const LwnodeAtStatus status = lwnode_at_poll( lorawanDevice );
+
+    *onAir = sent || ( typed && ( status == LWNODE_AT_STATUS_TIMEOUT ) );
+
+    if( typed && !sent && ( status == LWNODE_AT_STATUS_OK ) )
+    {
+        ( void ) lwnode_is_joined( lorawanDevice );
+    }
+
+    return sent;
+}
+
+/**
+ * @brief Enqueue an uplink under the queue mutex.
+ *
+ * @param[in] priority  Scheduling class.
+ * @param[in] streamId  Telemetry stream identifier.
+ * @param[in] data      Payload bytes.
+ * @param[in] len       Payload length.
+ * @param[in] confirmed Request a network acknowledgement for this frame.
+ *
+ * @return Enqueue status from the queue, INVALID if the task is not running.
+ */
+static UplinkQueueStatus lorawan_enqueue( UplinkPriority priority,
+                                          uint8_t streamId,
+                                          const uint8_t * const data,
+                                          uint8_t len,
+                                          bool confirmed )
+{
+    UplinkQueueStatus status = UPLINK_QUEUE_INVALID;
+
+    if( queueMutex != NULL )
+    {
+        ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+        status = confirmed ?
+                 uplink_queue_push_confirmed( &uplinkQueue, priority, streamId, data, len ) :
+                 uplink_queue_push( &uplinkQueue, priority, streamId, data, len );
+        ( void ) xSemaphoreGive( queueMutex );
+    }
+
+    return status;
+}
+
+/**
+ * @brief Dequeue the next uplink if the airtime budget allows it.
+ *
+ * The airtime is computed for the device's region and current data rate
+ * (the slowest DR if unknown). A frame that can never fit, e.g. one
+ * breaking the dwell time, is taken off the queue so it does not block
+ * it, and returned as rejected for the caller to journal.
+ *
+ * @param[out] entry     Output entry.
+ * @param[out] airtimeUs Airtime to charge once the entry is sent.
+ * @param[out] waitMs    Time until the head entry fits, 0 if not waiting.
+ * @param[out] rejected  Set if the entry was taken off because it never fits.
+ *
+ * @return true if an entry was dequeued, false if empty or held back.
+ */
+static bool lorawan_dequeue( UplinkEntry * const entry,
+                             uint32_t * const airtimeUs,
+                             uint32_t * const waitMs,
+                             bool * const rejected )
+{
+    bool result = false;
+
+    ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+
+    const UplinkEntry * const next = uplink_queue_peek( &uplinkQueue );
+
+    if( next != NULL )
+    {
+        uint32_t airtime = lora_airtime_uplink_us( lorawanDevice->region,
+                                                   lorawan_data_rate(),
+                                                   next->len );
+        if( airtime == 0U )
+        {
+            airtime = lora_airtime_uplink_us( lorawanDevice->region,
+                                              LORAWAN_FALLBACK_DR,
+                                              next->len );
+        }
+
+        switch( lora_airtime_budget_check( &airtimeBudget, airtime, lorawan_now_ms(), waitMs ) )
+        {
+            case LORA_AIRTIME_OK:
+                result = uplink_queue_pop( &uplinkQueue, entry );
+                *airtimeUs = airtime;
+                break;
+            case LORA_AIRTIME_WAIT:
+                airtimeDeferrals++;
+                break;
+            default:
+                *rejected = uplink_queue_pop( &uplinkQueue, entry );
+                airtimeRejected++;
+                break;
+        }
+    }
+
+    ( void ) xSemaphoreGive( queueMutex );
+
+    return result;
+}
+
+/**
+ * @brief Size packed uplinks to the device's region and current DR.
+ *
+ * Falls back to the slowest DR when the configured one is unknown. Called
+ * with the queue mutex held.
+ */
+static void lorawan_pack_resize( void )
+{
+    LoraDrParams params = { 0 };
+
+    if( lora_airtime_dr_params( lorawanDevice->region, lorawan_data_rate(), &params ) ||
+        lora_airtime_dr_params( lorawanDevice->region, LORAWAN_FALLBACK_DR, &params ) )
+    {
+        ( void ) uplink_packer_set_max_payload( &recordPacker, params.maxPayload );
+    }
+}
+
+/**
+ * @brief Move due packed records into the uplink queue.
+ *
+ * Each payload gets its own stream id from the packed range so that
+ * queued payloads never coalesce with each other. Records stay in the
+ * packer while the queue is full. Called with the queue mutex held.
+ */
+static void lorawan_pack_flush( void )
+{
+    static uint8_t payload[ UPLINK_PACKER_MAX_PAYLOAD ];
+
+    while( ( uplink_queue_depth( &uplinkQueue ) < UPLINK_QUEUE_CAPACITY ) &&
+           uplink_packer_ready( &recordPacker, lorawan_now_ms() ) )
+    {
+        const uint8_t len = uplink_packer_flush( &recordPacker, payload, sizeof( payload ),
+                                                 lorawan_now_ms() );
+
+        ( void ) uplink_queue_push( &uplinkQueue,
+                                    UPLINK_PRIORITY_TELEMETRY,
+                                    packStreamId,
+                                    payload,
+                                    len );
+
+        packStreamId = ( packStreamId == 0xFFU ) ? LORAWAN_PACK_STREAM_FIRST :
+                       ( uint8_t ) ( packStreamId + 1U );
+    }
+}
+
+/**
+ * @brief Feed new downlink metrics to the estimator and act on its advice.
+ *
+ * The advice is applied only while network ADR is off; otherwise it is
+ * just reported. After a change the history restarts so the next step is
+ * decided on a full fresh window.
+ */
+static void lorawan_link_adapt( void )
+{
+    const uint32_t frames = lorawanDevice->rxStats.framesReceived;
+    const LwnodeRegion region = lorawanDevice->region;
+    const uint8_t dataRate = lorawan_data_rate();
+    LoraDrParams params = { 0 };
+    LinkQualityAdvice advice = { 0 };
+
+    if( ( frames != linkFramesSeen ) &&
+        ( ( size_t ) region < ( sizeof( lorawanLinkLimits ) / sizeof( lorawanLinkLimits[ 0 ] ) ) ) &&
+        lora_airtime_dr_params( region, dataRate, &params ) )
+    {
+        const LinkQualityLimits * const limits = &lorawanLinkLimits[ region ];
+        const uint8_t eirp = ( lorawanDevice->txPower != 0U ) ? lorawanDevice->txPower :
+                                                                limits->maxEirp;
+        bool applied = false;
+
+        linkFramesSeen = frames;
+
+        ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+        ( void ) link_quality_add( &linkQuality, lorawanDevice->lastRssi, lorawanDevice->lastSnr );
+        if( link_quality_advise( &linkQuality, limits, dataRate,
+                                 params.sf, eirp, &advice ) )
+        {
+            linkAdvice = advice.action;
+        }
+        else
+        {
+            advice.action = LINK_QUALITY_HOLD;
+        }
+        ( void ) xSemaphoreGive( queueMutex );
+
+        if( !lorawanDevice->adr )
+        {
+            switch( advice.action )
+            {
+                case LINK_QUALITY_FASTER_DR:
+                case LINK_QUALITY_SLOWER_DR:
+                    applied = lwnode_set_datarate( lorawanDevice, advice.dataRate );
+                    break;
+                case LINK_QUALITY_LOWER_EIRP:
+                case LINK_QUALITY_RAISE_EIRP:
+                    applied = lwnode_set_eirp( lorawanDevice, advice.eirp );
+                    break;
+                default:
+                    /* Hold */
+                    break;
+            }
+        }
+
+        if( applied )
+        {
+            ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+            ( void ) link_quality_init( &linkQuality );
+            linkAdjustments++;
+            ( void ) xSemaphoreGive( queueMutex );
+        }
+    }
+}
+
+/**
+ * @brief Journal the records of a packed uplink that failed.
+ *
+ * Plain alarm and telemetry frames are not journaled: only packed records
+ * can be re-batched on replay. Replay pauses for LORAWAN_REPLAY_RETRY_MS.
+ * Called without the queue mutex: the appends may erase a sector.
+ *
+ * @param[in] entry Uplink that was not sent.
+ */
+static void lorawan_journal_payload( const UplinkEntry * const entry )
+{
+    lorawan_journal_records( entry );
+
+    replayHeld = true;
+    replayRetryAtMs = lorawan_now_ms() + LORAWAN_REPLAY_RETRY_MS;
+}
+
+/**
+ * @brief Append the records of a packed uplink to the journal.
+ *
+ * The batch header is dropped: replay stamps its own. Does nothing for a
+ * plain frame. Called without the queue mutex.
+ *
+ * @param[in] entry Packed uplink to keep.
+ */
+static void lorawan_journal_records( const UplinkEntry * const entry )
+{
+    if( journalReady && ( entry->streamId >= LORAWAN_PACK_STREAM_FIRST ) &&
+        ( entry->len > UPLINK_PACKER_HEADER_SIZE ) &&
+        ( ( ( entry->len - UPLINK_PACKER_HEADER_SIZE ) % UPLINK_PACKER_RECORD_SIZE ) == 0U ) )
+    {
+        ( void ) xSemaphoreTake( journalMutex, portMAX_DELAY );
+        for( uint8_t offset = UPLINK_PACKER_HEADER_SIZE; offset < entry->len;
+             offset += UPLINK_PACKER_RECORD_SIZE )
+        {
+            ( void ) uplink_journal_append( &uplinkJournal, &entry->payload[ offset ],
+                                            UPLINK_PACKER_RECORD_SIZE );
+        }
+        ( void ) xSemaphoreGive( journalMutex );
+    }
+}
+
+/**
+ * @brief Send one batch of journaled records if the link and budget allow.
+ *
+ * The batch is sized to the current DR, stamped with the journal sequence
+ * of its oldest record and acknowledged in the journal only once the
+ * module accepted it. After a failure, replay waits for the
+ * next successful live uplink or for LORAWAN_REPLAY_RETRY_MS.
+ *
+ * @return true if a batch was handed to the radio, false if nothing was sent.
+ */
+static bool lorawan_replay( void )
+{
+    static uint8_t payload[ UPLINK_PACKER_MAX_PAYLOAD ];
+    bool result = false;
+    bool due = false;
+    uint8_t records = 0U;
+    uint16_t len = 0U;
+    uint32_t airtimeUs = 0U;
+    uint32_t dropped = 0U;
+    uint32_t waitMs = 0U;
+    uint32_t firstSeq = 0U;
+    LoraDrParams params = { 0 };
+
+    ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+    due = journalReady && lwnode_is_ready( lorawanDevice ) &&
+          ( !replayHeld || ( ( int32_t ) ( lorawan_now_ms() - replayRetryAtMs ) >= 0 ) ) &&
+          ( lora_airtime_dr_params( lorawanDevice->region, lorawan_data_rate(), &params ) ||
+            lora_airtime_dr_params( lorawanDevice->region, LORAWAN_FALLBACK_DR, &params ) ) &&
+          ( params.maxPayload > UPLINK_PACKER_HEADER_SIZE );
+    ( void ) xSemaphoreGive( queueMutex );
+
+    if( due )
+    {
+        /* Flash reads outside the queue mutex */
+        ( void ) xSemaphoreTake( journalMutex, portMAX_DELAY );
+        if( uplink_journal_pending( &uplinkJournal ) > 0U )
+        {
+            len = uplink_journal_peek_batch( &uplinkJournal, &payload[ UPLINK_PACKER_HEADER_SIZE ],
+                                             sizeof( payload ) - UPLINK_PACKER_HEADER_SIZE,
+                                             ( uint16_t ) ( params.maxPayload - UPLINK_PACKER_HEADER_SIZE ),
+                                             &records, &firstSeq );
+            dropped = uplinkJournal.stats.dropped;
+        }
+        ( void ) xSemaphoreGive( journalMutex );
+    }
+
+    if( len > 0U )
+    {
+        len = ( uint16_t ) ( len + uplink_packer_replay_header( payload, sizeof( payload ), firstSeq ) );
+        airtimeUs = lora_airtime_frame_us( &params, ( uint16_t ) ( len + LORA_AIRTIME_FRAME_OVERHEAD ) );
+
+        ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+        if( lora_airtime_budget_check( &airtimeBudget, airtimeUs, lorawan_now_ms(), &waitMs ) !=
+            LORA_AIRTIME_OK )
+        {
+            airtimeDeferrals++;
+            len = 0U;
+        }
+        ( void ) xSemaphoreGive( queueMutex );
+    }
+
+    if( len > 0U )
+    {
+        bool onAir = false;
+        const bool sent = lorawan_send_frame( payload, ( uint8_t ) len,
+                                              LWNODE_PACKET_UNCONFIRMED, &onAir );
+
+        ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+        if( onAir )
+        {
+            lora_airtime_budget_consume( &airtimeBudget, airtimeUs, lorawan_now_ms() );
+        }
+        if( sent )
+        {
+            uplinksSent++;
+            moduleDataRateStale = true;
+        }
+        else
+        {
+            uplinkFailures++;
+            replayHeld = true;
+            replayRetryAtMs = lorawan_now_ms() + LORAWAN_REPLAY_RETRY_MS;
+        }
+        ( void ) xSemaphoreGive( queueMutex );
+
+        if( sent )
+        {
+            ( void ) xSemaphoreTake( journalMutex, portMAX_DELAY );
+            /* A reclaim meanwhile moved the tail: resend rather than ack blindly */
+            if( uplinkJournal.stats.dropped == dropped )
+            {
+                ( void ) uplink_journal_ack( &uplinkJournal, records );
+            }
+            ( void ) xSemaphoreGive( journalMutex );
+        }
+
+        result = true;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Settle the outstanding confirmed uplink.
+ *
+ * The DFR1115 reports a downlink only as a "+RECV=" frame, with no ACK
+ * flag, and the network answers a confirmed uplink in its RX windows. Any
+ * downlink read since the send was accepted, with or without payload, is
+ * therefore taken as its acknowledgement; nothing else is sent meanwhile.
+ * An ACK without payload may produce no frame at all, so a frame without
+ * one before its timeout is only counted as unverified, not resent.
+ */
+static void lorawan_confirm_poll( void )
+{
+    static UplinkEntry entry;
+
+    ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+
+    const uint32_t nowMs = lorawan_now_ms();
+
+    if( lorawanDevice->rxStats.framesReceived != confirmFramesSeen )
+    {
+        confirmFramesSeen = lorawanDevice->rxStats.framesReceived;
+        ( void ) uplink_confirm_on_ack( &uplinkConfirm, nowMs );
+    }
+
+    lorawan_confirm_settle( uplink_confirm_poll( &uplinkConfirm, nowMs, &entry ), &entry );
+
+    ( void ) xSemaphoreGive( queueMutex );
+}
+
+/**
+ * @brief Act on an unacknowledged confirmed uplink.
+ *
+ * A frame the radio rejected goes back to the head of its class, ahead of
+ * newer frames; a frame out of attempts and an unverified frame are only
+ * counted. Called with the queue mutex held.
+ *
+ * @param[in] event Tracker outcome for the frame.
+ * @param[in] entry Frame with its attempts counted.
+ */
+static void lorawan_confirm_settle( UplinkConfirmEvent event,
+                                    const UplinkEntry * const entry )
+{
+    if( event == UPLINK_CONFIRM_RETRY )
+    {
+        ( void ) uplink_queue_requeue( &uplinkQueue, entry );
+    }
+}
+
+/**
+ * @brief RX callback: decode a downlink and post its commands.
+ *
+ * Runs in the LoRaWAN task, from inside the driver, so routes only queue
+ * events and never call back into the driver.
+ *
+ * @param[in] payload Downlink payload.
+ * @param[in] len     Payload length in bytes.
+ * @param[in] rssi    Downlink RSSI (unused; read by link adaptation).
+ * @param[in] snr     Downlink SNR (unused; read by link adaptation).
+ */
+static void lorawan_on_downlink( const uint8_t * payload, uint8_t len, int8_t rssi, int8_t snr )
+{
+    ( void ) rssi;
+    ( void ) snr;
+
+    ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+    ( void ) downlink_cmd_dispatch( &downlinkDispatcher, payload, len );
+    ( void ) xSemaphoreGive( queueMutex );
+}
+
+/**
+ * @brief DR_HINT route: keep the latest hint for the task loop.
+ *
+ * A newer hint replaces one not applied yet. Called with the queue mutex
+ * held.
+ *
+ * @param[in] ctx   Unused.
+ * @param[in] event DR_HINT event.
+ *
+ * @return true.
+ */
+static bool lorawan_post_dr_hint( void * ctx, const DownlinkCmdEvent * event )
+{
+    ( void ) ctx;
+
+    drHint = *event;
+    drHintPending = true;
+
+    return true;
+}
+
+/**
+ * @brief Apply a pending DR hint from the network server.
+ *
+ * Ignored while network ADR is on, since the server then sets the DR
+ * itself. After a change the link history restarts, as for an adjustment
+ * made by link adaptation.
+ */
+static void lorawan_apply_dr_hint( void )
+{
+    DownlinkCmdEvent hint = { 0 };
+    bool pending = false;
+
+    ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+    if( drHintPending )
+    {
+        hint = drHint;
+        drHintPending = false;
+        pending = true;
+    }
+    ( void ) xSemaphoreGive( queueMutex );
+
+    if( pending && !lorawanDevice->adr &&
+        lwnode_set_datarate( lorawanDevice, hint.dataRate ) &&
+        ( ( hint.eirp == 0U ) || lwnode_set_eirp( lorawanDevice, hint.eirp ) ) )
+    {
+        ( void ) xSemaphoreTake( queueMutex, portMAX_DELAY );
+        ( void ) link_quality_init( &linkQuality );
+        drHintsApplied++;
+        ( void ) xSemaphoreGive( queueMutex );
+    }
+}
+
+/**
+ * @brief Scheduler time in milliseconds.
+ *
+ * @return Milliseconds since boot (wraps).
+ */
+static uint32_t lorawan_now_ms( void )
+{
+    return ( uint32_t ) ( xTaskGetTickCount() * portTICK_PERIOD_MS );
+}
+
+/**
+ * @brief Data rate the next uplink goes out at.
+ *
+ * With network ADR on, this is the DR the module last reported, since the
+ * network moves it without the device knowing; otherwise the configured
+ * one.
+ *
+ * @return Data rate index.
+ */
+static uint8_t lorawan_data_rate( void )
+{
+    return lorawanDevice->adr ? moduleDataRate : lorawanDevice->dataRate;
+}
+
+/**
+ * @brief Read back the module's data rate after an uplink while ADR is on.
+ *
+ * A LinkADRReq can only arrive in the RX windows of an uplink, so the DR
+ * is queried once per accepted uplink, with the module idle. A failed
+ * query keeps the last known DR until the next uplink.
+ */
+static void lorawan_refresh_data_rate( void )
+{
+    uint8_t dataRate = 0U;
+
+    if( lorawanDevice->adr && moduleDataRateStale )
+    {
+        moduleDataRateStale = false;
+
+        if( lwnode_get_datarate( lorawanDevice, &dataRate ) )
+        {
+            moduleDataRate = dataRate;
+        }
+    }
+}
@@ -0,0 +1,194 @@
+/******************************************************************************
+ * @file lorawan.h
+ * @brief LoRaWAN uplink task
+ *
+ * Owns the LWNode radio. FSM and diagnostics tasks hand uplinks to this
+ * module through a bounded priority queue and never block on the radio:
+ * alarm frames are transmitted ahead of periodic telemetry, stale
+ * telemetry for the same stream is coalesced, and producers get an
+ * explicit backpressure status when the queue is full. Uplinks leave the
+ * queue only when the regional airtime budget (duty cycle, dwell time,
+ * fair use) allows it. Fixed-size telemetry records can instead be packed
+ * several per uplink, sized to the current data rate and bounded by a
+ * latency deadline. Records that cannot be sent, because the packer is
+ * full while the radio is down or a packed uplink failed, are kept in a
+ * flash journal and replayed in packed batches once uplinks succeed
+ * again. With network ADR off, the task adapts the data rate and EIRP
+ * from the downlink RSSI/SNR history. Alarms are sent as confirmed uplinks,
+ * retried a bounded number of times while the radio rejects them;
+ * telemetry stays unconfirmed. Downlinks are decoded into typed
+ * commands (docs/lorawan/downlink-commands-v1.md) and posted to the task
+ * that registered for each opcode; DR hints are applied here. Other driver
+ * operations (settings, join) are submitted through a lock-free mailbox
+ * and executed by this task, the only one that touches the device.
+ ******************************************************************************/
+
+#ifndef SRC_MODULES_LORAWAN_LORAWAN_H
+#define SRC_MODULES_LORAWAN_LORAWAN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lib/downlink_cmd.h"
+#include "lib/link_quality.h"
+#include "lib/lwnode.h"
+#include "lib/lwnode_mailbox.h"
+#include "lib/uplink_confirm.h"
+#include "lib/uplink_journal.h"
+#include "lib/uplink_packer.h"
+#include "lib/uplink_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @struct LorawanStats
+ * @brief Uplink task counters
+ */
+typedef struct LorawanStats
+{
+    UplinkQueueStats queue;      /**< Queue depth and drop counters */
+    uint32_t sent;               /**< Uplinks accepted by the module */
+    uint32_t sendFailures;       /**< Uplinks the module rejected or timed out */
+    uint32_t probeFailures;      /**< Background bring-up attempts that failed */
+    bool radioReady;             /**< Module is up and configured */
+    bool joined;                 /**< Module holds a joined session (cached) */
+    uint32_t joinRequests;       /**< Joins requested by the task */
+    uint32_t airtimeRemainingMs; /**< Airtime budget left now (UINT32_MAX if unlimited) */
+    uint32_t airtimeConsumedMs;  /**< Airtime charged for uplinks */
+    uint32_t airtimeDeferrals;   /**< Scheduler passes that held an uplink for budget */
+    uint32_t airtimeRejected;    /**< Uplinks that can never fit (packed ones are journaled) */
+    UplinkPackerStats packer;    /**< Record packing counters */
+    LinkQualitySummary link;     /**< Downlink RSSI/SNR window (count 0 if empty) */
+    LinkQualityAction linkAdvice; /**< Last DR/EIRP advice */
+    uint32_t linkAdjustments;    /**< DR/EIRP changes applied from the advice */
+    UplinkJournalStats journal;  /**< Store-and-forward journal (zero if no partition) */
+    UplinkConfirmStats confirm;  /**< Confirmed uplink ACKs, unverified sends, retries and failures */
+    DownlinkCmdStats downlink;   /**< Downlink commands decoded, posted and rejected */
+    uint32_t drHintsApplied;     /**< DR hints applied (ignored while network ADR is on) */
+    LwnodeMailboxStats mailbox;  /**< Driver operations submitted by other tasks */
+} LorawanStats;
+
+/**
+ * @brief Start the LoRaWAN uplink task
+ *
+ * The device must already be initialized; the task becomes its only user.
+ * If the module is not ready yet (lwnode_begin_bounded() failed or was not
+ * called), the task keeps retrying the bring-up in the background with a
+ * backing-off interval. It then joins the network unless lwnode_begin()
+ * resumed a session, and re-joins with backoff whenever the session is
+ * lost. Uplinks queued meanwhile wait in the queue.
+ *
+ * @param device Pointer to LWNode device instance
+ * @return true if the task was started, false on invalid parameter or if
+ *         already running
+ */
+bool lorawan_start( LwnodeDevice * device );
+
+/**
+ * @brief Queue an alarm uplink
+ *
+ * Alarms are transmitted before any telemetry and evict the oldest
+ * telemetry frame when the queue is full, single frames before packed
+ * batches; an evicted batch is journaled for replay. Each alarm is sent as a
+ * confirmed uplink. A send the radio rejects is retried ahead of newer
+ * frames, up to four attempts. The DFR1115 reports no ACK flag, so a
+ * downlink after the send counts as the acknowledgement and an alarm
+ * without one is counted as unverified rather than resent. The call does
+ * not wait; outcomes are counted in LorawanStats.confirm.
+ *
+ * @param data Payload bytes (copied)
+ * @param len Payload length (1-128 bytes)
+ * @return UPLINK_QUEUE_OK, or FULL/INVALID if the frame was dropped
+ */
+UplinkQueueStatus lorawan_send_alarm( const uint8_t * data, uint8_t len );
+
+/**
+ * @brief Queue a telemetry uplink
+ *
+ * A pending frame of the same stream is replaced by the new sample. A
+ * frame the radio rejects is retried ahead of newer frames, up to four
+ * attempts.
+ *
+ * @param streamId Telemetry stream identifier
+ * @param data Payload bytes (copied)
+ * @param len Payload length (1-128 bytes)
+ * @return UPLINK_QUEUE_OK or COALESCED, or FULL/INVALID if dropped
+ */
+UplinkQueueStatus lorawan_send_telemetry( uint8_t streamId,
+                                          const uint8_t * data,
+                                          uint8_t len );
+
+/**
+ * @brief Queue one telemetry record for packed transmission
+ *
+ * Records are buffered and sent together, oldest first, as one telemetry
+ * uplink once as many as the current data rate allows are buffered or the
+ * oldest has waited for the packing deadline. The records follow a 3-byte
+ * batch header carrying the age of the newest record, or the journal
+ * sequence of the oldest one for a replayed batch (see
+ * docs/lorawan/uplink-payload-v1.md §7).
+ *
+ * @param record UPLINK_PACKER_RECORD_SIZE bytes (copied)
+ * @return UPLINK_QUEUE_OK if buffered or journaled, FULL if the packer is
+ *         full and the journal cannot take the record, INVALID on invalid
+ *         parameter or task not started
+ */
+UplinkQueueStatus lorawan_send_record( const uint8_t * record );
+
+/**
+ * @brief Set how long a packed record may wait before it is sent
+ *
+ * @param deadlineMs Latency deadline in milliseconds
+ * @return true if set, false if the task is not started
+ */
+bool lorawan_set_pack_deadline( uint32_t deadlineMs );
+
+/**
+ * @brief Register the task that handles a downlink command
+ *
+ * Downlink payloads are decoded in the LoRaWAN task and each command is
+ * posted to the route of its opcode, typically a wrapper around
+ * xQueueSend() with a zero timeout on the owner's queue. The callback runs
+ * in the LoRaWAN task with its lock held and must not block. DR_HINT is
+ * routed to the LoRaWAN task itself.
+ *
+ * @param opcode Command opcode
+ * @param post Callback, NULL to remove the route
+ * @param ctx Context passed to the callback
+ * @return true if registered, false on invalid opcode or task not started
+ */
+bool lorawan_route_downlink( DownlinkCmdOpcode opcode,
+                             DownlinkCmdPostFn post,
+                             void * ctx );
+
+/**
+ * @brief Submit a driver operation from any task
+ *
+ * The LoRaWAN task owns the device; other tasks hand it settings and join
+ * requests through a lock-free mailbox and never wait for the radio. The
+ * task executes them in submission order while the module is idle and
+ * calls the request's completion callback from its own context. The
+ * mailbox carries no uplinks: they go through lorawan_send_*() so they are
+ * prioritized and airtime-budgeted.
+ *
+ * @param req Request (copied)
+ * @return true if queued, false if the mailbox is full, the request is
+ *         invalid, or the task is not started
+ */
+bool lorawan_submit( const LwnodeMailboxReq * req );
+
+/**
+ * @brief Get uplink task counters
+ *
+ * @param out Output counters
+ * @return true if copied, false on invalid parameter or task not started
+ */
+bool lorawan_get_stats( LorawanStats * out );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_MODULES_LORAWAN_LORAWAN_H */
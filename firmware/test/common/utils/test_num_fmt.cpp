@@ -39,6 +39,27 @@ TEST( NumFmtHexEncode, MultipleBytes )
     EXPECT_STREQ( out, "0001ABFF" );
 }
 
+TEST( NumFmtHexDecode, MixedCaseRoundTrip )
+{
+    uint8_t out[ 4 ] = {};
+    char hex[ 9 ];
+
+    EXPECT_TRUE( num_fmt_hex_decode( "00a1Bcff", 8U, out, sizeof( out ) ) );
+    EXPECT_EQ( out[ 1 ], 0xA1U );
+    EXPECT_EQ( out[ 2 ], 0xBCU );
+    EXPECT_TRUE( num_fmt_hex_encode( out, sizeof( out ), hex, sizeof( hex ) ) );
+    EXPECT_STREQ( hex, "00A1BCFF" );
+}
+
+TEST( NumFmtHexDecode, RejectsBadInput )
+{
+    uint8_t out[ 2 ] = {};
+
+    EXPECT_FALSE( num_fmt_hex_decode( "12G4", 4U, out, sizeof( out ) ) );
+    EXPECT_FALSE( num_fmt_hex_decode( "123", 3U, out, sizeof( out ) ) );
+    EXPECT_FALSE( num_fmt_hex_decode( nullptr, 4U, out, sizeof( out ) ) );
+}
+
 TEST( NumFmtU32ToA, Zero )
 {
     char out[ 2 ];
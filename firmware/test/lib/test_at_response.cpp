@@ -0,0 +1,174 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "lib/at_response.h"
+
+class AtResponseTest : public ::testing::Test
+{
+protected:
+    std::string reply;
+    std::vector<AtResponseLine> lines;
+
+    void tokenize( const std::string & bytes )
+    {
+        AtResponseTokenizer tok;
+        AtResponseLine line;
+
+        reply = bytes;
+        lines.clear();
+        ASSERT_TRUE( at_response_init( &tok,
+                                       reinterpret_cast<const uint8_t *>( reply.data() ),
+                                       static_cast<uint16_t>( reply.size() ) ) );
+
+        while( at_response_next( &tok, &line ) )
+        {
+            lines.push_back( line );
+        }
+    }
+
+    std::string text( size_t i )
+    {
+        return std::string( reinterpret_cast<const char *>( lines[ i ].data ), lines[ i ].len );
+    }
+
+    static std::string recv_frame( const std::string & payload, uint8_t negRssi, uint8_t snrRaw )
+    {
+        std::string frame = "+RECV=";
+
+        frame.push_back( static_cast<char>( negRssi ) );
+        frame.push_back( static_cast<char>( snrRaw ) );
+        frame.push_back( static_cast<char>( payload.size() ) );
+
+        return frame + payload;
+    }
+};
+
+TEST_F( AtResponseTest, SplitsLinesAndSkipsEmptyOnes )
+{
+    tokenize( "\r\n+JOIN=1\r\n\r\nOK\r\n" );
+
+    ASSERT_EQ( lines.size(), 2U );
+    EXPECT_EQ( text( 0 ), "+JOIN=1" );
+    EXPECT_EQ( lines[ 0 ].kind, AT_RESPONSE_INFO );
+    EXPECT_EQ( lines[ 0 ].offset, 2U );
+    EXPECT_EQ( lines[ 0 ].span, 9U );
+    EXPECT_EQ( text( 1 ), "OK" );
+    EXPECT_EQ( lines[ 1 ].kind, AT_RESPONSE_OK );
+}
+
+TEST_F( AtResponseTest, ClassifiesFinalResultCodes )
+{
+    tokenize( "+SEND=OK\r\nERROR\r\n+JOIN=FAIL\r\n+SEND=ERROR\r\n+DATARATE=3\r\nOKAY\r\n" );
+
+    ASSERT_EQ( lines.size(), 6U );
+    EXPECT_EQ( lines[ 0 ].kind, AT_RESPONSE_OK );
+    EXPECT_EQ( lines[ 1 ].kind, AT_RESPONSE_ERROR );
+    EXPECT_EQ( lines[ 2 ].kind, AT_RESPONSE_ERROR );
+    EXPECT_EQ( lines[ 3 ].kind, AT_RESPONSE_ERROR );
+    EXPECT_EQ( lines[ 4 ].kind, AT_RESPONSE_INFO );
+    EXPECT_EQ( lines[ 5 ].kind, AT_RESPONSE_INFO );
+}
+
+TEST_F( AtResponseTest, AcceptsBareLineFeedAndMissingTerminator )
+{
+    tokenize( "+JOIN=0\nOK" );
+
+    ASSERT_EQ( lines.size(), 2U );
+    EXPECT_EQ( text( 0 ), "+JOIN=0" );
+    EXPECT_EQ( text( 1 ), "OK" );
+    EXPECT_EQ( lines[ 1 ].span, 2U );
+}
+
+TEST_F( AtResponseTest, RecvFrameIsDelimitedByLength )
+{
+    /* Payload holds CR LF bytes that must not split the frame */
+    const std::string frame = recv_frame( std::string( "\r\nA\n", 4U ), 87U, 57U );
+
+    tokenize( frame + "\r\n+SEND=OK\r\n" );
+
+    ASSERT_EQ( lines.size(), 2U );
+    EXPECT_EQ( lines[ 0 ].kind, AT_RESPONSE_URC );
+    EXPECT_EQ( lines[ 0 ].len, frame.size() );
+    EXPECT_EQ( lines[ 0 ].span, frame.size() + 2U );
+    EXPECT_EQ( text( 1 ), "+SEND=OK" );
+    EXPECT_EQ( lines[ 1 ].kind, AT_RESPONSE_OK );
+}
+
+TEST_F( AtResponseTest, RecvCommandRepliesAreText )
+{
+    tokenize( "+RECV=OK\r\n+RECV=1\r\n+RECV=ERROR" );
+
+    ASSERT_EQ( lines.size(), 3U );
+    EXPECT_EQ( lines[ 0 ].kind, AT_RESPONSE_OK );
+    EXPECT_EQ( lines[ 1 ].kind, AT_RESPONSE_INFO );
+    EXPECT_EQ( lines[ 2 ].kind, AT_RESPONSE_ERROR );
+}
+
+TEST_F( AtResponseTest, BackToBackRecvFramesWithoutTerminator )
+{
+    tokenize( recv_frame( "ab", 90U, 50U ) + recv_frame( "c", 91U, 48U ) + "OK\r\n" );
+
+    ASSERT_EQ( lines.size(), 3U );
+    EXPECT_EQ( lines[ 0 ].kind, AT_RESPONSE_URC );
+    EXPECT_EQ( lines[ 0 ].len, 11U );
+    EXPECT_EQ( lines[ 1 ].kind, AT_RESPONSE_URC );
+    EXPECT_EQ( lines[ 1 ].offset, 11U );
+    EXPECT_EQ( lines[ 2 ].kind, AT_RESPONSE_OK );
+}
+
+TEST_F( AtResponseTest, TruncatedRecvFrameConsumesTheRest )
+{
+    tokenize( std::string( "+RECV=\x57\x39\x08" "ab", 11U ) );
+
+    ASSERT_EQ( lines.size(), 1U );
+    EXPECT_EQ( lines[ 0 ].kind, AT_RESPONSE_URC );
+    EXPECT_EQ( lines[ 0 ].len, 11U );
+}
+
+TEST_F( AtResponseTest, LineEqualsIgnoresExpectedTerminator )
+{
+    tokenize( "+JOIN=OK\r\n" );
+
+    ASSERT_EQ( lines.size(), 1U );
+    EXPECT_TRUE( at_response_line_equals( &lines[ 0 ], "+JOIN=OK\r\n" ) );
+    EXPECT_TRUE( at_response_line_equals( &lines[ 0 ], "+JOIN=OK" ) );
+    EXPECT_FALSE( at_response_line_equals( &lines[ 0 ], "+JOIN=O" ) );
+    EXPECT_FALSE( at_response_line_equals( &lines[ 0 ], nullptr ) );
+}
+
+TEST_F( AtResponseTest, ContainsSkipsExtraLinesAndUrcs )
+{
+    const std::string withUrc = recv_frame( "+SEND=OK", 80U, 55U ) + "\r\n";
+    const std::string multi = "+LORAMODE=LORAWAN\r\n+SEND=OK\r\n";
+
+    /* The expected text inside a frame payload does not count */
+    EXPECT_FALSE( at_response_contains( reinterpret_cast<const uint8_t *>( withUrc.data() ),
+                                        static_cast<uint16_t>( withUrc.size() ),
+                                        "+SEND=OK\r\n" ) );
+    EXPECT_TRUE( at_response_contains( reinterpret_cast<const uint8_t *>( multi.data() ),
+                                       static_cast<uint16_t>( multi.size() ),
+                                       "+SEND=OK\r\n" ) );
+    EXPECT_FALSE( at_response_contains( reinterpret_cast<const uint8_t *>( multi.data() ),
+                                        static_cast<uint16_t>( multi.size() ),
+                                        "OK\r\n" ) );
+    EXPECT_FALSE( at_response_contains( nullptr, 0U, "OK\r\n" ) );
+}
+
+TEST_F( AtResponseTest, CompleteLenStopsAtPartialToken )
+{
+    const std::string frame = recv_frame( "xy\n", 85U, 52U );
+    const std::string stream = "+JOIN=OK\r\n" + frame + "\r\n+SEND=O";
+    const uint8_t * const bytes = reinterpret_cast<const uint8_t *>( stream.data() );
+
+    /* Partial line, partial frame header, partial payload */
+    EXPECT_EQ( at_response_complete_len( bytes, 5U ), 0U );
+    EXPECT_EQ( at_response_complete_len( bytes, 14U ), 10U );
+    EXPECT_EQ( at_response_complete_len( bytes, static_cast<uint16_t>( 10U + frame.size() - 1U ) ), 10U );
+
+    /* Whole frame and its terminator; the trailing result is still in flight */
+    EXPECT_EQ( at_response_complete_len( bytes, static_cast<uint16_t>( stream.size() ) ),
+               10U + frame.size() + 2U );
+    EXPECT_EQ( at_response_complete_len( nullptr, 4U ), 0U );
+}
@@ -0,0 +1,170 @@
+#include <cstdint>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "lib/downlink_cmd.h"
+
+namespace
+{
+
+struct Inbox
+{
+    std::vector<DownlinkCmdEvent> events;
+    bool full = false;
+};
+
+bool inbox_post( void * ctx, const DownlinkCmdEvent * event )
+{
+    Inbox * inbox = static_cast<Inbox *>( ctx );
+
+    if( inbox->full )
+    {
+        return false;
+    }
+
+    inbox->events.push_back( *event );
+    return true;
+}
+
+}
+
+class DownlinkCmdTest : public ::testing::Test
+{
+protected:
+    DownlinkCmdDispatcher dispatcher;
+    Inbox lights;
+    Inbox radio;
+    Inbox system;
+
+    void SetUp() override
+    {
+        ASSERT_TRUE( downlink_cmd_init( &dispatcher ) );
+        ASSERT_TRUE( downlink_cmd_route( &dispatcher, DOWNLINK_CMD_SET_LIGHT_LEVEL, inbox_post, &lights ) );
+        ASSERT_TRUE( downlink_cmd_route( &dispatcher, DOWNLINK_CMD_SET_THRESHOLDS, inbox_post, &lights ) );
+        ASSERT_TRUE( downlink_cmd_route( &dispatcher, DOWNLINK_CMD_SET_SAMPLE_PERIOD, inbox_post, &lights ) );
+        ASSERT_TRUE( downlink_cmd_route( &dispatcher, DOWNLINK_CMD_SET_UPLINK_PERIOD, inbox_post, &radio ) );
+        ASSERT_TRUE( downlink_cmd_route( &dispatcher, DOWNLINK_CMD_DR_HINT, inbox_post, &radio ) );
+        ASSERT_TRUE( downlink_cmd_route( &dispatcher, DOWNLINK_CMD_REBOOT, inbox_post, &system ) );
+    }
+
+    DownlinkCmdStats stats()
+    {
+        DownlinkCmdStats out;
+        EXPECT_TRUE( downlink_cmd_get_stats( &dispatcher, &out ) );
+        return out;
+    }
+};
+
+TEST_F( DownlinkCmdTest, RejectsInvalidArguments )
+{
+    const uint8_t payload[] = { 0x06U, 0x00U };
+
+    EXPECT_FALSE( downlink_cmd_init( nullptr ) );
+    EXPECT_FALSE( downlink_cmd_route( nullptr, DOWNLINK_CMD_REBOOT, inbox_post, &system ) );
+    EXPECT_FALSE( downlink_cmd_route( &dispatcher, DOWNLINK_CMD_NONE, inbox_post, &system ) );
+    EXPECT_FALSE( downlink_cmd_route( &dispatcher, DOWNLINK_CMD_OPCODE_COUNT, inbox_post, &system ) );
+    EXPECT_EQ( downlink_cmd_dispatch( nullptr, payload, sizeof( payload ) ), 0U );
+    EXPECT_EQ( downlink_cmd_dispatch( &dispatcher, nullptr, sizeof( payload ) ), 0U );
+    EXPECT_EQ( downlink_cmd_dispatch( &dispatcher, payload, 0U ), 0U );
+    EXPECT_EQ( stats().frames, 0U );
+}
+
+TEST_F( DownlinkCmdTest, DecodesEveryOpcodeToItsRoute )
+{
+    const uint8_t payload[] = {
+        0x01U, 0x01U, 0x4BU,
+        0x02U, 0x04U, 0x01U, 0xF4U, 0x03U, 0xE8U,
+        0x03U, 0x02U, 0x00U, 0x3CU,
+        0x04U, 0x02U, 0x03U, 0x84U,
+        0x05U, 0x02U, 0x05U, 0x0EU,
+        0x06U, 0x00U,
+    };
+
+    EXPECT_EQ( downlink_cmd_dispatch( &dispatcher, payload, sizeof( payload ) ), 6U );
+
+    ASSERT_EQ( lights.events.size(), 3U );
+    EXPECT_EQ( lights.events[ 0 ].opcode, DOWNLINK_CMD_SET_LIGHT_LEVEL );
+    EXPECT_EQ( lights.events[ 0 ].lightLevel, 75U );
+    EXPECT_EQ( lights.events[ 1 ].opcode, DOWNLINK_CMD_SET_THRESHOLDS );
+    EXPECT_EQ( lights.events[ 1 ].luxOnX10, 500U );
+    EXPECT_EQ( lights.events[ 1 ].luxOffX10, 1000U );
+    EXPECT_EQ( lights.events[ 2 ].opcode, DOWNLINK_CMD_SET_SAMPLE_PERIOD );
+    EXPECT_EQ( lights.events[ 2 ].periodS, 60U );
+
+    ASSERT_EQ( radio.events.size(), 2U );
+    EXPECT_EQ( radio.events[ 0 ].opcode, DOWNLINK_CMD_SET_UPLINK_PERIOD );
+    EXPECT_EQ( radio.events[ 0 ].periodS, 900U );
+    EXPECT_EQ( radio.events[ 1 ].opcode, DOWNLINK_CMD_DR_HINT );
+    EXPECT_EQ( radio.events[ 1 ].dataRate, 5U );
+    EXPECT_EQ( radio.events[ 1 ].eirp, 14U );
+
+    ASSERT_EQ( system.events.size(), 1U );
+    EXPECT_EQ( system.events[ 0 ].opcode, DOWNLINK_CMD_REBOOT );
+
+    DownlinkCmdStats s = stats();
+    EXPECT_EQ( s.frames, 1U );
+    EXPECT_EQ( s.posted, 6U );
+}
+
+TEST_F( DownlinkCmdTest, SkipsUnknownOpcodesByLength )
+{
+    const uint8_t payload[] = {
+        0x7FU, 0x03U, 0x01U, 0x06U, 0x00U,
+        0x00U, 0x00U,
+        0x01U, 0x01U, 0x0AU,
+    };
+
+    EXPECT_EQ( downlink_cmd_dispatch( &dispatcher, payload, sizeof( payload ) ), 1U );
+    ASSERT_EQ( lights.events.size(), 1U );
+    EXPECT_EQ( lights.events[ 0 ].lightLevel, 10U );
+    EXPECT_TRUE( system.events.empty() );
+    EXPECT_EQ( stats().unknown, 2U );
+}
+
+TEST_F( DownlinkCmdTest, RejectsBadLengthsAndValues )
+{
+    const uint8_t payload[] = {
+        0x01U, 0x01U, 0x65U,                            /* level 101 */
+        0x01U, 0x02U, 0x00U, 0x32U,                     /* wrong length */
+        0x02U, 0x04U, 0x03U, 0xE8U, 0x01U, 0xF4U,       /* on above off */
+        0x03U, 0x02U, 0x00U, 0x00U,                     /* zero period */
+        0x05U, 0x02U, 0x10U, 0x00U,                     /* DR 16 */
+        0x06U, 0x00U,
+    };
+
+    EXPECT_EQ( downlink_cmd_dispatch( &dispatcher, payload, sizeof( payload ) ), 1U );
+    EXPECT_TRUE( lights.events.empty() );
+    EXPECT_TRUE( radio.events.empty() );
+    EXPECT_EQ( system.events.size(), 1U );
+    EXPECT_EQ( stats().invalid, 5U );
+}
+
+TEST_F( DownlinkCmdTest, StopsAtTruncatedCommand )
+{
+    const uint8_t payload[] = { 0x01U, 0x01U, 0x32U, 0x02U, 0x04U, 0x00U, 0x10U };
+
+    EXPECT_EQ( downlink_cmd_dispatch( &dispatcher, payload, sizeof( payload ) ), 1U );
+    EXPECT_EQ( lights.events.size(), 1U );
+
+    const uint8_t header[] = { 0x06U };
+    EXPECT_EQ( downlink_cmd_dispatch( &dispatcher, header, sizeof( header ) ), 0U );
+
+    DownlinkCmdStats s = stats();
+    EXPECT_EQ( s.frames, 2U );
+    EXPECT_EQ( s.truncated, 2U );
+}
+
+TEST_F( DownlinkCmdTest, CountsUnroutedAndDroppedEvents )
+{
+    const uint8_t payload[] = { 0x06U, 0x00U, 0x05U, 0x02U, 0x03U, 0x00U };
+
+    ASSERT_TRUE( downlink_cmd_route( &dispatcher, DOWNLINK_CMD_REBOOT, nullptr, &system ) );
+    radio.full = true;
+
+    EXPECT_EQ( downlink_cmd_dispatch( &dispatcher, payload, sizeof( payload ) ), 0U );
+
+    DownlinkCmdStats s = stats();
+    EXPECT_EQ( s.unrouted, 1U );
+    EXPECT_EQ( s.dropped, 1U );
+    EXPECT_EQ( s.posted, 0U );
+}
@@ -0,0 +1,145 @@
+#include <cstdint>
+#include <gtest/gtest.h>
+
+#include "lib/link_quality.h"
+
+class LinkQualityTest : public ::testing::Test
+{
+protected:
+    LinkQuality lq;
+    LinkQualityLimits limits = { 0U, 5U, 2U, 16U, 10U };
+    LinkQualityAdvice advice;
+
+    void SetUp() override
+    {
+        ASSERT_TRUE( link_quality_init( &lq ) );
+    }
+
+    void fill( int8_t snr, uint8_t n = LINK_QUALITY_WINDOW )
+    {
+        for( uint8_t i = 0U; i < n; ++i )
+        {
+            ASSERT_TRUE( link_quality_add( &lq, -100, snr ) );
+        }
+    }
+};
+
+TEST_F( LinkQualityTest, EmptyWindowHasNoStatistics )
+{
+    LinkQualitySummary summary;
+    int8_t snr = 0;
+
+    EXPECT_FALSE( link_quality_percentile( &lq, 50U, nullptr, &snr ) );
+    EXPECT_FALSE( link_quality_summary( &lq, &summary ) );
+    EXPECT_EQ( link_quality_snr_trend_x10( &lq ), 0 );
+}
+
+TEST_F( LinkQualityTest, PercentilesUseNearestRank )
+{
+    for( int8_t i = 1; i <= 11; ++i )
+    {
+        ASSERT_TRUE( link_quality_add( &lq, ( int8_t ) ( -120 + i ), ( int8_t ) ( 11 - i ) ) );
+    }
+
+    LinkQualitySummary summary;
+    ASSERT_TRUE( link_quality_summary( &lq, &summary ) );
+    EXPECT_EQ( summary.count, 11U );
+    EXPECT_EQ( summary.rssiP10, -118 );
+    EXPECT_EQ( summary.rssiP50, -114 );
+    EXPECT_EQ( summary.rssiP90, -110 );
+    EXPECT_EQ( summary.snrP10, 1 );
+    EXPECT_EQ( summary.snrP50, 5 );
+    EXPECT_EQ( summary.snrP90, 9 );
+    /* SNR falls 1 dB per sample */
+    EXPECT_EQ( summary.snrTrendX10, -10 );
+}
+
+TEST_F( LinkQualityTest, WindowDropsOldestSamples )
+{
+    fill( -20 );
+    fill( 5 );
+
+    int8_t snr = 0;
+    ASSERT_TRUE( link_quality_percentile( &lq, 0U, nullptr, &snr ) );
+    EXPECT_EQ( snr, 5 );
+    EXPECT_EQ( link_quality_snr_trend_x10( &lq ), 0 );
+}
+
+TEST_F( LinkQualityTest, NoAdviceUntilEnoughSamples )
+{
+    fill( 10, LINK_QUALITY_MIN_SAMPLES - 1U );
+    EXPECT_FALSE( link_quality_advise( &lq, &limits, 0U, 12U, 16U, &advice ) );
+
+    fill( 10, 1U );
+    EXPECT_TRUE( link_quality_advise( &lq, &limits, 0U, 12U, 16U, &advice ) );
+}
+
+TEST_F( LinkQualityTest, StrongLinkStepsToFasterDataRate )
+{
+    /* SF12 floor -20 dB, 10 dB margin: 0 dB leaves 10 dB spare */
+    fill( 0 );
+
+    ASSERT_TRUE( link_quality_advise( &lq, &limits, 0U, 12U, 16U, &advice ) );
+    EXPECT_EQ( advice.action, LINK_QUALITY_FASTER_DR );
+    EXPECT_EQ( advice.dataRate, 1U );
+    EXPECT_EQ( advice.eirp, 16U );
+    EXPECT_EQ( advice.marginX10, 100 );
+}
+
+TEST_F( LinkQualityTest, StrongLinkAtFastestDataRateLowersPower )
+{
+    /* SF7 floor -7.5 dB, 10 dB margin: 10 dB leaves 7.5 dB spare */
+    fill( 10 );
+
+    ASSERT_TRUE( link_quality_advise( &lq, &limits, 5U, 7U, 16U, &advice ) );
+    EXPECT_EQ( advice.action, LINK_QUALITY_LOWER_EIRP );
+    EXPECT_EQ( advice.eirp, 14U );
+
+    ASSERT_TRUE( link_quality_advise( &lq, &limits, 5U, 7U, 3U, &advice ) );
+    EXPECT_EQ( advice.action, LINK_QUALITY_HOLD );
+}
+
+TEST_F( LinkQualityTest, MarginalLinkRaisesPowerThenSlowsDown )
+{
+    /* SF9 floor -12.5 dB, 10 dB margin: -5 dB is 2.5 dB short */
+    fill( -5 );
+
+    ASSERT_TRUE( link_quality_advise( &lq, &limits, 3U, 9U, 15U, &advice ) );
+    EXPECT_EQ( advice.action, LINK_QUALITY_RAISE_EIRP );
+    EXPECT_EQ( advice.eirp, 16U );
+
+    ASSERT_TRUE( link_quality_advise( &lq, &limits, 3U, 9U, 16U, &advice ) );
+    EXPECT_EQ( advice.action, LINK_QUALITY_SLOWER_DR );
+    EXPECT_EQ( advice.dataRate, 2U );
+}
+
+TEST_F( LinkQualityTest, LowPercentileKeepsMarginalPoleConservative )
+{
+    /* Mostly strong, but the 10th percentile fade decides */
+    fill( 0, 13U );
+    fill( -12, 3U );
+
+    ASSERT_TRUE( link_quality_advise( &lq, &limits, 2U, 10U, 16U, &advice ) );
+    EXPECT_EQ( advice.action, LINK_QUALITY_SLOWER_DR );
+}
+
+TEST_F( LinkQualityTest, FallingTrendHoldsDataRate )
+{
+    for( uint8_t i = 0U; i < LINK_QUALITY_WINDOW; ++i )
+    {
+        ASSERT_TRUE( link_quality_add( &lq, -100, ( int8_t ) ( 15 - i ) ) );
+    }
+
+    ASSERT_LT( link_quality_snr_trend_x10( &lq ), LINK_QUALITY_FALLING_TREND_X10 );
+    ASSERT_TRUE( link_quality_advise( &lq, &limits, 0U, 12U, 16U, &advice ) );
+    EXPECT_EQ( advice.action, LINK_QUALITY_HOLD );
+}
+
+TEST_F( LinkQualityTest, RejectsInvalidSpreadingFactor )
+{
+    fill( 0 );
+
+    EXPECT_FALSE( link_quality_advise( &lq, &limits, 0U, 6U, 16U, &advice ) );
+    EXPECT_FALSE( link_quality_advise( &lq, &limits, 0U, 13U, 16U, &advice ) );
+    EXPECT_FALSE( link_quality_advise( &lq, nullptr, 0U, 12U, 16U, &advice ) );
+}
@@ -0,0 +1,120 @@
+#include <cstdint>
+#include <gtest/gtest.h>
+
+#include "lib/lora_airtime.h"
+
+class LoraAirtimeTest : public ::testing::Test
+{
+protected:
+    LoraAirtimeBudget budget;
+};
+
+TEST_F( LoraAirtimeTest, DrLookupRejectsUnknownDataRate )
+{
+    LoraDrParams params;
+
+    EXPECT_FALSE( lora_airtime_dr_params( LWNODE_REGION_EU868, 7U, &params ) );
+    EXPECT_FALSE( lora_airtime_dr_params( LWNODE_REGION_US915, 5U, &params ) );
+    EXPECT_FALSE( lora_airtime_dr_params( LWNODE_REGION_EU868, 0U, nullptr ) );
+}
+
+TEST_F( LoraAirtimeTest, DrLookupReturnsRegionParameters )
+{
+    LoraDrParams params;
+
+    ASSERT_TRUE( lora_airtime_dr_params( LWNODE_REGION_EU868, 0U, &params ) );
+    EXPECT_EQ( params.sf, 12U );
+    EXPECT_EQ( params.bwHz, 125000U );
+
+    ASSERT_TRUE( lora_airtime_dr_params( LWNODE_REGION_US915, 4U, &params ) );
+    EXPECT_EQ( params.sf, 8U );
+    EXPECT_EQ( params.bwHz, 500000U );
+}
+
+TEST_F( LoraAirtimeTest, UplinkAirtimeMatchesReferenceValues )
+{
+    /* 10-byte payload, 23-byte PHY payload */
+    EXPECT_EQ( lora_airtime_uplink_us( LWNODE_REGION_EU868, 5U, 10U ), 61696U );
+    EXPECT_EQ( lora_airtime_uplink_us( LWNODE_REGION_EU868, 0U, 10U ), 1482752U );
+}
+
+TEST_F( LoraAirtimeTest, UplinkAirtimeUnknownDrIsZero )
+{
+    EXPECT_EQ( lora_airtime_uplink_us( LWNODE_REGION_US915, 9U, 10U ), 0U );
+}
+
+TEST_F( LoraAirtimeTest, Us915DwellTimeRejectsLongFrames )
+{
+    ASSERT_TRUE( lora_airtime_budget_init( &budget, LWNODE_REGION_US915, 0U, 0U ) );
+
+    /* DR0 max payload is 11 bytes: the 12-byte frame breaks 400 ms */
+    const uint32_t fits = lora_airtime_uplink_us( LWNODE_REGION_US915, 0U, 11U );
+    const uint32_t tooLong = lora_airtime_uplink_us( LWNODE_REGION_US915, 0U, 12U );
+
+    EXPECT_EQ( lora_airtime_budget_check( &budget, fits, 0U, nullptr ), LORA_AIRTIME_OK );
+    EXPECT_EQ( lora_airtime_budget_check( &budget, tooLong, 0U, nullptr ), LORA_AIRTIME_DWELL );
+}
+
+TEST_F( LoraAirtimeTest, Eu868DutyCycleDefersUntilRefilled )
+{
+    ASSERT_TRUE( lora_airtime_budget_init( &budget, LWNODE_REGION_EU868, 0U, 0U ) );
+    EXPECT_EQ( lora_airtime_budget_remaining_ms( &budget, 0U ), 36000U );
+
+    /* Drain the hourly 36 s allowance */
+    lora_airtime_budget_consume( &budget, 36000000U, 0U );
+    EXPECT_EQ( lora_airtime_budget_remaining_ms( &budget, 0U ), 0U );
+
+    uint32_t waitMs = 0U;
+    EXPECT_EQ( lora_airtime_budget_check( &budget, 61696U, 0U, &waitMs ),
+               LORA_AIRTIME_WAIT );
+    /* 1 % duty cycle: 100x the airtime */
+    EXPECT_EQ( waitMs, 6170U );
+
+    EXPECT_EQ( lora_airtime_budget_check( &budget, 61696U, waitMs - 1U, nullptr ),
+               LORA_AIRTIME_WAIT );
+    EXPECT_EQ( lora_airtime_budget_check( &budget, 61696U, waitMs, nullptr ),
+               LORA_AIRTIME_OK );
+}
+
+TEST_F( LoraAirtimeTest, FairUseRefillsSlowRatesExactly )
+{
+    ASSERT_TRUE( lora_airtime_budget_init( &budget, LWNODE_REGION_CN470, 30000U, 0U ) );
+
+    lora_airtime_budget_consume( &budget, 30000000U, 0U );
+
+    /* 30 s per day accrues 1 ms of airtime every 2880 ms, in small steps */
+    for( uint32_t t = 0U; t <= 2880U; t += 10U )
+    {
+        ( void ) lora_airtime_budget_remaining_ms( &budget, t );
+    }
+
+    EXPECT_EQ( lora_airtime_budget_remaining_ms( &budget, 2880U ), 1U );
+}
+
+TEST_F( LoraAirtimeTest, BudgetSurvivesTimerWrap )
+{
+    const uint32_t start = UINT32_MAX - 1000U;
+
+    ASSERT_TRUE( lora_airtime_budget_init( &budget, LWNODE_REGION_EU868, 0U, start ) );
+    lora_airtime_budget_consume( &budget, 36000000U, start );
+
+    /* 3600 ms after start, across the wrap: 36 ms accrued */
+    EXPECT_EQ( lora_airtime_budget_remaining_ms( &budget, start + 3600U ), 36U );
+}
+
+TEST_F( LoraAirtimeTest, FrameLargerThanWindowNeverFits )
+{
+    ASSERT_TRUE( lora_airtime_budget_init( &budget, LWNODE_REGION_CN470, 1U, 0U ) );
+
+    EXPECT_EQ( lora_airtime_budget_check( &budget, 61696U, 0U, nullptr ),
+               LORA_AIRTIME_DWELL );
+}
+
+TEST_F( LoraAirtimeTest, NoLimitsReportUnlimitedBudget )
+{
+    ASSERT_TRUE( lora_airtime_budget_init( &budget, LWNODE_REGION_CN470, 0U, 0U ) );
+
+    EXPECT_EQ( lora_airtime_budget_remaining_ms( &budget, 0U ), UINT32_MAX );
+    EXPECT_EQ( lora_airtime_budget_check( &budget, 1482752U, 0U, nullptr ),
+               LORA_AIRTIME_OK );
+}
@@ -0,0 +1,1071 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "hal/lwnode.h"
+#include "hal/lwnode_emulator.h"
+#include "lib/lwnode.h"
+#include "lib/lwnode_loopback.h"
+
+static std::vector<std::vector<uint8_t>> g_rxPayloads;
+static int8_t g_rxRssi = 0;
+static int8_t g_rxSnr = 0;
+
+static void on_rx( const uint8_t * payload, uint8_t payloadLen, int8_t rssi, int8_t snr )
+{
+    g_rxPayloads.emplace_back( payload, payload + payloadLen );
+    g_rxRssi = rssi;
+    g_rxSnr = snr;
+}
+
+struct AtDone
+{
+    uint32_t calls = 0U;
+    LwnodeAtStatus status = LWNODE_AT_STATUS_IDLE;
+    std::string ack;
+};
+
+static void on_at_done( LwnodeDevice * device, LwnodeAtStatus status, const char * ack, uint16_t ackLen, void * ctx )
+{
+    AtDone * const done = static_cast<AtDone *>( ctx );
+
+    ( void ) device;
+    done->calls++;
+    done->status = status;
+    done->ack.assign( ack, ackLen );
+}
+
+class LwnodeTest : public ::testing::Test
+{
+protected:
+    LwnodeHw hw;
+    LwnodeDevice device;
+
+    void SetUp() override
+    {
+        lwnode_emu_reset();
+        lwnode_hal_config_default( &hw );
+        g_rxPayloads.clear();
+        ASSERT_TRUE( lwnode_init( &device, &hw ) );
+        device.region = LWNODE_REGION_EU868;
+    }
+
+    /* Join and poll AT+JOIN? once a second, as the application does */
+    bool join_and_wait( uint32_t timeoutMs )
+    {
+        bool joined = lwnode_join( &device );
+        const uint32_t startMs = lwnode_emu_now_ms();
+
+        while( joined && !lwnode_is_joined( &device ) )
+        {
+            joined = ( ( lwnode_emu_now_ms() - startMs ) < timeoutMs );
+            lwnode_hal_delay_ms( 1000U );
+        }
+
+        return joined;
+    }
+
+    size_t count_commands( const std::string & prefix )
+    {
+        size_t n = 0U;
+
+        for( const std::string & cmd : lwnode_emu_commands() )
+        {
+            n += ( cmd.compare( 0U, prefix.size(), prefix ) == 0 ) ? 1U : 0U;
+        }
+
+        return n;
+    }
+
+    struct TransportLatency
+    {
+        uint32_t configMs;
+        uint32_t sendMs;
+    };
+
+    /* Joined session, then one setting and one uplink */
+    TransportLatency measure_transport()
+    {
+        const uint8_t payload[ 6 ] = { 0x04U, 0xD2U, 0x19U, 0x3CU, 0xBBU, 0x50U };
+        TransportLatency latency = {};
+
+        EXPECT_TRUE( lwnode_begin( &device ) );
+        EXPECT_TRUE( join_and_wait( 30000U ) );
+
+        uint32_t startMs = lwnode_emu_now_ms();
+        EXPECT_TRUE( lwnode_set_datarate( &device, 3U ) );
+        latency.configMs = lwnode_emu_now_ms() - startMs;
+
+        startMs = lwnode_emu_now_ms();
+        EXPECT_TRUE( lwnode_send_packet_bytes( &device, payload, sizeof( payload ) ) );
+        latency.sendMs = lwnode_emu_now_ms() - startMs;
+
+        return latency;
+    }
+};
+
+TEST_F( LwnodeTest, ColdBootConfiguresModule )
+{
+    ASSERT_TRUE( lwnode_begin( &device ) );
+
+    EXPECT_EQ( count_commands( "AT+REBOOT" ), 1U );
+    EXPECT_EQ( lwnode_emu_config( "LORAMODE" ), "LORAWAN" );
+    EXPECT_EQ( lwnode_emu_config( "JOINTYPE" ), "OTAA" );
+    EXPECT_TRUE( lwnode_is_ready( &device ) );
+}
+
+TEST_F( LwnodeTest, BenchmarkBootToJoined )
+{
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    const uint32_t readyMs = lwnode_emu_now_ms();
+
+    ASSERT_TRUE( join_and_wait( 30000U ) );
+    const uint32_t joinedMs = lwnode_emu_now_ms();
+
+    RecordProperty( "bootToReadyMs", static_cast<int>( readyMs ) );
+    RecordProperty( "bootToJoinedMs", static_cast<int>( joinedMs ) );
+
+    /* The first AT test lands inside the 300 ms reboot window and waits out
+     * one short-command timeout before the retry succeeds */
+    EXPECT_LT( readyMs, 2000U );
+    /* Join accept after 5 s, seen by the next 1 s query */
+    EXPECT_LT( joinedMs, readyMs + 7000U );
+}
+
+TEST_F( LwnodeTest, WarmBootSkipsRebootAndConfiguration )
+{
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    EXPECT_FALSE( lwnode_session_joined( &device ) );
+    ASSERT_TRUE( join_and_wait( 30000U ) );
+    EXPECT_TRUE( lwnode_session_joined( &device ) );
+    const size_t coldCommands = lwnode_emu_commands().size();
+    const uint32_t warmStartMs = lwnode_emu_now_ms();
+
+    /* MCU restarts, module keeps its session and settings */
+    ASSERT_TRUE( lwnode_init( &device, &hw ) );
+    ASSERT_TRUE( lwnode_begin( &device ) );
+
+    EXPECT_TRUE( lwnode_session_resumed( &device ) );
+    EXPECT_TRUE( lwnode_session_joined( &device ) );
+    EXPECT_EQ( count_commands( "AT+REBOOT" ), 1U );
+    /* AT+JOIN? probe and AT test only */
+    EXPECT_EQ( lwnode_emu_commands().size() - coldCommands, 2U );
+    EXPECT_LT( lwnode_emu_now_ms() - warmStartMs, 50U );
+}
+
+TEST_F( LwnodeTest, WarmBootFallsBackToColdWhenSessionIsGone )
+{
+    LwnodeJoinMetrics metrics;
+
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( join_and_wait( 30000U ) );
+
+    /* Warm boots are bounded, then the session is re-joined */
+    for( uint32_t boot = 0U; boot < LWNODE_SESSION_MAX_WARM_BOOTS; ++boot )
+    {
+        ASSERT_TRUE( lwnode_init( &device, &hw ) );
+        ASSERT_TRUE( lwnode_begin( &device ) );
+        ASSERT_TRUE( lwnode_session_resumed( &device ) );
+    }
+    ASSERT_TRUE( lwnode_init( &device, &hw ) );
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    EXPECT_FALSE( lwnode_session_resumed( &device ) );
+    EXPECT_EQ( count_commands( "AT+REBOOT" ), 2U );
+    ASSERT_TRUE( join_and_wait( 30000U ) );
+
+    /* Module lost power: AT+JOIN? says 0, so the MCU boots cold */
+    lwnode_emu_power_cycle();
+    ASSERT_TRUE( lwnode_init( &device, &hw ) );
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    EXPECT_FALSE( lwnode_session_resumed( &device ) );
+    EXPECT_FALSE( lwnode_session_joined( &device ) );
+    EXPECT_EQ( count_commands( "AT+REBOOT" ), 3U );
+    EXPECT_FALSE( lwnode_emu_joined() );
+
+    ASSERT_TRUE( lwnode_get_join_metrics( &device, &metrics ) );
+    EXPECT_FALSE( metrics.lastBootWarm );
+}
+
+TEST_F( LwnodeTest, WarmBootLimitIsJitteredPerDevice )
+{
+    const uint32_t limit = LWNODE_SESSION_MAX_WARM_BOOTS - 5U;
+    uint32_t warmBoots = 0U;
+
+    lwnode_emu_set_device_id( LWNODE_SESSION_WARM_BOOT_JITTER + 5U );
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( join_and_wait( 30000U ) );
+
+    do
+    {
+        ASSERT_LE( warmBoots, LWNODE_SESSION_MAX_WARM_BOOTS );
+        ASSERT_TRUE( lwnode_init( &device, &hw ) );
+        ASSERT_TRUE( lwnode_begin( &device ) );
+        warmBoots += lwnode_session_resumed( &device ) ? 1U : 0U;
+    } while( lwnode_session_resumed( &device ) );
+
+    EXPECT_EQ( warmBoots, limit );
+}
+
+TEST_F( LwnodeTest, BenchmarkUplinkLatency )
+{
+    const uint8_t payload[ 6 ] = { 0x04U, 0xD2U, 0x19U, 0x3CU, 0xBBU, 0x50U };
+
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( join_and_wait( 30000U ) );
+
+    const uint32_t startMs = lwnode_emu_now_ms();
+    ASSERT_TRUE( lwnode_send_packet_bytes( &device, payload, sizeof( payload ) ) );
+    const uint32_t uplinkMs = lwnode_emu_now_ms() - startMs;
+
+    RecordProperty( "uplinkMs", static_cast<int>( uplinkMs ) );
+
+    ASSERT_EQ( lwnode_emu_uplinks().size(), 1U );
+    EXPECT_EQ( lwnode_emu_uplinks()[ 0 ], std::vector<uint8_t>( payload, payload + sizeof( payload ) ) );
+    /* 60 ms on air, ACK seen within one 50 ms poll step */
+    EXPECT_GE( uplinkMs, 60U );
+    EXPECT_LT( uplinkMs, 120U );
+}
+
+TEST_F( LwnodeTest, MaxPayloadIsStreamedAsHexAcrossChunks )
+{
+    uint8_t payload[ LWNODE_MAX_LORA_PAYLOAD_BYTES ];
+
+    for( size_t i = 0U; i < sizeof( payload ); ++i )
+    {
+        payload[ i ] = static_cast<uint8_t>( ( i * 37U ) + 0x0FU );
+    }
+
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( join_and_wait( 30000U ) );
+
+    EXPECT_FALSE( lwnode_send_packet_bytes( &device, payload, 0U ) );
+    EXPECT_FALSE( lwnode_send_packet_bytes( &device, nullptr, 1U ) );
+
+    const uint32_t bytesBefore = lwnode_emu_stats().bytesWritten;
+    ASSERT_TRUE( lwnode_send_packet_bytes( &device, payload, sizeof( payload ) ) );
+
+    ASSERT_EQ( lwnode_emu_uplinks().size(), 1U );
+    EXPECT_EQ( lwnode_emu_uplinks()[ 0 ], std::vector<uint8_t>( payload, payload + sizeof( payload ) ) );
+    /* "AT+SEND=", two hex digits per byte and CRLF, nothing else */
+    EXPECT_EQ( lwnode_emu_stats().bytesWritten - bytesBefore, 8U + ( 2U * sizeof( payload ) ) + 2U );
+    const std::string & cmd = lwnode_emu_commands().back();
+    EXPECT_EQ( cmd.compare( 0U, 12U, "AT+SEND=0F34" ), 0 );
+    EXPECT_EQ( cmd.size(), 8U + ( 2U * sizeof( payload ) ) );
+}
+
+TEST_F( LwnodeTest, SleepDeliversQueuedDownlinksInOnePass )
+{
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( lwnode_set_rx_cb( &device, on_rx ) );
+
+    const uint32_t atMs = lwnode_emu_now_ms() + 200U;
+    lwnode_emu_queue_downlink( atMs, { 0x01U, 0x02U }, -87, 7 );
+    lwnode_emu_queue_downlink( atMs, { 0x03U }, -90, -3 );
+    lwnode_emu_queue_downlink( atMs, { 0x04U, 0x05U, 0x06U }, -95, -12 );
+
+    ( void ) lwnode_sleep_ms( &device, 2000U );
+
+    ASSERT_EQ( g_rxPayloads.size(), 3U );
+    EXPECT_EQ( g_rxPayloads[ 0 ], ( std::vector<uint8_t>{ 0x01U, 0x02U } ) );
+    EXPECT_EQ( g_rxPayloads[ 2 ], ( std::vector<uint8_t>{ 0x04U, 0x05U, 0x06U } ) );
+    EXPECT_EQ( g_rxRssi, -95 );
+    EXPECT_EQ( g_rxSnr, -12 );
+    EXPECT_EQ( lwnode_last_rssi( &device ), -95 );
+}
+
+TEST_F( LwnodeTest, DrainReadsQueueDepthOnce )
+{
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    EXPECT_EQ( lwnode_drain_rx( &device ), 0U );
+    ASSERT_TRUE( lwnode_set_rx_cb( &device, on_rx ) );
+
+    for( uint8_t i = 0U; i < 5U; ++i )
+    {
+        lwnode_emu_queue_downlink( lwnode_emu_now_ms(), { i, 0xEEU }, -90, 1 );
+    }
+    lwnode_hal_delay_ms( 10U );
+
+    const uint32_t readsBefore = lwnode_emu_stats().i2cReads;
+    const uint32_t startMs = lwnode_emu_now_ms();
+    EXPECT_EQ( lwnode_drain_rx( &device ), 5U );
+
+    ASSERT_EQ( g_rxPayloads.size(), 5U );
+    EXPECT_EQ( g_rxPayloads[ 4 ], ( std::vector<uint8_t>{ 4U, 0xEEU } ) );
+    /* Depth once, then length and data per frame, no settle delays */
+    EXPECT_EQ( lwnode_emu_stats().i2cReads - readsBefore, 1U + ( 5U * 2U ) );
+    EXPECT_LT( lwnode_emu_now_ms() - startMs, 10U );
+    EXPECT_EQ( lwnode_drain_rx( &device ), 0U );
+}
+
+TEST_F( LwnodeTest, BatchLeavesFrameThatDoesNotFitQueued )
+{
+    uint8_t buf[ 6 ] = { 0U };
+    LwnodeRxFrameInfo frames[ 4 ] = {};
+    LwnodeRxBatch batch = { buf, sizeof( buf ), frames, 4U, 0U, 0U };
+    LwnodeRxStats stats = {};
+
+    ASSERT_TRUE( lwnode_begin( &device ) );
+
+    const uint32_t atMs = lwnode_emu_now_ms();
+    lwnode_emu_queue_downlink( atMs, { 0x01U, 0x02U, 0x03U, 0x04U }, -80, 5 );
+    lwnode_emu_queue_downlink( atMs, { 0x05U, 0x06U, 0x07U, 0x08U }, -81, 4 );
+    lwnode_emu_queue_raw_downlink( atMs, "GARBAGE" );
+    lwnode_emu_queue_downlink( atMs, { 0x09U }, -82, 3 );
+    lwnode_hal_delay_ms( 100U );
+
+    /* The second frame would overflow buf: it must not be consumed */
+    ASSERT_TRUE( lwnode_read_data_batch( &device, &batch ) );
+    ASSERT_EQ( batch.frameCount, 1U );
+    EXPECT_EQ( batch.bufUsed, 4U );
+    EXPECT_EQ( buf[ 3 ], 0x04U );
+
+    /* Next read starts with it; the malformed frame is skipped and counted */
+    ASSERT_TRUE( lwnode_read_data_batch( &device, &batch ) );
+    ASSERT_EQ( batch.frameCount, 2U );
+    EXPECT_EQ( frames[ 0 ].len, 4U );
+    EXPECT_EQ( buf[ 0 ], 0x05U );
+    EXPECT_EQ( frames[ 0 ].rssi, -81 );
+    EXPECT_EQ( frames[ 1 ].len, 1U );
+    EXPECT_EQ( buf[ frames[ 1 ].offset ], 0x09U );
+
+    EXPECT_FALSE( lwnode_read_data_batch( &device, &batch ) );
+    ASSERT_TRUE( lwnode_get_rx_stats( &device, &stats ) );
+    EXPECT_EQ( stats.framesReceived, 4U );
+    EXPECT_EQ( stats.malformedFrames, 1U );
+}
+
+/* A bare ACK has no payload: counted as received, nothing to dispatch */
+TEST_F( LwnodeTest, EmptyDownlinkIsCountedButNotDispatched )
+{
+    LwnodeRxStats stats = {};
+
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( lwnode_set_rx_cb( &device, on_rx ) );
+
+    lwnode_emu_queue_downlink( lwnode_emu_now_ms() + 200U, {}, -88, 2 );
+    ( void ) lwnode_sleep_ms( &device, 2000U );
+
+    EXPECT_TRUE( g_rxPayloads.empty() );
+    ASSERT_TRUE( lwnode_get_rx_stats( &device, &stats ) );
+    EXPECT_EQ( stats.framesReceived, 1U );
+    EXPECT_EQ( stats.malformedFrames, 0U );
+    EXPECT_EQ( lwnode_last_rssi( &device ), -88 );
+}
+
+TEST_F( LwnodeTest, IdlePollingBacksOffAndStillDelivers )
+{
+    LwnodeRxStats stats = {};
+
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( lwnode_set_rx_cb( &device, on_rx ) );
+
+    /* 100, 200, 400, 800 ms, then once a second */
+    ( void ) lwnode_sleep_ms( &device, 30000U );
+    ASSERT_TRUE( lwnode_get_rx_stats( &device, &stats ) );
+    EXPECT_LE( stats.pollsIssued, 35U );
+    EXPECT_GE( stats.pollsAvoided, 29900U );
+
+    /* A downlink arriving while idle waits at most one capped interval */
+    lwnode_emu_queue_downlink( lwnode_emu_now_ms() + 10U, { 0x5AU }, -84, 6 );
+    ( void ) lwnode_sleep_ms( &device, 1000U );
+    ASSERT_EQ( g_rxPayloads.size(), 1U );
+    EXPECT_EQ( g_rxPayloads[ 0 ][ 0 ], 0x5AU );
+
+    /* Legacy mode polls every millisecond */
+    const uint32_t readsBefore = lwnode_emu_stats().i2cReads;
+    ASSERT_TRUE( lwnode_set_rx_mode( &device, LWNODE_RX_MODE_POLL ) );
+    ( void ) lwnode_sleep_ms( &device, 100U );
+    EXPECT_GE( lwnode_emu_stats().i2cReads - readsBefore, 50U );
+}
+
+TEST_F( LwnodeTest, IrqWakesOnDownlinkWithoutPolling )
+{
+    lwnode_emu_set_irq( true );
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( lwnode_set_rx_cb( &device, on_rx ) );
+
+    lwnode_emu_queue_downlink( lwnode_emu_now_ms() + 500U, { 0xAAU }, -80, 5 );
+    const uint32_t readsBefore = lwnode_emu_stats().i2cReads;
+
+    ( void ) lwnode_sleep_ms( &device, 2000U );
+
+    ASSERT_EQ( g_rxPayloads.size(), 1U );
+    /* Queue depth, length and data reads only */
+    EXPECT_LE( lwnode_emu_stats().i2cReads - readsBefore, 4U );
+}
+
+TEST_F( LwnodeTest, AsyncTransactionAdvancesOnlyWhenPolled )
+{
+    AtDone done;
+
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    const uint32_t commands = lwnode_emu_stats().commands;
+    const uint32_t startMs = lwnode_emu_now_ms();
+
+    /* Submitting is free: no bus traffic, no time spent */
+    ASSERT_TRUE( lwnode_at_submit( &device, "AT+DATARATE=2", on_at_done, &done ) );
+    EXPECT_TRUE( lwnode_at_busy( &device ) );
+    EXPECT_EQ( lwnode_emu_stats().commands, commands );
+    EXPECT_EQ( lwnode_emu_now_ms(), startMs );
+
+    /* One transaction per device */
+    EXPECT_FALSE( lwnode_at_submit( &device, "AT+EIRP=10", nullptr, nullptr ) );
+    EXPECT_FALSE( lwnode_set_eirp( &device, 10U ) );
+
+    /* The caller owns the schedule: sleep as asked, poll again */
+    LwnodeAtStatus status = LWNODE_AT_STATUS_PENDING;
+    while( status == LWNODE_AT_STATUS_PENDING )
+    {
+        ASSERT_LT( lwnode_emu_now_ms() - startMs, 1500U );
+        lwnode_hal_delay_ms( lwnode_at_next_poll_ms( &device ) );
+        status = lwnode_at_poll( &device );
+    }
+
+    EXPECT_EQ( status, LWNODE_AT_STATUS_OK );
+    EXPECT_FALSE( lwnode_at_busy( &device ) );
+    EXPECT_EQ( done.calls, 1U );
+    EXPECT_EQ( done.status, LWNODE_AT_STATUS_OK );
+    EXPECT_EQ( done.ack, "+DATARATE=OK\r\n" );
+    EXPECT_EQ( lwnode_emu_config( "DATARATE" ), "2" );
+    EXPECT_EQ( lwnode_emu_config( "EIRP" ), "" );
+
+    /* Idle polls report the last status and do not call back again */
+    EXPECT_EQ( lwnode_at_poll( &device ), LWNODE_AT_STATUS_OK );
+    EXPECT_EQ( done.calls, 1U );
+}
+
+/* The ACK is picked up when it is ready, not after a fixed 800 ms sleep */
+TEST_F( LwnodeTest, AckIsSeenWithinOnePollStep )
+{
+    const uint32_t replyMs[] = { 5U, 120U, 400U };
+
+    for( const uint32_t reply : replyMs )
+    {
+        LwnodeEmuTiming timing;
+
+        timing.replyMs = reply;
+        lwnode_emu_reset( timing );
+        ASSERT_TRUE( lwnode_init( &device, &hw ) );
+        ASSERT_TRUE( lwnode_begin( &device ) );
+
+        const uint32_t startMs = lwnode_emu_now_ms();
+        ASSERT_TRUE( lwnode_set_datarate( &device, 3U ) );
+        const uint32_t elapsedMs = lwnode_emu_now_ms() - startMs;
+
+        /* Backoff is capped at 50 ms */
+        EXPECT_GE( elapsedMs, reply );
+        EXPECT_LT( elapsedMs, reply + 55U );
+        EXPECT_GE( lwnode_at_last_ack_latency_ms( &device ), reply );
+        EXPECT_LE( lwnode_at_last_ack_latency_ms( &device ), elapsedMs );
+    }
+}
+
+TEST_F( LwnodeTest, ChunkGapCalibrationFindsModuleLimit )
+{
+    const char * const probe = "AT+APPKEY=00112233445566778899AABBCCDDEEFF";
+    LwnodeEmuTiming timing;
+    uint32_t gapMs = 0U;
+
+    timing.chunkGapMinMs = 20U;
+    lwnode_emu_reset( timing );
+    ASSERT_TRUE( lwnode_init( &device, &hw ) );
+    ASSERT_TRUE( lwnode_begin( &device ) );
+
+    /* Chunks sent back to back are garbled */
+    ASSERT_TRUE( lwnode_set_chunk_gap_ms( &device, 0U ) );
+    EXPECT_FALSE( lwnode_set_app_key( &device, "00112233445566778899aabbccddeeff" ) );
+
+    ASSERT_TRUE( lwnode_calibrate_chunk_gap( &device, probe, "+APPKEY=OK\r\n", &gapMs ) );
+    /* The gap runs from the start of a chunk; a 30-byte write takes ~3 ms */
+    EXPECT_GE( gapMs, 20U );
+    EXPECT_LE( gapMs, 24U );
+    EXPECT_EQ( device.chunkGapMs, gapMs + 2U );
+
+    /* Multi-chunk commands now pass, well under the 100 ms default gap */
+    const uint32_t startMs = lwnode_emu_now_ms();
+    EXPECT_TRUE( lwnode_set_app_key( &device, "ffeeddccbbaa99887766554433221100" ) );
+    EXPECT_LT( lwnode_emu_now_ms() - startMs, 100U );
+    EXPECT_EQ( lwnode_emu_config( "APPKEY" ), "FFEEDDCCBBAA99887766554433221100" );
+
+    /* A probe that fits one chunk can not measure anything */
+    EXPECT_FALSE( lwnode_calibrate_chunk_gap( &device, "AT", "OK\r\n", nullptr ) );
+    EXPECT_EQ( device.chunkGapMs, gapMs + 2U );
+}
+
+TEST_F( LwnodeTest, MissingAckTimesOut )
+{
+    ASSERT_TRUE( lwnode_begin( &device ) );
+
+    lwnode_emu_drop_replies( 1U );
+    const uint32_t startMs = lwnode_emu_now_ms();
+    EXPECT_FALSE( lwnode_set_datarate( &device, 3U ) );
+
+    /* Short command ACK budget */
+    EXPECT_GE( lwnode_emu_now_ms() - startMs, 1500U );
+    EXPECT_LT( lwnode_emu_now_ms() - startMs, 1600U );
+}
+
+TEST_F( LwnodeTest, SettingsAlreadyAppliedAreNotResent )
+{
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( lwnode_set_datarate( &device, 3U ) );
+    const size_t commands = lwnode_emu_commands().size();
+
+    ASSERT_TRUE( lwnode_set_datarate( &device, 3U ) );
+
+    EXPECT_EQ( lwnode_emu_commands().size(), commands );
+    EXPECT_EQ( lwnode_emu_config( "DATARATE" ), "3" );
+}
+
+TEST_F( LwnodeTest, ShadowSurvivesRestartUntilInvalidated )
+{
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( lwnode_set_class( &device, LWNODE_CLASS_C ) );
+    ASSERT_TRUE( lwnode_enable_adr( &device, true ) );
+
+    /* MCU restart: the NVS copy still matches the module */
+    ASSERT_TRUE( lwnode_init( &device, &hw ) );
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    const size_t commands = lwnode_emu_commands().size();
+    ASSERT_TRUE( lwnode_set_class( &device, LWNODE_CLASS_C ) );
+    ASSERT_TRUE( lwnode_enable_adr( &device, true ) );
+    EXPECT_EQ( lwnode_emu_commands().size(), commands );
+    EXPECT_GT( device.shadowSkips, 0U );
+
+    /* Replaced module: every setting goes out again */
+    ASSERT_TRUE( lwnode_shadow_invalidate( &device ) );
+    ASSERT_TRUE( lwnode_set_class( &device, LWNODE_CLASS_C ) );
+    ASSERT_TRUE( lwnode_enable_adr( &device, true ) );
+    EXPECT_EQ( lwnode_emu_commands().size(), commands + 2U );
+    EXPECT_EQ( count_commands( "AT+CLASS" ), 2U );
+}
+
+TEST_F( LwnodeTest, RuntimeSettingsDoNotWriteNvs )
+{
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    const uint32_t storesAfterBegin = lwnode_emu_stats().nvsStores;
+
+    /* Link adaptation and per-frame uplink type */
+    for( uint8_t dr = 0U; dr < 6U; ++dr )
+    {
+        ASSERT_TRUE( lwnode_set_datarate( &device, dr ) );
+        ASSERT_TRUE( lwnode_set_eirp( &device, ( uint8_t ) ( 2U * dr ) ) );
+        ASSERT_TRUE( lwnode_set_packet_type( &device, ( ( dr & 1U ) != 0U ) ?
+                                             LWNODE_PACKET_CONFIRMED : LWNODE_PACKET_UNCONFIRMED ) );
+    }
+    EXPECT_EQ( lwnode_emu_stats().nvsStores, storesAfterBegin );
+    EXPECT_EQ( lwnode_emu_config( "DATARATE" ), "5" );
+
+    /* A boot-relevant setting is still persisted */
+    ASSERT_TRUE( lwnode_set_class( &device, LWNODE_CLASS_C ) );
+    EXPECT_EQ( lwnode_emu_stats().nvsStores, storesAfterBegin + 1U );
+
+    /* After a restart the runtime settings are re-sent once, not trusted */
+    ASSERT_TRUE( lwnode_init( &device, &hw ) );
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    const size_t commands = lwnode_emu_commands().size();
+    ASSERT_TRUE( lwnode_set_class( &device, LWNODE_CLASS_C ) );
+    EXPECT_EQ( lwnode_emu_commands().size(), commands );
+    ASSERT_TRUE( lwnode_set_datarate( &device, 5U ) );
+    EXPECT_EQ( lwnode_emu_commands().size(), commands + 1U );
+}
+
+TEST_F( LwnodeTest, UplinkTypeSwitchesOnlyWhenItChanges )
+{
+    const uint8_t payload[ 2 ] = { 0x01U, 0x02U };
+    const LwnodePacketType runs[] = {
+        LWNODE_PACKET_CONFIRMED, LWNODE_PACKET_CONFIRMED,
+        LWNODE_PACKET_UNCONFIRMED, LWNODE_PACKET_UNCONFIRMED, LWNODE_PACKET_UNCONFIRMED,
+        LWNODE_PACKET_CONFIRMED
+    };
+
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( join_and_wait( 30000U ) );
+    const uint32_t stores = lwnode_emu_stats().nvsStores;
+
+    for( const LwnodePacketType type : runs )
+    {
+        ASSERT_TRUE( lwnode_set_packet_type( &device, type ) );
+        ASSERT_TRUE( lwnode_send_packet_bytes( &device, payload, sizeof( payload ) ) );
+        lwnode_hal_delay_ms( 4000U );
+    }
+
+    /* Three runs, three switches */
+    EXPECT_EQ( count_commands( "AT+UPLINKTYPE" ), 3U );
+    EXPECT_EQ( lwnode_emu_uplinks().size(), 6U );
+    EXPECT_EQ( lwnode_emu_stats().nvsStores, stores );
+}
+
+TEST_F( LwnodeTest, TableSettersFormatArgumentsAndRecordState )
+{
+    ASSERT_TRUE( lwnode_begin( &device ) );
+
+    EXPECT_TRUE( lwnode_set_app_eui( &device, "70b3d57ed0001234" ) );
+    EXPECT_TRUE( lwnode_set_dev_addr( &device, 0x0601ABCDU ) );
+    EXPECT_TRUE( lwnode_set_eirp( &device, 16U ) );
+    EXPECT_TRUE( lwnode_enable_adr( &device, true ) );
+
+    EXPECT_EQ( lwnode_emu_config( "JOINEUI" ), "70B3D57ED0001234" );
+    const uint8_t appEui[ LWNODE_APP_EUI_BYTES ] = { 0x70U, 0xB3U, 0xD5U, 0x7EU, 0xD0U, 0x00U, 0x12U, 0x34U };
+    EXPECT_EQ( std::memcmp( device.appEui, appEui, sizeof( appEui ) ), 0 );
+    EXPECT_EQ( lwnode_emu_config( "DEVADDR" ), "0601ABCD" );
+    EXPECT_EQ( device.devAddr, 0x0601ABCDU );
+    EXPECT_EQ( lwnode_emu_config( "EIRP" ), "16" );
+    EXPECT_EQ( device.txPower, 16U );
+    EXPECT_EQ( lwnode_emu_config( "ADR" ), "1" );
+    EXPECT_TRUE( device.adr );
+
+    /* Wrong key length never reaches the module */
+    const size_t commands = lwnode_emu_commands().size();
+    EXPECT_FALSE( lwnode_set_app_key( &device, "00112233" ) );
+    EXPECT_FALSE( lwnode_set_app_key( &device, "0011223344556677889900AABBCCDDXX" ) );
+    EXPECT_FALSE( lwnode_set_datarate( nullptr, 3U ) );
+    EXPECT_EQ( lwnode_emu_commands().size(), commands );
+
+    /* A rejected radio setting leaves the driver state alone */
+    lwnode_emu_drop_replies( 1U );
+    EXPECT_FALSE( lwnode_set_eirp( &device, 10U ) );
+    EXPECT_EQ( device.txPower, 16U );
+}
+
+TEST_F( LwnodeTest, DataRateQueryReportsModuleValue )
+{
+    uint8_t dataRate = 0xFFU;
+
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( lwnode_set_datarate( &device, 3U ) );
+
+    /* Network ADR moved the DR: the query sees it, the setting is kept */
+    lwnode_emu_set_config( "DATARATE", "1" );
+    EXPECT_TRUE( lwnode_get_datarate( &device, &dataRate ) );
+    EXPECT_EQ( dataRate, 1U );
+    EXPECT_EQ( device.dataRate, 3U );
+
+    lwnode_emu_set_config( "DATARATE", "16" );
+    EXPECT_FALSE( lwnode_get_datarate( &device, &dataRate ) );
+    lwnode_emu_set_config( "DATARATE", "" );
+    EXPECT_FALSE( lwnode_get_datarate( &device, &dataRate ) );
+    EXPECT_FALSE( lwnode_get_datarate( &device, nullptr ) );
+    EXPECT_EQ( dataRate, 1U );
+}
+
+TEST_F( LwnodeTest, BinaryKeysAreReplayedByBegin )
+{
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( lwnode_set_app_key( &device, "00112233445566778899aabbccddeeff" ) );
+
+    /* A module that lost its settings needs the recorded key again */
+    lwnode_emu_power_cycle();
+    ASSERT_TRUE( lwnode_shadow_invalidate( &device ) );
+    ASSERT_TRUE( lwnode_begin( &device ) );
+
+    EXPECT_EQ( lwnode_emu_config( "APPKEY" ), "00112233445566778899AABBCCDDEEFF" );
+    EXPECT_NE( device.keyMask, 0U );
+}
+
+TEST_F( LwnodeTest, PersistedShadowHoldsKeyDigestsOnly )
+{
+    const uint8_t appKey[ LWNODE_KEY_BYTES ] = { 0x00U, 0x11U, 0x22U, 0x33U, 0x44U, 0x55U, 0x66U, 0x77U,
+                                                 0x88U, 0x99U, 0xAAU, 0xBBU, 0xCCU, 0xDDU, 0xEEU, 0xFFU };
+    LwnodeConfigShadow stored = {};
+
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( lwnode_set_app_key( &device, "00112233445566778899aabbccddeeff" ) );
+
+    ASSERT_TRUE( lwnode_hal_nvs_load( "shadow", &stored, sizeof( stored ) ) );
+    const uint8_t * const blob = reinterpret_cast<const uint8_t *>( &stored );
+    EXPECT_EQ( std::search( blob, blob + sizeof( stored ), appKey, appKey + sizeof( appKey ) ),
+               blob + sizeof( stored ) );
+    EXPECT_NE( stored.appKeyCrc, 0U );
+
+    /* The digest is enough to skip the same key after a restart, not a new one */
+    ASSERT_TRUE( lwnode_init( &device, &hw ) );
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( lwnode_set_app_key( &device, "00112233445566778899aabbccddeeff" ) );
+    EXPECT_EQ( count_commands( "AT+APPKEY" ), 1U );
+    ASSERT_TRUE( lwnode_set_app_key( &device, "00112233445566778899aabbccddeefe" ) );
+    EXPECT_EQ( count_commands( "AT+APPKEY" ), 2U );
+}
+
+TEST_F( LwnodeTest, DownlinkInsideReplyIsRoutedAndAckAccepted )
+{
+    const uint8_t payload[ 2 ] = { 0x01U, 0x02U };
+
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( join_and_wait( 30000U ) );
+    ASSERT_TRUE( lwnode_set_rx_cb( &device, on_rx ) );
+
+    /* Frame payload holds CR LF, followed by a terminated frame */
+    lwnode_emu_wrap_next_reply( lwnode_emu_recv_frame( { 0x0DU, 0x0AU }, -101, -4 ) +
+                                lwnode_emu_recv_frame( { 0x7EU }, -99, 2 ) + "\r\n",
+                                "" );
+    const uint32_t commands = lwnode_emu_stats().commands;
+
+    EXPECT_TRUE( lwnode_send_packet_bytes( &device, payload, sizeof( payload ) ) );
+
+    /* Accepted on the first attempt */
+    EXPECT_EQ( lwnode_emu_stats().commands - commands, 1U );
+    ASSERT_EQ( g_rxPayloads.size(), 2U );
+    EXPECT_EQ( g_rxPayloads[ 0 ], ( std::vector<uint8_t>{ 0x0DU, 0x0AU } ) );
+    EXPECT_EQ( g_rxPayloads[ 1 ], ( std::vector<uint8_t>{ 0x7EU } ) );
+    EXPECT_EQ( lwnode_last_rssi( &device ), -99 );
+
+    LwnodeRxStats stats;
+    ASSERT_TRUE( lwnode_get_rx_stats( &device, &stats ) );
+    EXPECT_EQ( stats.urcFrames, 2U );
+}
+
+TEST_F( LwnodeTest, ExtraInformationLineDoesNotFailAck )
+{
+    ASSERT_TRUE( lwnode_begin( &device ) );
+
+    lwnode_emu_wrap_next_reply( "\r\n+DATARATE=3\r\n", "" );
+    EXPECT_TRUE( lwnode_set_datarate( &device, 3U ) );
+
+    lwnode_emu_wrap_next_reply( "", "+EIRP=14\r\n" );
+    EXPECT_TRUE( lwnode_set_eirp( &device, 14U ) );
+}
+
+TEST_F( LwnodeTest, FrameIteratorWalksBackToBackFrames )
+{
+    const std::string bytes = lwnode_emu_recv_frame( { 0x0DU, 0x0AU }, -101, -4 ) + "\r\n" +
+                              lwnode_emu_recv_frame( {}, -70, 9 ) +
+                              lwnode_emu_recv_frame( { 0x55U }, -88, 3 ) + "+RECV=";
+    const uint8_t * const buf = reinterpret_cast<const uint8_t *>( bytes.data() );
+    LwnodeRxFrameIter it;
+    LwnodeRxFrame frame;
+
+    ASSERT_TRUE( lwnode_rx_frames_begin( &it, buf, static_cast<uint16_t>( bytes.size() ) ) );
+
+    ASSERT_TRUE( lwnode_rx_frames_next( &it, &frame ) );
+    EXPECT_EQ( frame.payload, buf + 9 );
+    EXPECT_EQ( frame.len, 2U );
+    EXPECT_EQ( frame.rssi, -101 );
+    EXPECT_EQ( frame.snr, -4 );
+
+    ASSERT_TRUE( lwnode_rx_frames_next( &it, &frame ) );
+    EXPECT_EQ( frame.len, 0U );
+    EXPECT_EQ( frame.snr, 9 );
+
+    ASSERT_TRUE( lwnode_rx_frames_next( &it, &frame ) );
+    EXPECT_EQ( frame.payload[ 0 ], 0x55U );
+
+    /* Trailing prefix without a header */
+    EXPECT_FALSE( lwnode_rx_frames_next( &it, &frame ) );
+    EXPECT_TRUE( it.malformed );
+}
+
+TEST_F( LwnodeTest, ReadFrameReturnsViewIntoRxBuffer )
+{
+    ASSERT_TRUE( lwnode_begin( &device ) );
+
+    lwnode_emu_queue_downlink( lwnode_emu_now_ms(), { 0x10U, 0x20U, 0x30U }, -92, 6 );
+    lwnode_emu_queue_downlink( lwnode_emu_now_ms(), { 0x40U, 0x50U, 0x60U }, -93, 5 );
+
+    LwnodeRxFrame frame;
+    ASSERT_TRUE( lwnode_read_frame( &device, &frame ) );
+    EXPECT_GE( frame.payload, device.rxBuf );
+    EXPECT_LT( frame.payload, device.rxBuf + sizeof( device.rxBuf ) );
+    EXPECT_EQ( std::vector<uint8_t>( frame.payload, frame.payload + frame.len ),
+               ( std::vector<uint8_t>{ 0x10U, 0x20U, 0x30U } ) );
+    EXPECT_EQ( lwnode_last_rssi( &device ), -92 );
+
+    /* The copying API sees the same decode, truncated to the caller buffer */
+    uint8_t out[ 2 ] = {};
+    uint16_t outLen = 0U;
+    ASSERT_TRUE( lwnode_read_data_bytes( &device, out, sizeof( out ), &outLen ) );
+    EXPECT_EQ( outLen, 2U );
+    EXPECT_EQ( out[ 0 ], 0x40U );
+    EXPECT_EQ( lwnode_last_snr( &device ), 5 );
+}
+
+TEST_F( LwnodeTest, BenchmarkTransportLatency )
+{
+    LwnodeLoopback loopback;
+
+    const TransportLatency i2c = measure_transport();
+
+    lwnode_emu_reset();
+    ASSERT_TRUE( lwnode_init( &device, &hw ) );
+    ASSERT_TRUE( lwnode_set_transport( &device, &lwnode_emu_uart_transport(), nullptr ) );
+    const TransportLatency uart = measure_transport();
+    ASSERT_EQ( lwnode_emu_uplinks().size(), 1U );
+
+    lwnode_emu_reset();
+    ASSERT_TRUE( lwnode_init( &device, &hw ) );
+    ASSERT_TRUE( lwnode_loopback_init( &loopback, nullptr, nullptr ) );
+    ASSERT_TRUE( lwnode_set_transport( &device, &lwnodeLoopbackTransport, &loopback ) );
+    const TransportLatency lb = measure_transport();
+
+    RecordProperty( "i2cConfigMs", static_cast<int>( i2c.configMs ) );
+    RecordProperty( "i2cSendMs", static_cast<int>( i2c.sendMs ) );
+    RecordProperty( "uartConfigMs", static_cast<int>( uart.configMs ) );
+    RecordProperty( "uartSendMs", static_cast<int>( uart.sendMs ) );
+    RecordProperty( "loopbackConfigMs", static_cast<int>( lb.configMs ) );
+    RecordProperty( "loopbackSendMs", static_cast<int>( lb.sendMs ) );
+
+    /* UART: one burst and a wake-up on the reply instead of chunk gaps and
+     * poll backoff. The uplink is dominated by airtime, which the I2C poll
+     * schedule already targets. Loopback leaves only the driver overhead. */
+    EXPECT_LT( uart.configMs, i2c.configMs );
+    EXPECT_LE( uart.sendMs, i2c.sendMs );
+    EXPECT_LT( uart.sendMs, 70U );
+    EXPECT_EQ( lb.configMs, 0U );
+    EXPECT_EQ( lb.sendMs, 0U );
+}
+
+TEST_F( LwnodeTest, UartStreamDeliversDownlinksWhileSleeping )
+{
+    ASSERT_TRUE( lwnode_set_transport( &device, &lwnode_emu_uart_transport(), nullptr ) );
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( lwnode_set_rx_cb( &device, on_rx ) );
+
+    const uint32_t atMs = lwnode_emu_now_ms() + 300U;
+    lwnode_emu_queue_downlink( atMs, { 0xA1U, 0xA2U }, -80, 4 );
+    ( void ) lwnode_sleep_ms( &device, 1000U );
+
+    ASSERT_EQ( g_rxPayloads.size(), 1U );
+    EXPECT_EQ( g_rxPayloads[ 0 ], ( std::vector<uint8_t>{ 0xA1U, 0xA2U } ) );
+    EXPECT_EQ( g_rxRssi, -80 );
+
+    /* No queue registers behind a stream */
+    LwnodeRxFrame frame;
+    EXPECT_FALSE( lwnode_read_frame( &device, &frame ) );
+}
+
+TEST_F( LwnodeTest, LoopbackRoutesInjectedFrames )
+{
+    LwnodeLoopback loopback;
+    const std::string frame = lwnode_emu_recv_frame( { 0x42U }, -77, 1 ) + "\r\n";
+
+    ASSERT_TRUE( lwnode_loopback_init( &loopback, nullptr, nullptr ) );
+    ASSERT_TRUE( lwnode_set_transport( &device, &lwnodeLoopbackTransport, &loopback ) );
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( lwnode_set_rx_cb( &device, on_rx ) );
+
+    /* Frame already in the stream when the next command goes out */
+    ASSERT_TRUE( lwnode_loopback_inject( &loopback,
+                                         reinterpret_cast<const uint8_t *>( frame.data() ),
+                                         static_cast<uint16_t>( frame.size() ) ) );
+    EXPECT_TRUE( lwnode_set_eirp( &device, 14U ) );
+    ASSERT_EQ( g_rxPayloads.size(), 1U );
+    EXPECT_EQ( g_rxPayloads[ 0 ][ 0 ], 0x42U );
+    EXPECT_STREQ( loopback.cmd, "AT+EIRP=14" );
+
+    /* Transport can not change under a command in flight or without callbacks */
+    const LwnodeTransport incomplete = {};
+    EXPECT_FALSE( lwnode_set_transport( &device, &incomplete, nullptr ) );
+    EXPECT_TRUE( lwnode_set_transport( &device, nullptr, nullptr ) );
+}
+
+TEST_F( LwnodeTest, AbsentModuleFailsFast )
+{
+    lwnode_emu_set_present( false );
+
+    EXPECT_FALSE( lwnode_begin_bounded( &device, 3000U ) );
+    EXPECT_FALSE( lwnode_is_ready( &device ) );
+    EXPECT_LT( lwnode_emu_now_ms(), 10U );
+}
+
+TEST_F( LwnodeTest, WedgedModuleIsBoundedByTheBudget )
+{
+    EXPECT_FALSE( lwnode_begin_bounded( &device, 0U ) );
+
+    /* Present on the bus, never answers */
+    lwnode_emu_drop_replies( 1000U );
+    const uint32_t startMs = lwnode_emu_now_ms();
+    EXPECT_FALSE( lwnode_begin_bounded( &device, 1000U ) );
+    const uint32_t elapsedMs = lwnode_emu_now_ms() - startMs;
+
+    EXPECT_GE( elapsedMs, 1000U );
+    EXPECT_LT( elapsedMs, 1010U );
+    EXPECT_FALSE( lwnode_is_ready( &device ) );
+
+    /* Retried later, once the module answers */
+    lwnode_emu_drop_replies( 0U );
+    EXPECT_TRUE( lwnode_begin_bounded( &device, 3000U ) );
+    EXPECT_TRUE( lwnode_is_ready( &device ) );
+}
+
+TEST_F( LwnodeTest, BusyStateFollowsJoinAndUplink )
+{
+    const uint8_t payload[ 2 ] = { 0x01U, 0x02U };
+    LwnodeEmuTiming timing;
+    LwnodeBusyStats busy;
+
+    timing.rxWindowsMs = 3000U;
+    timing.busyWhileJoining = true;
+    lwnode_emu_reset( timing );
+    ASSERT_TRUE( lwnode_init( &device, &hw ) );
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    EXPECT_EQ( lwnode_get_busy_state( &device ), LWNODE_STATE_IDLE );
+
+    /* Rejected before the join (+SEND=ERROR): nothing on air, no RX windows */
+    EXPECT_FALSE( lwnode_send_packet_bytes( &device, payload, sizeof( payload ) ) );
+    EXPECT_EQ( lwnode_get_busy_state( &device ), LWNODE_STATE_IDLE );
+
+    ASSERT_TRUE( lwnode_join( &device ) );
+    EXPECT_EQ( lwnode_get_busy_state( &device ), LWNODE_STATE_JOINING );
+    /* Too early for the join accept: answered without asking the module */
+    EXPECT_FALSE( lwnode_is_joined( &device ) );
+    EXPECT_EQ( count_commands( "AT+JOIN?" ), 0U );
+
+    while( !lwnode_is_joined( &device ) )
+    {
+        ASSERT_LT( lwnode_emu_now_ms(), 30000U );
+        lwnode_hal_delay_ms( 1000U );
+    }
+    EXPECT_EQ( lwnode_get_busy_state( &device ), LWNODE_STATE_IDLE );
+
+    ASSERT_TRUE( lwnode_send_packet_bytes( &device, payload, sizeof( payload ) ) );
+    EXPECT_EQ( lwnode_get_busy_state( &device ), LWNODE_STATE_RECV_WINDOW );
+    const uint32_t remainingMs = lwnode_busy_remaining_ms( &device );
+    EXPECT_GT( remainingMs, 3000U );
+
+    /* Held until RX2 has closed instead of timing out on a busy module */
+    const uint32_t startMs = lwnode_emu_now_ms();
+    EXPECT_TRUE( lwnode_set_datarate( &device, 3U ) );
+    EXPECT_GE( lwnode_emu_now_ms() - startMs, remainingMs );
+    EXPECT_EQ( lwnode_get_busy_state( &device ), LWNODE_STATE_IDLE );
+
+    EXPECT_EQ( lwnode_emu_stats().busyAccesses, 0U );
+    ASSERT_TRUE( lwnode_get_busy_stats( &device, &busy ) );
+    EXPECT_EQ( busy.cmdsParked, 1U );
+    EXPECT_EQ( busy.parkedMs, remainingMs );
+    EXPECT_GE( busy.joinQueriesSkipped, 1U );
+}
+
+TEST_F( LwnodeTest, DownlinkPollsWaitForRxWindowsToClose )
+{
+    const uint8_t payload[ 1 ] = { 0x01U };
+    LwnodeEmuTiming timing;
+    LwnodeBusyStats busy;
+
+    timing.rxWindowsMs = 3000U;
+    lwnode_emu_reset( timing );
+    ASSERT_TRUE( lwnode_init( &device, &hw ) );
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( join_and_wait( 30000U ) );
+    ASSERT_TRUE( lwnode_set_rx_cb( &device, on_rx ) );
+
+    ASSERT_TRUE( lwnode_send_packet_bytes( &device, payload, sizeof( payload ) ) );
+    /* Network answers in RX1 */
+    lwnode_emu_queue_downlink( lwnode_emu_now_ms() + 1000U, { 0xC0U }, -70, 8 );
+    ( void ) lwnode_sleep_ms( &device, 5000U );
+
+    ASSERT_EQ( g_rxPayloads.size(), 1U );
+    EXPECT_EQ( g_rxPayloads[ 0 ], ( std::vector<uint8_t>{ 0xC0U } ) );
+    EXPECT_EQ( lwnode_emu_stats().busyAccesses, 0U );
+    ASSERT_TRUE( lwnode_get_busy_stats( &device, &busy ) );
+    EXPECT_GE( busy.pollsDeferred, 1U );
+}
+
+TEST_F( LwnodeTest, DrainAndIrqWaitForRxWindowsToClose )
+{
+    const uint8_t payload[ 1 ] = { 0x01U };
+    uint8_t buf[ 16 ] = { 0U };
+    LwnodeRxFrameInfo frames[ 2 ] = {};
+    LwnodeRxBatch batch = { buf, sizeof( buf ), frames, 2U, 0U, 0U };
+    LwnodeEmuTiming timing;
+    LwnodeBusyStats busy;
+
+    timing.rxWindowsMs = 3000U;
+    lwnode_emu_reset( timing );
+    lwnode_emu_set_irq( true );
+    ASSERT_TRUE( lwnode_init( &device, &hw ) );
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( join_and_wait( 30000U ) );
+    ASSERT_TRUE( lwnode_set_rx_cb( &device, on_rx ) );
+
+    ASSERT_TRUE( lwnode_send_packet_bytes( &device, payload, sizeof( payload ) ) );
+    lwnode_emu_queue_downlink( lwnode_emu_now_ms() + 1000U, { 0xC0U }, -70, 8 );
+    lwnode_emu_queue_downlink( lwnode_emu_now_ms() + 1000U, { 0xC1U }, -70, 8 );
+    lwnode_hal_delay_ms( 1500U );
+
+    /* Frame is there, but the windows are still open */
+    ASSERT_TRUE( lwnode_get_busy_stats( &device, &busy ) );
+    const uint32_t deferredBefore = busy.pollsDeferred;
+    const uint32_t readsBefore = lwnode_emu_stats().i2cReads;
+    EXPECT_EQ( lwnode_drain_rx( &device ), 0U );
+    EXPECT_FALSE( lwnode_read_data_batch( &device, &batch ) );
+    EXPECT_EQ( lwnode_emu_stats().i2cReads, readsBefore );
+    ASSERT_TRUE( lwnode_get_busy_stats( &device, &busy ) );
+    EXPECT_EQ( busy.pollsDeferred - deferredBefore, 2U );
+
+    /* The IRQ raised in RX1 is taken once RX2 has closed */
+    ( void ) lwnode_sleep_ms( &device, 5000U );
+
+    ASSERT_EQ( g_rxPayloads.size(), 2U );
+    EXPECT_EQ( g_rxPayloads[ 1 ], ( std::vector<uint8_t>{ 0xC1U } ) );
+    EXPECT_EQ( lwnode_emu_stats().busyAccesses, 0U );
+    ASSERT_TRUE( lwnode_get_busy_stats( &device, &busy ) );
+    EXPECT_GT( busy.pollsDeferred - deferredBefore, 2U );
+}
+
+#if ( LWNODE_STATS_ENABLED != 0 )
+TEST_F( LwnodeTest, CommandStatsTrackLatencyBytesAndFailures )
+{
+    LwnodeCmdReport report;
+
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( lwnode_reset_cmd_stats( &device ) );
+
+    lwnode_emu_drop_replies( 1U );
+    EXPECT_FALSE( lwnode_set_datarate( &device, 3U ) );
+    EXPECT_TRUE( lwnode_set_datarate( &device, 3U ) );
+
+    ASSERT_TRUE( lwnode_get_cmd_stats( &device, LWNODE_CMD_CONFIG, &report ) );
+    EXPECT_EQ( report.count, 2U );
+    EXPECT_EQ( report.failures, 1U );
+    EXPECT_EQ( report.retries, 1U );
+    /* "AT+DATARATE=3\r\n" twice */
+    EXPECT_EQ( report.bytesWritten, 30U );
+    EXPECT_EQ( report.total.maxMs, 1500U );
+    /* 5 ms reply, seen after the 2 + 4 + 8 ms poll backoff */
+    EXPECT_LE( report.ack.minMs, 20U );
+    EXPECT_GE( report.ack.p99Ms, report.ack.minMs );
+    EXPECT_GT( report.ackPolls, 2U );
+
+    char dump[ 256 ];
+    ASSERT_GT( lwnode_dump_cmd_stats( &device, dump, sizeof( dump ) ), 0U );
+    EXPECT_EQ( std::strncmp( dump, "CFG c=2 f=1 r=1 ", 16U ), 0 );
+    EXPECT_EQ( lwnode_dump_cmd_stats( &device, dump, 8U ), 0U );
+}
+
+TEST_F( LwnodeTest, CommandStatsAreKeptPerClass )
+{
+    const uint8_t payload[ 4 ] = { 0x01U, 0x02U, 0x03U, 0x04U };
+    LwnodeCmdReport report;
+
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    ASSERT_TRUE( lwnode_get_cmd_stats( &device, LWNODE_CMD_REBOOT, &report ) );
+    EXPECT_EQ( report.count, 1U );
+    ASSERT_TRUE( lwnode_get_cmd_stats( &device, LWNODE_CMD_TEST, &report ) );
+    EXPECT_GE( report.count, 1U );
+
+    ASSERT_TRUE( lwnode_reset_cmd_stats( &device ) );
+    ASSERT_TRUE( join_and_wait( 30000U ) );
+    ASSERT_TRUE( lwnode_send_packet_bytes( &device, payload, sizeof( payload ) ) );
+
+    ASSERT_TRUE( lwnode_get_cmd_stats( &device, LWNODE_CMD_REBOOT, &report ) );
+    EXPECT_EQ( report.count, 0U );
+    ASSERT_TRUE( lwnode_get_cmd_stats( &device, LWNODE_CMD_JOIN, &report ) );
+    EXPECT_EQ( report.count, 1U );
+    ASSERT_TRUE( lwnode_get_cmd_stats( &device, LWNODE_CMD_JOIN_QUERY, &report ) );
+    EXPECT_EQ( report.count, count_commands( "AT+JOIN?" ) );
+    EXPECT_EQ( report.failures, 0U );
+
+    /* "AT+SEND=01020304\r\n"; the ACK waits out the 60 ms airtime */
+    ASSERT_TRUE( lwnode_get_cmd_stats( &device, LWNODE_CMD_SEND, &report ) );
+    EXPECT_EQ( report.count, 1U );
+    EXPECT_EQ( report.bytesWritten, 18U );
+    EXPECT_GE( report.bytesRead, 10U );
+    EXPECT_GE( report.ack.minMs, 60U );
+    EXPECT_GE( report.total.maxMs, report.ack.maxMs );
+
+    EXPECT_FALSE( lwnode_get_cmd_stats( &device, LWNODE_CMD_TYPE_COUNT, &report ) );
+}
+#endif
@@ -0,0 +1,248 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "hal/lwnode.h"
+#include "hal/lwnode_emulator.h"
+#include "lib/lwnode.h"
+#include "lib/lwnode_mailbox.h"
+
+namespace
+{
+
+struct Completions
+{
+    std::atomic<uint32_t> ok{ 0U };
+    std::atomic<uint32_t> failed{ 0U };
+    std::vector<LwnodeMailboxOp> order;
+};
+
+void on_done( void * ctx, LwnodeMailboxOp op, bool ok )
+{
+    Completions * completions = static_cast<Completions *>( ctx );
+
+    completions->order.push_back( op );
+    ( ok ? completions->ok : completions->failed )++;
+}
+
+/* Identifies one stress request in its completion */
+struct Tag
+{
+    uint8_t producer;
+    uint8_t seq;
+    std::vector<Tag> * log;
+};
+
+void on_tagged_done( void * ctx, LwnodeMailboxOp op, bool ok )
+{
+    Tag * tag = static_cast<Tag *>( ctx );
+
+    ( void ) op;
+    if( ok )
+    {
+        tag->log->push_back( *tag );
+    }
+}
+
+LwnodeMailboxReq make_datarate( uint8_t dataRate, Completions * completions )
+{
+    LwnodeMailboxReq req = {};
+
+    req.op = LWNODE_MAILBOX_SET_DATARATE;
+    req.arg = dataRate;
+    req.done = ( completions != nullptr ) ? on_done : nullptr;
+    req.ctx = completions;
+
+    return req;
+}
+
+}
+
+class LwnodeMailboxTest : public ::testing::Test
+{
+protected:
+    LwnodeHw hw;
+    LwnodeDevice device;
+    LwnodeMailbox mailbox;
+    Completions completions;
+
+    void SetUp() override
+    {
+        lwnode_emu_reset();
+        lwnode_hal_config_default( &hw );
+        ASSERT_TRUE( lwnode_init( &device, &hw ) );
+        device.region = LWNODE_REGION_EU868;
+        ASSERT_TRUE( lwnode_mailbox_init( &mailbox ) );
+    }
+
+    LwnodeMailboxStats stats()
+    {
+        LwnodeMailboxStats out;
+        EXPECT_TRUE( lwnode_mailbox_get_stats( &mailbox, &out ) );
+        return out;
+    }
+};
+
+TEST_F( LwnodeMailboxTest, RejectsInvalidRequests )
+{
+    LwnodeMailboxReq req = make_datarate( 0U, nullptr );
+
+    EXPECT_FALSE( lwnode_mailbox_init( nullptr ) );
+    EXPECT_FALSE( lwnode_mailbox_submit( nullptr, &req ) );
+    EXPECT_FALSE( lwnode_mailbox_submit( &mailbox, nullptr ) );
+
+    req.op = LWNODE_MAILBOX_OP_COUNT;
+    EXPECT_FALSE( lwnode_mailbox_submit( &mailbox, &req ) );
+
+    EXPECT_FALSE( lwnode_mailbox_pending( &mailbox ) );
+    EXPECT_EQ( lwnode_mailbox_service( &mailbox, nullptr, 1U ), 0U );
+    EXPECT_EQ( stats().submitted, 0U );
+}
+
+TEST_F( LwnodeMailboxTest, ExecutesInSubmissionOrder )
+{
+    ASSERT_TRUE( lwnode_begin( &device ) );
+
+    LwnodeMailboxReq req = {};
+    req.done = on_done;
+    req.ctx = &completions;
+
+    req.op = LWNODE_MAILBOX_SET_DATARATE;
+    req.arg = 3U;
+    ASSERT_TRUE( lwnode_mailbox_submit( &mailbox, &req ) );
+    req.op = LWNODE_MAILBOX_SET_EIRP;
+    req.arg = 10U;
+    ASSERT_TRUE( lwnode_mailbox_submit( &mailbox, &req ) );
+    req.op = LWNODE_MAILBOX_JOIN;
+    req.arg = 0U;
+    ASSERT_TRUE( lwnode_mailbox_submit( &mailbox, &req ) );
+
+    EXPECT_TRUE( lwnode_mailbox_pending( &mailbox ) );
+    EXPECT_EQ( lwnode_emu_config( "EIRP" ), "" );
+    EXPECT_EQ( lwnode_mailbox_service( &mailbox, &device, 2U ), 2U );
+    EXPECT_EQ( lwnode_mailbox_service( &mailbox, &device, 8U ), 1U );
+    EXPECT_FALSE( lwnode_mailbox_pending( &mailbox ) );
+
+    ASSERT_EQ( completions.order.size(), 3U );
+    EXPECT_EQ( completions.order[ 0 ], LWNODE_MAILBOX_SET_DATARATE );
+    EXPECT_EQ( completions.order[ 1 ], LWNODE_MAILBOX_SET_EIRP );
+    EXPECT_EQ( completions.order[ 2 ], LWNODE_MAILBOX_JOIN );
+    EXPECT_EQ( completions.ok.load(), 3U );
+    EXPECT_EQ( lwnode_emu_config( "DATARATE" ), "3" );
+    EXPECT_EQ( lwnode_emu_config( "EIRP" ), "10" );
+}
+
+TEST_F( LwnodeMailboxTest, FullMailboxRejectsWithoutWaiting )
+{
+    LwnodeMailboxReq req = make_datarate( 2U, nullptr );
+
+    ASSERT_TRUE( lwnode_begin( &device ) );
+    for( uint32_t i = 0U; i < LWNODE_MAILBOX_DEPTH; ++i )
+    {
+        ASSERT_TRUE( lwnode_mailbox_submit( &mailbox, &req ) );
+    }
+    EXPECT_FALSE( lwnode_mailbox_submit( &mailbox, &req ) );
+
+    /* A serviced slot is free again, even though the command failed */
+    lwnode_emu_drop_replies( 1U );
+    EXPECT_EQ( lwnode_mailbox_service( &mailbox, &device, 1U ), 1U );
+    EXPECT_TRUE( lwnode_mailbox_submit( &mailbox, &req ) );
+
+    LwnodeMailboxStats s = stats();
+    EXPECT_EQ( s.submitted, LWNODE_MAILBOX_DEPTH + 1U );
+    EXPECT_EQ( s.full, 1U );
+    EXPECT_EQ( s.executed, 1U );
+    EXPECT_EQ( s.failed, 1U );
+}
+
+/* Producers on their own threads, the radio task on this one */
+TEST_F( LwnodeMailboxTest, StressManyProducersAgainstEmulator )
+{
+    constexpr uint8_t kProducers = 8U;
+    constexpr uint8_t kPerProducer = 64U;
+    constexpr uint32_t kTotal = kProducers * kPerProducer;
+
+    ASSERT_TRUE( lwnode_begin( &device ) );
+
+    std::atomic<bool> go{ false };
+    std::atomic<uint32_t> retries{ 0U };
+    std::vector<std::thread> producers;
+    std::vector<Tag> log;
+    std::vector<Tag> tags( kTotal );
+
+    log.reserve( kTotal );
+    for( uint8_t p = 0U; p < kProducers; ++p )
+    {
+        producers.emplace_back( [ this, p, &go, &retries, &log, &tags ]()
+        {
+            while( !go.load() )
+            {
+                std::this_thread::yield();
+            }
+
+            for( uint8_t seq = 0U; seq < kPerProducer; ++seq )
+            {
+                Tag & tag = tags[ ( p * kPerProducer ) + seq ];
+                LwnodeMailboxReq req = make_datarate( seq % 6U, nullptr );
+
+                tag = { p, seq, &log };
+                req.done = on_tagged_done;
+                req.ctx = &tag;
+
+                while( !lwnode_mailbox_submit( &mailbox, &req ) )
+                {
+                    retries++;
+                    std::this_thread::yield();
+                }
+            }
+        } );
+    }
+
+    go = true;
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds( 60 );
+    uint32_t executed = 0U;
+
+    while( ( executed < kTotal ) && ( std::chrono::steady_clock::now() < deadline ) )
+    {
+        const uint8_t n = lwnode_mailbox_service( &mailbox, &device, LWNODE_MAILBOX_DEPTH );
+
+        executed += n;
+        if( n == 0U )
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    for( std::thread & producer : producers )
+    {
+        producer.join();
+    }
+
+    ASSERT_EQ( executed, kTotal );
+
+    /* Every request completed exactly once, in order per producer */
+    std::vector<uint32_t> next( kProducers, 0U );
+
+    ASSERT_EQ( log.size(), kTotal );
+    for( const Tag & tag : log )
+    {
+        ASSERT_LT( tag.producer, kProducers );
+        EXPECT_EQ( tag.seq, next[ tag.producer ] );
+        next[ tag.producer ]++;
+    }
+    EXPECT_EQ( lwnode_emu_config( "DATARATE" ),
+               std::to_string( log.back().seq % 6U ) );
+
+    LwnodeMailboxStats s = stats();
+    EXPECT_EQ( s.submitted, kTotal );
+    EXPECT_EQ( s.full, retries.load() );
+    EXPECT_EQ( s.executed, kTotal );
+    EXPECT_EQ( s.failed, 0U );
+
+    RecordProperty( "fullRetries", static_cast<int>( retries.load() ) );
+}
@@ -0,0 +1,135 @@
+#include <cstdint>
+#include <gtest/gtest.h>
+
+#include "lib/uplink_confirm.h"
+
+class UplinkConfirmTest : public ::testing::Test
+{
+protected:
+    UplinkConfirm tracker;
+    UplinkEntry entry;
+    UplinkEntry out;
+
+    void SetUp() override
+    {
+        ASSERT_TRUE( uplink_confirm_init( &tracker, 3U ) );
+
+        entry = {};
+        entry.priority = UPLINK_PRIORITY_ALARM;
+        entry.confirmed = true;
+        entry.len = 1U;
+        entry.payload[ 0 ] = 0xA5U;
+        out = {};
+    }
+};
+
+TEST_F( UplinkConfirmTest, InitRejectsInvalidArguments )
+{
+    EXPECT_FALSE( uplink_confirm_init( nullptr, 3U ) );
+    EXPECT_FALSE( uplink_confirm_init( &tracker, 0U ) );
+    EXPECT_FALSE( uplink_confirm_init( &tracker, UPLINK_CONFIRM_MAX_ATTEMPTS + 1U ) );
+}
+
+TEST_F( UplinkConfirmTest, UnconfirmedFramesAreNotTracked )
+{
+    entry.confirmed = false;
+
+    EXPECT_FALSE( uplink_confirm_sent( &tracker, &entry, 1000U, 0U ) );
+    EXPECT_FALSE( uplink_confirm_busy( &tracker ) );
+    EXPECT_EQ( uplink_confirm_send_failed( &tracker, &entry, &out ), UPLINK_CONFIRM_NONE );
+}
+
+TEST_F( UplinkConfirmTest, AckCompletesOutstandingFrame )
+{
+    ASSERT_TRUE( uplink_confirm_sent( &tracker, &entry, 3000U, 100U ) );
+    EXPECT_TRUE( uplink_confirm_busy( &tracker ) );
+    EXPECT_FALSE( uplink_confirm_sent( &tracker, &entry, 3000U, 100U ) );
+
+    EXPECT_EQ( uplink_confirm_poll( &tracker, 3099U, &out ), UPLINK_CONFIRM_NONE );
+    EXPECT_EQ( uplink_confirm_on_ack( &tracker, 1600U ), UPLINK_CONFIRM_ACKED );
+    EXPECT_FALSE( uplink_confirm_busy( &tracker ) );
+    EXPECT_EQ( uplink_confirm_on_ack( &tracker, 1700U ), UPLINK_CONFIRM_NONE );
+    EXPECT_EQ( uplink_confirm_poll( &tracker, 10000U, &out ), UPLINK_CONFIRM_NONE );
+
+    UplinkConfirmStats stats;
+    ASSERT_TRUE( uplink_confirm_get_stats( &tracker, &stats ) );
+    EXPECT_EQ( stats.sent, 1U );
+    EXPECT_EQ( stats.acked, 1U );
+    EXPECT_EQ( stats.lastAckMs, 1500U );
+}
+
+TEST_F( UplinkConfirmTest, TimeoutIsPerFrame )
+{
+    ASSERT_TRUE( uplink_confirm_sent( &tracker, &entry, 500U, 0U ) );
+    EXPECT_EQ( uplink_confirm_poll( &tracker, 499U, &out ), UPLINK_CONFIRM_NONE );
+    EXPECT_EQ( uplink_confirm_poll( &tracker, 500U, &out ), UPLINK_CONFIRM_UNVERIFIED );
+    EXPECT_EQ( out.attempts, 1U );
+    EXPECT_EQ( out.payload[ 0 ], 0xA5U );
+
+    ASSERT_TRUE( uplink_confirm_sent( &tracker, &entry, 4000U, 1000U ) );
+    EXPECT_EQ( uplink_confirm_poll( &tracker, 1500U, &out ), UPLINK_CONFIRM_NONE );
+    EXPECT_EQ( uplink_confirm_poll( &tracker, 5000U, &out ), UPLINK_CONFIRM_UNVERIFIED );
+}
+
+/* An ACK without payload never reaches the tracker: the frame is not resent */
+TEST_F( UplinkConfirmTest, MissingAckIsUnverifiedNotRetried )
+{
+    ASSERT_TRUE( uplink_confirm_sent( &tracker, &entry, 1000U, 0U ) );
+    EXPECT_EQ( uplink_confirm_poll( &tracker, 1000U, &out ), UPLINK_CONFIRM_UNVERIFIED );
+    EXPECT_FALSE( uplink_confirm_busy( &tracker ) );
+
+    /* A downlink after the timeout no longer refers to the frame */
+    EXPECT_EQ( uplink_confirm_on_ack( &tracker, 1500U ), UPLINK_CONFIRM_NONE );
+    EXPECT_EQ( uplink_confirm_poll( &tracker, 9000U, &out ), UPLINK_CONFIRM_NONE );
+
+    UplinkConfirmStats stats;
+    ASSERT_TRUE( uplink_confirm_get_stats( &tracker, &stats ) );
+    EXPECT_EQ( stats.sent, 1U );
+    EXPECT_EQ( stats.acked, 0U );
+    EXPECT_EQ( stats.unverified, 1U );
+    EXPECT_EQ( stats.retries, 0U );
+    EXPECT_EQ( stats.failed, 0U );
+}
+
+TEST_F( UplinkConfirmTest, GivesUpAfterMaxAttempts )
+{
+    UplinkConfirmEvent event = UPLINK_CONFIRM_NONE;
+
+    for( uint8_t i = 0U; i < 3U; ++i )
+    {
+        event = uplink_confirm_send_failed( &tracker, &entry, &entry );
+    }
+
+    EXPECT_EQ( event, UPLINK_CONFIRM_FAILED );
+    EXPECT_EQ( entry.attempts, 3U );
+    EXPECT_FALSE( uplink_confirm_busy( &tracker ) );
+
+    UplinkConfirmStats stats;
+    ASSERT_TRUE( uplink_confirm_get_stats( &tracker, &stats ) );
+    EXPECT_EQ( stats.sent, 0U );
+    EXPECT_EQ( stats.retries, 2U );
+    EXPECT_EQ( stats.failed, 1U );
+    EXPECT_EQ( stats.acked, 0U );
+}
+
+TEST_F( UplinkConfirmTest, FailedSendCountsAsAttempt )
+{
+    EXPECT_EQ( uplink_confirm_send_failed( &tracker, &entry, &out ), UPLINK_CONFIRM_RETRY );
+    EXPECT_EQ( out.attempts, 1U );
+    EXPECT_FALSE( uplink_confirm_busy( &tracker ) );
+
+    /* The accepted retry carries its attempt count */
+    ASSERT_TRUE( uplink_confirm_sent( &tracker, &out, 1000U, 0U ) );
+    EXPECT_EQ( uplink_confirm_on_ack( &tracker, 800U ), UPLINK_CONFIRM_ACKED );
+
+    out.attempts = 2U;
+    EXPECT_EQ( uplink_confirm_send_failed( &tracker, &out, &out ), UPLINK_CONFIRM_FAILED );
+    EXPECT_EQ( out.attempts, 3U );
+}
+
+TEST_F( UplinkConfirmTest, TimeoutSurvivesClockWrap )
+{
+    ASSERT_TRUE( uplink_confirm_sent( &tracker, &entry, 1000U, 0xFFFFFF00U ) );
+    EXPECT_EQ( uplink_confirm_poll( &tracker, 0x00000100U, &out ), UPLINK_CONFIRM_NONE );
+    EXPECT_EQ( uplink_confirm_poll( &tracker, 0x000002E8U, &out ), UPLINK_CONFIRM_UNVERIFIED );
+}
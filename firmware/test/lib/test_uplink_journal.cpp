@@ -0,0 +1,378 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "lib/uplink_journal.h"
+
+namespace
+{
+
+/* NOR flash on a virtual clock: programming only clears bits, erase sets a
+ * whole sector to 0xFF, and power can be cut after a number of programmed
+ * bytes. Timings follow a typical SPI NOR part (4 KB erase 45 ms, page
+ * program 0.4 ms per 256 bytes). */
+struct NorFlash
+{
+    std::vector<uint8_t> mem;
+    uint32_t sectorSize = 0U;
+    uint64_t nowUs = 0U;
+    uint32_t violations = 0U;           /* 0 -> 1 programming attempts */
+    int64_t cutAfterBytes = -1;         /* Power lost after this many programmed bytes */
+    bool powerLost = false;
+
+    void reset( uint32_t sectorBytes, uint16_t sectors )
+    {
+        sectorSize = sectorBytes;
+        mem.assign( static_cast<size_t>( sectorBytes ) * sectors, 0xFFU );
+        nowUs = 0U;
+        violations = 0U;
+        cutAfterBytes = -1;
+        powerLost = false;
+    }
+
+    bool read( uint32_t offset, void * buf, size_t len )
+    {
+        bool ok = !powerLost && ( offset + len <= mem.size() );
+        if( ok )
+        {
+            std::memcpy( buf, &mem[ offset ], len );
+            nowUs += 10U + ( len / 40U );
+        }
+        return ok;
+    }
+
+    bool write( uint32_t offset, const void * data, size_t len )
+    {
+        bool ok = !powerLost && ( offset + len <= mem.size() );
+        const uint8_t * const src = static_cast<const uint8_t *>( data );
+
+        for( size_t i = 0U; ok && ( i < len ); i++ )
+        {
+            if( cutAfterBytes == 0 )
+            {
+                powerLost = true;
+                ok = false;
+            }
+            else
+            {
+                violations += ( ( ~mem[ offset + i ] & src[ i ] ) != 0U ) ? 1U : 0U;
+                mem[ offset + i ] &= src[ i ];
+                cutAfterBytes = ( cutAfterBytes > 0 ) ? ( cutAfterBytes - 1 ) : cutAfterBytes;
+            }
+        }
+        nowUs += 20U + ( ( len * 400U ) / 256U );
+        return ok;
+    }
+
+    bool erase( uint32_t offset, uint32_t len )
+    {
+        bool ok = !powerLost && ( ( offset % sectorSize ) == 0U ) && ( offset + len <= mem.size() );
+        if( ok )
+        {
+            std::fill( mem.begin() + offset, mem.begin() + offset + len, 0xFFU );
+            nowUs += 45000U * ( len / sectorSize );
+        }
+        return ok;
+    }
+};
+
+NorFlash flash;
+
+bool flash_read( void * ctx, uint32_t offset, void * buf, size_t len )
+{
+    return static_cast<NorFlash *>( ctx )->read( offset, buf, len );
+}
+
+bool flash_write( void * ctx, uint32_t offset, const void * data, size_t len )
+{
+    return static_cast<NorFlash *>( ctx )->write( offset, data, len );
+}
+
+bool flash_erase( void * ctx, uint32_t offset, uint32_t len )
+{
+    return static_cast<NorFlash *>( ctx )->erase( offset, len );
+}
+
+const UplinkJournalFlash norFlashOps = { flash_read, flash_write, flash_erase };
+
+constexpr uint32_t kSectorSize = 4096U;
+constexpr uint8_t kRecordLen = 6U;
+
+}  // namespace
+
+class UplinkJournalTest : public ::testing::Test
+{
+protected:
+    UplinkJournal journal;
+
+    void SetUp() override
+    {
+        flash.reset( kSectorSize, 8U );
+        ASSERT_TRUE( mount() );
+    }
+
+    bool mount( uint32_t sectorSize = kSectorSize )
+    {
+        flash.powerLost = false;
+        flash.cutAfterBytes = -1;
+        return uplink_journal_mount( &journal, &norFlashOps, &flash, sectorSize,
+                                     static_cast<uint16_t>( flash.mem.size() / sectorSize ) );
+    }
+
+    static std::vector<uint8_t> record( uint32_t n )
+    {
+        return { static_cast<uint8_t>( n ), static_cast<uint8_t>( n >> 8 ), 0x11U, 0x22U, 0x33U, 0x44U };
+    }
+
+    bool append( uint32_t n )
+    {
+        const std::vector<uint8_t> r = record( n );
+        return uplink_journal_append( &journal, r.data(), static_cast<uint8_t>( r.size() ) );
+    }
+
+    /* First record number in a batch of records built by record() */
+    static uint32_t first_of( const uint8_t * payload )
+    {
+        return static_cast<uint32_t>( payload[ 0 ] ) | ( static_cast<uint32_t>( payload[ 1 ] ) << 8 );
+    }
+};
+
+TEST_F( UplinkJournalTest, MountRejectsInvalidArguments )
+{
+    EXPECT_FALSE( uplink_journal_mount( nullptr, &norFlashOps, &flash, kSectorSize, 8U ) );
+    EXPECT_FALSE( uplink_journal_mount( &journal, nullptr, &flash, kSectorSize, 8U ) );
+    EXPECT_FALSE( uplink_journal_mount( &journal, &norFlashOps, &flash, 100U, 8U ) );
+    EXPECT_FALSE( uplink_journal_mount( &journal, &norFlashOps, &flash, kSectorSize, 1U ) );
+}
+
+TEST_F( UplinkJournalTest, BlankFlashMountsEmpty )
+{
+    uint8_t out[ 64 ];
+    uint8_t records = 0xFFU;
+
+    EXPECT_EQ( uplink_journal_pending( &journal ), 0U );
+    EXPECT_EQ( uplink_journal_peek_batch( &journal, out, sizeof( out ), 51U, &records, nullptr ), 0U );
+    EXPECT_EQ( records, 0U );
+}
+
+TEST_F( UplinkJournalTest, BatchesAreConcatenatedOldestFirstAndAcked )
+{
+    uint8_t out[ 128 ];
+    uint8_t records = 0U;
+
+    for( uint32_t i = 0U; i < 20U; i++ )
+    {
+        ASSERT_TRUE( append( i ) );
+    }
+
+    /* 51-byte DR limit: eight 6-byte records */
+    ASSERT_EQ( uplink_journal_peek_batch( &journal, out, sizeof( out ), 51U, &records, nullptr ), 48U );
+    EXPECT_EQ( records, 8U );
+    EXPECT_EQ( first_of( out ), 0U );
+    EXPECT_EQ( first_of( &out[ 42 ] ), 7U );
+
+    /* Peeking does not consume */
+    ASSERT_EQ( uplink_journal_peek_batch( &journal, out, sizeof( out ), 51U, &records, nullptr ), 48U );
+    EXPECT_EQ( first_of( out ), 0U );
+
+    ASSERT_TRUE( uplink_journal_ack( &journal, records ) );
+    EXPECT_EQ( uplink_journal_pending( &journal ), 12U );
+    uint32_t firstSeq = 0U;
+    ASSERT_EQ( uplink_journal_peek_batch( &journal, out, sizeof( out ), 51U, &records, &firstSeq ), 48U );
+    EXPECT_EQ( first_of( out ), 8U );
+    EXPECT_EQ( firstSeq, 8U );
+
+    EXPECT_FALSE( uplink_journal_ack( &journal, 13U ) );
+    EXPECT_EQ( flash.violations, 0U );
+}
+
+TEST_F( UplinkJournalTest, StateSurvivesRemount )
+{
+    uint8_t out[ 128 ];
+    uint8_t records = 0U;
+
+    for( uint32_t i = 0U; i < 10U; i++ )
+    {
+        ASSERT_TRUE( append( i ) );
+    }
+    ASSERT_EQ( uplink_journal_peek_batch( &journal, out, sizeof( out ), 24U, &records, nullptr ), 24U );
+    ASSERT_TRUE( uplink_journal_ack( &journal, records ) );
+
+    ASSERT_TRUE( mount() );
+    EXPECT_EQ( uplink_journal_pending( &journal ), 6U );
+    EXPECT_EQ( journal.nextSeq, 10U );
+
+    ASSERT_TRUE( append( 10U ) );
+    ASSERT_EQ( uplink_journal_peek_batch( &journal, out, sizeof( out ), 128U, &records, nullptr ), 42U );
+    EXPECT_EQ( first_of( out ), 4U );
+    EXPECT_EQ( first_of( &out[ 36 ] ), 10U );
+}
+
+TEST_F( UplinkJournalTest, TornAppendIsDiscardedAtEveryCutPoint )
+{
+    const uint32_t recordBytes = UPLINK_JOURNAL_RECORD_HDR_LEN - 1U + kRecordLen;
+    uint8_t out[ 128 ];
+    uint8_t records = 0U;
+
+    for( uint32_t cut = 0U; cut < recordBytes; cut++ )
+    {
+        flash.reset( kSectorSize, 8U );
+        ASSERT_TRUE( mount() );
+        ASSERT_TRUE( append( 1U ) );
+        ASSERT_TRUE( append( 2U ) );
+
+        flash.cutAfterBytes = cut;
+        EXPECT_FALSE( append( 3U ) );
+
+        ASSERT_TRUE( mount() );
+        EXPECT_EQ( uplink_journal_pending( &journal ), 2U ) << "cut " << cut;
+
+        /* Appending resumes after the torn slot */
+        ASSERT_TRUE( append( 4U ) );
+        ASSERT_EQ( uplink_journal_peek_batch( &journal, out, sizeof( out ), 128U, &records, nullptr ), 18U );
+        EXPECT_EQ( first_of( &out[ 12 ] ), 4U );
+        EXPECT_EQ( flash.violations, 0U );
+    }
+}
+
+TEST_F( UplinkJournalTest, CorruptRecordIsSkipped )
+{
+    uint8_t out[ 128 ];
+    uint8_t records = 0U;
+
+    ASSERT_TRUE( append( 1U ) );
+    ASSERT_TRUE( append( 2U ) );
+    ASSERT_TRUE( append( 3U ) );
+
+    /* Bit rot in the second payload */
+    const size_t second = UPLINK_JOURNAL_SECTOR_HDR_LEN + UPLINK_JOURNAL_RECORD_HDR_LEN + 8U;
+    flash.mem[ second + UPLINK_JOURNAL_RECORD_HDR_LEN + 2U ] &= 0xFEU;
+
+    ASSERT_TRUE( mount() );
+    EXPECT_EQ( uplink_journal_pending( &journal ), 3U );
+
+    /* Detected on replay and retired; the batch ends at the sequence gap */
+    uint32_t firstSeq = UINT32_MAX;
+    ASSERT_EQ( uplink_journal_peek_batch( &journal, out, sizeof( out ), 128U, &records, &firstSeq ), 6U );
+    EXPECT_EQ( first_of( out ), 1U );
+    EXPECT_EQ( firstSeq, 0U );
+
+    UplinkJournalStats stats;
+    ASSERT_TRUE( uplink_journal_get_stats( &journal, &stats ) );
+    EXPECT_EQ( stats.pending, 2U );
+    EXPECT_EQ( stats.corrupt, 1U );
+
+    ASSERT_TRUE( uplink_journal_ack( &journal, records ) );
+    ASSERT_EQ( uplink_journal_peek_batch( &journal, out, sizeof( out ), 128U, &records, &firstSeq ), 6U );
+    EXPECT_EQ( first_of( out ), 3U );
+    EXPECT_EQ( firstSeq, 2U );
+
+    ASSERT_TRUE( uplink_journal_ack( &journal, records ) );
+    EXPECT_EQ( uplink_journal_pending( &journal ), 0U );
+    ASSERT_TRUE( mount() );
+    EXPECT_EQ( uplink_journal_pending( &journal ), 0U );
+}
+
+TEST_F( UplinkJournalTest, FullRingDropsOldestAndLevelsWear )
+{
+    constexpr uint32_t kSmallSector = 256U;
+    constexpr uint16_t kSectors = 4U;
+    uint8_t out[ 128 ];
+    uint8_t records = 0U;
+
+    flash.reset( kSmallSector, kSectors );
+    ASSERT_TRUE( mount( kSmallSector ) );
+
+    for( uint32_t i = 0U; i < 400U; i++ )
+    {
+        ASSERT_TRUE( append( i ) );
+    }
+
+    UplinkJournalStats stats;
+    ASSERT_TRUE( uplink_journal_get_stats( &journal, &stats ) );
+    EXPECT_GT( stats.dropped, 0U );
+    EXPECT_EQ( stats.pending + stats.dropped, 400U );
+
+    /* The newest records survive, still in order */
+    ASSERT_GT( uplink_journal_peek_batch( &journal, out, sizeof( out ), 6U, &records, nullptr ), 0U );
+    EXPECT_EQ( first_of( out ), 400U - stats.pending );
+
+    /* Round-robin: erase counts of all sectors stay within one */
+    uint32_t minErases = UINT32_MAX;
+    uint32_t maxErases = 0U;
+    for( uint16_t s = 0U; s < kSectors; s++ )
+    {
+        uint32_t erases = 0U;
+        std::memcpy( &erases, &flash.mem[ ( s * kSmallSector ) + 8U ], sizeof( erases ) );
+        minErases = std::min( minErases, erases );
+        maxErases = std::max( maxErases, erases );
+    }
+    EXPECT_LE( maxErases - minErases, 1U );
+    EXPECT_EQ( stats.maxSectorErases, maxErases );
+
+    ASSERT_TRUE( mount( kSmallSector ) );
+    EXPECT_EQ( uplink_journal_pending( &journal ), stats.pending );
+    EXPECT_EQ( flash.violations, 0U );
+}
+
+TEST_F( UplinkJournalTest, BenchmarkWriteAndReplayThroughput )
+{
+    constexpr uint16_t kSectors = 64U;
+    constexpr uint32_t kRecords = 10000U;
+    constexpr uint16_t kBatchLen = 51U;   /* EU868 DR0-2 payload limit */
+    uint8_t out[ 128 ];
+    uint8_t records = 0U;
+
+    flash.reset( kSectorSize, kSectors );
+    ASSERT_TRUE( mount() );
+
+    uint64_t startUs = flash.nowUs;
+    for( uint32_t i = 0U; i < kRecords; i++ )
+    {
+        ASSERT_TRUE( append( i ) );
+    }
+    const uint64_t writeUs = flash.nowUs - startUs;
+
+    startUs = flash.nowUs;
+    ASSERT_TRUE( mount() );
+    const uint64_t mountUs = flash.nowUs - startUs;
+    ASSERT_EQ( uplink_journal_pending( &journal ), kRecords );
+
+    startUs = flash.nowUs;
+    uint32_t replayed = 0U;
+    uint32_t batches = 0U;
+    while( uplink_journal_pending( &journal ) > 0U )
+    {
+        ASSERT_GT( uplink_journal_peek_batch( &journal, out, sizeof( out ), kBatchLen, &records, nullptr ), 0U );
+        ASSERT_EQ( first_of( out ), replayed & 0xFFFFU );
+        ASSERT_TRUE( uplink_journal_ack( &journal, records ) );
+        replayed += records;
+        batches++;
+    }
+    const uint64_t replayUs = flash.nowUs - startUs;
+
+    /* Drained sectors are skipped */
+    startUs = flash.nowUs;
+    ASSERT_TRUE( mount() );
+    const uint64_t drainedMountUs = flash.nowUs - startUs;
+    EXPECT_EQ( uplink_journal_pending( &journal ), 0U );
+    EXPECT_EQ( journal.nextSeq, kRecords );
+
+    const uint32_t writePerSec = static_cast<uint32_t>( ( kRecords * 1000000ULL ) / writeUs );
+    const uint32_t replayPerSec = static_cast<uint32_t>( ( kRecords * 1000000ULL ) / replayUs );
+
+    RecordProperty( "writeRecordsPerSec", static_cast<int>( writePerSec ) );
+    RecordProperty( "replayRecordsPerSec", static_cast<int>( replayPerSec ) );
+    RecordProperty( "mountMs", static_cast<int>( mountUs / 1000U ) );
+    RecordProperty( "drainedMountMs", static_cast<int>( drainedMountUs / 1000U ) );
+    RecordProperty( "replayBatches", static_cast<int>( batches ) );
+
+    /* Flash is never the bottleneck: one uplink takes tens of ms on air */
+    EXPECT_EQ( batches, kRecords / 8U );
+    EXPECT_GT( writePerSec, 1000U );
+    EXPECT_GT( replayPerSec, 5000U );
+    EXPECT_LT( drainedMountUs * 10U, mountUs );
+    EXPECT_EQ( flash.violations, 0U );
+}
@@ -0,0 +1,143 @@
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+
+#include "lib/uplink_packer.h"
+
+class UplinkPackerTest : public ::testing::Test
+{
+protected:
+    static constexpr uint32_t DEADLINE_MS = 60000U;
+
+    UplinkPacker packer;
+    uint8_t out[ UPLINK_PACKER_MAX_PAYLOAD ];
+
+    void SetUp() override
+    {
+        ASSERT_TRUE( uplink_packer_init( &packer, DEADLINE_MS ) );
+    }
+
+    bool add( uint8_t tag, uint32_t nowMs )
+    {
+        const uint8_t record[ UPLINK_PACKER_RECORD_SIZE ] = { tag, 0U, 0U, 0U, 0U, tag };
+        return uplink_packer_add( &packer, record, nowMs );
+    }
+};
+
+TEST_F( UplinkPackerTest, RejectsInvalidArguments )
+{
+    EXPECT_FALSE( uplink_packer_init( nullptr, DEADLINE_MS ) );
+    EXPECT_FALSE( uplink_packer_add( &packer, nullptr, 0U ) );
+    EXPECT_FALSE( uplink_packer_set_max_payload( &packer,
+                                                 UPLINK_PACKER_HEADER_SIZE + UPLINK_PACKER_RECORD_SIZE - 1U ) );
+    EXPECT_EQ( uplink_packer_flush( &packer, out, sizeof( out ), 0U ), 0U );
+}
+
+TEST_F( UplinkPackerTest, ReadyWhenDataRateLimitReached )
+{
+    /* EU868 DR0: 51 bytes, 8 records */
+    ASSERT_TRUE( uplink_packer_set_max_payload( &packer, 51U ) );
+
+    for( uint8_t i = 0U; i < 7U; ++i )
+    {
+        ASSERT_TRUE( add( i, 0U ) );
+        EXPECT_FALSE( uplink_packer_ready( &packer, 0U ) );
+    }
+
+    ASSERT_TRUE( add( 7U, 0U ) );
+    EXPECT_TRUE( uplink_packer_ready( &packer, 0U ) );
+
+    EXPECT_EQ( uplink_packer_flush( &packer, out, sizeof( out ), 0U ), 51U );
+    EXPECT_EQ( out[ 0 ], UPLINK_PACKER_KIND_LIVE );
+    EXPECT_EQ( out[ 3 ], 0U );
+    EXPECT_EQ( out[ 45 ], 7U );
+    EXPECT_EQ( packer.stats.flushesFull, 1U );
+}
+
+TEST_F( UplinkPackerTest, ReadyWhenDeadlineExpires )
+{
+    ASSERT_TRUE( add( 1U, 1000U ) );
+    ASSERT_TRUE( add( 2U, 2000U ) );
+
+    EXPECT_FALSE( uplink_packer_ready( &packer, 1000U + DEADLINE_MS - 1U ) );
+    EXPECT_TRUE( uplink_packer_ready( &packer, 1000U + DEADLINE_MS ) );
+
+    EXPECT_EQ( uplink_packer_flush( &packer, out, sizeof( out ), 1000U + DEADLINE_MS ),
+               UPLINK_PACKER_HEADER_SIZE + ( 2U * UPLINK_PACKER_RECORD_SIZE ) );
+    EXPECT_EQ( packer.stats.flushesDeadline, 1U );
+
+    /* Newest record waited 59 s */
+    EXPECT_EQ( out[ 0 ], UPLINK_PACKER_KIND_LIVE );
+    EXPECT_EQ( ( out[ 1 ] << 8 ) | out[ 2 ], 59 );
+    EXPECT_FALSE( uplink_packer_ready( &packer, UINT32_MAX ) );
+}
+
+TEST_F( UplinkPackerTest, SingleRecordFollowsBatchHeader )
+{
+    const uint8_t record[ UPLINK_PACKER_RECORD_SIZE ] = { 0x04U, 0xD2U, 0x19U, 0x3CU, 0xBBU, 0x50U };
+
+    ASSERT_TRUE( uplink_packer_add( &packer, record, 0U ) );
+    ASSERT_EQ( uplink_packer_flush( &packer, out, sizeof( out ), 0U ),
+               UPLINK_PACKER_HEADER_SIZE + UPLINK_PACKER_RECORD_SIZE );
+    EXPECT_EQ( out[ 0 ], UPLINK_PACKER_KIND_LIVE );
+    EXPECT_EQ( 0, memcmp( &out[ UPLINK_PACKER_HEADER_SIZE ], record, sizeof( record ) ) );
+}
+
+TEST_F( UplinkPackerTest, LiveAgeSaturatesAndReplayHeaderCarriesSequence )
+{
+    ASSERT_TRUE( add( 1U, 0U ) );
+    ASSERT_GT( uplink_packer_flush( &packer, out, sizeof( out ), 0x10000U * 1000U ), 0U );
+    EXPECT_EQ( out[ 1 ], 0xFFU );
+    EXPECT_EQ( out[ 2 ], 0xFFU );
+
+    EXPECT_EQ( uplink_packer_replay_header( out, sizeof( out ), 0x12345U ), UPLINK_PACKER_HEADER_SIZE );
+    EXPECT_EQ( out[ 0 ], UPLINK_PACKER_KIND_REPLAY );
+    EXPECT_EQ( out[ 1 ], 0x23U );
+    EXPECT_EQ( out[ 2 ], 0x45U );
+    EXPECT_EQ( uplink_packer_replay_header( out, UPLINK_PACKER_HEADER_SIZE - 1U, 0U ), 0U );
+}
+
+TEST_F( UplinkPackerTest, DataRateDropKeepsRemainderOldestFirst )
+{
+    for( uint8_t i = 0U; i < 5U; ++i )
+    {
+        ASSERT_TRUE( add( i, i ) );
+    }
+
+    /* US915 DR0: 11 bytes, one record per uplink */
+    ASSERT_TRUE( uplink_packer_set_max_payload( &packer, 11U ) );
+    EXPECT_TRUE( uplink_packer_ready( &packer, 0U ) );
+
+    for( uint8_t i = 0U; i < 5U; ++i )
+    {
+        ASSERT_EQ( uplink_packer_flush( &packer, out, sizeof( out ), 0U ),
+                   UPLINK_PACKER_HEADER_SIZE + UPLINK_PACKER_RECORD_SIZE );
+        EXPECT_EQ( out[ UPLINK_PACKER_HEADER_SIZE ], i );
+    }
+
+    EXPECT_EQ( packer.count, 0U );
+}
+
+TEST_F( UplinkPackerTest, FullBufferRejectsRecords )
+{
+    for( uint8_t i = 0U; i < UPLINK_PACKER_MAX_RECORDS; ++i )
+    {
+        ASSERT_TRUE( add( i, 0U ) );
+    }
+
+    EXPECT_FALSE( add( 0xFFU, 0U ) );
+    EXPECT_EQ( packer.stats.rejected, 1U );
+    EXPECT_EQ( uplink_packer_flush( &packer, out, sizeof( out ), 0U ),
+               UPLINK_PACKER_HEADER_SIZE + ( UPLINK_PACKER_MAX_RECORDS * UPLINK_PACKER_RECORD_SIZE ) );
+}
+
+TEST_F( UplinkPackerTest, FlushHonoursOutputCapacity )
+{
+    ASSERT_TRUE( add( 1U, 0U ) );
+    ASSERT_TRUE( add( 2U, 0U ) );
+
+    EXPECT_EQ( uplink_packer_flush( &packer, out,
+                                    UPLINK_PACKER_HEADER_SIZE + UPLINK_PACKER_RECORD_SIZE + 1U, 0U ),
+               UPLINK_PACKER_HEADER_SIZE + UPLINK_PACKER_RECORD_SIZE );
+    EXPECT_EQ( packer.count, 1U );
+}
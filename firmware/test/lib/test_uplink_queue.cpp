@@ -0,0 +1,301 @@
+#include <cstdint>
+#include <gtest/gtest.h>
+
+#include "lib/uplink_queue.h"
+
+class UplinkQueueTest : public ::testing::Test
+{
+protected:
+    UplinkQueue queue;
+    UplinkEntry entry;
+
+    void SetUp() override
+    {
+        ASSERT_TRUE( uplink_queue_init( &queue ) );
+    }
+
+    UplinkQueueStatus push( UplinkPriority prio, uint8_t stream, uint8_t tag )
+    {
+        const uint8_t payload[ 2 ] = { stream, tag };
+        return uplink_queue_push( &queue, prio, stream, payload, sizeof( payload ) );
+    }
+};
+
+TEST_F( UplinkQueueTest, InitFailsWithNullQueue )
+{
+    EXPECT_FALSE( uplink_queue_init( nullptr ) );
+}
+
+TEST_F( UplinkQueueTest, PushRejectsInvalidArguments )
+{
+    const uint8_t payload[ 1 ] = { 0U };
+
+    EXPECT_EQ( uplink_queue_push( nullptr, UPLINK_PRIORITY_ALARM, 0U, payload, 1U ),
+               UPLINK_QUEUE_INVALID );
+    EXPECT_EQ( uplink_queue_push( &queue, UPLINK_PRIORITY_ALARM, 0U, nullptr, 1U ),
+               UPLINK_QUEUE_INVALID );
+    EXPECT_EQ( uplink_queue_push( &queue, UPLINK_PRIORITY_ALARM, 0U, payload, 0U ),
+               UPLINK_QUEUE_INVALID );
+    EXPECT_EQ( uplink_queue_depth( &queue ), 0U );
+}
+
+TEST_F( UplinkQueueTest, PopEmptyFails )
+{
+    EXPECT_FALSE( uplink_queue_pop( &queue, &entry ) );
+}
+
+TEST_F( UplinkQueueTest, AlarmsGoAheadOfTelemetry )
+{
+    EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY, 1U, 10U ), UPLINK_QUEUE_OK );
+    EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY, 2U, 20U ), UPLINK_QUEUE_OK );
+    EXPECT_EQ( push( UPLINK_PRIORITY_ALARM, 0U, 30U ), UPLINK_QUEUE_OK );
+    EXPECT_EQ( push( UPLINK_PRIORITY_ALARM, 0U, 40U ), UPLINK_QUEUE_OK );
+
+    const uint8_t expectedTags[] = { 30U, 40U, 10U, 20U };
+
+    for( uint8_t tag : expectedTags )
+    {
+        ASSERT_TRUE( uplink_queue_pop( &queue, &entry ) );
+        EXPECT_EQ( entry.payload[ 1 ], tag );
+    }
+
+    EXPECT_FALSE( uplink_queue_pop( &queue, &entry ) );
+}
+
+TEST_F( UplinkQueueTest, PeekMatchesPopWithoutRemoving )
+{
+    EXPECT_EQ( uplink_queue_peek( &queue ), nullptr );
+
+    EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY, 1U, 10U ), UPLINK_QUEUE_OK );
+    EXPECT_EQ( push( UPLINK_PRIORITY_ALARM, 0U, 20U ), UPLINK_QUEUE_OK );
+
+    const UplinkEntry * const next = uplink_queue_peek( &queue );
+    ASSERT_NE( next, nullptr );
+    EXPECT_EQ( next->payload[ 1 ], 20U );
+    EXPECT_EQ( uplink_queue_depth( &queue ), 2U );
+
+    ASSERT_TRUE( uplink_queue_pop( &queue, &entry ) );
+    EXPECT_EQ( entry.payload[ 1 ], 20U );
+}
+
+TEST_F( UplinkQueueTest, TelemetryIsCoalescedPerStream )
+{
+    EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY, 1U, 10U ), UPLINK_QUEUE_OK );
+    EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY, 2U, 20U ), UPLINK_QUEUE_OK );
+    EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY, 1U, 11U ), UPLINK_QUEUE_COALESCED );
+
+    EXPECT_EQ( uplink_queue_depth( &queue ), 2U );
+
+    /* Stream 1 keeps its original position but carries the fresh sample */
+    ASSERT_TRUE( uplink_queue_pop( &queue, &entry ) );
+    EXPECT_EQ( entry.streamId, 1U );
+    EXPECT_EQ( entry.payload[ 1 ], 11U );
+}
+
+TEST_F( UplinkQueueTest, AlarmsAreNeverCoalesced )
+{
+    EXPECT_EQ( push( UPLINK_PRIORITY_ALARM, 1U, 10U ), UPLINK_QUEUE_OK );
+    EXPECT_EQ( push( UPLINK_PRIORITY_ALARM, 1U, 11U ), UPLINK_QUEUE_OK );
+    EXPECT_EQ( uplink_queue_depth( &queue ), 2U );
+}
+
+TEST_F( UplinkQueueTest, FullQueueRejectsTelemetry )
+{
+    for( uint8_t i = 0U; i < UPLINK_QUEUE_CAPACITY; ++i )
+    {
+        EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY, i, i ), UPLINK_QUEUE_OK );
+    }
+
+    EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY, 100U, 0U ), UPLINK_QUEUE_FULL );
+
+    UplinkQueueStats stats;
+    ASSERT_TRUE( uplink_queue_get_stats( &queue, &stats ) );
+    EXPECT_EQ( stats.dropped, 1U );
+    EXPECT_EQ( stats.depth, UPLINK_QUEUE_CAPACITY );
+    EXPECT_EQ( stats.highWater, UPLINK_QUEUE_CAPACITY );
+}
+
+TEST_F( UplinkQueueTest, AlarmEvictsOldestTelemetryWhenFull )
+{
+    for( uint8_t i = 0U; i < UPLINK_QUEUE_CAPACITY; ++i )
+    {
+        EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY, i, i ), UPLINK_QUEUE_OK );
+    }
+
+    EXPECT_EQ( push( UPLINK_PRIORITY_ALARM, 0U, 99U ), UPLINK_QUEUE_OK );
+
+    ASSERT_TRUE( uplink_queue_pop( &queue, &entry ) );
+    EXPECT_EQ( entry.priority, UPLINK_PRIORITY_ALARM );
+
+    /* Stream 0 was the oldest telemetry and got evicted */
+    ASSERT_TRUE( uplink_queue_pop( &queue, &entry ) );
+    EXPECT_EQ( entry.streamId, 1U );
+
+    UplinkQueueStats stats;
+    ASSERT_TRUE( uplink_queue_get_stats( &queue, &stats ) );
+    EXPECT_EQ( stats.evicted, 1U );
+    EXPECT_EQ( stats.dropped, 0U );
+}
+
+TEST_F( UplinkQueueTest, AlarmEvictsSingleTelemetryBeforeBatches )
+{
+    EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY, UPLINK_QUEUE_BATCH_STREAM_FIRST, 0U ),
+               UPLINK_QUEUE_OK );
+    for( uint8_t i = 1U; i < UPLINK_QUEUE_CAPACITY; ++i )
+    {
+        EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY, i, i ), UPLINK_QUEUE_OK );
+    }
+
+    EXPECT_EQ( push( UPLINK_PRIORITY_ALARM, 0U, 99U ), UPLINK_QUEUE_OK );
+    EXPECT_FALSE( uplink_queue_take_spill( &queue, &entry ) );
+
+    ASSERT_TRUE( uplink_queue_pop( &queue, &entry ) );
+    EXPECT_EQ( entry.priority, UPLINK_PRIORITY_ALARM );
+
+    /* The older batch stayed; single stream 1 was evicted instead */
+    ASSERT_TRUE( uplink_queue_pop( &queue, &entry ) );
+    EXPECT_EQ( entry.streamId, UPLINK_QUEUE_BATCH_STREAM_FIRST );
+    ASSERT_TRUE( uplink_queue_pop( &queue, &entry ) );
+    EXPECT_EQ( entry.streamId, 2U );
+}
+
+TEST_F( UplinkQueueTest, EvictedBatchIsSpilledToOwner )
+{
+    for( uint8_t i = 0U; i < UPLINK_QUEUE_CAPACITY; ++i )
+    {
+        EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY,
+                         ( uint8_t ) ( UPLINK_QUEUE_BATCH_STREAM_FIRST + i ), i ),
+                   UPLINK_QUEUE_OK );
+    }
+
+    EXPECT_EQ( push( UPLINK_PRIORITY_ALARM, 0U, 99U ), UPLINK_QUEUE_OK );
+
+    ASSERT_TRUE( uplink_queue_take_spill( &queue, &entry ) );
+    EXPECT_EQ( entry.streamId, UPLINK_QUEUE_BATCH_STREAM_FIRST );
+    EXPECT_EQ( entry.payload[ 1 ], 0U );
+    EXPECT_FALSE( uplink_queue_take_spill( &queue, &entry ) );
+
+    UplinkQueueStats stats;
+    ASSERT_TRUE( uplink_queue_get_stats( &queue, &stats ) );
+    EXPECT_EQ( stats.evicted, 1U );
+    EXPECT_EQ( stats.spilled, 1U );
+    EXPECT_EQ( uplink_queue_depth( &queue ), UPLINK_QUEUE_CAPACITY );
+}
+
+TEST_F( UplinkQueueTest, FullOfAlarmsRejectsAlarm )
+{
+    for( uint8_t i = 0U; i < UPLINK_QUEUE_CAPACITY; ++i )
+    {
+        EXPECT_EQ( push( UPLINK_PRIORITY_ALARM, 0U, i ), UPLINK_QUEUE_OK );
+    }
+
+    EXPECT_EQ( push( UPLINK_PRIORITY_ALARM, 0U, 0U ), UPLINK_QUEUE_FULL );
+}
+
+TEST_F( UplinkQueueTest, CountersTrackFlow )
+{
+    EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY, 1U, 0U ), UPLINK_QUEUE_OK );
+    EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY, 1U, 1U ), UPLINK_QUEUE_COALESCED );
+    ASSERT_TRUE( uplink_queue_pop( &queue, &entry ) );
+
+    UplinkQueueStats stats;
+    ASSERT_TRUE( uplink_queue_get_stats( &queue, &stats ) );
+    EXPECT_EQ( stats.enqueued, 1U );
+    EXPECT_EQ( stats.coalesced, 1U );
+    EXPECT_EQ( stats.dequeued, 1U );
+    EXPECT_EQ( stats.depth, 0U );
+    EXPECT_EQ( stats.highWater, 1U );
+}
+
+TEST_F( UplinkQueueTest, ConfirmedTelemetryIsNotCoalesced )
+{
+    const uint8_t payload[ 2 ] = { 1U, 0U };
+
+    EXPECT_EQ( uplink_queue_push_confirmed( &queue, UPLINK_PRIORITY_TELEMETRY, 1U,
+                                            payload, sizeof( payload ) ),
+               UPLINK_QUEUE_OK );
+    EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY, 1U, 1U ), UPLINK_QUEUE_OK );
+    EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY, 1U, 2U ), UPLINK_QUEUE_COALESCED );
+    EXPECT_EQ( uplink_queue_depth( &queue ), 2U );
+
+    ASSERT_TRUE( uplink_queue_pop( &queue, &entry ) );
+    EXPECT_TRUE( entry.confirmed );
+    EXPECT_EQ( entry.attempts, 0U );
+    EXPECT_EQ( entry.payload[ 1 ], 0U );
+
+    ASSERT_TRUE( uplink_queue_pop( &queue, &entry ) );
+    EXPECT_FALSE( entry.confirmed );
+    EXPECT_EQ( entry.payload[ 1 ], 2U );
+}
+
+TEST_F( UplinkQueueTest, RequeueGoesAheadOfNewerFramesOfItsClass )
+{
+    const uint8_t payload[ 2 ] = { 0U, 10U };
+
+    EXPECT_EQ( uplink_queue_push_confirmed( &queue, UPLINK_PRIORITY_ALARM, 0U,
+                                            payload, sizeof( payload ) ),
+               UPLINK_QUEUE_OK );
+    ASSERT_TRUE( uplink_queue_pop( &queue, &entry ) );
+
+    EXPECT_EQ( push( UPLINK_PRIORITY_ALARM, 0U, 20U ), UPLINK_QUEUE_OK );
+    EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY, 1U, 30U ), UPLINK_QUEUE_OK );
+
+    entry.attempts = 1U;
+    EXPECT_EQ( uplink_queue_requeue( &queue, &entry ), UPLINK_QUEUE_OK );
+
+    const uint8_t expectedTags[] = { 10U, 20U, 30U };
+
+    for( uint8_t tag : expectedTags )
+    {
+        ASSERT_TRUE( uplink_queue_pop( &queue, &entry ) );
+        EXPECT_EQ( entry.payload[ 1 ], tag );
+    }
+
+    UplinkQueueStats stats;
+    ASSERT_TRUE( uplink_queue_get_stats( &queue, &stats ) );
+    EXPECT_EQ( stats.requeued, 1U );
+    EXPECT_EQ( stats.enqueued, 3U );
+    EXPECT_EQ( stats.depth, 0U );
+}
+
+TEST_F( UplinkQueueTest, RequeueKeepsAttemptCount )
+{
+    EXPECT_EQ( push( UPLINK_PRIORITY_ALARM, 0U, 1U ), UPLINK_QUEUE_OK );
+    ASSERT_TRUE( uplink_queue_pop( &queue, &entry ) );
+
+    entry.attempts = 2U;
+    EXPECT_EQ( uplink_queue_requeue( &queue, &entry ), UPLINK_QUEUE_OK );
+
+    ASSERT_TRUE( uplink_queue_pop( &queue, &entry ) );
+    EXPECT_EQ( entry.attempts, 2U );
+}
+
+TEST_F( UplinkQueueTest, RequeuedAlarmEvictsTelemetryWhenFull )
+{
+    EXPECT_EQ( push( UPLINK_PRIORITY_ALARM, 0U, 99U ), UPLINK_QUEUE_OK );
+    ASSERT_TRUE( uplink_queue_pop( &queue, &entry ) );
+
+    for( uint8_t i = 0U; i < UPLINK_QUEUE_CAPACITY; ++i )
+    {
+        EXPECT_EQ( push( UPLINK_PRIORITY_TELEMETRY, i, i ), UPLINK_QUEUE_OK );
+    }
+
+    EXPECT_EQ( uplink_queue_requeue( &queue, &entry ), UPLINK_QUEUE_OK );
+    EXPECT_EQ( uplink_queue_depth( &queue ), UPLINK_QUEUE_CAPACITY );
+
+    UplinkEntry telemetry = entry;
+    telemetry.priority = UPLINK_PRIORITY_TELEMETRY;
+    EXPECT_EQ( uplink_queue_requeue( &queue, &telemetry ), UPLINK_QUEUE_FULL );
+
+    ASSERT_TRUE( uplink_queue_pop( &queue, &entry ) );
+    EXPECT_EQ( entry.payload[ 1 ], 99U );
+}
+
+TEST_F( UplinkQueueTest, RequeueRejectsInvalidEntry )
+{
+    UplinkEntry invalid = {};
+
+    EXPECT_EQ( uplink_queue_requeue( &queue, nullptr ), UPLINK_QUEUE_INVALID );
+    EXPECT_EQ( uplink_queue_requeue( &queue, &invalid ), UPLINK_QUEUE_INVALID );
+    EXPECT_EQ( uplink_queue_depth( &queue ), 0U );
+}
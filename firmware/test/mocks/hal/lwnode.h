@@ -0,0 +1,35 @@
+#ifndef TEST_MOCKS_HAL_LWNODE_H
+#define TEST_MOCKS_HAL_LWNODE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct LwnodeHw
+{
+    uint16_t i2cAddr;
+} LwnodeHw;
+
+void lwnode_hal_config_default( LwnodeHw * sensor );
+bool lwnode_hal_init( LwnodeHw * sensor );
+bool lwnode_hal_deinit( LwnodeHw * sensor );
+bool lwnode_hal_write( const LwnodeHw * sensor, uint8_t reg, const uint8_t * data, size_t len );
+bool lwnode_hal_read( const LwnodeHw * sensor, uint8_t reg, uint8_t * data, size_t len );
+bool lwnode_hal_probe( const LwnodeHw * sensor );
+void lwnode_hal_delay_ms( uint32_t delayMs );
+bool lwnode_hal_irq_available( const LwnodeHw * sensor );
+bool lwnode_hal_wait_irq( const LwnodeHw * sensor, uint32_t timeoutMs );
+uint32_t lwnode_hal_get_time_ms( void );
+uint32_t lwnode_hal_device_id( void );
+bool lwnode_hal_nvs_load( const char * key, void * data, size_t len );
+bool lwnode_hal_nvs_store( const char * key, const void * data, size_t len );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TEST_MOCKS_HAL_LWNODE_H */
@@ -0,0 +1,706 @@
+#include "hal/lwnode_emulator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+
+#include "hal/lwnode.h"
+
+namespace
+{
+
+constexpr uint8_t REG_WRITE_AT_LONG = 0x39U;
+constexpr uint8_t REG_WRITE_AT = 0x40U;
+constexpr uint8_t REG_READ_AT_LEN = 0x41U;
+constexpr uint8_t REG_READ_AT = 0x42U;
+constexpr uint8_t REG_READ_DATA = 0x45U;
+constexpr uint8_t REG_READ_NUM_QUEUE = 0x46U;
+constexpr uint8_t REG_READ_DATA_LEN = 0x47U;
+constexpr uint8_t REG_READ_NEXT_DATA = 0x48U;
+
+constexpr uint8_t SNR_OFFSET = 50U;
+
+struct Downlink
+{
+    uint64_t arriveUs;
+    std::vector<uint8_t> frame;
+};
+
+struct Module
+{
+    LwnodeEmuTiming timing;
+    LwnodeEmuStats stats;
+    uint64_t nowUs = 0U;
+    bool present = true;
+    bool irqWired = false;
+    uint32_t dropReplies = 0U;
+    uint32_t deviceId = 0U;
+    std::string wrapBefore;
+    std::string wrapAfter;
+
+    /* AT command assembly */
+    std::string cmdBuf;
+    bool cmdCorrupt = false;
+    uint64_t lastChunkUs = 0U;
+
+    /* Pending reply */
+    std::string reply;
+    uint64_t replyReadyUs = 0U;
+    size_t replyOffset = 0U;
+
+    /* Module state */
+    bool rebootPending = false;
+    uint64_t rebootStartUs = 0U;
+    uint64_t rebootEndUs = 0U;
+    bool joinRequested = false;
+    uint64_t joinAtUs = 0U;
+    uint64_t busyUntilUs = 0U;
+    std::map<std::string, std::string> config;
+    std::deque<Downlink> downlinks;
+    size_t dataOffset = 0U;
+
+    std::vector<std::string> commands;
+    std::vector<std::vector<uint8_t>> uplinks;
+    std::map<std::string, std::vector<uint8_t>> nvs;
+};
+
+Module g_module;
+
+void advance_us( uint64_t us )
+{
+    g_module.nowUs += us;
+}
+
+void charge_bus( size_t bytes )
+{
+    /* Register address byte plus data */
+    advance_us( g_module.timing.i2cTxnUs + ( ( bytes + 1U ) * g_module.timing.i2cByteUs ) );
+}
+
+uint64_t ms_to_us( uint32_t ms )
+{
+    return static_cast<uint64_t>( ms ) * 1000U;
+}
+
+void clear_session()
+{
+    g_module.joinRequested = false;
+    g_module.config.clear();
+    g_module.downlinks.clear();
+    g_module.dataOffset = 0U;
+    g_module.cmdBuf.clear();
+    g_module.cmdCorrupt = false;
+}
+
+/* Apply state changes that are due by now */
+void update_state()
+{
+    if( g_module.rebootPending && ( g_module.nowUs >= g_module.rebootStartUs ) )
+    {
+        g_module.rebootPending = false;
+        g_module.stats.reboots++;
+        clear_session();
+    }
+}
+
+bool rebooting()
+{
+    return ( g_module.nowUs >= g_module.rebootStartUs ) && ( g_module.nowUs < g_module.rebootEndUs );
+}
+
+bool joined()
+{
+    return g_module.joinRequested && ( g_module.nowUs >= g_module.joinAtUs );
+}
+
+/* Radio owns the module: RX windows after an uplink, or a join in progress */
+bool busy()
+{
+    return ( g_module.nowUs < g_module.busyUntilUs ) ||
+           ( g_module.timing.busyWhileJoining && g_module.joinRequested && !joined() );
+}
+
+bool starts_with( const std::string & s, const char * prefix )
+{
+    return s.compare( 0U, std::strlen( prefix ), prefix ) == 0;
+}
+
+bool hex_decode( const std::string & hex, std::vector<uint8_t> & out )
+{
+    bool ok = ( ( hex.size() % 2U ) == 0U );
+
+    for( size_t i = 0U; ok && ( i < hex.size() ); i += 2U )
+    {
+        unsigned value = 0U;
+
+        ok = ( std::sscanf( hex.substr( i, 2U ).c_str(), "%2x", &value ) == 1 );
+        out.push_back( static_cast<uint8_t>( value ) );
+    }
+
+    return ok;
+}
+
+void set_reply( const std::string & text, uint32_t latencyMs )
+{
+    g_module.reply = text;
+    g_module.replyOffset = 0U;
+    g_module.replyReadyUs = g_module.nowUs + ms_to_us( latencyMs );
+}
+
+void execute( const std::string & cmd )
+{
+    const uint32_t replyMs = g_module.timing.replyMs;
+
+    g_module.commands.push_back( cmd );
+    g_module.stats.commands++;
+
+    if( busy() )
+    {
+        /* Lost: the caller times out */
+        g_module.stats.busyAccesses++;
+        g_module.reply.clear();
+    }
+    else if( cmd == "AT" )
+    {
+        set_reply( "OK\r\n", replyMs );
+    }
+    else if( cmd == "AT+REBOOT" )
+    {
+        set_reply( "+REBOOT=OK\r\n", replyMs );
+        g_module.rebootPending = true;
+        g_module.rebootStartUs = g_module.replyReadyUs;
+        g_module.rebootEndUs = g_module.rebootStartUs + ms_to_us( g_module.timing.rebootMs );
+    }
+    else if( cmd == "AT+JOIN?" )
+    {
+        set_reply( joined() ? "+JOIN=1\r\n" : "+JOIN=0\r\n", replyMs );
+    }
+    else if( cmd == "AT+JOIN=1" )
+    {
+        if( !joined() )
+        {
+            g_module.joinRequested = true;
+            g_module.joinAtUs = g_module.nowUs + ms_to_us( g_module.timing.joinAcceptMs );
+        }
+        set_reply( "+JOIN=OK\r\n", replyMs );
+    }
+    else if( starts_with( cmd, "AT+SEND=" ) )
+    {
+        std::vector<uint8_t> payload;
+
+        if( joined() && hex_decode( cmd.substr( 8U ), payload ) )
+        {
+            g_module.uplinks.push_back( payload );
+            set_reply( "+SEND=OK\r\n", g_module.timing.sendMs );
+            g_module.busyUntilUs = g_module.replyReadyUs + ms_to_us( g_module.timing.rxWindowsMs );
+        }
+        else
+        {
+            set_reply( "+SEND=ERROR\r\n", replyMs );
+        }
+    }
+    else if( starts_with( cmd, "AT+" ) && ( cmd.find( '=' ) != std::string::npos ) )
+    {
+        const size_t eq = cmd.find( '=' );
+        const std::string key = cmd.substr( 3U, eq - 3U );
+
+        g_module.config[ key ] = cmd.substr( eq + 1U );
+        set_reply( "+" + key + "=OK\r\n", replyMs );
+    }
+    else if( starts_with( cmd, "AT+" ) && ( cmd.back() == '?' ) )
+    {
+        const std::string key = cmd.substr( 3U, cmd.size() - 4U );
+
+        set_reply( "+" + key + "=" + g_module.config[ key ] + "\r\n", replyMs );
+    }
+    else
+    {
+        set_reply( "ERROR\r\n", replyMs );
+    }
+
+    if( g_module.dropReplies > 0U )
+    {
+        g_module.dropReplies--;
+        g_module.reply.clear();
+    }
+    else if( !g_module.wrapBefore.empty() || !g_module.wrapAfter.empty() )
+    {
+        g_module.reply = g_module.wrapBefore + g_module.reply + g_module.wrapAfter;
+        g_module.wrapBefore.clear();
+        g_module.wrapAfter.clear();
+    }
+    else
+    {
+        /* Plain reply */
+    }
+}
+
+void write_at( uint8_t reg, const uint8_t * data, size_t len, bool checkGap )
+{
+    const uint64_t gapUs = ms_to_us( g_module.timing.chunkGapMinMs );
+
+    if( checkGap && !g_module.cmdBuf.empty() && ( ( g_module.nowUs - g_module.lastChunkUs ) < gapUs ) )
+    {
+        g_module.cmdCorrupt = true;
+    }
+
+    g_module.cmdBuf.append( reinterpret_cast<const char *>( data ), len );
+    g_module.lastChunkUs = g_module.nowUs;
+
+    if( reg == REG_WRITE_AT )
+    {
+        std::string cmd = g_module.cmdBuf;
+        const bool corrupt = g_module.cmdCorrupt;
+
+        g_module.cmdBuf.clear();
+        g_module.cmdCorrupt = false;
+
+        if( ( cmd.size() >= 2U ) && ( cmd.compare( cmd.size() - 2U, 2U, "\r\n" ) == 0 ) )
+        {
+            cmd.resize( cmd.size() - 2U );
+        }
+
+        if( corrupt )
+        {
+            g_module.commands.push_back( cmd );
+            g_module.stats.commands++;
+            set_reply( "ERROR\r\n", g_module.timing.replyMs );
+        }
+        else
+        {
+            execute( cmd );
+        }
+    }
+}
+
+size_t arrived_downlinks()
+{
+    size_t count = 0U;
+
+    while( ( count < g_module.downlinks.size() ) &&
+           ( g_module.downlinks[ count ].arriveUs <= g_module.nowUs ) )
+    {
+        count++;
+    }
+
+    return count;
+}
+
+void read_register( uint8_t reg, uint8_t * data, size_t len )
+{
+    std::memset( data, 0, len );
+
+    switch( reg )
+    {
+        case REG_READ_AT_LEN:
+            if( !g_module.reply.empty() && ( g_module.nowUs >= g_module.replyReadyUs ) )
+            {
+                data[ 0 ] = static_cast<uint8_t>( g_module.reply.size() - g_module.replyOffset );
+            }
+            break;
+        case REG_READ_AT:
+            if( !g_module.reply.empty() && ( g_module.nowUs >= g_module.replyReadyUs ) )
+            {
+                const size_t n = std::min( len, g_module.reply.size() - g_module.replyOffset );
+
+                std::memcpy( data, &g_module.reply[ g_module.replyOffset ], n );
+                g_module.replyOffset += n;
+                if( g_module.replyOffset >= g_module.reply.size() )
+                {
+                    g_module.reply.clear();
+                }
+            }
+            break;
+        case REG_READ_NUM_QUEUE:
+            if( busy() )
+            {
+                g_module.stats.busyAccesses++;
+            }
+            else
+            {
+                data[ 0 ] = static_cast<uint8_t>( std::min<size_t>( arrived_downlinks(), 255U ) );
+            }
+            break;
+        case REG_READ_DATA_LEN:
+        case REG_READ_NEXT_DATA:
+            if( arrived_downlinks() > 0U )
+            {
+                data[ 0 ] = static_cast<uint8_t>( g_module.downlinks.front().frame.size() -
+                                                  g_module.dataOffset );
+            }
+            break;
+        case REG_READ_DATA:
+            if( arrived_downlinks() > 0U )
+            {
+                const std::vector<uint8_t> & frame = g_module.downlinks.front().frame;
+                const size_t n = std::min( len, frame.size() - g_module.dataOffset );
+
+                std::memcpy( data, &frame[ g_module.dataOffset ], n );
+                g_module.dataOffset += n;
+                if( g_module.dataOffset >= frame.size() )
+                {
+                    g_module.downlinks.pop_front();
+                    g_module.dataOffset = 0U;
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+uint64_t uart_reply_done_us()
+{
+    return g_module.replyReadyUs + ( g_module.reply.size() * g_module.timing.uartByteUs );
+}
+
+bool uart_write( void * ctx, const uint8_t * data, size_t len, bool final )
+{
+    ( void ) ctx;
+
+    advance_us( len * g_module.timing.uartByteUs );
+    update_state();
+
+    if( g_module.present )
+    {
+        g_module.stats.bytesWritten += static_cast<uint32_t>( len );
+
+        if( !rebooting() )
+        {
+            /* One stream, no chunk registers: the gap rule does not apply */
+            write_at( final ? REG_WRITE_AT : REG_WRITE_AT_LONG, data, len, false );
+        }
+    }
+
+    return g_module.present;
+}
+
+bool uart_read( void * ctx, uint8_t * buf, size_t cap, uint16_t * outLen )
+{
+    std::string chunk;
+
+    ( void ) ctx;
+    update_state();
+
+    /* A reply becomes readable once its last byte is on the wire */
+    if( !g_module.reply.empty() && ( g_module.nowUs >= uart_reply_done_us() ) )
+    {
+        chunk = g_module.reply.substr( g_module.replyOffset, cap );
+        g_module.replyOffset += chunk.size();
+        if( g_module.replyOffset >= g_module.reply.size() )
+        {
+            g_module.reply.clear();
+        }
+    }
+    else if( arrived_downlinks() > 0U )
+    {
+        const std::vector<uint8_t> & frame = g_module.downlinks.front().frame;
+
+        if( frame.size() + 2U <= cap )
+        {
+            chunk.assign( frame.begin(), frame.end() );
+            chunk += "\r\n";
+            g_module.downlinks.pop_front();
+        }
+    }
+    else
+    {
+        /* Nothing on the line */
+    }
+
+    std::memcpy( buf, chunk.data(), chunk.size() );
+    *outLen = static_cast<uint16_t>( chunk.size() );
+    g_module.stats.bytesRead += static_cast<uint32_t>( chunk.size() );
+
+    return !chunk.empty();
+}
+
+bool uart_wait_rx( void * ctx, uint32_t timeoutMs )
+{
+    const uint64_t deadlineUs = g_module.nowUs + ms_to_us( timeoutMs );
+    uint64_t eventUs = deadlineUs + 1U;
+
+    ( void ) ctx;
+
+    if( !g_module.reply.empty() )
+    {
+        eventUs = std::min( eventUs, uart_reply_done_us() );
+    }
+
+    if( !g_module.downlinks.empty() )
+    {
+        eventUs = std::min( eventUs, g_module.downlinks.front().arriveUs );
+    }
+
+    g_module.nowUs = std::max( g_module.nowUs, std::min( eventUs, deadlineUs ) );
+
+    return eventUs <= deadlineUs;
+}
+
+const LwnodeTransport g_uartTransport =
+{
+    "uart",
+    true,
+    nullptr,
+    uart_write,
+    uart_read,
+    uart_wait_rx
+};
+
+} // namespace
+
+const LwnodeTransport & lwnode_emu_uart_transport()
+{
+    return g_uartTransport;
+}
+
+void lwnode_emu_reset( const LwnodeEmuTiming & timing )
+{
+    g_module = Module();
+    g_module.timing = timing;
+}
+
+void lwnode_emu_power_cycle()
+{
+    clear_session();
+    g_module.reply.clear();
+    g_module.rebootPending = false;
+    g_module.rebootEndUs = g_module.nowUs;
+}
+
+void lwnode_emu_set_present( bool present )
+{
+    g_module.present = present;
+}
+
+void lwnode_emu_set_irq( bool wired )
+{
+    g_module.irqWired = wired;
+}
+
+void lwnode_emu_set_device_id( uint32_t id )
+{
+    g_module.deviceId = id;
+}
+
+void lwnode_emu_drop_replies( uint32_t count )
+{
+    g_module.dropReplies = count;
+}
+
+void lwnode_emu_wrap_next_reply( const std::string & before, const std::string & after )
+{
+    g_module.wrapBefore = before;
+    g_module.wrapAfter = after;
+}
+
+std::string lwnode_emu_recv_frame( const std::vector<uint8_t> & payload, int8_t rssi, int8_t snr )
+{
+    std::string frame = "+RECV=";
+
+    frame.push_back( static_cast<char>( -rssi ) );
+    frame.push_back( static_cast<char>( snr + SNR_OFFSET ) );
+    frame.push_back( static_cast<char>( payload.size() ) );
+    frame.append( payload.begin(), payload.end() );
+
+    return frame;
+}
+
+void lwnode_emu_queue_downlink( uint32_t atMs,
+                                const std::vector<uint8_t> & payload,
+                                int8_t rssi,
+                                int8_t snr )
+{
+    lwnode_emu_queue_raw_downlink( atMs, lwnode_emu_recv_frame( payload, rssi, snr ) );
+}
+
+void lwnode_emu_queue_raw_downlink( uint32_t atMs, const std::string & frame )
+{
+    Downlink downlink;
+
+    downlink.arriveUs = ms_to_us( atMs );
+    downlink.frame.assign( frame.begin(), frame.end() );
+
+    g_module.downlinks.push_back( downlink );
+}
+
+uint32_t lwnode_emu_now_ms()
+{
+    return static_cast<uint32_t>( g_module.nowUs / 1000U );
+}
+
+bool lwnode_emu_joined()
+{
+    update_state();
+    return joined();
+}
+
+const LwnodeEmuStats & lwnode_emu_stats()
+{
+    return g_module.stats;
+}
+
+const std::vector<std::string> & lwnode_emu_commands()
+{
+    return g_module.commands;
+}
+
+std::string lwnode_emu_config( const std::string & key )
+{
+    const auto it = g_module.config.find( key );
+
+    return ( it != g_module.config.end() ) ? it->second : std::string();
+}
+
+void lwnode_emu_set_config( const std::string & key, const std::string & value )
+{
+    g_module.config[ key ] = value;
+}
+
+const std::vector<std::vector<uint8_t>> & lwnode_emu_uplinks()
+{
+    return g_module.uplinks;
+}
+
+// ------------------ HAL ------------------
+
+void lwnode_hal_config_default( LwnodeHw * sensor )
+{
+    sensor->i2cAddr = 0x20U;
+}
+
+bool lwnode_hal_init( LwnodeHw * sensor )
+{
+    ( void ) sensor;
+    return g_module.present;
+}
+
+bool lwnode_hal_deinit( LwnodeHw * sensor )
+{
+    ( void ) sensor;
+    return true;
+}
+
+bool lwnode_hal_write( const LwnodeHw * sensor, uint8_t reg, const uint8_t * data, size_t len )
+{
+    ( void ) sensor;
+
+    charge_bus( len );
+    update_state();
+    g_module.stats.i2cWrites++;
+
+    if( g_module.present )
+    {
+        g_module.stats.bytesWritten += static_cast<uint32_t>( len );
+
+        if( ( ( reg == REG_WRITE_AT_LONG ) || ( reg == REG_WRITE_AT ) ) && !rebooting() )
+        {
+            write_at( reg, data, len, true );
+        }
+    }
+
+    return g_module.present;
+}
+
+bool lwnode_hal_read( const LwnodeHw * sensor, uint8_t reg, uint8_t * data, size_t len )
+{
+    ( void ) sensor;
+
+    charge_bus( len );
+    update_state();
+    g_module.stats.i2cReads++;
+
+    if( g_module.present )
+    {
+        g_module.stats.bytesRead += static_cast<uint32_t>( len );
+        read_register( reg, data, len );
+    }
+
+    return g_module.present;
+}
+
+bool lwnode_hal_probe( const LwnodeHw * sensor )
+{
+    ( void ) sensor;
+
+    charge_bus( 0U );
+    return g_module.present;
+}
+
+void lwnode_hal_delay_ms( uint32_t delayMs )
+{
+    advance_us( ms_to_us( delayMs ) );
+}
+
+bool lwnode_hal_irq_available( const LwnodeHw * sensor )
+{
+    ( void ) sensor;
+    return g_module.irqWired;
+}
+
+bool lwnode_hal_wait_irq( const LwnodeHw * sensor, uint32_t timeoutMs )
+{
+    bool fired = false;
+
+    ( void ) sensor;
+
+    if( g_module.irqWired )
+    {
+        const uint64_t deadlineUs = g_module.nowUs + ms_to_us( timeoutMs );
+
+        for( const Downlink & downlink : g_module.downlinks )
+        {
+            if( downlink.arriveUs <= deadlineUs )
+            {
+                if( downlink.arriveUs > g_module.nowUs )
+                {
+                    g_module.nowUs = downlink.arriveUs;
+                }
+                fired = true;
+                break;
+            }
+        }
+
+        if( !fired )
+        {
+            g_module.nowUs = deadlineUs;
+        }
+    }
+
+    return fired;
+}
+
+uint32_t lwnode_hal_get_time_ms( void )
+{
+    return lwnode_emu_now_ms();
+}
+
+uint32_t lwnode_hal_device_id( void )
+{
+    return g_module.deviceId;
+}
+
+bool lwnode_hal_nvs_load( const char * key, void * data, size_t len )
+{
+    bool result = false;
+    const auto it = g_module.nvs.find( key );
+
+    if( ( it != g_module.nvs.end() ) && ( it->second.size() == len ) )
+    {
+        std::memcpy( data, it->second.data(), len );
+        result = true;
+    }
+
+    return result;
+}
+
+bool lwnode_hal_nvs_store( const char * key, const void * data, size_t len )
+{
+    const uint8_t * const bytes = static_cast<const uint8_t *>( data );
+
+    g_module.nvs[ key ].assign( bytes, bytes + len );
+    g_module.stats.nvsStores++;
+    return true;
+}
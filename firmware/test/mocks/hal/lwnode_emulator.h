@@ -0,0 +1,99 @@
+#ifndef TEST_MOCKS_HAL_LWNODE_EMULATOR_H
+#define TEST_MOCKS_HAL_LWNODE_EMULATOR_H
+
+/*
+ * Register-level DFR1115 emulator behind the hal/lwnode.h mock.
+ *
+ * Implements the AT command registers (REG_WRITE_AT*, REG_READ_AT*), the
+ * downlink queue registers (REG_READ_DATA*, REG_READ_NUM_QUEUE) and NVS on
+ * a virtual clock: every I2C transfer costs bus time, lwnode_hal_delay_ms()
+ * advances the clock without sleeping, and the module answers after
+ * configurable latencies. Tests read lwnode_emu_now_ms() to benchmark the
+ * driver without hardware.
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "lib/lwnode.h"
+
+struct LwnodeEmuTiming
+{
+    uint32_t i2cByteUs = 90U;        /* 100 kHz bus, 9 clocks per byte */
+    uint32_t i2cTxnUs = 50U;         /* Start, address and stop per transfer */
+    uint32_t chunkGapMinMs = 0U;     /* Module garbles AT chunks sent closer than this */
+    uint32_t replyMs = 5U;           /* Command parser reply latency */
+    uint32_t sendMs = 60U;           /* AT+SEND until +SEND=OK (radio TX) */
+    uint32_t joinAcceptMs = 5000U;   /* AT+JOIN=1 until the session is up */
+    uint32_t rebootMs = 300U;        /* Module ignores commands after AT+REBOOT */
+    uint32_t rxWindowsMs = 0U;       /* After +SEND=OK: commands and queue reads go unanswered (RX1/RX2) */
+    bool busyWhileJoining = false;   /* Same from AT+JOIN=1 until the join accept */
+    uint32_t uartByteUs = 87U;       /* 115200 baud, 10 bits per byte */
+};
+
+struct LwnodeEmuStats
+{
+    uint32_t i2cWrites = 0U;
+    uint32_t i2cReads = 0U;
+    uint32_t bytesWritten = 0U;
+    uint32_t bytesRead = 0U;
+    uint32_t commands = 0U;
+    uint32_t reboots = 0U;
+    uint32_t busyAccesses = 0U;      /* Commands and queue reads that hit a busy module */
+    uint32_t nvsStores = 0U;         /* lwnode_hal_nvs_store() calls */
+};
+
+/* UART wiring of the same module: commands and replies cost line time,
+ * downlinks are pushed into the reply stream as "+RECV=" frames and
+ * wait_rx() sleeps until the next byte arrives. Context is unused. */
+const LwnodeTransport & lwnode_emu_uart_transport();
+
+/* Fresh module, empty NVS, clock at zero */
+void lwnode_emu_reset( const LwnodeEmuTiming & timing = LwnodeEmuTiming() );
+
+/* Module loses power: session, settings and queue are gone, NVS is kept */
+void lwnode_emu_power_cycle();
+
+void lwnode_emu_set_present( bool present );
+void lwnode_emu_set_irq( bool wired );
+
+/* lwnode_hal_device_id() of the board, 0 after a reset */
+void lwnode_emu_set_device_id( uint32_t id );
+
+/* The next count commands are executed but never answered */
+void lwnode_emu_drop_replies( uint32_t count );
+
+/* Surround the next reply with raw bytes, e.g. an information line or an
+ * unsolicited frame that arrived while the command was in flight */
+void lwnode_emu_wrap_next_reply( const std::string & before, const std::string & after );
+
+/* "+RECV=" frame bytes as the module emits them */
+std::string lwnode_emu_recv_frame( const std::vector<uint8_t> & payload, int8_t rssi, int8_t snr );
+
+/* Queue a downlink that becomes readable at atMs */
+void lwnode_emu_queue_downlink( uint32_t atMs,
+                                const std::vector<uint8_t> & payload,
+                                int8_t rssi,
+                                int8_t snr );
+
+/* Queue raw frame bytes, e.g. a frame that is not "+RECV=" */
+void lwnode_emu_queue_raw_downlink( uint32_t atMs, const std::string & frame );
+
+uint32_t lwnode_emu_now_ms();
+bool lwnode_emu_joined();
+const LwnodeEmuStats & lwnode_emu_stats();
+
+/* Commands received, without CRLF, oldest first */
+const std::vector<std::string> & lwnode_emu_commands();
+
+/* Value of the last "AT+<key>=<value>" setting, empty if never set */
+std::string lwnode_emu_config( const std::string & key );
+
+/* Change a setting behind the driver's back, e.g. the DR under network ADR */
+void lwnode_emu_set_config( const std::string & key, const std::string & value );
+
+/* Decoded AT+SEND payloads accepted by the module */
+const std::vector<std::vector<uint8_t>> & lwnode_emu_uplinks();
+
+#endif /* TEST_MOCKS_HAL_LWNODE_EMULATOR_H */